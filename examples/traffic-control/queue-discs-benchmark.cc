@@ -27,7 +27,7 @@
 // n1 ------------------------------------ n2 ----------------------------------- n3
 //   point-to-point (access link)                point-to-point (bottleneck link)
 //   100 Mbps, 0.1 ms                            bandwidth [10 Mbps], delay [5 ms]
-//   qdiscs PfifoFast with capacity              qdiscs queueDiscType in {PfifoFast, ARED, CoDel, FqCoDel, PIE} [PfifoFast]
+//   qdiscs PfifoFast with capacity              qdiscs queueDiscType in {PfifoFast, ARED, CoDel, FqCoDel, FqCoDelFlat, PIE, REM} [PfifoFast]
 //   of 1000 packets                             with capacity of queueDiscSize packets [1000]
 //   netdevices queues with size of 100 packets  netdevices queues with size of netdevicesQueueSize packets [100]
 //   without BQL                                 bql BQL [false]
@@ -52,6 +52,16 @@
 //
 // If you use an AQM as queue disc on the bottleneck netdevices, you can observe that the ping Rtt
 // decrease. A further decrease can be observed when you enable BQL.
+//
+// If batchSize is not zero, no network is simulated. Instead, bursts of batchSize packets are
+// enqueued into and dequeued from a standalone queue disc of type queueDiscType, first one packet
+// at a time and then through the EnqueueBatch/DequeueBatch API, and the wall clock throughput of
+// the two approaches is printed, e.g.:
+//
+//    RED per-packet: 1.52 Mpps (0 drops)
+//    RED batch of 32: 1.87 Mpps (0 drops)
+
+#include <algorithm>
 
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
@@ -93,6 +103,69 @@ static void PingRtt (std::string context, Time rtt)
   std::cout << context << "=" << rtt.GetMilliSeconds () << " ms" << std::endl;
 }
 
+static void
+MeasureThroughput (std::string queueDiscType, TrafficControlHelper &tch, uint32_t batchSize,
+                   uint32_t nPackets, uint32_t packetSize, bool batch)
+{
+  // Install the queue disc on a dummy device to get it configured like the bottleneck one
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  node->AddDevice (device);
+  node->AggregateObject (CreateObject<TrafficControlLayer> ());
+  Ptr<QueueDisc> qdisc = tch.Install (device).Get (0);
+  node->Initialize ();
+
+  // Spread the packets over a few flows, so that FqCoDel uses several queues
+  std::vector<Ptr<QueueDiscItem> > items;
+  for (uint32_t i = 0; i < batchSize; i++)
+    {
+      Ipv4Header hdr;
+      hdr.SetSource (Ipv4Address ("10.0.0.1"));
+      hdr.SetDestination (Ipv4Address (0x0a000100 + (i % 16)));
+      hdr.SetProtocol (17);
+      items.push_back (Create<Ipv4QueueDiscItem> (Create<Packet> (packetSize), Address (), 0x0800, hdr));
+    }
+
+  std::vector<Ptr<QueueDiscItem> > dequeued;
+  dequeued.reserve (batchSize);
+  uint32_t nRounds = nPackets / batchSize;
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (uint32_t round = 0; round < nRounds; round++)
+    {
+      if (batch)
+        {
+          qdisc->EnqueueBatch (items);
+          dequeued.clear ();
+          qdisc->DequeueBatch (dequeued, batchSize);
+        }
+      else
+        {
+          for (uint32_t i = 0; i < batchSize; i++)
+            {
+              qdisc->Enqueue (items[i]);
+            }
+          for (uint32_t i = 0; i < batchSize && qdisc->Dequeue () != 0; i++)
+            {
+            }
+        }
+    }
+  int64_t elapsed = std::max<int64_t> (clock.End (), 1);
+
+  std::cout << queueDiscType;
+  if (batch)
+    {
+      std::cout << " batch of " << batchSize;
+    }
+  else
+    {
+      std::cout << " per-packet";
+    }
+  std::cout << ": " << nRounds * batchSize / (elapsed * 1000.0) << " Mpps ("
+            << qdisc->GetTotalDroppedPackets () << " drops)" << std::endl;
+}
+
 int main (int argc, char *argv[])
 {
   std::string bandwidth = "10Mbps";
@@ -109,10 +182,13 @@ int main (int argc, char *argv[])
   float simDuration = 60;
   float samplingPeriod = 1;
 
+  uint32_t batchSize = 0;
+  uint32_t batchPackets = 2000000;
+
   CommandLine cmd;
   cmd.AddValue ("bandwidth", "Bottleneck bandwidth", bandwidth);
   cmd.AddValue ("delay", "Bottleneck delay", delay);
-  cmd.AddValue ("queueDiscType", "Bottleneck queue disc type in {PfifoFast, ARED, CoDel, FqCoDel, PIE}", queueDiscType);
+  cmd.AddValue ("queueDiscType", "Bottleneck queue disc type in {PfifoFast, ARED, CoDel, FqCoDel, FqCoDelFlat, PIE, REM}", queueDiscType);
   cmd.AddValue ("queueDiscSize", "Bottleneck queue disc size in packets", queueDiscSize);
   cmd.AddValue ("netdevicesQueueSize", "Bottleneck netdevices queue size in packets", netdevicesQueueSize);
   cmd.AddValue ("bql", "Enable byte queue limits on bottleneck netdevices", bql);
@@ -121,6 +197,8 @@ int main (int argc, char *argv[])
   cmd.AddValue ("startTime", "Simulation start time", startTime);
   cmd.AddValue ("simDuration", "Simulation duration in seconds", simDuration);
   cmd.AddValue ("samplingPeriod", "Goodput sampling period in seconds", samplingPeriod);
+  cmd.AddValue ("batchSize", "If not zero, only compare per-packet and batch queue disc throughput with bursts of this size", batchSize);
+  cmd.AddValue ("batchPackets", "Number of packets enqueued and dequeued by the throughput comparison", batchPackets);
   cmd.Parse (argc, argv);
 
   float stopTime = startTime + simDuration;
@@ -174,17 +252,38 @@ int main (int argc, char *argv[])
       tchBottleneck.AddPacketFilter (handle, "ns3::FqCoDelIpv4PacketFilter");
       tchBottleneck.AddPacketFilter (handle, "ns3::FqCoDelIpv6PacketFilter");
     }
+  else if (queueDiscType.compare ("FqCoDelFlat") == 0)
+    {
+      uint32_t handle = tchBottleneck.SetRootQueueDisc ("ns3::FqCoDelFlatQueueDisc");
+      Config::SetDefault ("ns3::FqCoDelFlatQueueDisc::PacketLimit", UintegerValue (queueDiscSize));
+      tchBottleneck.AddPacketFilter (handle, "ns3::FqCoDelIpv4PacketFilter");
+      tchBottleneck.AddPacketFilter (handle, "ns3::FqCoDelIpv6PacketFilter");
+    }
   else if (queueDiscType.compare ("PIE") == 0)
     {
       tchBottleneck.SetRootQueueDisc ("ns3::PieQueueDisc");
       Config::SetDefault ("ns3::PieQueueDisc::Mode", EnumValue (Queue::QUEUE_MODE_PACKETS));
       Config::SetDefault ("ns3::PieQueueDisc::QueueLimit", UintegerValue (queueDiscSize));
     }
+  else if (queueDiscType.compare ("REM") == 0)
+    {
+      tchBottleneck.SetRootQueueDisc ("ns3::RemQueueDisc");
+      Config::SetDefault ("ns3::RemQueueDisc::Mode", EnumValue (Queue::QUEUE_MODE_PACKETS));
+      Config::SetDefault ("ns3::RemQueueDisc::QueueLimit", UintegerValue (queueDiscSize));
+    }
   else
     {
       NS_ABORT_MSG ("--queueDiscType not valid");
     }
 
+  if (batchSize)
+    {
+      MeasureThroughput (queueDiscType, tchBottleneck, batchSize, batchPackets, flowsPacketsSize, false);
+      MeasureThroughput (queueDiscType, tchBottleneck, batchSize, batchPackets, flowsPacketsSize, true);
+      Simulator::Destroy ();
+      return 0;
+    }
+
   if (bql)
     {
       tchBottleneck.SetQueueLimits ("ns3::DynamicQueueLimits");
@@ -300,6 +399,10 @@ int main (int argc, char *argv[])
 
   flowMonitor->SerializeToXmlFile(queueDiscType + "-flowMonitor.xml", true, true);
 
+  QueueDiscItemPool &pool = Ipv4QueueDiscItem::GetPool ();
+  std::cout << "Ipv4QueueDiscItem pool: " << pool.GetHits () << " hits, "
+            << pool.GetMisses () << " misses" << std::endl;
+
   Simulator::Destroy ();
   return 0;
 }
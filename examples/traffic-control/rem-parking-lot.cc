@@ -0,0 +1,376 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This example compares REM, RED and PIE on a parking-lot topology with many
+// bottlenecks, and shows how REM link prices add up along a path.
+//
+// Network topology
+//
+//       S                                                        D
+//       |                                                        |
+//       R0 ---------- R1 ---------- R2 -- ... -- R(N-1) ---------- RN
+//       |             | |           | |            |  |            |
+//       C0            K0 C1         K1 C2         K(N-2) C(N-1)     K(N-1)
+//
+//   bottleneck links Ri -> Ri+1: bandwidth [10 Mbps], delay [1 ms], qdisc queueDiscType
+//   access links: 100 Mbps, 1 ms, qdisc PfifoFast
+//
+// A long TCP flow goes from S to D and crosses all the nBottlenecks [64]
+// bottleneck links. On every bottleneck link, a cross TCP flow goes from Ci
+// to Ki, so every bottleneck is shared by two flows.
+//
+// For every queue disc type, the example reports:
+// - the average queueing delay per bottleneck and along the path of the long
+//   flow, computed from the bytes in the queue discs sampled every 10 ms;
+// - the convergence time, i.e., the time after which the average queueing
+//   delay (smoothed by an EWMA) stays within 20% of its value in the second
+//   half of the run;
+// - the goodput of the long flow and the average goodput of the cross flows.
+// With REM, the bottleneck queue discs also add their price to a RemPriceTag,
+// which is read back when packets of the long flow reach D. The average
+// end-to-end price found in the tag is printed together with the sum of the
+// link prices at the end of the run.
+//
+// Usage:
+//
+//    $ ./waf --run "rem-parking-lot --PrintHelp"
+//    $ ./waf --run "rem-parking-lot --queueDiscType=Rem --nBottlenecks=64"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include <cmath>
+#include <iomanip>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RemParkingLot");
+
+/// Results of a run
+struct ParkingLotResults
+{
+  double meanQueueDelay;      //!< Mean queueing delay per bottleneck (s)
+  double meanPathQueueDelay;  //!< Mean queueing delay along the path of the long flow (s)
+  double convergenceTime;     //!< Time after which the queueing delay settles (s)
+  double longFlowGoodput;     //!< Goodput of the long flow (Mbps)
+  double crossFlowGoodput;    //!< Average goodput of the cross flows (Mbps)
+  double meanTagPrice;        //!< Average end-to-end price read from the tags (REM only)
+  double meanTagLinks;        //!< Average number of links which added their price (REM only)
+  double sumLinkPrices;       //!< Sum of the link prices at the end of the run (REM only)
+};
+
+QueueDiscContainer g_bottlenecks;
+double g_bottleneckRate;
+double g_measureStart;
+double g_delaySum;
+uint64_t g_delaySamples;
+double g_ewmaDelay;
+std::vector<std::pair<double, double> > g_ewmaSeries;
+double g_tagPriceSum;
+double g_tagLinksSum;
+uint64_t g_taggedPackets;
+
+void
+SampleQueues (Time interval)
+{
+  double sum = 0;
+  for (uint32_t i = 0; i < g_bottlenecks.GetN (); i++)
+    {
+      sum += g_bottlenecks.Get (i)->GetNBytes () * 8.0 / g_bottleneckRate;
+    }
+  double avg = sum / g_bottlenecks.GetN ();
+
+  g_ewmaDelay = 0.9 * g_ewmaDelay + 0.1 * avg;
+  g_ewmaSeries.push_back (std::make_pair (Simulator::Now ().GetSeconds (), g_ewmaDelay));
+
+  if (Simulator::Now ().GetSeconds () >= g_measureStart)
+    {
+      g_delaySum += avg;
+      g_delaySamples++;
+    }
+
+  Simulator::Schedule (interval, &SampleQueues, interval);
+}
+
+void
+LocalDeliverTrace (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface)
+{
+  RemPriceTag tag;
+  if (packet->PeekPacketTag (tag) && Simulator::Now ().GetSeconds () >= g_measureStart)
+    {
+      g_tagPriceSum += tag.GetPathPrice ();
+      g_tagLinksSum += tag.GetNLinks ();
+      g_taggedPackets++;
+    }
+}
+
+ParkingLotResults
+RunParkingLot (std::string queueDiscType, uint32_t nBottlenecks, std::string bottleneckRate,
+               std::string bottleneckDelay, uint32_t queueDiscSize, double simTime)
+{
+  g_bottlenecks = QueueDiscContainer ();
+  g_bottleneckRate = DataRate (bottleneckRate).GetBitRate ();
+  g_measureStart = simTime / 2;
+  g_delaySum = 0;
+  g_delaySamples = 0;
+  g_ewmaDelay = 0;
+  g_ewmaSeries.clear ();
+  g_tagPriceSum = 0;
+  g_tagLinksSum = 0;
+  g_taggedPackets = 0;
+
+  NodeContainer routers;
+  routers.Create (nBottlenecks + 1);
+  NodeContainer hosts;
+  hosts.Create (2);
+  NodeContainer crossSources;
+  crossSources.Create (nBottlenecks);
+  NodeContainer crossSinks;
+  crossSinks.Create (nBottlenecks);
+
+  InternetStackHelper internet;
+  internet.InstallAll ();
+
+  TrafficControlHelper tchBottleneck;
+  if (queueDiscType == "Rem")
+    {
+      tchBottleneck.SetRootQueueDisc ("ns3::RemQueueDisc",
+                                      "LinkBandwidth", StringValue (bottleneckRate),
+                                      "QueueLimit", UintegerValue (queueDiscSize),
+                                      "PathPrice", BooleanValue (true));
+    }
+  else if (queueDiscType == "Red")
+    {
+      tchBottleneck.SetRootQueueDisc ("ns3::RedQueueDisc",
+                                      "LinkBandwidth", StringValue (bottleneckRate),
+                                      "LinkDelay", StringValue (bottleneckDelay),
+                                      "QueueLimit", UintegerValue (queueDiscSize));
+    }
+  else if (queueDiscType == "Pie")
+    {
+      tchBottleneck.SetRootQueueDisc ("ns3::PieQueueDisc",
+                                      "QueueLimit", UintegerValue (queueDiscSize));
+    }
+  else
+    {
+      NS_ABORT_MSG ("--queueDiscType not valid");
+    }
+
+  PointToPointHelper bottleneck;
+  bottleneck.SetDeviceAttribute ("DataRate", StringValue (bottleneckRate));
+  bottleneck.SetChannelAttribute ("Delay", StringValue (bottleneckDelay));
+  // keep the device queues small, so that packets wait in the queue discs
+  bottleneck.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (5));
+
+  PointToPointHelper access;
+  access.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+  access.SetChannelAttribute ("Delay", StringValue ("1ms"));
+
+  Ipv4AddressHelper address;
+  Ipv4InterfaceContainer crossSinkInterfaces;
+  for (uint32_t i = 0; i < nBottlenecks; i++)
+    {
+      NetDeviceContainer devices = bottleneck.Install (routers.Get (i), routers.Get (i + 1));
+      // only the forward direction of the bottleneck links uses the AQM
+      g_bottlenecks.Add (tchBottleneck.Install (devices.Get (0)));
+      std::ostringstream subnet;
+      subnet << "10.1." << i << ".0";
+      address.SetBase (subnet.str ().c_str (), "255.255.255.0");
+      address.Assign (devices);
+
+      devices = access.Install (crossSources.Get (i), routers.Get (i));
+      subnet.str ("");
+      subnet << "10.2." << i << ".0";
+      address.SetBase (subnet.str ().c_str (), "255.255.255.0");
+      address.Assign (devices);
+
+      devices = access.Install (routers.Get (i + 1), crossSinks.Get (i));
+      subnet.str ("");
+      subnet << "10.3." << i << ".0";
+      address.SetBase (subnet.str ().c_str (), "255.255.255.0");
+      crossSinkInterfaces.Add (address.Assign (devices).Get (1));
+    }
+
+  NetDeviceContainer devices = access.Install (hosts.Get (0), routers.Get (0));
+  address.SetBase ("10.4.1.0", "255.255.255.0");
+  address.Assign (devices);
+  devices = access.Install (routers.Get (nBottlenecks), hosts.Get (1));
+  address.SetBase ("10.4.2.0", "255.255.255.0");
+  Ipv4InterfaceContainer longSinkInterface = address.Assign (devices);
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  uint16_t port = 50000;
+  PacketSinkHelper sinkHelper ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+  ApplicationContainer longSink = sinkHelper.Install (hosts.Get (1));
+  ApplicationContainer crossSinkApps = sinkHelper.Install (crossSinks);
+  longSink.Start (Seconds (0));
+  crossSinkApps.Start (Seconds (0));
+
+  BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (longSinkInterface.GetAddress (1), port));
+  ApplicationContainer sources = source.Install (hosts.Get (0));
+  for (uint32_t i = 0; i < nBottlenecks; i++)
+    {
+      source.SetAttribute ("Remote", AddressValue (InetSocketAddress (crossSinkInterfaces.GetAddress (i), port)));
+      sources.Add (source.Install (crossSources.Get (i)));
+    }
+  // stagger the start times to avoid synchronized slow starts
+  Ptr<UniformRandomVariable> startTime = CreateObject<UniformRandomVariable> ();
+  startTime->SetAttribute ("Max", DoubleValue (0.1));
+  for (uint32_t i = 0; i < sources.GetN (); i++)
+    {
+      sources.Get (i)->SetStartTime (Seconds (startTime->GetValue ()));
+    }
+
+  hosts.Get (1)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("LocalDeliver",
+                                                                          MakeCallback (&LocalDeliverTrace));
+
+  Time sampleInterval = MilliSeconds (10);
+  Simulator::Schedule (sampleInterval, &SampleQueues, sampleInterval);
+
+  // goodput is measured over the second half of the run
+  std::vector<uint32_t> rxAtMeasureStart (nBottlenecks + 1);
+  Simulator::Stop (Seconds (g_measureStart));
+  Simulator::Run ();
+  rxAtMeasureStart[0] = DynamicCast<PacketSink> (longSink.Get (0))->GetTotalRx ();
+  for (uint32_t i = 0; i < nBottlenecks; i++)
+    {
+      rxAtMeasureStart[i + 1] = DynamicCast<PacketSink> (crossSinkApps.Get (i))->GetTotalRx ();
+    }
+  Simulator::Stop (Seconds (simTime - g_measureStart));
+  Simulator::Run ();
+
+  ParkingLotResults results;
+  double measureTime = simTime - g_measureStart;
+  results.longFlowGoodput = (DynamicCast<PacketSink> (longSink.Get (0))->GetTotalRx () - rxAtMeasureStart[0])
+    * 8 / measureTime / 1e6;
+  results.crossFlowGoodput = 0;
+  for (uint32_t i = 0; i < nBottlenecks; i++)
+    {
+      results.crossFlowGoodput += (DynamicCast<PacketSink> (crossSinkApps.Get (i))->GetTotalRx () - rxAtMeasureStart[i + 1])
+        * 8 / measureTime / 1e6;
+    }
+  results.crossFlowGoodput /= nBottlenecks;
+
+  results.meanQueueDelay = g_delaySamples ? g_delaySum / g_delaySamples : 0;
+  results.meanPathQueueDelay = results.meanQueueDelay * nBottlenecks;
+
+  double reference = 0;
+  uint32_t nReference = 0;
+  for (uint32_t i = 0; i < g_ewmaSeries.size (); i++)
+    {
+      if (g_ewmaSeries[i].first >= g_measureStart)
+        {
+          reference += g_ewmaSeries[i].second;
+          nReference++;
+        }
+    }
+  reference = nReference ? reference / nReference : 0;
+  results.convergenceTime = 0;
+  for (uint32_t i = 0; i < g_ewmaSeries.size (); i++)
+    {
+      if (std::fabs (g_ewmaSeries[i].second - reference) > 0.2 * reference)
+        {
+          results.convergenceTime = g_ewmaSeries[i].first;
+        }
+    }
+
+  results.meanTagPrice = g_taggedPackets ? g_tagPriceSum / g_taggedPackets : 0;
+  results.meanTagLinks = g_taggedPackets ? g_tagLinksSum / g_taggedPackets : 0;
+  results.sumLinkPrices = 0;
+  if (queueDiscType == "Rem")
+    {
+      for (uint32_t i = 0; i < g_bottlenecks.GetN (); i++)
+        {
+          results.sumLinkPrices += StaticCast<RemQueueDisc> (g_bottlenecks.Get (i))->GetLinkPrice ();
+        }
+    }
+
+  g_bottlenecks = QueueDiscContainer ();
+  Simulator::Destroy ();
+  return results;
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string queueDiscType = "All";
+  uint32_t nBottlenecks = 64;
+  std::string bottleneckRate = "10Mbps";
+  std::string bottleneckDelay = "1ms";
+  uint32_t queueDiscSize = 100;
+  double simTime = 10.0;
+
+  CommandLine cmd;
+  cmd.AddValue ("queueDiscType", "Bottleneck queue disc type in {Rem, Red, Pie, All}", queueDiscType);
+  cmd.AddValue ("nBottlenecks", "Number of bottleneck links crossed by the long flow", nBottlenecks);
+  cmd.AddValue ("bottleneckRate", "Bandwidth of the bottleneck links", bottleneckRate);
+  cmd.AddValue ("bottleneckDelay", "Delay of the bottleneck links", bottleneckDelay);
+  cmd.AddValue ("queueDiscSize", "Bottleneck queue disc limit in packets", queueDiscSize);
+  cmd.AddValue ("simTime", "Simulation time in seconds", simTime);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (nBottlenecks == 0 || nBottlenecks > 255, "nBottlenecks must be between 1 and 255");
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1000));
+  GlobalValue::Bind ("ChecksumEnabled", BooleanValue (false));
+
+  std::vector<std::string> types;
+  if (queueDiscType == "All")
+    {
+      types.push_back ("Rem");
+      types.push_back ("Red");
+      types.push_back ("Pie");
+    }
+  else
+    {
+      types.push_back (queueDiscType);
+    }
+
+  std::cout << nBottlenecks << " bottlenecks of " << bottleneckRate << ", " << simTime << " s" << std::endl;
+  std::cout << std::setw (6) << "qdisc"
+            << std::setw (16) << "delay/hop(ms)"
+            << std::setw (16) << "delay/path(ms)"
+            << std::setw (16) << "converged(s)"
+            << std::setw (16) << "long(Mbps)"
+            << std::setw (16) << "cross(Mbps)" << std::endl;
+
+  for (uint32_t i = 0; i < types.size (); i++)
+    {
+      ParkingLotResults r = RunParkingLot (types[i], nBottlenecks, bottleneckRate, bottleneckDelay,
+                                           queueDiscSize, simTime);
+      std::cout << std::setw (6) << types[i]
+                << std::setw (16) << r.meanQueueDelay * 1000
+                << std::setw (16) << r.meanPathQueueDelay * 1000
+                << std::setw (16) << r.convergenceTime
+                << std::setw (16) << r.longFlowGoodput
+                << std::setw (16) << r.crossFlowGoodput << std::endl;
+      if (types[i] == "Rem")
+        {
+          std::cout << "       path price from tags " << r.meanTagPrice
+                    << " (" << r.meanTagLinks << " links), sum of link prices at the end "
+                    << r.sumLinkPrices << std::endl;
+        }
+    }
+
+  return 0;
+}
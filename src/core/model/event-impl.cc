@@ -20,6 +20,8 @@
 
 #include "event-impl.h"
 #include "log.h"
+#include <atomic>
+#include <new>
 
 /**
  * \file
@@ -31,6 +33,81 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+namespace {
+
+/** Granularity of the size classes of events. */
+const std::size_t EVENT_CLASS_SIZE = 16;
+/** Number of size classes of events. */
+const uint32_t EVENT_N_CLASSES = 8;
+/** Maximum number of free blocks kept per size class and per thread. */
+const uint32_t EVENT_MAX_FREE = 4096;
+
+/** A free block, storing the link to the next free block. */
+struct EventFreeBlock
+{
+  EventFreeBlock *m_next; //!< Next free block
+};
+
+/**
+ * The free lists of a thread.
+ *
+ * This is a POD, hence it is zero-initialized and does not need any
+ * run-time initialization check in the allocation fast path.
+ */
+struct EventImplCache
+{
+  EventFreeBlock *m_free[EVENT_N_CLASSES]; //!< Free list of each size class
+  uint32_t m_nFree[EVENT_N_CLASSES];       //!< Number of free blocks of each size class
+  uint64_t m_nAllocations;                 //!< Number of allocations
+  uint64_t m_nRecycled;                    //!< Number of allocations served from the free lists
+  bool m_registered;                       //!< Whether the cleaner of this thread has been created
+  bool m_closed;                           //!< Whether this thread is exiting
+};
+
+/** The free lists of the current thread. */
+thread_local EventImplCache g_eventCache;
+
+/** Number of allocations of the threads which have exited. */
+std::atomic<uint64_t> g_eventAllocations (0);
+/** Number of recycled allocations of the threads which have exited. */
+std::atomic<uint64_t> g_eventRecycled (0);
+
+/** Release the free blocks of the current thread when it exits. */
+struct EventImplCacheCleaner
+{
+  ~EventImplCacheCleaner ()
+  {
+    EventImplCache &cache = g_eventCache;
+    for (uint32_t i = 0; i < EVENT_N_CLASSES; i++)
+      {
+        while (cache.m_free[i] != 0)
+          {
+            EventFreeBlock *block = cache.m_free[i];
+            cache.m_free[i] = block->m_next;
+            ::operator delete (block);
+          }
+        cache.m_nFree[i] = 0;
+      }
+    g_eventAllocations += cache.m_nAllocations;
+    g_eventRecycled += cache.m_nRecycled;
+    cache.m_nAllocations = 0;
+    cache.m_nRecycled = 0;
+    // events released from now on are freed immediately
+    cache.m_closed = true;
+  }
+};
+
+/** Make sure that the free blocks of the current thread are released when it exits. */
+void
+RegisterEventImplCacheCleaner (void)
+{
+  static thread_local EventImplCacheCleaner cleaner;
+  (void) cleaner;
+  g_eventCache.m_registered = true;
+}
+
+} // unnamed namespace
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
@@ -66,4 +143,78 @@ EventImpl::IsCancelled (void)
   return m_cancel;
 }
 
+void *
+EventImpl::operator new (std::size_t size)
+{
+  EventImplCache &cache = g_eventCache;
+  cache.m_nAllocations++;
+  if (size > EVENT_CLASS_SIZE * EVENT_N_CLASSES)
+    {
+      return ::operator new (size);
+    }
+  uint32_t sizeClass = (size - 1) / EVENT_CLASS_SIZE;
+  EventFreeBlock *block = cache.m_free[sizeClass];
+  if (block != 0)
+    {
+      cache.m_free[sizeClass] = block->m_next;
+      cache.m_nFree[sizeClass]--;
+      cache.m_nRecycled++;
+      return block;
+    }
+  // allocate the size of the class, for the block to be reusable
+  // by any event of the same class
+  return ::operator new ((sizeClass + 1) * EVENT_CLASS_SIZE);
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  EventImplCache &cache = g_eventCache;
+  if (size <= EVENT_CLASS_SIZE * EVENT_N_CLASSES && !cache.m_closed)
+    {
+      uint32_t sizeClass = (size - 1) / EVENT_CLASS_SIZE;
+      if (cache.m_nFree[sizeClass] < EVENT_MAX_FREE)
+        {
+          if (!cache.m_registered)
+            {
+              RegisterEventImplCacheCleaner ();
+            }
+          EventFreeBlock *block = static_cast<EventFreeBlock *> (p);
+          block->m_next = cache.m_free[sizeClass];
+          cache.m_free[sizeClass] = block;
+          cache.m_nFree[sizeClass]++;
+          return;
+        }
+    }
+  ::operator delete (p);
+}
+
+uint64_t
+EventImpl::GetNAllocations (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return g_eventAllocations + g_eventCache.m_nAllocations;
+}
+
+uint64_t
+EventImpl::GetNRecycled (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return g_eventRecycled + g_eventCache.m_nRecycled;
+}
+
+void
+EventImpl::ResetAllocationStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_eventAllocations = 0;
+  g_eventRecycled = 0;
+  g_eventCache.m_nAllocations = 0;
+  g_eventCache.m_nRecycled = 0;
+}
+
 } // namespace ns3
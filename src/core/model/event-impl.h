@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -66,6 +67,44 @@ public:
    */
   bool IsCancelled (void);
 
+  /**
+   * Allocate the memory of an event, from the free list of its
+   * size class if possible.
+   *
+   * \param [in] size The size of the event.
+   * \returns A pointer to the memory.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Release the memory of an event to the free list of its size class.
+   *
+   * \param [in] p The pointer to the memory.
+   * \param [in] size The size of the event.
+   */
+  static void operator delete (void *p, std::size_t size);
+
+  /**
+   * Get the number of events allocated since the start of the program
+   * or the last call to ResetAllocationStats().
+   *
+   * Events allocated by threads which are still running, other than
+   * the calling thread, are not accounted for.
+   *
+   * \returns The number of allocated events.
+   */
+  static uint64_t GetNAllocations (void);
+  /**
+   * Get the number of events whose memory was recycled from a free
+   * list, i.e., the number of calls to the global operator new
+   * which were avoided, since the start of the program or the last
+   * call to ResetAllocationStats().
+   *
+   * \returns The number of recycled events.
+   */
+  static uint64_t GetNRecycled (void);
+  /** Reset the allocation statistics. */
+  static void ResetAllocationStats (void);
+
 protected:
   /**
    * Implementation for Invoke().
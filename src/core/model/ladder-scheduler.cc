@@ -0,0 +1,336 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include <algorithm>
+#include "assert.h"
+#include "log.h"
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+namespace {
+
+/**
+ * \ingroup scheduler
+ * Compare two events in decreasing order, which is the order
+ * of the Bottom list.
+ *
+ * \param [in] a The first event.
+ * \param [in] b The second event.
+ * \returns \c true if \pname{a} is later than \pname{b}.
+ */
+bool
+IsLater (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return b < a;
+}
+
+} // unnamed namespace
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topStart (0),
+    m_topMin (0),
+    m_topMax (0),
+    m_rungs (MAX_RUNGS),
+    m_nRungs (0),
+    m_nEvents (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+LadderScheduler::BucketIndex (const Rung &rung, uint64_t ts) const
+{
+  NS_ASSERT (ts >= rung.m_start);
+  uint64_t index = (ts - rung.m_start) / rung.m_width;
+  // events after the end of the rung are kept in its last bucket
+  return index < rung.m_nBuckets ? static_cast<uint32_t> (index) : rung.m_nBuckets - 1;
+}
+
+uint64_t
+LadderScheduler::CurrentStart (const Rung &rung) const
+{
+  return rung.m_start + rung.m_current * rung.m_width;
+}
+
+uint32_t
+LadderScheduler::FindRung (uint64_t ts) const
+{
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      const Rung &rung = m_rungs[i];
+      // a rung whose buckets have all been consumed may only hold
+      // events earlier than those of the finer rungs
+      if (rung.m_current < rung.m_nBuckets && ts >= CurrentStart (rung))
+        {
+          return i;
+        }
+    }
+  return m_nRungs;
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  uint64_t ts = ev.key.m_ts;
+  m_nEvents++;
+
+  if (ts >= m_topStart)
+    {
+      if (m_top.empty ())
+        {
+          m_topMin = ts;
+          m_topMax = ts;
+        }
+      else
+        {
+          m_topMin = std::min (m_topMin, ts);
+          m_topMax = std::max (m_topMax, ts);
+        }
+      m_top.push_back (ev);
+      return;
+    }
+
+  uint32_t r = FindRung (ts);
+  if (r < m_nRungs)
+    {
+      Rung &rung = m_rungs[r];
+      rung.m_buckets[BucketIndex (rung, ts)].push_back (ev);
+      rung.m_nEvents++;
+      return;
+    }
+
+  m_bottom.insert (std::upper_bound (m_bottom.begin (), m_bottom.end (), ev, IsLater), ev);
+
+  if (m_bottom.size () > MAX_BOTTOM && m_nRungs < MAX_RUNGS
+      && m_bottom.front ().key.m_ts > m_bottom.back ().key.m_ts)
+    {
+      // Keep the cost of the sorted insertions bounded by moving
+      // the Bottom list to a new rung
+      NS_LOG_LOGIC ("spawn rung " << m_nRungs << " from the bottom list");
+      SpawnRung (m_bottom, m_bottom.back ().key.m_ts, m_bottom.front ().key.m_ts + 1);
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  return m_nEvents == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_bottom.empty ())
+    {
+      const_cast<LadderScheduler *> (this)->Refill ();
+    }
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+  Scheduler::Event ev = m_bottom.back ();
+  m_bottom.pop_back ();
+  m_nEvents--;
+  NS_LOG_DEBUG ("remove ts=" << ev.key.m_ts <<
+                ", key=" << ev.key.m_uid <<
+                ", from bottom list, size=" << m_bottom.size ());
+  return ev;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t ts = ev.key.m_ts;
+  m_nEvents--;
+
+  if (ts >= m_topStart)
+    {
+      RemoveFromBucket (m_top, ev);
+      return;
+    }
+
+  uint32_t r = FindRung (ts);
+  if (r < m_nRungs)
+    {
+      Rung &rung = m_rungs[r];
+      RemoveFromBucket (rung.m_buckets[BucketIndex (rung, ts)], ev);
+      rung.m_nEvents--;
+      return;
+    }
+
+  Bucket::iterator i = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, IsLater);
+  NS_ASSERT (i != m_bottom.end () && i->key.m_uid == ev.key.m_uid);
+  NS_ASSERT (ev.impl == i->impl);
+  m_bottom.erase (i);
+}
+
+void
+LadderScheduler::RemoveFromBucket (Bucket &bucket, const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  // search from the end, as cancelled events (e.g., timers which are
+  // restarted) are likely to have been inserted recently
+  for (Bucket::reverse_iterator i = bucket.rbegin (); i != bucket.rend (); ++i)
+    {
+      if (i->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (ev.impl == i->impl);
+          // buckets are not sorted
+          *i = bucket.back ();
+          bucket.pop_back ();
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+void
+LadderScheduler::SpawnRung (Bucket &events, uint64_t start, uint64_t end)
+{
+  NS_LOG_FUNCTION (this << events.size () << start << end);
+  NS_ASSERT (m_nRungs < MAX_RUNGS);
+  NS_ASSERT (end > start && !events.empty ());
+
+  Rung &rung = m_rungs[m_nRungs++];
+  uint64_t span = end - start;
+  rung.m_start = start;
+  rung.m_width = span / events.size () + 1;
+  rung.m_nBuckets = static_cast<uint32_t> ((span - 1) / rung.m_width + 1);
+  rung.m_current = 0;
+  rung.m_nEvents = events.size ();
+  if (rung.m_buckets.size () < rung.m_nBuckets)
+    {
+      rung.m_buckets.resize (rung.m_nBuckets);
+    }
+
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      rung.m_buckets[BucketIndex (rung, i->key.m_ts)].push_back (*i);
+    }
+  events.clear ();
+}
+
+void
+LadderScheduler::MoveToBottom (Bucket &events)
+{
+  NS_LOG_FUNCTION (this << events.size ());
+  NS_ASSERT (m_bottom.empty ());
+  // swap rather than copy to recycle the memory of the buckets
+  m_bottom.swap (events);
+  std::sort (m_bottom.begin (), m_bottom.end (), IsLater);
+}
+
+void
+LadderScheduler::Refill (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (m_bottom.empty ())
+    {
+      if (m_nRungs == 0)
+        {
+          NS_ASSERT (!m_top.empty ());
+          if (m_top.size () <= THRESHOLD || m_topMin == m_topMax)
+            {
+              m_topStart = m_topMax + 1;
+              MoveToBottom (m_top);
+            }
+          else
+            {
+              NS_LOG_LOGIC ("spawn rung 0 from the top list, size=" << m_top.size ());
+              SpawnRung (m_top, m_topMin, m_topMax + 1);
+              m_topStart = m_rungs[0].m_start + m_rungs[0].m_nBuckets * m_rungs[0].m_width;
+            }
+          continue;
+        }
+
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.m_nEvents == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (rung.m_buckets[rung.m_current].empty ())
+        {
+          rung.m_current++;
+        }
+      Bucket &bucket = rung.m_buckets[rung.m_current];
+      rung.m_nEvents -= bucket.size ();
+      rung.m_current++;
+
+      if (bucket.size () > THRESHOLD && m_nRungs < MAX_RUNGS)
+        {
+          uint64_t min = bucket.front ().key.m_ts;
+          uint64_t max = min;
+          for (Bucket::const_iterator i = bucket.begin (); i != bucket.end (); ++i)
+            {
+              min = std::min (min, i->key.m_ts);
+              max = std::max (max, i->key.m_ts);
+            }
+          if (max > min)
+            {
+              NS_LOG_LOGIC ("spawn rung " << m_nRungs << ", size=" << bucket.size ());
+              SpawnRung (bucket, min, max + 1);
+              continue;
+            }
+        }
+      MoveToBottom (bucket);
+    }
+}
+
+} // namespace ns3
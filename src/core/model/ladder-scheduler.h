@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler is a variant of the ladder queue published in
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Tang, Goh and Thng (2005). It is a
+ * hybrid of a calendar queue and a sorted list, which does not need the
+ * resizing heuristics of the calendar queue:
+ *
+ * - events far in the future are appended, unsorted, to the Top list;
+ * - when no earlier event is left, the Top list is spread over the
+ *   buckets of a calendar-like Rung, whose bucket width is derived from
+ *   the time span of the events it receives;
+ * - a bucket holding too many events is spread over a finer child Rung,
+ *   up to a maximum number of rungs;
+ * - the earliest bucket is finally sorted into the Bottom list, from
+ *   which events are removed.
+ *
+ * Only the (small) buckets moved to the Bottom list are ever sorted, hence
+ * insertion and removal take amortized constant time for most event time
+ * distributions, including the highly skewed ones of network simulations
+ * where most events are scheduled a few microseconds ahead and a few
+ * (timers, application start and stop) seconds ahead.
+ *
+ * Buckets are stored in contiguous vectors, which are reused when a rung is
+ * spawned again, so that the scheduler does not allocate memory once it has
+ * reached its steady state.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Ladder bucket type: an unsorted vector of Events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** A rung of the ladder: a calendar of buckets of equal width. */
+  struct Rung
+  {
+    uint64_t m_start;              //!< Timestamp of the start of the first bucket
+    uint64_t m_width;              //!< Width of the buckets, in dimensionless time units
+    uint32_t m_nBuckets;           //!< Number of buckets in use
+    uint32_t m_current;            //!< Index of the first bucket which may be non empty
+    uint32_t m_nEvents;            //!< Number of events in the rung
+    std::vector<Bucket> m_buckets; //!< The buckets (possibly more than in use)
+  };
+
+  /** Maximum number of events moved to a bucket of the Bottom list without spawning a rung. */
+  static const uint32_t THRESHOLD = 50;
+  /** Maximum number of rungs. */
+  static const uint32_t MAX_RUNGS = 8;
+  /** Maximum size of the Bottom list before it is moved to a new rung. */
+  static const uint32_t MAX_BOTTOM = 4 * THRESHOLD;
+
+  /**
+   * Compute the index of the bucket of a rung in which an event is stored.
+   *
+   * \param [in] rung The rung.
+   * \param [in] ts The timestamp of the event.
+   * \returns The bucket index.
+   */
+  inline uint32_t BucketIndex (const Rung &rung, uint64_t ts) const;
+  /**
+   * Timestamp of the start of the current bucket of a rung.
+   *
+   * \param [in] rung The rung.
+   * \returns The timestamp.
+   */
+  inline uint64_t CurrentStart (const Rung &rung) const;
+  /**
+   * Find the rung in which an event earlier than the Top list is stored.
+   *
+   * \param [in] ts The timestamp of the event.
+   * \returns The rung index, or the number of rungs if the event
+   *          belongs to the Bottom list.
+   */
+  uint32_t FindRung (uint64_t ts) const;
+  /**
+   * Spawn a new rung, finer than all the existing ones, and
+   * move a set of events to it.
+   *
+   * \param [in,out] events The events, cleared on return.
+   * \param [in] start The timestamp of the start of the rung.
+   * \param [in] end The timestamp of the end of the rung.
+   */
+  void SpawnRung (Bucket &events, uint64_t start, uint64_t end);
+  /**
+   * Move a set of events to the Bottom list and sort it.
+   *
+   * \param [in,out] events The events, cleared on return.
+   */
+  void MoveToBottom (Bucket &events);
+  /** Refill the Bottom list from the rungs or from the Top list. */
+  void Refill (void);
+  /**
+   * Remove an event from an unsorted bucket.
+   *
+   * \param [in,out] bucket The bucket.
+   * \param [in] ev The event to remove.
+   */
+  void RemoveFromBucket (Bucket &bucket, const Scheduler::Event &ev);
+
+  /** The Top list: unsorted events at or after m_topStart. */
+  Bucket m_top;
+  /** Timestamp from which events are stored in the Top list. */
+  uint64_t m_topStart;
+  /** Minimum timestamp in the Top list. */
+  uint64_t m_topMin;
+  /** Maximum timestamp in the Top list. */
+  uint64_t m_topMax;
+  /** The rungs, from the coarsest to the finest. */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs in use. */
+  uint32_t m_nRungs;
+  /** The Bottom list, sorted by decreasing timestamp. */
+  Bucket m_bottom;
+  /** Number of events in the scheduler. */
+  uint32_t m_nEvents;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
@@ -0,0 +1,784 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "simulator.h"
+#include "multithreaded-simulator-impl.h"
+#include "scheduler.h"
+#include "event-impl.h"
+#include "config.h"
+#include "uinteger.h"
+
+#include "ptr.h"
+#include "pointer.h"
+#include "assert.h"
+#include "log.h"
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+/**
+ * \file
+ * \ingroup simulator
+ * Implementation of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+// Note:  Logging in this file is largely avoided due to the
+// number of calls that are made to these functions and the possibility
+// of causing recursions leading to stack overflow
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+namespace {
+
+/** Timestamp of an empty partition. */
+const uint64_t NO_EVENT = std::numeric_limits<uint64_t>::max ();
+
+/** Number of times the barrier is polled before yielding the processor. */
+const uint32_t BARRIER_SPIN = 1000;
+
+/**
+ * \ingroup simulator
+ * The partition executed by the calling thread, if any.
+ *
+ * The partition identifies the simulator it belongs to, which is checked
+ * by MultithreadedSimulatorImpl::GetCurrentPartition, hence the opaque type.
+ */
+thread_local void *t_partition = 0;
+
+/**
+ * \ingroup simulator
+ * The number of MultithreadedSimulatorImpl instances.
+ */
+std::atomic<uint32_t> g_nInstances (0);
+
+/**
+ * \ingroup simulator
+ * Add two timestamps, saturating at NO_EVENT.
+ *
+ * \param [in] a The first timestamp.
+ * \param [in] b The second timestamp.
+ * \returns The sum.
+ */
+uint64_t
+SaturatingAdd (uint64_t a, uint64_t b)
+{
+  return a > NO_EVENT - b ? NO_EVENT : a + b;
+}
+
+} // unnamed namespace
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Core")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("ThreadCount",
+                   "The number of partitions, each executed by its own thread. "
+                   "0 selects the number of hardware threads.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_threadCount),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("LookAhead",
+                   "The minimum delay of the events scheduled from a partition "
+                   "to another. 0 selects the minimum Delay attribute of the "
+                   "channels of the simulation.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&MultithreadedSimulatorImpl::m_lookAheadAttribute),
+                   MakeTimeChecker (Seconds (0)))
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_threadCount (0),
+    m_lookAhead (0),
+    m_started (false),
+    m_running (false),
+    m_stop (false),
+    m_stopTs (NO_EVENT),
+    m_currentTs (0),
+    m_currentContext (Simulator::NO_CONTEXT),
+    m_nWindows (0),
+    m_barrierCount (0),
+    m_barrierSense (false),
+    m_runGeneration (0),
+    m_nRunning (0),
+    m_exit (false)
+{
+  NS_LOG_FUNCTION (this);
+  g_nInstances++;
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+  g_nInstances--;
+}
+
+bool
+MultithreadedSimulatorImpl::IsInUse (void)
+{
+  return g_nInstances.load (std::memory_order_relaxed) != 0;
+}
+
+bool
+MultithreadedSimulatorImpl::GetNextStreamIndex (uint64_t &index)
+{
+  Partition *partition = static_cast<Partition *> (t_partition);
+  if (partition == 0 || partition->m_currentContext == Simulator::NO_CONTEXT)
+    {
+      return false;
+    }
+  // 2^32 streams per context, in [2^62, 2^63) for the first 2^30 contexts
+  uint32_t context = partition->m_currentContext;
+  NS_ASSERT_MSG (context < (1U << 30), "Context " << context << " has no stream index range");
+  uint64_t n = partition->m_nStreams[context]++;
+  NS_ASSERT_MSG (n < (1ULL << 32), "Too many streams allocated by context " << context);
+  index = (1ULL << 62) + (static_cast<uint64_t> (context) << 32) + n;
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::NotifyConstructionCompleted (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t n = m_threadCount;
+  if (n == 0)
+    {
+      n = std::max (std::thread::hardware_concurrency (), 1u);
+    }
+  NS_LOG_INFO ("partitions: " << n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Partition *partition = new Partition;
+      partition->m_impl = this;
+      partition->m_index = i;
+      partition->m_currentTs = 0;
+      partition->m_currentContext = Simulator::NO_CONTEXT;
+      // uids are allocated from 4.
+      // uid 0 is "invalid" events
+      // uid 1 is "now" events
+      // uid 2 is "destroy" events
+      partition->m_uid = 4;
+      partition->m_currentUid = 0;
+      partition->m_sequence = 0;
+      partition->m_stop = false;
+      partition->m_barrierSense = false;
+      partition->m_nEvents = 0;
+      partition->m_inbound.store (0);
+      m_partitions.push_back (partition);
+    }
+  m_windowState.resize (n);
+  m_barrierCount.store (n);
+  SimulatorImpl::NotifyConstructionCompleted ();
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_started)
+    {
+      {
+        std::lock_guard<std::mutex> lock (m_runMutex);
+        m_exit = true;
+      }
+      m_runCondition.notify_all ();
+      for (uint32_t i = 1; i < m_partitions.size (); i++)
+        {
+          m_partitions[i]->m_thread->Join ();
+          m_partitions[i]->m_thread = 0;
+        }
+    }
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      Partition *partition = m_partitions[i];
+      ProcessInbound (partition);
+      while (!partition->m_events->IsEmpty ())
+        {
+          Scheduler::Event next = partition->m_events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      partition->m_events = 0;
+      delete partition;
+    }
+  m_partitions.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_ASSERT_MSG (!m_running, "Cannot change the scheduler during Simulator::Run");
+  m_schedulerFactory = schedulerFactory;
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      Partition *partition = m_partitions[i];
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      if (partition->m_events != 0)
+        {
+          while (!partition->m_events->IsEmpty ())
+            {
+              Scheduler::Event next = partition->m_events->RemoveNext ();
+              scheduler->Insert (next);
+            }
+        }
+      partition->m_events = scheduler;
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  // Packet uids include the system id: the partitions must allocate
+  // disjoint uids
+  Partition *partition = GetCurrentPartition ();
+  return partition != 0 ? partition->m_index : 0;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetNPartitions (void) const
+{
+  return m_partitions.size ();
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartition (uint32_t context) const
+{
+  return context % m_partitions.size ();
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookAhead (void) const
+{
+  return TimeStep (m_lookAhead);
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrentPartition (void) const
+{
+  Partition *partition = static_cast<Partition *> (t_partition);
+  if (partition != 0 && partition->m_impl == this)
+    {
+      return partition;
+    }
+  return 0;
+}
+
+Scheduler::Event
+MultithreadedSimulatorImpl::Insert (Partition *partition, EventImpl *event, uint64_t ts, uint32_t context)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = partition->m_uid;
+  partition->m_uid++;
+  partition->m_events->Insert (ev);
+  return ev;
+}
+
+void
+MultithreadedSimulatorImpl::ProcessInbound (Partition *partition)
+{
+  InboundEvent *head = partition->m_inbound.exchange (0, std::memory_order_acquire);
+  if (head == 0)
+    {
+      return;
+    }
+  std::vector<InboundEvent *> events;
+  for (InboundEvent *i = head; i != 0; i = i->m_next)
+    {
+      events.push_back (i);
+    }
+  // the order in which the threads appended the events is not
+  // deterministic, unlike the order of their senders
+  std::sort (events.begin (), events.end (),
+             [] (const InboundEvent *a, const InboundEvent *b)
+             {
+               if (a->m_ts != b->m_ts)
+                 {
+                   return a->m_ts < b->m_ts;
+                 }
+               if (a->m_source != b->m_source)
+                 {
+                   return a->m_source < b->m_source;
+                 }
+               return a->m_sequence < b->m_sequence;
+             });
+  for (std::vector<InboundEvent *>::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      Insert (partition, (*i)->m_impl, (*i)->m_ts, (*i)->m_context);
+      delete *i;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Barrier (Partition *partition)
+{
+  partition->m_barrierSense = !partition->m_barrierSense;
+  if (m_barrierCount.fetch_sub (1, std::memory_order_acq_rel) == 1)
+    {
+      // last partition to reach the barrier: release the others
+      m_barrierCount.store (m_partitions.size (), std::memory_order_relaxed);
+      m_barrierSense.store (partition->m_barrierSense, std::memory_order_release);
+      return;
+    }
+  uint32_t spin = 0;
+  while (m_barrierSense.load (std::memory_order_acquire) != partition->m_barrierSense)
+    {
+      if (++spin >= BARRIER_SPIN)
+        {
+          std::this_thread::yield ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::RunPartition (Partition *partition)
+{
+  t_partition = partition;
+  WindowState &state = m_windowState[partition->m_index];
+  for (;;)
+    {
+      ProcessInbound (partition);
+      state.m_nextTs = partition->m_events->IsEmpty () ?
+        NO_EVENT : partition->m_events->PeekNext ().key.m_ts;
+      state.m_stop = partition->m_stop;
+      Barrier (partition);
+
+      // All the partitions compute the same window from the same state
+      uint64_t lbts = NO_EVENT;
+      bool stop = false;
+      for (std::vector<WindowState>::const_iterator i = m_windowState.begin ();
+           i != m_windowState.end (); ++i)
+        {
+          lbts = std::min (lbts, i->m_nextTs);
+          stop = stop || i->m_stop;
+        }
+      if (stop || lbts == NO_EVENT || lbts >= m_stopTs)
+        {
+          break;
+        }
+      if (partition->m_index == 0)
+        {
+          m_nWindows++;
+        }
+
+      // No event can be received from another partition before the end
+      // of the window
+      uint64_t end = std::min (SaturatingAdd (lbts, m_lookAhead), m_stopTs);
+      while (!partition->m_stop && !partition->m_events->IsEmpty ()
+             && partition->m_events->PeekNext ().key.m_ts < end)
+        {
+          Scheduler::Event next = partition->m_events->RemoveNext ();
+          NS_ASSERT (next.key.m_ts >= partition->m_currentTs);
+          partition->m_currentTs = next.key.m_ts;
+          partition->m_currentContext = next.key.m_context;
+          partition->m_currentUid = next.key.m_uid;
+          partition->m_nEvents++;
+          next.impl->Invoke ();
+          next.impl->Unref ();
+        }
+      Barrier (partition);
+    }
+  t_partition = 0;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::ComputeLookAhead (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_lookAheadAttribute.IsZero ())
+    {
+      return m_lookAheadAttribute.GetTimeStep ();
+    }
+  if (m_partitions.size () == 1)
+    {
+      return NO_EVENT;
+    }
+  uint64_t lookAhead = NO_EVENT;
+  Config::MatchContainer channels = Config::LookupMatches ("/ChannelList/*");
+  for (Config::MatchContainer::Iterator i = channels.Begin (); i != channels.End (); ++i)
+    {
+      TimeValue delay;
+      if ((*i)->GetAttributeFailSafe ("Delay", delay))
+        {
+          lookAhead = std::min<uint64_t> (lookAhead, delay.Get ().GetTimeStep ());
+        }
+    }
+  if (lookAhead == 0 || lookAhead == NO_EVENT)
+    {
+      NS_FATAL_ERROR ("No channel with a positive Delay attribute: "
+                      "set the LookAhead attribute of MultithreadedSimulatorImpl");
+    }
+  return lookAhead;
+}
+
+void
+MultithreadedSimulatorImpl::Partition::Work (void)
+{
+  uint32_t generation = 0;
+  for (;;)
+    {
+      {
+        std::unique_lock<std::mutex> lock (m_impl->m_runMutex);
+        while (!m_impl->m_exit && m_impl->m_runGeneration == generation)
+          {
+            m_impl->m_runCondition.wait (lock);
+          }
+        if (m_impl->m_exit)
+          {
+            return;
+          }
+        generation = m_impl->m_runGeneration;
+      }
+      m_impl->RunPartition (this);
+      {
+        std::lock_guard<std::mutex> lock (m_impl->m_runMutex);
+        m_impl->m_nRunning--;
+      }
+      m_impl->m_runCondition.notify_all ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Start (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_lookAhead = ComputeLookAhead ();
+  NS_LOG_INFO ("lookahead: " << TimeStep (m_lookAhead).As (Time::US));
+  // The threads are kept until the simulator is destroyed, rather than
+  // created by each call to Run, as the packet uids are counted by thread
+  for (uint32_t i = 1; i < m_partitions.size (); i++)
+    {
+      Partition *partition = m_partitions[i];
+      partition->m_thread = Create<SystemThread> (MakeCallback (&Partition::Work, partition));
+      partition->m_thread->Start ();
+    }
+  m_started = true;
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (GetCurrentPartition () == 0, "Simulator::Run called by an event");
+  if (!m_started)
+    {
+      Start ();
+    }
+  m_stop = false;
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      m_partitions[i]->m_stop = false;
+    }
+
+  m_running = true;
+  {
+    std::lock_guard<std::mutex> lock (m_runMutex);
+    m_nRunning = m_partitions.size () - 1;
+    m_runGeneration++;
+  }
+  m_runCondition.notify_all ();
+  RunPartition (m_partitions[0]);
+  {
+    std::unique_lock<std::mutex> lock (m_runMutex);
+    while (m_nRunning != 0)
+      {
+        m_runCondition.wait (lock);
+      }
+  }
+  m_running = false;
+
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      Partition *partition = m_partitions[i];
+      ProcessInbound (partition);
+      m_stop = m_stop || partition->m_stop;
+      m_currentTs = std::max (m_currentTs, partition->m_currentTs);
+      NS_LOG_INFO ("partition " << i << ": " << partition->m_nEvents << " events");
+    }
+  NS_LOG_INFO ("synchronization windows: " << m_nWindows);
+  if (!m_stop && m_stopTs != NO_EVENT)
+    {
+      // Like the event scheduled by Stop (delay) with the other
+      // implementations, the stop time is reached even if no event
+      // is left before it
+      m_stop = true;
+      m_currentTs = std::max (m_currentTs, m_stopTs);
+      m_stopTs = NO_EVENT;
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop)
+    {
+      return true;
+    }
+  for (uint32_t i = 0; i < m_partitions.size (); i++)
+    {
+      if (!m_partitions[i]->m_events->IsEmpty ()
+          || m_partitions[i]->m_inbound.load () != 0)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  Partition *partition = GetCurrentPartition ();
+  if (partition != 0)
+    {
+      partition->m_stop = true;
+    }
+  else
+    {
+      m_stop = true;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  if (GetCurrentPartition () != 0)
+    {
+      Simulator::Schedule (delay, &Simulator::Stop);
+      return;
+    }
+  // Stop all the partitions at the same time, before the events
+  // scheduled at or after the stop time
+  uint64_t ts = m_currentTs + delay.GetTimeStep ();
+  m_stopTs = std::min (m_stopTs, ts);
+}
+
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_ASSERT_MSG (!m_running || GetCurrentPartition () != 0,
+                 "Simulator::Schedule Thread-unsafe invocation!");
+  Time tAbsolute = delay + Now ();
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= Now ());
+  uint32_t context = GetContext ();
+  Partition *partition = m_partitions[GetPartition (context)];
+  Scheduler::Event ev = Insert (partition, event, tAbsolute.GetTimeStep (), context);
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  Partition *target = m_partitions[GetPartition (context)];
+  Partition *partition = GetCurrentPartition ();
+  if (partition == 0)
+    {
+      NS_ASSERT_MSG (!m_running, "Simulator::ScheduleWithContext Thread-unsafe invocation!");
+      Insert (target, event, m_currentTs + delay.GetTimeStep (), context);
+      return;
+    }
+  uint64_t ts = partition->m_currentTs + delay.GetTimeStep ();
+  if (target == partition)
+    {
+      Insert (partition, event, ts, context);
+      return;
+    }
+  if (static_cast<uint64_t> (delay.GetTimeStep ()) < m_lookAhead)
+    {
+      NS_FATAL_ERROR ("Event scheduled in context " << context << " with delay " <<
+                      delay.As (Time::NS) << ", below the lookahead " <<
+                      GetLookAhead ().As (Time::NS));
+    }
+  InboundEvent *inbound = new InboundEvent;
+  inbound->m_impl = event;
+  inbound->m_ts = ts;
+  inbound->m_context = context;
+  inbound->m_source = partition->m_index;
+  inbound->m_sequence = partition->m_sequence++;
+  inbound->m_next = target->m_inbound.load (std::memory_order_relaxed);
+  while (!target->m_inbound.compare_exchange_weak (inbound->m_next, inbound,
+                                                   std::memory_order_release,
+                                                   std::memory_order_relaxed))
+    {
+    }
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return Schedule (TimeStep (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  CriticalSection cs (m_destroyMutex);
+  EventId id (Ptr<EventImpl> (event, false), Now ().GetTimeStep (), 0xffffffff, 2);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  Partition *partition = GetCurrentPartition ();
+  return TimeStep (partition != 0 ? partition->m_currentTs : m_currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs ()) - Now ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *partition = m_partitions[GetPartition (id.GetContext ())];
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  partition->m_events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0 ||
+          id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (m_destroyMutex);
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  if (id.PeekEventImpl () == 0)
+    {
+      return true;
+    }
+  // Only the partition of an event knows whether it has been executed
+  Partition *partition = m_partitions[GetPartition (id.GetContext ())];
+  NS_ASSERT_MSG (!m_running || partition == GetCurrentPartition (),
+                 "Event of context " << id.GetContext () << " accessed from another partition");
+  if (id.GetTs () < partition->m_currentTs ||
+      (id.GetTs () == partition->m_currentTs &&
+       id.GetUid () <= partition->m_currentUid) ||
+      id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  Partition *partition = GetCurrentPartition ();
+  return partition != 0 ? partition->m_currentContext : m_currentContext;
+}
+
+} // namespace ns3
@@ -0,0 +1,291 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "simulator-impl.h"
+#include "scheduler.h"
+#include "event-impl.h"
+#include "system-thread.h"
+#include "system-mutex.h"
+#include "nstime.h"
+
+#include "ptr.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <mutex>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup simulator
+ * Declaration of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ *
+ * \brief A conservative parallel simulator implementation running
+ * in a single process, with one thread per partition.
+ *
+ * The events are partitioned by context, i.e., by node: the events of
+ * context \c c are executed by partition <tt>c % ThreadCount</tt>, each
+ * partition having its own event list and its own thread. The partitions
+ * execute in parallel all the events of a synchronization window, which
+ * starts at the earliest pending event of all the partitions and lasts
+ * for the lookahead, i.e., the minimum delay of the events scheduled from
+ * a partition to another. The partitions synchronize with a barrier at
+ * the end of each window.
+ *
+ * The lookahead is, by default, the minimum \c Delay attribute of the
+ * channels of the simulation (e.g., PointToPointChannel::Delay), and it
+ * can be set with the LookAhead attribute. Scheduling an event in another
+ * partition with a delay shorter than the lookahead is a fatal error.
+ *
+ * The events scheduled in another partition are appended to a lock-free
+ * inbound queue of the target partition, which inserts them in its event
+ * list at the end of the window, sorted by timestamp, source partition and
+ * order of scheduling in the source partition, and the random variable
+ * streams created during the run are numbered by context (see
+ * GetNextStreamIndex). Hence, the results of a simulation do not depend on
+ * the scheduling of the threads. Events with
+ * the same timestamp are not necessarily executed in the same order as
+ * with the DefaultSimulatorImpl, though.
+ *
+ * The models must not share state across nodes (e.g., trace sinks
+ * connected to the nodes of different partitions), or must protect it.
+ * Simulator::Stop stops the calling partition immediately and the other
+ * partitions at the end of the current synchronization window.
+ * Simulator::GetSystemId returns the index of the calling partition.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * Check whether a MultithreadedSimulatorImpl exists, in which case the
+   * models may be executed by several threads. This allows the models to
+   * skip what they only need for thread safety (e.g., copying a packet
+   * handed to another node) with the other simulator implementations.
+   *
+   * \returns \c true if a MultithreadedSimulatorImpl exists.
+   */
+  static bool IsInUse (void);
+
+  /**
+   * Get the next automatically assigned stream index of the context of
+   * the event executed by the calling thread.
+   *
+   * The random variable streams created while the partitions run in
+   * parallel (e.g., by applications or sockets created at run time)
+   * cannot number their streams with the global counter of the
+   * RngSeedManager, as the order of the calls would depend on the
+   * scheduling of the threads. Each context numbers its own streams
+   * instead, in a range of the automatic stream indices starting at
+   * 2^62, so that the streams do not depend on the number of threads
+   * either. The events without a context use the global counter, as
+   * they are all executed by the same partition.
+   *
+   * \param [out] index The stream index.
+   * 
+eturns \c true if \p index was set, i.e., if the calling thread
+   *          executes an event with a context in a partition.
+   */
+  static bool GetNextStreamIndex (uint64_t &index);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (const Time &delay);
+  virtual EventId Schedule (const Time &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, const Time &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * Get the number of partitions, i.e., of threads.
+   *
+   * \returns The number of partitions.
+   */
+  uint32_t GetNPartitions (void) const;
+  /**
+   * Get the partition executing the events of a context.
+   *
+   * \param [in] context The context.
+   * \returns The partition index.
+   */
+  uint32_t GetPartition (uint32_t context) const;
+  /**
+   * Get the lookahead used for the synchronization windows.
+   *
+   * The lookahead is computed when Run() is first called.
+   *
+   * \returns The lookahead.
+   */
+  Time GetLookAhead (void) const;
+
+private:
+  virtual void DoDispose (void);
+  virtual void NotifyConstructionCompleted (void);
+
+  /** An event scheduled by a partition in another partition. */
+  struct InboundEvent
+  {
+    EventImpl *m_impl;      //!< The event
+    uint64_t m_ts;          //!< The timestamp of the event
+    uint32_t m_context;     //!< The context of the event
+    uint32_t m_source;      //!< The index of the source partition
+    uint64_t m_sequence;    //!< The order of the event in the source partition
+    InboundEvent *m_next;   //!< The next event of the inbound queue
+  };
+
+  /** The state of a partition. */
+  struct Partition
+  {
+    MultithreadedSimulatorImpl *m_impl;      //!< The simulator
+    uint32_t m_index;                        //!< The index of the partition
+    Ptr<Scheduler> m_events;                 //!< The event list
+    uint64_t m_currentTs;                    //!< Timestamp of the current event
+    uint32_t m_currentContext;               //!< Context of the current event
+    uint32_t m_currentUid;                   //!< Uid of the current event
+    uint32_t m_uid;                          //!< Next event uid
+    uint64_t m_sequence;                     //!< Number of events sent to the other partitions
+    bool m_stop;                             //!< Whether Stop was called by this partition
+    bool m_barrierSense;                     //!< The sense of the barrier for this partition
+    uint64_t m_nEvents;                      //!< Number of events executed
+    std::map<uint32_t, uint64_t> m_nStreams; //!< Number of stream indices allocated by each context
+    std::atomic<InboundEvent *> m_inbound;   //!< The events sent by the other partitions
+    Ptr<SystemThread> m_thread;              //!< The thread of the partition (except for the first one)
+
+    /** Worker thread entry point. */
+    void Work (void);
+  };
+
+  /** State published by each partition at the start of each window. */
+  struct WindowState
+  {
+    uint64_t m_nextTs;    //!< Timestamp of the next event of the partition
+    bool m_stop;          //!< Whether the partition called Stop
+  };
+
+  /**
+   * Insert an event in the event list of a partition.
+   *
+   * \param [in] partition The partition.
+   * \param [in] event The event.
+   * \param [in] ts The timestamp of the event.
+   * \param [in] context The context of the event.
+   * \returns The inserted event.
+   */
+  Scheduler::Event Insert (Partition *partition, EventImpl *event, uint64_t ts, uint32_t context);
+  /**
+   * Move the events sent by the other partitions to the event list.
+   *
+   * \param [in] partition The partition.
+   */
+  void ProcessInbound (Partition *partition);
+  /**
+   * Execute the events of a partition until the end of the simulation.
+   *
+   * \param [in] partition The partition.
+   */
+  void RunPartition (Partition *partition);
+  /**
+   * Wait for all the partitions to reach the barrier.
+   *
+   * \param [in] partition The calling partition.
+   */
+  void Barrier (Partition *partition);
+  /** Compute the lookahead and start the threads of the partitions. */
+  void Start (void);
+  /**
+   * Compute the lookahead from the delays of the channels.
+   *
+   * \returns The lookahead, in time steps.
+   */
+  uint64_t ComputeLookAhead (void) const;
+  /**
+   * Get the partition of the calling thread, if it is executing
+   * a partition of this simulator.
+   *
+   * \returns The partition, or 0.
+   */
+  Partition * GetCurrentPartition (void) const;
+
+  /** Container type for the events to run at Simulator::Destroy(). */
+  typedef std::list<EventId> DestroyEvents;
+  /** The container of events to run at Destroy. */
+  DestroyEvents m_destroyEvents;
+  /** Mutex protecting the destroy events. */
+  mutable SystemMutex m_destroyMutex;
+
+  std::vector<Partition *> m_partitions;  //!< The partitions
+  std::vector<WindowState> m_windowState; //!< The state published by the partitions
+  uint32_t m_threadCount;                 //!< The ThreadCount attribute
+  Time m_lookAheadAttribute;              //!< The LookAhead attribute
+  uint64_t m_lookAhead;                   //!< The lookahead, in time steps
+  ObjectFactory m_schedulerFactory;       //!< The factory of the event lists
+
+  bool m_started;                         //!< Whether the threads have been started
+  bool m_running;                         //!< Whether Run is executing
+  bool m_stop;                            //!< Whether the last Run was stopped
+  uint64_t m_stopTs;                      //!< Timestamp at which the next Run stops
+  uint64_t m_currentTs;                   //!< The current time outside of Run
+  uint32_t m_currentContext;              //!< The current context outside of Run
+  uint64_t m_nWindows;                    //!< Number of synchronization windows
+
+  std::atomic<uint32_t> m_barrierCount;   //!< Number of partitions yet to reach the barrier
+  std::atomic<bool> m_barrierSense;       //!< The sense of the current barrier
+
+  std::mutex m_runMutex;                  //!< Mutex protecting the run state of the workers
+  std::condition_variable m_runCondition; //!< Condition signalled when the run state changes
+  uint32_t m_runGeneration;               //!< Incremented by each call to Run
+  uint32_t m_nRunning;                    //!< Number of workers executing a Run
+  bool m_exit;                            //!< Whether the workers must exit
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
@@ -23,6 +23,9 @@
 #include "integer.h"
 #include "config.h"
 #include "log.h"
+#include "multithreaded-simulator-impl.h"
+
+#include <atomic>
 
 /**
  * \file
@@ -39,7 +42,7 @@ NS_LOG_COMPONENT_DEFINE ("RngSeedManager");
  * The next random number generator stream number to use
  * for automatic assignment.
  */
-static uint64_t g_nextStreamIndex = 0;
+static std::atomic<uint64_t> g_nextStreamIndex (0);
 /**
  * \relates RngSeedManager
  * The random number generator seed number global value.  This is used to
@@ -100,9 +103,12 @@ uint64_t RngSeedManager::GetRun ()
 uint64_t RngSeedManager::GetNextStreamIndex (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  uint64_t next = g_nextStreamIndex;
-  g_nextStreamIndex++;
-  return next;
+  uint64_t next;
+  if (MultithreadedSimulatorImpl::GetNextStreamIndex (next))
+    {
+      return next;
+    }
+  return g_nextStreamIndex.fetch_add (1, std::memory_order_relaxed);
 }
 
 } // namespace ns3
@@ -101,6 +101,13 @@ public:
 
   /**
    * Get the next automatically assigned stream index.
+   *
+   * The indices are numbered by a global counter, except in the events
+   * executed by the partitions of a MultithreadedSimulatorImpl, where
+   * each context numbers its own streams (see
+   * MultithreadedSimulatorImpl::GetNextStreamIndex) so that the streams
+   * do not depend on the scheduling of the threads.
+   *
    * \returns The next stream index.
    */
   static uint64_t GetNextStreamIndex(void);
@@ -77,6 +77,22 @@ static GlobalValue g_schedTypeImpl = GlobalValue ("SchedulerType",
                                                   TypeIdValue (MapScheduler::GetTypeId ()),
                                                   MakeTypeIdChecker ());
 
+/**
+ * \ingroup simulator
+ * Whether Simulator::Run was called since the simulation was created.
+ */
+static bool g_hasRun = false;
+/**
+ * \ingroup simulator
+ * EventImpl::GetNAllocations at the first Simulator::Run of the current simulation.
+ */
+static uint64_t g_nAllocationsAtRun = 0;
+/**
+ * \ingroup simulator
+ * EventImpl::GetNRecycled at the first Simulator::Run of the current simulation.
+ */
+static uint64_t g_nRecycledAtRun = 0;
+
 /**
  * \ingroup logging
  * Default TimePrinter implementation.
@@ -203,6 +219,20 @@ Simulator::Destroy (void)
    */
   LogSetTimePrinter (0);
   LogSetNodePrinter (0);
+  if (g_hasRun)
+    {
+      // The counters span the whole program: report this simulation only
+      uint64_t nRecycled = EventImpl::GetNRecycled () - g_nRecycledAtRun;
+      NS_LOG_INFO ("Events allocated while running: " << EventImpl::GetNAllocations () - g_nAllocationsAtRun <<
+                   ", recycled: " << nRecycled);
+      double seconds = (*pimpl)->Now ().GetSeconds ();
+      if (seconds > 0)
+        {
+          NS_LOG_INFO ("Event allocations avoided per simulated second: " <<
+                       nRecycled / seconds);
+        }
+      g_hasRun = false;
+    }
   (*pimpl)->Destroy ();
   (*pimpl)->Unref ();
   *pimpl = 0;
@@ -227,6 +257,12 @@ Simulator::Run (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
   Time::ClearMarkedTimes ();
+  if (!g_hasRun)
+    {
+      g_hasRun = true;
+      g_nAllocationsAtRun = EventImpl::GetNAllocations ();
+      g_nRecycledAtRun = EventImpl::GetNRecycled ();
+    }
   GetImpl ()->Run ();
 }
 
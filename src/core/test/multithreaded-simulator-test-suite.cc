@@ -0,0 +1,308 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup core-tests
+ *
+ * Check that MultithreadedSimulatorImpl executes the same events as
+ * DefaultSimulatorImpl, each in its context, and that its results do
+ * not depend on the scheduling of the threads.
+ *
+ * Chains of events hop from context to context with pseudo-random
+ * delays. Each event is a pure function of its parameters, so that the
+ * set of events executed in each context does not depend on the order of
+ * the events with the same timestamp.
+ */
+class MultithreadedSimulatorEventsTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   *
+   * \param [in] threads The number of threads.
+   */
+  MultithreadedSimulatorEventsTestCase (uint32_t threads);
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /** The events executed in a context: (timestamp, value). */
+  typedef std::vector<std::pair<uint64_t, uint32_t> > Log;
+
+  /**
+   * Run the simulation with a simulator implementation.
+   *
+   * \param [in] simulatorType The simulator implementation.
+   * \returns The events executed in each context.
+   */
+  std::vector<Log> RunSimulation (std::string simulatorType);
+  /**
+   * Execute a hop of a chain of events.
+   *
+   * \param [in] value The value of the event.
+   */
+  void Hop (uint32_t value);
+  /** An event which must have been removed. */
+  void Removed (void);
+
+  uint32_t m_threads;                     //!< The number of threads
+  std::vector<Log> m_logs;                //!< The events executed in each context
+  std::atomic<uint32_t> m_nRemoved;       //!< Number of removed events executed
+  std::atomic<uint32_t> m_nWrongContext;  //!< Number of events executed in another context
+};
+
+/** Number of contexts. */
+static const uint32_t N_CONTEXTS = 13;
+/** The lookahead, in nanoseconds. */
+static const uint32_t LOOKAHEAD = 1000;
+/** The end of the simulation, in nanoseconds. */
+static const uint32_t DURATION = 2000000;
+
+MultithreadedSimulatorEventsTestCase::MultithreadedSimulatorEventsTestCase (uint32_t threads)
+  : TestCase ("Check that MultithreadedSimulatorImpl with " + std::to_string (threads) +
+              " threads executes the same events as DefaultSimulatorImpl"),
+    m_threads (threads)
+{
+}
+
+void
+MultithreadedSimulatorEventsTestCase::Hop (uint32_t value)
+{
+  uint32_t context = Simulator::GetContext ();
+  if (context >= N_CONTEXTS || value % N_CONTEXTS != context)
+    {
+      m_nWrongContext++;
+      return;
+    }
+  m_logs[context].push_back (std::make_pair (Simulator::Now ().GetTimeStep (), value));
+
+  // an event removed or cancelled before it expires
+  EventId removed = Simulator::Schedule (NanoSeconds (1), &MultithreadedSimulatorEventsTestCase::Removed, this);
+  if (value & 1)
+    {
+      Simulator::Remove (removed);
+    }
+  else
+    {
+      Simulator::Cancel (removed);
+    }
+
+  // next hop: simple linear congruential generator
+  uint32_t next = value * 1103515245 + 12345;
+  uint32_t r = (next >> 8) & 0xffffff;
+  uint32_t nextContext = next % N_CONTEXTS;
+  uint64_t delay;
+  if (nextContext == context)
+    {
+      delay = r % (3 * LOOKAHEAD);
+      Simulator::Schedule (NanoSeconds (delay), &MultithreadedSimulatorEventsTestCase::Hop, this, next);
+    }
+  else
+    {
+      delay = LOOKAHEAD + r % (2 * LOOKAHEAD);
+      Simulator::ScheduleWithContext (nextContext, NanoSeconds (delay),
+                                      &MultithreadedSimulatorEventsTestCase::Hop, this, next);
+    }
+}
+
+void
+MultithreadedSimulatorEventsTestCase::Removed (void)
+{
+  m_nRemoved++;
+}
+
+std::vector<MultithreadedSimulatorEventsTestCase::Log>
+MultithreadedSimulatorEventsTestCase::RunSimulation (std::string simulatorType)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (simulatorType));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (m_threads));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::LookAhead", TimeValue (NanoSeconds (LOOKAHEAD)));
+  m_logs.assign (N_CONTEXTS, Log ());
+  m_nRemoved = 0;
+  m_nWrongContext = 0;
+
+  for (uint32_t value = 0; value < 10 * N_CONTEXTS; value++)
+    {
+      Simulator::ScheduleWithContext (value % N_CONTEXTS, NanoSeconds (value),
+                                      &MultithreadedSimulatorEventsTestCase::Hop, this, value);
+    }
+  Simulator::Stop (NanoSeconds (DURATION));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), NanoSeconds (DURATION), "Wrong time at the end of " << simulatorType);
+  NS_TEST_EXPECT_MSG_EQ (Simulator::IsFinished (), true, "Simulation not finished with " << simulatorType);
+  NS_TEST_EXPECT_MSG_EQ (m_nRemoved, 0, "Removed events executed with " << simulatorType);
+  NS_TEST_EXPECT_MSG_EQ (m_nWrongContext, 0, "Events executed in the wrong context with " << simulatorType);
+  Simulator::Destroy ();
+  return m_logs;
+}
+
+void
+MultithreadedSimulatorEventsTestCase::DoRun (void)
+{
+  std::vector<Log> expected = RunSimulation ("ns3::DefaultSimulatorImpl");
+  std::vector<Log> first = RunSimulation ("ns3::MultithreadedSimulatorImpl");
+  std::vector<Log> second = RunSimulation ("ns3::MultithreadedSimulatorImpl");
+
+  for (uint32_t i = 0; i < N_CONTEXTS; i++)
+    {
+      // deterministic, including the order of the events with the same timestamp
+      NS_TEST_ASSERT_MSG_EQ ((first[i] == second[i]), true, "Different runs in context " << i);
+      NS_TEST_ASSERT_MSG_GT (expected[i].size (), 1000, "Too few events in context " << i);
+      std::sort (expected[i].begin (), expected[i].end ());
+      std::sort (first[i].begin (), first[i].end ());
+      NS_TEST_ASSERT_MSG_EQ (first[i].size (), expected[i].size (), "Wrong number of events in context " << i);
+      NS_TEST_ASSERT_MSG_EQ ((first[i] == expected[i]), true, "Wrong events in context " << i);
+    }
+}
+
+void
+MultithreadedSimulatorEventsTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (0));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::LookAhead", TimeValue (Seconds (0)));
+}
+
+/**
+ * \ingroup core-tests
+ *
+ * Check the time and the partition seen by the events executed with
+ * MultithreadedSimulatorImpl, and the Stop semantics.
+ */
+class MultithreadedSimulatorStopTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorStopTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Check the state of the simulator seen by an event.
+   *
+   * \param [in] context The expected context.
+   * \param [in] ts The expected time, in nanoseconds.
+   */
+  void Check (uint32_t context, uint64_t ts);
+  /** Stop the partition of the calling event. */
+  void Stop (void);
+
+  Ptr<MultithreadedSimulatorImpl> m_impl;  //!< The simulator
+  std::atomic<uint32_t> m_nErrors;         //!< Number of errors
+  std::atomic<uint32_t> m_nEvents;         //!< Number of events executed
+};
+
+MultithreadedSimulatorStopTestCase::MultithreadedSimulatorStopTestCase ()
+  : TestCase ("Check the context, time, system id and Stop of MultithreadedSimulatorImpl")
+{
+}
+
+void
+MultithreadedSimulatorStopTestCase::Check (uint32_t context, uint64_t ts)
+{
+  m_nEvents++;
+  if (Simulator::GetContext () != context
+      || Simulator::Now () != NanoSeconds (ts)
+      || Simulator::GetSystemId () != m_impl->GetPartition (context))
+    {
+      m_nErrors++;
+    }
+}
+
+void
+MultithreadedSimulatorStopTestCase::Stop (void)
+{
+  Simulator::Stop ();
+}
+
+void
+MultithreadedSimulatorStopTestCase::DoRun (void)
+{
+  m_impl = CreateObjectWithAttributes<MultithreadedSimulatorImpl> ("ThreadCount", UintegerValue (3),
+                                                                   "LookAhead", TimeValue (MicroSeconds (1)));
+  Simulator::SetImplementation (m_impl);
+  NS_TEST_ASSERT_MSG_EQ (m_impl->GetNPartitions (), 3, "Wrong number of partitions");
+  m_nErrors = 0;
+  m_nEvents = 0;
+
+  for (uint32_t context = 0; context < 6; context++)
+    {
+      for (uint64_t ts = 1000; ts <= 10000; ts += 1000)
+        {
+          Simulator::ScheduleWithContext (context, NanoSeconds (ts),
+                                          &MultithreadedSimulatorStopTestCase::Check, this, context, ts);
+        }
+    }
+  // stop all the partitions before the events at 5 us
+  Simulator::Stop (MicroSeconds (5));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_nEvents, 24, "Wrong number of events executed before the stop time");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), MicroSeconds (5), "Wrong time after the stop time");
+  NS_TEST_EXPECT_MSG_EQ (m_impl->GetLookAhead (), MicroSeconds (1), "Wrong lookahead");
+
+  // the simulation can be resumed, and stopped by an event
+  Simulator::ScheduleWithContext (1, MicroSeconds (2) + NanoSeconds (1),
+                                  &MultithreadedSimulatorStopTestCase::Stop, this);
+  Simulator::Run ();
+  // the partition of context 1 stops after its events at 7 us, the other
+  // partitions at the end of the synchronization window [7 us, 8 us)
+  NS_TEST_EXPECT_MSG_EQ (m_nEvents, 42, "Wrong number of events executed before Stop");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::IsFinished (), true, "Simulation not stopped");
+
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_nEvents, 60, "Wrong number of events executed");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::IsFinished (), true, "Simulation not finished");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), MicroSeconds (10), "Wrong time at the end");
+  NS_TEST_EXPECT_MSG_EQ (m_nErrors, 0, "Wrong state seen by the events");
+  Simulator::Destroy ();
+  m_impl = 0;
+}
+
+/**
+ * \ingroup core-tests
+ *
+ * The MultithreadedSimulatorImpl TestSuite.
+ */
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ()
+    : TestSuite ("multithreaded-simulator")
+  {
+    AddTestCase (new MultithreadedSimulatorEventsTestCase (1), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorEventsTestCase (2), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorEventsTestCase (4), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorEventsTestCase (8), TestCase::QUICK);
+    AddTestCase (new MultithreadedSimulatorStopTestCase, TestCase::QUICK);
+  }
+} g_multithreadedSimulatorTestSuite; //!< Static variable for test initialization
@@ -23,6 +23,7 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
 
 using namespace ns3;
 
@@ -459,6 +460,185 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * Insert, cancel and remove a large number of events with a skewed
+ * distribution of timestamps, directly into a scheduler and into a
+ * MapScheduler, and check that the events are removed in the same order.
+ */
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+private:
+  uint32_t Rand (void);
+  uint64_t Delay (void);
+  ObjectFactory m_schedulerFactory;
+  uint32_t m_seed;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check that " + schedulerFactory.GetTypeId ().GetName () + " removes events in order"),
+    m_schedulerFactory (schedulerFactory),
+    m_seed (1)
+{
+}
+
+uint32_t
+SchedulerOrderTestCase::Rand (void)
+{
+  // simple linear congruential generator, to be independent of the RNG streams
+  m_seed = m_seed * 1103515245 + 12345;
+  return (m_seed >> 8) & 0xffffff;
+}
+
+uint64_t
+SchedulerOrderTestCase::Delay (void)
+{
+  uint32_t p = Rand () % 100;
+  if (p < 5)
+    {
+      return 0;
+    }
+  else if (p < 85)
+    {
+      return Rand () % 2000;
+    }
+  else if (p < 98)
+    {
+      return 1000000 + Rand () % 10000000;
+    }
+  return 1000000000 + Rand ();
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  Ptr<Scheduler> reference = CreateObject<MapScheduler> ();
+  std::vector<Scheduler::Event> pending;
+  uint64_t now = 0;
+  uint32_t uid = 0;
+  uint32_t nErrors = 0;
+
+  for (uint32_t i = 0; i < 200000; i++)
+    {
+      uint32_t op = Rand () % 100;
+      if (op < 50 || pending.size () < 1000)
+        {
+          Scheduler::Event ev;
+          ev.impl = 0;
+          ev.key.m_ts = now + Delay ();
+          ev.key.m_uid = uid++;
+          ev.key.m_context = 0;
+          scheduler->Insert (ev);
+          reference->Insert (ev);
+          pending.push_back (ev);
+        }
+      else if (op < 60)
+        {
+          uint32_t index = Rand () % pending.size ();
+          scheduler->Remove (pending[index]);
+          reference->Remove (pending[index]);
+          pending[index] = pending.back ();
+          pending.pop_back ();
+        }
+      else
+        {
+          Scheduler::Event next = reference->RemoveNext ();
+          Scheduler::Event ev = scheduler->RemoveNext ();
+          nErrors += (ev.key.m_uid != next.key.m_uid) ? 1 : 0;
+          now = next.key.m_ts;
+          for (uint32_t j = 0; j < pending.size (); j++)
+            {
+              if (pending[j].key.m_uid == next.key.m_uid)
+                {
+                  pending[j] = pending.back ();
+                  pending.pop_back ();
+                  break;
+                }
+            }
+        }
+    }
+  while (!reference->IsEmpty ())
+    {
+      NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), false, "Scheduler should not be empty");
+      nErrors += (scheduler->RemoveNext ().key.m_uid != reference->RemoveNext ().key.m_uid) ? 1 : 0;
+    }
+  NS_TEST_EXPECT_MSG_EQ (scheduler->IsEmpty (), true, "Scheduler should be empty");
+  NS_TEST_EXPECT_MSG_EQ (nErrors, 0, "Events should be removed in the same order as with MapScheduler");
+}
+
+/**
+ * Check that the memory of the events is recycled.
+ */
+class EventImplRecyclingTestCase : public TestCase
+{
+public:
+  EventImplRecyclingTestCase ();
+  virtual void DoRun (void);
+  /** A large event argument. */
+  struct Large
+  {
+    char m_data[200]; ///< data
+  };
+  void Small (int a);
+  void Big (Large l);
+};
+
+EventImplRecyclingTestCase::EventImplRecyclingTestCase ()
+  : TestCase ("Check that the memory of the events is recycled")
+{
+}
+
+void
+EventImplRecyclingTestCase::Small (int a)
+{
+}
+
+void
+EventImplRecyclingTestCase::Big (Large l)
+{
+}
+
+void
+EventImplRecyclingTestCase::DoRun (void)
+{
+  EventImpl *ev = MakeEvent (&EventImplRecyclingTestCase::Small, this, 1);
+  void *p = ev;
+  ev->Unref ();
+  EventImpl::ResetAllocationStats ();
+  ev = MakeEvent (&EventImplRecyclingTestCase::Small, this, 2);
+  NS_TEST_EXPECT_MSG_EQ (static_cast<void *> (ev), p, "The memory of the event should be reused");
+  ev->Unref ();
+  NS_TEST_EXPECT_MSG_EQ (EventImpl::GetNAllocations (), 1, "One event should have been allocated");
+  NS_TEST_EXPECT_MSG_EQ (EventImpl::GetNRecycled (), 1, "The event should have been recycled");
+
+  // events larger than the largest size class are not recycled
+  Large l;
+  ev = MakeEvent (&EventImplRecyclingTestCase::Big, this, l);
+  ev->Unref ();
+  ev = MakeEvent (&EventImplRecyclingTestCase::Big, this, l);
+  ev->Unref ();
+  NS_TEST_EXPECT_MSG_EQ (EventImpl::GetNAllocations (), 3, "Three events should have been allocated");
+  NS_TEST_EXPECT_MSG_EQ (EventImpl::GetNRecycled (), 1, "Large events should not be recycled");
+
+  // the events scheduled by a simulation are recycled
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &EventImplRecyclingTestCase::Small, this, i);
+      Simulator::Schedule (MicroSeconds (i), &EventImplRecyclingTestCase::Big, this, l);
+    }
+  Simulator::Run ();
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &EventImplRecyclingTestCase::Small, this, i);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_GT (EventImpl::GetNRecycled (), 100, "The events of the second run should be recycled");
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +655,13 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+    AddTestCase (new EventImplRecyclingTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
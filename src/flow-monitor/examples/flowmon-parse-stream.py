@@ -0,0 +1,109 @@
+## -*- Mode: python; py-indent-offset: 4; indent-tabs-mode: nil; coding: utf-8; -*-
+##
+## Reads a file written by ns3::FlowStatsExporter, in CSV or binary
+## format, and prints the totals of each flow, or with --intervals the
+## totals of each interval.
+##
+## Usage: python flowmon-parse-stream.py [--intervals] FILE
+
+from __future__ import division
+from __future__ import print_function
+import struct
+import sys
+
+## Names of the columns, in file order
+COLUMNS = ['time', 'flowId', 'txPackets', 'rxPackets', 'lostPackets', 'timesForwarded',
+           'packetsDropped', 'txBytes', 'rxBytes', 'bytesDropped', 'delaySum', 'jitterSum']
+## struct formats of the columns of a binary block, after the time
+BINARY_COLUMN_FORMATS = ['I'] * 6 + ['Q'] * 3 + ['q'] * 2
+## Magic at the start of a binary file
+BINARY_MAGIC = b'ns3flows'
+
+
+def read_binary(file_obj):
+    '''Yield the rows of a binary file, one block at a time.
+    @param file_obj The file, positioned after the magic.
+    @return A generator of dicts keyed by column name.
+    '''
+    version, = struct.unpack('<I', file_obj.read(4))
+    if version != 1:
+        raise ValueError("unsupported version %d" % version)
+    while True:
+        header = file_obj.read(12)
+        if len(header) < 12:
+            return
+        time, rows = struct.unpack('<qI', header)
+        columns = []
+        for fmt in BINARY_COLUMN_FORMATS:
+            size = struct.calcsize('<' + fmt) * rows
+            columns.append(struct.unpack('<%d%s' % (rows, fmt), file_obj.read(size)))
+        for i in range(rows):
+            row = {'time': time}
+            for name, column in zip(COLUMNS[1:], columns):
+                row[name] = column[i]
+            yield row
+
+
+def read_csv(file_obj):
+    '''Yield the rows of a CSV file.
+    @param file_obj The file, positioned after the header line.
+    @return A generator of dicts keyed by column name.
+    '''
+    for line in file_obj:
+        fields = line.decode('ascii').strip().split(',')
+        if len(fields) == len(COLUMNS):
+            yield dict(zip(COLUMNS, [int(f) for f in fields]))
+
+
+def read_rows(file_obj):
+    '''Yield the rows of a file written by FlowStatsExporter.
+    @param file_obj The file, opened in binary mode.
+    @return A generator of dicts keyed by column name.
+    '''
+    if file_obj.read(len(BINARY_MAGIC)) == BINARY_MAGIC:
+        return read_binary(file_obj)
+    file_obj.seek(0)
+    header = file_obj.readline().decode('ascii').strip().split(',')
+    if header != COLUMNS:
+        raise ValueError("not a FlowStatsExporter file")
+    return read_csv(file_obj)
+
+
+def add(totals, key, row):
+    '''Add the counters of a row to the totals of a key.
+    @param totals The totals, a dict keyed by key.
+    @param key The key.
+    @param row The row.
+    '''
+    total = totals.setdefault(key, dict((name, 0) for name in COLUMNS[2:]))
+    for name in COLUMNS[2:]:
+        total[name] += row[name]
+
+
+def main(argv):
+    by_interval = '--intervals' in argv[1:]
+    file_names = [arg for arg in argv[1:] if arg != '--intervals']
+    if len(file_names) != 1:
+        print("usage: %s [--intervals] FILE" % argv[0], file=sys.stderr)
+        return 1
+    totals = {}
+    with open(file_names[0], 'rb') as file_obj:
+        for row in read_rows(file_obj):
+            add(totals, row['time'] if by_interval else row['flowId'], row)
+    print("%s txPackets rxPackets lostPackets txBytes rxBytes meanDelay(s)"
+          % ('time(s)' if by_interval else 'flowId'))
+    for key in sorted(totals):
+        total = totals[key]
+        if total['rxPackets']:
+            delay = "%.6f" % (total['delaySum'] / total['rxPackets'] * 1e-9)
+        else:
+            delay = "-"
+        print("%s %d %d %d %d %d %s"
+              % ("%.3f" % (key * 1e-9) if by_interval else key,
+                 total['txPackets'], total['rxPackets'], total['lostPackets'],
+                 total['txBytes'], total['rxBytes'], delay))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
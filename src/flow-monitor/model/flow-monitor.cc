@@ -22,6 +22,7 @@
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/double.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
@@ -80,7 +81,9 @@ FlowMonitor::GetInstanceTypeId (void) const
 }
 
 FlowMonitor::FlowMonitor ()
-  : m_enabled (false)
+  : m_flowStatsDirty (false),
+    m_trackedPacketsCount (0),
+    m_enabled (false)
 {
   // m_histogramBinWidth=DEFAULT_BIN_WIDTH;
 }
@@ -105,11 +108,16 @@ FlowMonitor::DoDispose (void)
 inline FlowMonitor::FlowStats&
 FlowMonitor::GetStatsForFlow (FlowId flowId)
 {
-  FlowStatsContainerI iter;
-  iter = m_flowStats.find (flowId);
-  if (iter == m_flowStats.end ())
+  m_flowStatsDirty = true;
+  if (flowId >= m_flowStatsValid.size ())
     {
-      FlowMonitor::FlowStats &ref = m_flowStats[flowId];
+      m_flowStatsVector.resize (flowId + 1);
+      m_flowStatsValid.resize (flowId + 1, false);
+    }
+  FlowMonitor::FlowStats &ref = m_flowStatsVector[flowId];
+  if (!m_flowStatsValid[flowId])
+    {
+      m_flowStatsValid[flowId] = true;
       ref.delaySum = Seconds (0);
       ref.jitterSum = Seconds (0);
       ref.lastDelay = Seconds (0);
@@ -123,12 +131,97 @@ FlowMonitor::GetStatsForFlow (FlowId flowId)
       ref.jitterHistogram.SetDefaultBinWidth (m_jitterBinWidth);
       ref.packetSizeHistogram.SetDefaultBinWidth (m_packetSizeBinWidth);
       ref.flowInterruptionsHistogram.SetDefaultBinWidth (m_flowInterruptionsBinWidth);
-      return ref;
     }
-  else
+  return ref;
+}
+
+inline uint32_t
+FlowMonitor::GetTrackedPacketHome (FlowId flowId, FlowPacketId packetId) const
+{
+  // Fibonacci hashing of the pair, keeping the high bits
+  uint64_t key = (static_cast<uint64_t> (flowId) << 32) | packetId;
+  uint64_t h = key * 0x9e3779b97f4a7c15ULL;
+  return static_cast<uint32_t> (h >> 32) & (m_trackedPackets.size () - 1);
+}
+
+FlowMonitor::TrackedPacketSlot*
+FlowMonitor::FindTrackedPacket (FlowId flowId, FlowPacketId packetId)
+{
+  if (m_trackedPacketsCount == 0)
     {
-      return iter->second;
+      return 0;
     }
+  uint32_t mask = m_trackedPackets.size () - 1;
+  for (uint32_t i = GetTrackedPacketHome (flowId, packetId); m_trackedPackets[i].used; i = (i + 1) & mask)
+    {
+      if (m_trackedPackets[i].flowId == flowId && m_trackedPackets[i].packetId == packetId)
+        {
+          return &m_trackedPackets[i];
+        }
+    }
+  return 0;
+}
+
+FlowMonitor::TrackedPacket&
+FlowMonitor::InsertTrackedPacket (FlowId flowId, FlowPacketId packetId)
+{
+  // Keep the load factor at most 1/2
+  if (2 * (m_trackedPacketsCount + 1) > m_trackedPackets.size ())
+    {
+      std::vector<TrackedPacketSlot> old;
+      old.swap (m_trackedPackets);
+      TrackedPacketSlot empty;
+      empty.used = false;
+      m_trackedPackets.assign (std::max<std::size_t> (64, 2 * old.size ()), empty);
+      uint32_t mask = m_trackedPackets.size () - 1;
+      for (std::vector<TrackedPacketSlot>::const_iterator it = old.begin (); it != old.end (); ++it)
+        {
+          if (it->used)
+            {
+              uint32_t i = GetTrackedPacketHome (it->flowId, it->packetId);
+              while (m_trackedPackets[i].used)
+                {
+                  i = (i + 1) & mask;
+                }
+              m_trackedPackets[i] = *it;
+            }
+        }
+    }
+
+  uint32_t mask = m_trackedPackets.size () - 1;
+  uint32_t i = GetTrackedPacketHome (flowId, packetId);
+  for (; m_trackedPackets[i].used; i = (i + 1) & mask)
+    {
+      if (m_trackedPackets[i].flowId == flowId && m_trackedPackets[i].packetId == packetId)
+        {
+          return m_trackedPackets[i].packet;
+        }
+    }
+  m_trackedPackets[i].flowId = flowId;
+  m_trackedPackets[i].packetId = packetId;
+  m_trackedPackets[i].used = true;
+  m_trackedPacketsCount++;
+  return m_trackedPackets[i].packet;
+}
+
+void
+FlowMonitor::EraseTrackedPacket (TrackedPacketSlot *slot)
+{
+  // Backward shift deletion: move back the packets of the probe sequence
+  // that follows the hole, unless their home slot lies after the hole
+  uint32_t mask = m_trackedPackets.size () - 1;
+  uint32_t hole = slot - &m_trackedPackets[0];
+  for (uint32_t i = (hole + 1) & mask; m_trackedPackets[i].used; i = (i + 1) & mask)
+    {
+      uint32_t home = GetTrackedPacketHome (m_trackedPackets[i].flowId, m_trackedPackets[i].packetId);
+      if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+          m_trackedPackets[hole] = m_trackedPackets[i];
+          hole = i;
+        }
+    }
+  m_trackedPackets[hole].used = false;
+  m_trackedPacketsCount--;
 }
 
 
@@ -140,7 +233,7 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
       return;
     }
   Time now = Simulator::Now ();
-  TrackedPacket &tracked = m_trackedPackets[std::make_pair (flowId, packetId)];
+  TrackedPacket &tracked = InsertTrackedPacket (flowId, packetId);
   tracked.firstSeenTime = now;
   tracked.lastSeenTime = tracked.firstSeenTime;
   tracked.timesForwarded = 0;
@@ -167,19 +260,18 @@ FlowMonitor::ReportForwarding (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t p
     {
       return;
     }
-  std::pair<FlowId, FlowPacketId> key (flowId, packetId);
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (key);
-  if (tracked == m_trackedPackets.end ())
+  TrackedPacketSlot *tracked = FindTrackedPacket (flowId, packetId);
+  if (tracked == 0)
     {
       NS_LOG_WARN ("Received packet forward report (flowId=" << flowId << ", packetId=" << packetId
                                                              << ") but not known to be transmitted.");
       return;
     }
 
-  tracked->second.timesForwarded++;
-  tracked->second.lastSeenTime = Simulator::Now ();
+  tracked->packet.timesForwarded++;
+  tracked->packet.lastSeenTime = Simulator::Now ();
 
-  Time delay = (Simulator::Now () - tracked->second.firstSeenTime);
+  Time delay = (Simulator::Now () - tracked->packet.firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 }
 
@@ -191,8 +283,8 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     {
       return;
     }
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked == m_trackedPackets.end ())
+  TrackedPacketSlot *tracked = FindTrackedPacket (flowId, packetId);
+  if (tracked == 0)
     {
       NS_LOG_WARN ("Received packet last-tx report (flowId=" << flowId << ", packetId=" << packetId
                                                              << ") but not known to be transmitted.");
@@ -200,7 +292,7 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     }
 
   Time now = Simulator::Now ();
-  Time delay = (now - tracked->second.firstSeenTime);
+  Time delay = (now - tracked->packet.firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 
   FlowStats &stats = GetStatsForFlow (flowId);
@@ -239,12 +331,12 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
         }
     }
   stats.timeLastRxPacket = now;
-  stats.timesForwarded += tracked->second.timesForwarded;
+  stats.timesForwarded += tracked->packet.timesForwarded;
 
   NS_LOG_DEBUG ("ReportLastTx: removing tracked packet (flowId="
                 << flowId << ", packetId=" << packetId << ").");
 
-  m_trackedPackets.erase (tracked); // we don't need to track this packet anymore
+  EraseTrackedPacket (tracked); // we don't need to track this packet anymore
 }
 
 void
@@ -269,45 +361,76 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
   stats.bytesDropped[reasonCode] += packetSize;
   NS_LOG_DEBUG ("++stats.packetsDropped[" << reasonCode<< "]; // becomes: " << stats.packetsDropped[reasonCode]);
 
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked != m_trackedPackets.end ())
+  TrackedPacketSlot *tracked = FindTrackedPacket (flowId, packetId);
+  if (tracked != 0)
     {
       // we don't need to track this packet anymore
       // FIXME: this will not necessarily be true with broadcast/multicast
       NS_LOG_DEBUG ("ReportDrop: removing tracked packet (flowId="
                     << flowId << ", packetId=" << packetId << ").");
-      m_trackedPackets.erase (tracked);
+      EraseTrackedPacket (tracked);
     }
 }
 
 const FlowMonitor::FlowStatsContainer&
 FlowMonitor::GetFlowStats () const
 {
+  if (m_flowStatsDirty)
+    {
+      m_flowStats.clear ();
+      for (FlowId flowId = 0; flowId < m_flowStatsValid.size (); flowId++)
+        {
+          if (m_flowStatsValid[flowId])
+            {
+              m_flowStats.insert (m_flowStats.end (), std::make_pair (flowId, m_flowStatsVector[flowId]));
+            }
+        }
+      m_flowStatsDirty = false;
+    }
   return m_flowStats;
 }
 
+const FlowMonitor::FlowStats*
+FlowMonitor::FindFlowStats (FlowId flowId) const
+{
+  if (flowId < m_flowStatsValid.size () && m_flowStatsValid[flowId])
+    {
+      return &m_flowStatsVector[flowId];
+    }
+  return 0;
+}
+
+FlowId
+FlowMonitor::GetFlowIdLimit () const
+{
+  return m_flowStatsValid.size ();
+}
+
 
 void
 FlowMonitor::CheckForLostPackets (Time maxDelay)
 {
   Time now = Simulator::Now ();
 
-  for (TrackedPacketMap::iterator iter = m_trackedPackets.begin ();
-       iter != m_trackedPackets.end (); )
+  // Erasing a packet may move a later packet into its slot, which is then
+  // checked again; packets are only moved backward along their probe
+  // sequence, so none is skipped
+  for (uint32_t i = 0; i < m_trackedPackets.size (); )
     {
-      if (now - iter->second.lastSeenTime >= maxDelay)
+      TrackedPacketSlot &slot = m_trackedPackets[i];
+      if (slot.used && now - slot.packet.lastSeenTime >= maxDelay)
         {
           // packet is considered lost, add it to the loss statistics
-          FlowStatsContainerI flow = m_flowStats.find (iter->first.first);
-          NS_ASSERT (flow != m_flowStats.end ());
-          flow->second.lostPackets++;
+          NS_ASSERT (slot.flowId < m_flowStatsValid.size () && m_flowStatsValid[slot.flowId]);
+          m_flowStatsVector[slot.flowId].lostPackets++;
+          m_flowStatsDirty = true;
 
           // we won't track it anymore
-          m_trackedPackets.erase (iter++);
+          EraseTrackedPacket (&slot);
         }
       else
         {
-          iter++;
+          i++;
         }
     }
 }
@@ -406,8 +529,9 @@ FlowMonitor::SerializeToXmlStream (std::ostream &os, uint16_t indent, bool enabl
   indent += 2;
   os << std::string ( indent, ' ' ) << "<FlowStats>\n";
   indent += 2;
-  for (FlowStatsContainerCI flowI = m_flowStats.begin ();
-       flowI != m_flowStats.end (); flowI++)
+  const FlowStatsContainer &flowStats = GetFlowStats ();
+  for (FlowStatsContainerCI flowI = flowStats.begin ();
+       flowI != flowStats.end (); flowI++)
     {
       os << std::string ( indent, ' ' );
 #define ATTRIB(name) << " " # name "=\"" << flowI->second.name << "\""
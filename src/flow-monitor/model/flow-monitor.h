@@ -46,6 +46,12 @@ namespace ns3 {
  * The FlowMonitor class is responsible for coordinating efforts
  * regarding probes, and collects end-to-end flow statistics.
  *
+ * The statistics are stored in a vector indexed by FlowId (the classifiers
+ * assign consecutive identifiers), and the packets in transit in an
+ * open-addressed hash table, so that the cost of each probe report does not
+ * grow with the number of flows. The std::map returned by GetFlowStats is
+ * built from the vector when it is requested.
+ *
  */
 class FlowMonitor : public Object
 {
@@ -228,10 +234,20 @@ public:
   /// Retrieve all collected the flow statistics.  Note, if the
   /// FlowMonitor has not stopped monitoring yet, you should call
   /// CheckForLostPackets() to make sure all possibly lost packets are
-  /// accounted for.
+  /// accounted for.  The returned container is a snapshot, updated
+  /// by each call, which costs time linear in the number of flows.
   /// \returns the flows statistics
   const FlowStatsContainer& GetFlowStats () const;
 
+  /// Get the statistics of a single flow, without building the
+  /// container returned by GetFlowStats
+  /// \param flowId the flow identification
+  /// \returns the statistics of the flow, or 0 if it has none
+  const FlowStats* FindFlowStats (FlowId flowId) const;
+
+  /// \returns a FlowId larger than that of every flow with statistics
+  FlowId GetFlowIdLimit () const;
+
   /// Get a list of all FlowProbe's associated with this FlowMonitor
   /// \returns a list of all the probes
   const FlowProbeContainer& GetAllProbes () const;
@@ -272,12 +288,26 @@ private:
     uint32_t timesForwarded; //!< number of times the packet was reportedly forwarded
   };
 
-  /// FlowId --> FlowStats
-  FlowStatsContainer m_flowStats;
+  /// Slot of the tracked packets hash table
+  struct TrackedPacketSlot
+  {
+    FlowId flowId;         //!< flow of the packet
+    FlowPacketId packetId; //!< packet identifier within the flow
+    bool used;             //!< true if the slot holds a packet
+    TrackedPacket packet;  //!< the tracked packet
+  };
 
-  /// (FlowId,PacketId) --> TrackedPacket
-  typedef std::map< std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
-  TrackedPacketMap m_trackedPackets; //!< Tracked packets
+  /// FlowId --> FlowStats, valid only where m_flowStatsValid is set
+  std::vector<FlowStats> m_flowStatsVector;
+  std::vector<bool> m_flowStatsValid; //!< FlowId --> stats exist for the flow
+  /// FlowId --> FlowStats, built from m_flowStatsVector by GetFlowStats
+  mutable FlowStatsContainer m_flowStats;
+  mutable bool m_flowStatsDirty; //!< m_flowStats must be rebuilt
+
+  /// (FlowId,PacketId) --> TrackedPacket, open-addressed with linear
+  /// probing; the size is zero or a power of two
+  std::vector<TrackedPacketSlot> m_trackedPackets;
+  uint32_t m_trackedPacketsCount; //!< Number of used slots in m_trackedPackets
   Time m_maxPerHopDelay; //!< Minimum per-hop delay
   FlowProbeContainer m_flowProbes; //!< all the FlowProbes
 
@@ -298,6 +328,30 @@ private:
   /// \returns the stats of the flow
   FlowStats& GetStatsForFlow (FlowId flowId);
 
+  /// Get the home slot of a packet in m_trackedPackets
+  /// \param flowId the Flow identification
+  /// \param packetId the packet identification
+  /// \returns the first slot to probe
+  uint32_t GetTrackedPacketHome (FlowId flowId, FlowPacketId packetId) const;
+
+  /// Find a tracked packet
+  /// \param flowId the Flow identification
+  /// \param packetId the packet identification
+  /// \returns the slot of the packet, or 0 if the packet is not tracked
+  TrackedPacketSlot* FindTrackedPacket (FlowId flowId, FlowPacketId packetId);
+
+  /// Start tracking a packet, or find it if it is already tracked
+  /// \param flowId the Flow identification
+  /// \param packetId the packet identification
+  /// \returns the tracked packet
+  TrackedPacket& InsertTrackedPacket (FlowId flowId, FlowPacketId packetId);
+
+  /// Stop tracking a packet.  The packets that follow it in its probe
+  /// sequence are moved backward, so the slot may hold another packet
+  /// after the call.
+  /// \param slot the slot of the packet
+  void EraseTrackedPacket (TrackedPacketSlot *slot);
+
   /// Periodic function to check for lost packets and prune statistics
   void PeriodicCheckForLostPackets ();
 };
@@ -22,6 +22,7 @@
 #define FLOW_PROBE_H
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 #include "ns3/object.h"
@@ -104,7 +105,8 @@ public:
 
 protected:
   Ptr<FlowMonitor> m_flowMonitor; //!< the FlowMonitor instance
-  Stats m_stats; //!< The flow stats
+  /// The flow stats, in a hash table since a probe usually sees few of the flows
+  std::unordered_map<FlowId, FlowStats> m_stats;
 
 };
 
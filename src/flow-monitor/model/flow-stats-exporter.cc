@@ -0,0 +1,387 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "flow-stats-exporter.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/string.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FlowStatsExporter");
+
+NS_OBJECT_ENSURE_REGISTERED (FlowStatsExporter);
+
+/// Magic at the start of a binary file
+static const char FLOW_STATS_MAGIC[8] = { 'n', 's', '3', 'f', 'l', 'o', 'w', 's' };
+/// Version of the binary format
+static const uint32_t FLOW_STATS_VERSION = 1;
+/// Size of a row in the binary format
+static const uint32_t FLOW_STATS_ROW_SIZE = 6 * 4 + 5 * 8;
+
+/**
+ * Append an integer to a string in little endian order
+ * \param out the string
+ * \param value the integer
+ * \param bytes the number of bytes to append
+ */
+static void
+AppendLittleEndian (std::string &out, uint64_t value, uint32_t bytes)
+{
+  for (uint32_t i = 0; i < bytes; i++)
+    {
+      out.push_back (static_cast<char> ((value >> (8 * i)) & 0xff));
+    }
+}
+
+/**
+ * Append an unsigned integer to a string in decimal
+ * \param out the string
+ * \param value the integer
+ */
+static void
+AppendDecimal (std::string &out, uint64_t value)
+{
+  char digits[20];
+  uint32_t n = 0;
+  do
+    {
+      digits[n++] = '0' + value % 10;
+      value /= 10;
+    }
+  while (value != 0);
+  while (n > 0)
+    {
+      out.push_back (digits[--n]);
+    }
+}
+
+/**
+ * Append a signed integer to a string in decimal
+ * \param out the string
+ * \param value the integer
+ */
+static void
+AppendDecimal (std::string &out, int64_t value)
+{
+  if (value < 0)
+    {
+      out.push_back ('-');
+      AppendDecimal (out, static_cast<uint64_t> (0) - static_cast<uint64_t> (value));
+    }
+  else
+    {
+      AppendDecimal (out, static_cast<uint64_t> (value));
+    }
+}
+
+TypeId
+FlowStatsExporter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FlowStatsExporter")
+    .SetParent<Object> ()
+    .SetGroupName ("FlowMonitor")
+    .AddConstructor<FlowStatsExporter> ()
+    .AddAttribute ("FileName", "The name of the output file, read by Start.",
+                   StringValue ("flow-stats.csv"),
+                   MakeStringAccessor (&FlowStatsExporter::m_fileName),
+                   MakeStringChecker ())
+    .AddAttribute ("Format", "The format of the output file, read by Start.",
+                   EnumValue (FlowStatsExporter::CSV),
+                   MakeEnumAccessor (&FlowStatsExporter::m_format),
+                   MakeEnumChecker (FlowStatsExporter::CSV, "Csv",
+                                    FlowStatsExporter::BINARY, "Binary"))
+    .AddAttribute ("Interval", "The time between two exports; the file is flushed after each.",
+                   TimeValue (Seconds (1.0)),
+                   MakeTimeAccessor (&FlowStatsExporter::m_interval),
+                   MakeTimeChecker ())
+    .AddAttribute ("BufferSize", "The size in bytes of the buffer of rows not yet written, read by Start.",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&FlowStatsExporter::m_bufferSize),
+                   MakeUintegerChecker<uint32_t> (FLOW_STATS_ROW_SIZE))
+  ;
+  return tid;
+}
+
+FlowStatsExporter::FlowStatsExporter ()
+  : m_maxRows (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FlowStatsExporter::~FlowStatsExporter ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FlowStatsExporter::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Stop ();
+  Object::DoDispose ();
+}
+
+std::vector<std::string>
+FlowStatsExporter::ColumnNames (void)
+{
+  static const char *names[] = {
+    "time", "flowId", "txPackets", "rxPackets", "lostPackets", "timesForwarded",
+    "packetsDropped", "txBytes", "rxBytes", "bytesDropped", "delaySum", "jitterSum"
+  };
+  return std::vector<std::string> (names, names + sizeof (names) / sizeof (names[0]));
+}
+
+void
+FlowStatsExporter::Start (Ptr<FlowMonitor> monitor)
+{
+  NS_LOG_FUNCTION (this << monitor);
+  NS_ABORT_MSG_IF (m_file.is_open (), "FlowStatsExporter already started");
+
+  m_file.open (m_fileName.c_str (), std::ios::out | std::ios::trunc | std::ios::binary);
+  NS_ABORT_MSG_UNLESS (m_file.is_open (), "Unable to open " << m_fileName);
+  m_output.clear ();
+  if (m_format == CSV)
+    {
+      std::vector<std::string> names = ColumnNames ();
+      for (uint32_t i = 0; i < names.size (); i++)
+        {
+          m_output += (i == 0 ? "" : ",") + names[i];
+        }
+      m_output += "\n";
+    }
+  else
+    {
+      m_output.append (FLOW_STATS_MAGIC, sizeof (FLOW_STATS_MAGIC));
+      AppendLittleEndian (m_output, FLOW_STATS_VERSION, 4);
+    }
+  m_file.write (m_output.data (), m_output.size ());
+
+  m_monitor = monitor;
+  m_maxRows = m_bufferSize / FLOW_STATS_ROW_SIZE;
+  m_rows.clear ();
+  m_rows.reserve (m_maxRows);
+  m_last.clear ();
+  for (FlowId flowId = 0; flowId < m_monitor->GetFlowIdLimit (); flowId++)
+    {
+      const FlowMonitor::FlowStats *stats = m_monitor->FindFlowStats (flowId);
+      m_last.push_back (stats ? GetRow (flowId, *stats) : Row ());
+    }
+
+  m_exportEvent = Simulator::Schedule (m_interval, &FlowStatsExporter::PeriodicExport, this);
+  Simulator::ScheduleDestroy (&FlowStatsExporter::Stop, Ptr<FlowStatsExporter> (this));
+}
+
+void
+FlowStatsExporter::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+  m_exportEvent.Cancel ();
+  Export ();
+  m_file.close ();
+  m_monitor = 0;
+  std::vector<Row> ().swap (m_last);
+  std::vector<Row> ().swap (m_rows);
+}
+
+void
+FlowStatsExporter::PeriodicExport (void)
+{
+  NS_LOG_FUNCTION (this);
+  Export ();
+  m_exportEvent = Simulator::Schedule (m_interval, &FlowStatsExporter::PeriodicExport, this);
+}
+
+FlowStatsExporter::Row
+FlowStatsExporter::GetRow (FlowId flowId, const FlowMonitor::FlowStats &stats)
+{
+  Row row;
+  row.flowId = flowId;
+  row.txPackets = stats.txPackets;
+  row.rxPackets = stats.rxPackets;
+  row.lostPackets = stats.lostPackets;
+  row.timesForwarded = stats.timesForwarded;
+  row.packetsDropped = 0;
+  for (uint32_t i = 0; i < stats.packetsDropped.size (); i++)
+    {
+      row.packetsDropped += stats.packetsDropped[i];
+    }
+  row.txBytes = stats.txBytes;
+  row.rxBytes = stats.rxBytes;
+  row.bytesDropped = 0;
+  for (uint32_t i = 0; i < stats.bytesDropped.size (); i++)
+    {
+      row.bytesDropped += stats.bytesDropped[i];
+    }
+  row.delaySum = stats.delaySum.GetNanoSeconds ();
+  row.jitterSum = stats.jitterSum.GetNanoSeconds ();
+  return row;
+}
+
+void
+FlowStatsExporter::Export (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+  m_rowsTime = Simulator::Now ();
+  FlowId limit = m_monitor->GetFlowIdLimit ();
+  if (m_last.size () < limit)
+    {
+      m_last.resize (limit, Row ());
+    }
+  for (FlowId flowId = 0; flowId < limit; flowId++)
+    {
+      const FlowMonitor::FlowStats *stats = m_monitor->FindFlowStats (flowId);
+      if (stats == 0)
+        {
+          continue;
+        }
+      Row now = GetRow (flowId, *stats);
+      Row &last = m_last[flowId];
+      Row delta;
+      delta.flowId = flowId;
+      delta.txPackets = now.txPackets - last.txPackets;
+      delta.rxPackets = now.rxPackets - last.rxPackets;
+      delta.lostPackets = now.lostPackets - last.lostPackets;
+      delta.timesForwarded = now.timesForwarded - last.timesForwarded;
+      delta.packetsDropped = now.packetsDropped - last.packetsDropped;
+      delta.txBytes = now.txBytes - last.txBytes;
+      delta.rxBytes = now.rxBytes - last.rxBytes;
+      delta.bytesDropped = now.bytesDropped - last.bytesDropped;
+      delta.delaySum = now.delaySum - last.delaySum;
+      delta.jitterSum = now.jitterSum - last.jitterSum;
+      if (delta.txPackets == 0 && delta.rxPackets == 0 && delta.lostPackets == 0
+          && delta.timesForwarded == 0 && delta.packetsDropped == 0)
+        {
+          // the other counters only change along with a packet counter
+          continue;
+        }
+      last = now;
+      m_rows.push_back (delta);
+      if (m_rows.size () == m_maxRows)
+        {
+          WriteRows ();
+        }
+    }
+  WriteRows ();
+  m_file.flush ();
+}
+
+void
+FlowStatsExporter::WriteRows (void)
+{
+  NS_LOG_FUNCTION (this << m_rows.size ());
+  if (m_rows.empty ())
+    {
+      return;
+    }
+  m_output.clear ();
+  if (m_format == CSV)
+    {
+      int64_t time = m_rowsTime.GetNanoSeconds ();
+      for (std::vector<Row>::const_iterator row = m_rows.begin (); row != m_rows.end (); row++)
+        {
+          AppendDecimal (m_output, time);
+          m_output.push_back (',');
+          AppendDecimal (m_output, static_cast<uint64_t> (row->flowId));
+          m_output.push_back (',');
+          AppendDecimal (m_output, static_cast<uint64_t> (row->txPackets));
+          m_output.push_back (',');
+          AppendDecimal (m_output, static_cast<uint64_t> (row->rxPackets));
+          m_output.push_back (',');
+          AppendDecimal (m_output, static_cast<uint64_t> (row->lostPackets));
+          m_output.push_back (',');
+          AppendDecimal (m_output, static_cast<uint64_t> (row->timesForwarded));
+          m_output.push_back (',');
+          AppendDecimal (m_output, static_cast<uint64_t> (row->packetsDropped));
+          m_output.push_back (',');
+          AppendDecimal (m_output, row->txBytes);
+          m_output.push_back (',');
+          AppendDecimal (m_output, row->rxBytes);
+          m_output.push_back (',');
+          AppendDecimal (m_output, row->bytesDropped);
+          m_output.push_back (',');
+          AppendDecimal (m_output, row->delaySum);
+          m_output.push_back (',');
+          AppendDecimal (m_output, row->jitterSum);
+          m_output.push_back ('\n');
+        }
+    }
+  else
+    {
+      std::vector<Row>::const_iterator row;
+      AppendLittleEndian (m_output, m_rowsTime.GetNanoSeconds (), 8);
+      AppendLittleEndian (m_output, m_rows.size (), 4);
+      for (row = m_rows.begin (); row != m_rows.end (); row++)
+        {
+          AppendLittleEndian (m_output, row->flowId, 4);
+        }
+      for (row = m_rows.begin (); row != m_rows.end (); row++)
+        {
+          AppendLittleEndian (m_output, row->txPackets, 4);
+        }
+      for (row = m_rows.begin (); row != m_rows.end (); row++)
+        {
+          AppendLittleEndian (m_output, row->rxPackets, 4);
+        }
+      for (row = m_rows.begin (); row != m_rows.end (); row++)
+        {
+          AppendLittleEndian (m_output, row->lostPackets, 4);
+        }
+      for (row = m_rows.begin (); row != m_rows.end (); row++)
+        {
+          AppendLittleEndian (m_output, row->timesForwarded, 4);
+        }
+      for (row = m_rows.begin (); row != m_rows.end (); row++)
+        {
+          AppendLittleEndian (m_output, row->packetsDropped, 4);
+        }
+      for (row = m_rows.begin (); row != m_rows.end (); row++)
+        {
+          AppendLittleEndian (m_output, row->txBytes, 8);
+        }
+      for (row = m_rows.begin (); row != m_rows.end (); row++)
+        {
+          AppendLittleEndian (m_output, row->rxBytes, 8);
+        }
+      for (row = m_rows.begin (); row != m_rows.end (); row++)
+        {
+          AppendLittleEndian (m_output, row->bytesDropped, 8);
+        }
+      for (row = m_rows.begin (); row != m_rows.end (); row++)
+        {
+          AppendLittleEndian (m_output, row->delaySum, 8);
+        }
+      for (row = m_rows.begin (); row != m_rows.end (); row++)
+        {
+          AppendLittleEndian (m_output, row->jitterSum, 8);
+        }
+    }
+  m_file.write (m_output.data (), m_output.size ());
+  m_rows.clear ();
+}
+
+} // namespace ns3
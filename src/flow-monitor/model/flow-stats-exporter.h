@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef FLOW_STATS_EXPORTER_H
+#define FLOW_STATS_EXPORTER_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/flow-monitor.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup flow-monitor
+ * \brief Periodically write the changes of the FlowMonitor statistics to a file
+ *
+ * At the end of each interval, one row is written for every flow whose
+ * counters changed during the interval.  The row holds the end of the
+ * interval, the FlowId and the increase of each counter of
+ * FlowMonitor::FlowStats: packets and bytes transmitted, received, lost
+ * and dropped (summed over the reason codes), times forwarded, and the
+ * sums of the delays and jitters.  The histograms are not exported; use
+ * FlowMonitor::SerializeToXmlFile for them.
+ *
+ * The file is either CSV, with a header line and the times in
+ * nanoseconds, or a little endian binary format made of an 8 byte magic
+ * "ns3flows", a 32 bit version, and blocks of rows.  Each block holds a 64
+ * bit time in nanoseconds, a 32 bit number of rows N, and then each of the
+ * other columns in turn, in the order of ColumnNames: N 32 bit values for
+ * the FlowIds and for each packet counter, then N 64 bit values for each
+ * byte counter and each sum of times in nanoseconds.
+ *
+ * The rows are kept in a buffer of at most BufferSize bytes, which is
+ * written out when it is full (an interval may therefore span several
+ * blocks) and at the end of every interval, when the file is also
+ * flushed.  Besides the buffer, the exporter keeps the counters of each
+ * flow as they were at the last export, so its memory does not grow
+ * with the duration of the simulation.
+ *
+ * The file can be read with src/flow-monitor/examples/flowmon-parse-stream.py.
+ */
+class FlowStatsExporter : public Object
+{
+public:
+  /// Format of the exported file
+  enum Format
+  {
+    CSV,   //!< comma separated values, with a header line
+    BINARY //!< columnar binary blocks
+  };
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  FlowStatsExporter ();
+  virtual ~FlowStatsExporter ();
+
+  /**
+   * Open the file and start exporting the statistics of a FlowMonitor.
+   * The first interval starts now, from the current statistics, and the
+   * pending changes are exported when the simulator is destroyed, unless
+   * Stop is called before.
+   * \param monitor the FlowMonitor
+   */
+  void Start (Ptr<FlowMonitor> monitor);
+
+  /// Export the changes since the last export, then close the file
+  void Stop (void);
+
+  /// Export the changes since the last export now, without waiting for
+  /// the end of the interval
+  void Export (void);
+
+  /// \returns the names of the exported columns, in file order
+  static std::vector<std::string> ColumnNames (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// Counters of a flow, as exported
+  struct Row
+  {
+    FlowId flowId;           //!< flow identification
+    uint32_t txPackets;      //!< transmitted packets
+    uint32_t rxPackets;      //!< received packets
+    uint32_t lostPackets;    //!< lost packets
+    uint32_t timesForwarded; //!< times forwarded
+    uint32_t packetsDropped; //!< dropped packets, for all reason codes
+    uint64_t txBytes;        //!< transmitted bytes
+    uint64_t rxBytes;        //!< received bytes
+    uint64_t bytesDropped;   //!< dropped bytes, for all reason codes
+    int64_t delaySum;        //!< sum of the delays, in nanoseconds
+    int64_t jitterSum;       //!< sum of the jitters, in nanoseconds
+  };
+
+  /**
+   * Get the counters of a flow
+   * \param flowId the flow identification
+   * \param stats the statistics of the flow
+   * \returns the counters
+   */
+  static Row GetRow (FlowId flowId, const FlowMonitor::FlowStats &stats);
+
+  /// Export at the end of an interval and schedule the next one
+  void PeriodicExport (void);
+
+  /// Write the buffered rows to the file
+  void WriteRows (void);
+
+  Ptr<FlowMonitor> m_monitor; //!< the monitored FlowMonitor
+  std::string m_fileName;     //!< name of the output file
+  Format m_format;            //!< format of the output file
+  Time m_interval;            //!< time between two exports
+  uint32_t m_bufferSize;      //!< size of the row buffer, in bytes
+  std::ofstream m_file;       //!< the output file
+  EventId m_exportEvent;      //!< next periodic export
+
+  std::vector<Row> m_last;    //!< FlowId --> counters at the last export
+  std::vector<Row> m_rows;    //!< rows waiting to be written
+  uint32_t m_maxRows;         //!< capacity of m_rows
+  Time m_rowsTime;            //!< time of the rows in m_rows
+  std::string m_output;       //!< scratch space for the encoded rows
+};
+
+} // namespace ns3
+
+#endif /* FLOW_STATS_EXPORTER_H */
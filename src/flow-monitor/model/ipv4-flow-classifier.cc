@@ -23,6 +23,7 @@
 #include "ipv4-flow-classifier.h"
 #include "ns3/udp-header.h"
 #include "ns3/tcp-header.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -94,6 +95,17 @@ bool operator == (const Ipv4FlowClassifier::FiveTuple &t1,
 }
 
 
+std::size_t
+Ipv4FlowClassifier::FiveTupleHash::operator () (const FiveTuple &tuple) const
+{
+  uint64_t addresses = (static_cast<uint64_t> (tuple.sourceAddress.Get ()) << 32) | tuple.destinationAddress.Get ();
+  uint64_t rest = (static_cast<uint64_t> (tuple.protocol) << 32)
+    | (static_cast<uint32_t> (tuple.sourcePort) << 16) | tuple.destinationPort;
+  std::size_t h = std::hash<uint64_t> () (addresses);
+  h ^= std::hash<uint64_t> () (rest) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  return h;
+}
+
 
 Ipv4FlowClassifier::Ipv4FlowClassifier ()
 {
@@ -147,7 +159,7 @@ Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
   tuple.destinationPort = dstPort;
 
   // try to insert the tuple, but check if it already exists
-  std::pair<std::map<FiveTuple, FlowId>::iterator, bool> insert
+  std::pair<std::unordered_map<FiveTuple, FlowId, FiveTupleHash>::iterator, bool> insert
     = m_flowMap.insert (std::pair<FiveTuple, FlowId> (tuple, 0));
 
   // if the insertion succeeded, we need to assign this tuple a new flow identifier
@@ -155,6 +167,12 @@ Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
     {
       FlowId newFlowId = GetNewFlowId ();
       insert.first->second = newFlowId;
+      if (m_flowTuples.size () <= newFlowId)
+        {
+          m_flowTuples.resize (newFlowId + 1);
+          m_flowPktIdMap.resize (newFlowId + 1);
+        }
+      m_flowTuples[newFlowId] = tuple;
       m_flowPktIdMap[newFlowId] = 0;
     }
   else
@@ -172,13 +190,9 @@ Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
 Ipv4FlowClassifier::FiveTuple
 Ipv4FlowClassifier::FindFlow (FlowId flowId) const
 {
-  for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  if (flowId > 0 && flowId < m_flowTuples.size ())
     {
-      if (iter->second == flowId)
-        {
-          return iter->first;
-        }
+      return m_flowTuples[flowId];
     }
   NS_FATAL_ERROR ("Could not find the flow with ID " << flowId);
   FiveTuple retval = { Ipv4Address::GetZero (), Ipv4Address::GetZero (), 0, 0, 0 };
@@ -190,9 +204,13 @@ Ipv4FlowClassifier::SerializeToXmlStream (std::ostream &os, uint16_t indent) con
 {
   Indent (os, indent); os << "<Ipv4FlowClassifier>\n";
 
+  // list the flows in tuple order, as they used to be stored
+  std::vector<std::pair<FiveTuple, FlowId> > flows (m_flowMap.begin (), m_flowMap.end ());
+  std::sort (flows.begin (), flows.end ());
+
   indent += 2;
-  for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  for (std::vector<std::pair<FiveTuple, FlowId> >::const_iterator
+       iter = flows.begin (); iter != flows.end (); iter++)
     {
       Indent (os, indent);
       os << "<Flow flowId=\"" << iter->second << "\""
@@ -22,7 +22,8 @@
 #define IPV4_FLOW_CLASSIFIER_H
 
 #include <stdint.h>
-#include <map>
+#include <vector>
+#include <unordered_map>
 
 #include "ns3/ipv4-header.h"
 #include "ns3/flow-classifier.h"
@@ -34,7 +35,11 @@ class Packet;
 /// Classifies packets by looking at their IP and TCP/UDP headers.
 /// From these packet headers, a tuple (source-ip, destination-ip,
 /// protocol, source-port, destination-port) is created, and a unique
-/// flow identifier is assigned for each different tuple combination
+/// flow identifier is assigned for each different tuple combination.
+///
+/// The tuples are kept in a hash table, and the tuple and the last packet
+/// identifier of each flow in vectors indexed by FlowId, so that
+/// classifying a packet and finding a flow take constant time.
 class Ipv4FlowClassifier : public FlowClassifier
 {
 public:
@@ -49,6 +54,14 @@ public:
     uint16_t destinationPort;       //!< Destination port
   };
 
+  /// Hash function of a FiveTuple
+  struct FiveTupleHash
+  {
+    /// \param tuple the five-tuple
+    /// \returns the hash of the five-tuple
+    std::size_t operator () (const FiveTuple &tuple) const;
+  };
+
   Ipv4FlowClassifier ();
 
   /// \brief try to classify the packet into flow-id and packet-id
@@ -74,9 +87,11 @@ public:
 private:
 
   /// Map to Flows Identifiers to FlowIds
-  std::map<FiveTuple, FlowId> m_flowMap;
-  /// Map to FlowIds to FlowPacketId
-  std::map<FlowId, FlowPacketId> m_flowPktIdMap;
+  std::unordered_map<FiveTuple, FlowId, FiveTupleHash> m_flowMap;
+  /// FlowId --> FiveTuple
+  std::vector<FiveTuple> m_flowTuples;
+  /// FlowId --> last FlowPacketId
+  std::vector<FlowPacketId> m_flowPktIdMap;
 
 };
 
@@ -24,6 +24,7 @@
 #include "ipv6-flow-classifier.h"
 #include "ns3/udp-header.h"
 #include "ns3/tcp-header.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -95,6 +96,18 @@ bool operator == (const Ipv6FlowClassifier::FiveTuple &t1,
 }
 
 
+std::size_t
+Ipv6FlowClassifier::FiveTupleHash::operator () (const FiveTuple &tuple) const
+{
+  Ipv6AddressHash addressHash;
+  uint64_t rest = (static_cast<uint64_t> (tuple.protocol) << 32)
+    | (static_cast<uint32_t> (tuple.sourcePort) << 16) | tuple.destinationPort;
+  std::size_t h = addressHash (tuple.sourceAddress);
+  h ^= addressHash (tuple.destinationAddress) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  h ^= std::hash<uint64_t> () (rest) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  return h;
+}
+
 
 Ipv6FlowClassifier::Ipv6FlowClassifier ()
 {
@@ -148,7 +161,7 @@ Ipv6FlowClassifier::Classify (const Ipv6Header &ipHeader, Ptr<const Packet> ipPa
   tuple.destinationPort = dstPort;
 
   // try to insert the tuple, but check if it already exists
-  std::pair<std::map<FiveTuple, FlowId>::iterator, bool> insert
+  std::pair<std::unordered_map<FiveTuple, FlowId, FiveTupleHash>::iterator, bool> insert
     = m_flowMap.insert (std::pair<FiveTuple, FlowId> (tuple, 0));
 
   // if the insertion succeeded, we need to assign this tuple a new flow identifier
@@ -156,6 +169,12 @@ Ipv6FlowClassifier::Classify (const Ipv6Header &ipHeader, Ptr<const Packet> ipPa
     {
       FlowId newFlowId = GetNewFlowId ();
       insert.first->second = newFlowId;
+      if (m_flowTuples.size () <= newFlowId)
+        {
+          m_flowTuples.resize (newFlowId + 1);
+          m_flowPktIdMap.resize (newFlowId + 1);
+        }
+      m_flowTuples[newFlowId] = tuple;
       m_flowPktIdMap[newFlowId] = 0;
     }
   else
@@ -173,13 +192,9 @@ Ipv6FlowClassifier::Classify (const Ipv6Header &ipHeader, Ptr<const Packet> ipPa
 Ipv6FlowClassifier::FiveTuple
 Ipv6FlowClassifier::FindFlow (FlowId flowId) const
 {
-  for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  if (flowId > 0 && flowId < m_flowTuples.size ())
     {
-      if (iter->second == flowId)
-        {
-          return iter->first;
-        }
+      return m_flowTuples[flowId];
     }
   NS_FATAL_ERROR ("Could not find the flow with ID " << flowId);
   FiveTuple retval = { Ipv6Address::GetZero (), Ipv6Address::GetZero (), 0, 0, 0 };
@@ -191,9 +206,13 @@ Ipv6FlowClassifier::SerializeToXmlStream (std::ostream &os, uint16_t indent) con
 {
   Indent (os, indent); os << "<Ipv6FlowClassifier>\n";
 
+  // list the flows in tuple order, as they used to be stored
+  std::vector<std::pair<FiveTuple, FlowId> > flows (m_flowMap.begin (), m_flowMap.end ());
+  std::sort (flows.begin (), flows.end ());
+
   indent += 2;
-  for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  for (std::vector<std::pair<FiveTuple, FlowId> >::const_iterator
+       iter = flows.begin (); iter != flows.end (); iter++)
     {
       Indent (os, indent);
       os << "<Flow flowId=\"" << iter->second << "\""
@@ -0,0 +1,181 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/udp-header.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+#include "ns3/ipv4-flow-classifier.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief A FlowProbe that only reports what the benchmark tells it
+ */
+class FlowMonitorBenchmarkProbe : public FlowProbe
+{
+public:
+  /**
+   * \brief Constructor
+   * \param monitor the FlowMonitor
+   */
+  FlowMonitorBenchmarkProbe (Ptr<FlowMonitor> monitor)
+    : FlowProbe (monitor)
+  {
+  }
+};
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief Time the classification and the reports of packets of many flows
+ *
+ * Each packet is classified at its source, forwarded by two routers and
+ * received, with a few packets of each flow in transit at any time, as the
+ * IPv4 probes of a three hop path would report them.
+ */
+class FlowMonitorBenchmarkTestCase : public TestCase
+{
+public:
+  FlowMonitorBenchmarkTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Send packets over many flows
+   * \param flows the number of flows
+   */
+  void Run (uint32_t flows);
+
+  /// The monitors, kept until the end of the simulation for their periodic checks
+  std::vector<Ptr<FlowMonitor> > m_monitors;
+};
+
+FlowMonitorBenchmarkTestCase::FlowMonitorBenchmarkTestCase ()
+  : TestCase ("FlowMonitor with many flows")
+{
+}
+
+void
+FlowMonitorBenchmarkTestCase::Run (uint32_t flows)
+{
+  typedef std::chrono::steady_clock Clock;
+  const uint32_t rounds = 10;
+  const uint32_t inTransit = 4;
+
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  m_monitors.push_back (monitor);
+  Ptr<Ipv4FlowClassifier> classifier = Create<Ipv4FlowClassifier> ();
+  monitor->AddFlowClassifier (classifier);
+  std::vector<Ptr<FlowMonitorBenchmarkProbe> > probes;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      probes.push_back (CreateObject<FlowMonitorBenchmarkProbe> (monitor));
+    }
+  monitor->StartRightNow ();
+
+  std::vector<Ipv4Header> headers (flows);
+  for (uint32_t f = 0; f < flows; f++)
+    {
+      headers[f].SetSource (Ipv4Address (0x0a000000 + f / 50));
+      headers[f].SetDestination (Ipv4Address (0x0b000000 + f % 1000));
+      headers[f].SetProtocol (17);
+    }
+  Ptr<Packet> payload = Create<Packet> (1000);
+  UdpHeader udp;
+  udp.SetSourcePort (49152);
+  udp.SetDestinationPort (9);
+  payload->AddHeader (udp);
+
+  std::vector<std::pair<FlowId, FlowPacketId> > sent (flows * inTransit);
+  Clock::time_point start = Clock::now ();
+  uint64_t packets = 0;
+  for (uint32_t r = 0; r < rounds + inTransit; r++)
+    {
+      for (uint32_t f = 0; f < flows; f++)
+        {
+          std::pair<FlowId, FlowPacketId> &slot = sent[f * inTransit + r % inTransit];
+          if (r >= inTransit)
+            {
+              // the packet sent inTransit rounds ago arrives
+              monitor->ReportForwarding (probes[1], slot.first, slot.second, 1028);
+              monitor->ReportForwarding (probes[2], slot.first, slot.second, 1028);
+              monitor->ReportLastRx (probes[3], slot.first, slot.second, 1028);
+              packets++;
+            }
+          if (r < rounds)
+            {
+              classifier->Classify (headers[f], payload, &slot.first, &slot.second);
+              monitor->ReportFirstTx (probes[0], slot.first, slot.second, 1028);
+            }
+        }
+    }
+  double seconds = std::chrono::duration<double> (Clock::now () - start).count ();
+
+  const FlowMonitor::FlowStatsContainer &stats = monitor->GetFlowStats ();
+  NS_TEST_EXPECT_MSG_EQ (stats.size (), flows, "Every flow should have statistics");
+  NS_TEST_EXPECT_MSG_EQ (stats.begin ()->second.rxPackets, rounds, "Every packet should be received");
+
+  std::cout << "flow-monitor-perf: " << flows << " flows: "
+            << 1e9 * seconds / packets << " ns per packet" << std::endl;
+}
+
+void
+FlowMonitorBenchmarkTestCase::DoRun (void)
+{
+  // Run inside the simulation, where Time objects are no longer tracked for
+  // a change of resolution
+  Simulator::Schedule (Seconds (0), &FlowMonitorBenchmarkTestCase::Run, this, 1000);
+  Simulator::Schedule (Seconds (1), &FlowMonitorBenchmarkTestCase::Run, this, 100000);
+  Simulator::Stop (Seconds (1.5));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  for (uint32_t i = 0; i < m_monitors.size (); i++)
+    {
+      m_monitors[i]->Dispose ();
+    }
+  m_monitors.clear ();
+}
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief FlowMonitor performance test suite
+ */
+class FlowMonitorPerformanceSuite : public TestSuite
+{
+public:
+  FlowMonitorPerformanceSuite ();
+};
+
+FlowMonitorPerformanceSuite::FlowMonitorPerformanceSuite ()
+  : TestSuite ("flow-monitor-perf", PERFORMANCE)
+{
+  AddTestCase (new FlowMonitorBenchmarkTestCase, TestCase::QUICK);
+}
+
+static FlowMonitorPerformanceSuite g_flowMonitorPerformanceSuite; //!< Static variable for test initialization
@@ -0,0 +1,660 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/udp-header.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+#include "ns3/ipv4-flow-classifier.h"
+#include "ns3/ipv6-flow-classifier.h"
+#include "ns3/flow-stats-exporter.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief Classify packets of many flows with the IPv4 and IPv6 classifiers
+ *
+ * The flow and packet identifiers, FindFlow and the XML output are checked
+ * against a std::map of the five-tuples.
+ */
+class FlowClassifierTestCase : public TestCase
+{
+public:
+  FlowClassifierTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FlowClassifierTestCase::FlowClassifierTestCase ()
+  : TestCase ("Ipv4FlowClassifier and Ipv6FlowClassifier")
+{
+}
+
+void
+FlowClassifierTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (3);
+
+  const uint32_t nTuples = 500;
+  std::vector<Ipv4FlowClassifier::FiveTuple> tuples4;
+  std::vector<Ipv6FlowClassifier::FiveTuple> tuples6;
+  for (uint32_t i = 0; i < nTuples; i++)
+    {
+      // few distinct values, so that tuples share addresses and ports
+      Ipv4FlowClassifier::FiveTuple t4;
+      t4.sourceAddress = Ipv4Address (0x0a000001 + rng->GetInteger (0, 7));
+      t4.destinationAddress = Ipv4Address (0x0a010001 + rng->GetInteger (0, 7));
+      t4.protocol = rng->GetInteger (0, 1) ? 6 : 17;
+      t4.sourcePort = 49152 + rng->GetInteger (0, 3);
+      t4.destinationPort = 9 + rng->GetInteger (0, 3);
+      tuples4.push_back (t4);
+
+      Ipv6FlowClassifier::FiveTuple t6;
+      std::ostringstream src, dst;
+      src << "2001:db8::" << rng->GetInteger (1, 8);
+      dst << "2001:db8:1::" << rng->GetInteger (1, 8);
+      t6.sourceAddress = Ipv6Address (src.str ().c_str ());
+      t6.destinationAddress = Ipv6Address (dst.str ().c_str ());
+      t6.protocol = t4.protocol;
+      t6.sourcePort = t4.sourcePort;
+      t6.destinationPort = t4.destinationPort;
+      tuples6.push_back (t6);
+    }
+
+  Ptr<Ipv4FlowClassifier> classifier4 = Create<Ipv4FlowClassifier> ();
+  Ptr<Ipv6FlowClassifier> classifier6 = Create<Ipv6FlowClassifier> ();
+  std::map<Ipv4FlowClassifier::FiveTuple, std::pair<FlowId, FlowPacketId> > model4;
+  std::map<Ipv6FlowClassifier::FiveTuple, std::pair<FlowId, FlowPacketId> > model6;
+
+  for (uint32_t n = 0; n < 5000; n++)
+    {
+      uint32_t i = rng->GetInteger (0, nTuples - 1);
+      const Ipv4FlowClassifier::FiveTuple &t4 = tuples4[i];
+      const Ipv6FlowClassifier::FiveTuple &t6 = tuples6[i];
+
+      Ptr<Packet> payload = Create<Packet> (100);
+      UdpHeader udp;
+      udp.SetSourcePort (t4.sourcePort);
+      udp.SetDestinationPort (t4.destinationPort);
+      payload->AddHeader (udp);
+
+      Ipv4Header ip4;
+      ip4.SetSource (t4.sourceAddress);
+      ip4.SetDestination (t4.destinationAddress);
+      ip4.SetProtocol (t4.protocol);
+      FlowId flowId;
+      FlowPacketId packetId;
+      NS_TEST_ASSERT_MSG_EQ (classifier4->Classify (ip4, payload, &flowId, &packetId), true,
+                             "IPv4 packet not classified");
+      if (model4.count (t4) == 0)
+        {
+          FlowId newFlowId = model4.size () + 1;
+          model4[t4] = std::make_pair (newFlowId, 0);
+        }
+      else
+        {
+          model4[t4].second++;
+        }
+      NS_TEST_ASSERT_MSG_EQ (flowId, model4[t4].first, "Wrong IPv4 flow identifier");
+      NS_TEST_ASSERT_MSG_EQ (packetId, model4[t4].second, "Wrong IPv4 packet identifier");
+      NS_TEST_ASSERT_MSG_EQ ((classifier4->FindFlow (flowId) == t4), true, "Wrong IPv4 flow found");
+
+      Ipv6Header ip6;
+      ip6.SetSourceAddress (t6.sourceAddress);
+      ip6.SetDestinationAddress (t6.destinationAddress);
+      ip6.SetNextHeader (t6.protocol);
+      NS_TEST_ASSERT_MSG_EQ (classifier6->Classify (ip6, payload, &flowId, &packetId), true,
+                             "IPv6 packet not classified");
+      if (model6.count (t6) == 0)
+        {
+          FlowId newFlowId = model6.size () + 1;
+          model6[t6] = std::make_pair (newFlowId, 0);
+        }
+      else
+        {
+          model6[t6].second++;
+        }
+      NS_TEST_ASSERT_MSG_EQ (flowId, model6[t6].first, "Wrong IPv6 flow identifier");
+      NS_TEST_ASSERT_MSG_EQ (packetId, model6[t6].second, "Wrong IPv6 packet identifier");
+      NS_TEST_ASSERT_MSG_EQ ((classifier6->FindFlow (flowId) == t6), true, "Wrong IPv6 flow found");
+    }
+
+  // The flows are listed in tuple order
+  std::ostringstream expected;
+  expected << "<Ipv4FlowClassifier>\n";
+  for (std::map<Ipv4FlowClassifier::FiveTuple, std::pair<FlowId, FlowPacketId> >::const_iterator
+       it = model4.begin (); it != model4.end (); ++it)
+    {
+      expected << "  <Flow flowId=\"" << it->second.first << "\""
+               << " sourceAddress=\"" << it->first.sourceAddress << "\""
+               << " destinationAddress=\"" << it->first.destinationAddress << "\""
+               << " protocol=\"" << int(it->first.protocol) << "\""
+               << " sourcePort=\"" << it->first.sourcePort << "\""
+               << " destinationPort=\"" << it->first.destinationPort << "\""
+               << " />\n";
+    }
+  expected << "</Ipv4FlowClassifier>\n";
+  std::ostringstream xml;
+  classifier4->SerializeToXmlStream (xml, 0);
+  NS_TEST_ASSERT_MSG_EQ (xml.str (), expected.str (), "Wrong XML output");
+}
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief A FlowProbe that only reports what the test tells it
+ */
+class FlowMonitorTestProbe : public FlowProbe
+{
+public:
+  /**
+   * \brief Constructor
+   * \param monitor the FlowMonitor
+   */
+  FlowMonitorTestProbe (Ptr<FlowMonitor> monitor)
+    : FlowProbe (monitor)
+  {
+  }
+};
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief Report random packet events to a FlowMonitor
+ *
+ * Packets of many flows are transmitted, forwarded, received, dropped and
+ * declared lost in random order, and the flow statistics are compared with
+ * a straightforward model of the tracked packets.
+ */
+class FlowMonitorTrackedPacketsTestCase : public TestCase
+{
+public:
+  FlowMonitorTrackedPacketsTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /// Report one random event
+  void Step (void);
+
+  /// A packet in transit in the model
+  struct Tracked
+  {
+    FlowId flowId;            //!< flow of the packet
+    FlowPacketId packetId;    //!< packet identifier
+    Time firstSeen;           //!< transmission time
+    Time lastSeen;            //!< last report time
+    uint32_t timesForwarded;  //!< number of forwarding reports
+  };
+
+  /// Expected statistics of a flow
+  struct Expected
+  {
+    uint32_t txPackets;       //!< transmitted packets
+    uint32_t rxPackets;       //!< received packets
+    uint32_t lostPackets;     //!< lost and dropped packets
+    uint32_t timesForwarded;  //!< forwarding reports of the received packets
+    uint64_t rxBytes;         //!< received bytes
+    Time delaySum;            //!< sum of the delays of the received packets
+  };
+
+  Ptr<FlowMonitor> m_monitor;              //!< the monitor under test
+  Ptr<FlowMonitorTestProbe> m_probe;       //!< the reporting probe
+  Ptr<UniformRandomVariable> m_rng;        //!< random events
+  std::vector<Tracked> m_tracked;          //!< packets in transit
+  std::vector<FlowPacketId> m_nextPacket;  //!< FlowId --> next packet identifier
+  std::map<FlowId, Expected> m_expected;   //!< expected statistics
+  uint32_t m_steps;                        //!< remaining steps
+};
+
+FlowMonitorTrackedPacketsTestCase::FlowMonitorTrackedPacketsTestCase ()
+  : TestCase ("FlowMonitor flow statistics and tracked packets")
+{
+}
+
+void
+FlowMonitorTrackedPacketsTestCase::Step (void)
+{
+  const uint32_t nFlows = 300;
+  uint32_t action = m_rng->GetInteger (0, 9);
+  Time now = Simulator::Now ();
+
+  if (action < 4 || m_tracked.empty ())
+    {
+      Tracked t;
+      t.flowId = m_rng->GetInteger (1, nFlows);
+      t.packetId = m_nextPacket[t.flowId]++;
+      t.firstSeen = now;
+      t.lastSeen = now;
+      t.timesForwarded = 0;
+      m_tracked.push_back (t);
+      Expected &e = m_expected[t.flowId];
+      e.txPackets++;
+      m_monitor->ReportFirstTx (m_probe, t.flowId, t.packetId, 100);
+    }
+  else if (action < 9)
+    {
+      uint32_t i = m_rng->GetInteger (0, m_tracked.size () - 1);
+      Tracked &t = m_tracked[i];
+      if (action < 6)
+        {
+          t.timesForwarded++;
+          t.lastSeen = now;
+          m_monitor->ReportForwarding (m_probe, t.flowId, t.packetId, 100);
+        }
+      else
+        {
+          Expected &e = m_expected[t.flowId];
+          if (action < 8)
+            {
+              e.rxPackets++;
+              e.rxBytes += 100;
+              e.timesForwarded += t.timesForwarded;
+              e.delaySum += now - t.firstSeen;
+              m_monitor->ReportLastRx (m_probe, t.flowId, t.packetId, 100);
+            }
+          else
+            {
+              e.lostPackets++;
+              m_monitor->ReportDrop (m_probe, t.flowId, t.packetId, 100, 0);
+            }
+          m_tracked[i] = m_tracked.back ();
+          m_tracked.pop_back ();
+        }
+    }
+  else
+    {
+      // Declare lost the packets not seen for a while
+      Time maxDelay = MilliSeconds (m_rng->GetInteger (20, 200));
+      for (uint32_t i = 0; i < m_tracked.size (); )
+        {
+          if (now - m_tracked[i].lastSeen >= maxDelay)
+            {
+              m_expected[m_tracked[i].flowId].lostPackets++;
+              m_tracked[i] = m_tracked.back ();
+              m_tracked.pop_back ();
+            }
+          else
+            {
+              i++;
+            }
+        }
+      m_monitor->CheckForLostPackets (maxDelay);
+    }
+
+  // Unknown packets are ignored
+  m_monitor->ReportLastRx (m_probe, nFlows + 1, 0, 100);
+
+  if (--m_steps > 0)
+    {
+      Simulator::Schedule (MicroSeconds (m_rng->GetInteger (1, 2000)),
+                           &FlowMonitorTrackedPacketsTestCase::Step, this);
+    }
+}
+
+void
+FlowMonitorTrackedPacketsTestCase::DoRun (void)
+{
+  m_monitor = CreateObject<FlowMonitor> ();
+  m_probe = CreateObject<FlowMonitorTestProbe> (m_monitor);
+  m_rng = CreateObject<UniformRandomVariable> ();
+  m_rng->SetStream (5);
+  m_nextPacket.assign (302, 0);
+  m_steps = 20000;
+  m_monitor->StartRightNow ();
+  Simulator::Schedule (Seconds (0), &FlowMonitorTrackedPacketsTestCase::Step, this);
+  Simulator::Stop (Seconds (9));
+  Simulator::Run ();
+
+  const FlowMonitor::FlowStatsContainer &stats = m_monitor->GetFlowStats ();
+  NS_TEST_ASSERT_MSG_EQ (stats.size (), m_expected.size (), "Wrong number of flows");
+  for (std::map<FlowId, Expected>::const_iterator it = m_expected.begin (); it != m_expected.end (); ++it)
+    {
+      FlowMonitor::FlowStatsContainerCI flow = stats.find (it->first);
+      NS_TEST_ASSERT_MSG_EQ ((flow != stats.end ()), true, "Missing flow " << it->first);
+      NS_TEST_ASSERT_MSG_EQ (flow->second.txPackets, it->second.txPackets, "Wrong txPackets");
+      NS_TEST_ASSERT_MSG_EQ (flow->second.txBytes, 100 * it->second.txPackets, "Wrong txBytes");
+      NS_TEST_ASSERT_MSG_EQ (flow->second.rxPackets, it->second.rxPackets, "Wrong rxPackets");
+      NS_TEST_ASSERT_MSG_EQ (flow->second.rxBytes, it->second.rxBytes, "Wrong rxBytes");
+      NS_TEST_ASSERT_MSG_EQ (flow->second.lostPackets, it->second.lostPackets, "Wrong lostPackets");
+      NS_TEST_ASSERT_MSG_EQ (flow->second.timesForwarded, it->second.timesForwarded, "Wrong timesForwarded");
+      NS_TEST_ASSERT_MSG_EQ (flow->second.delaySum, it->second.delaySum, "Wrong delaySum");
+    }
+
+  // Every packet still in transit is lost at the end
+  m_monitor->CheckForLostPackets (Seconds (0));
+  const FlowMonitor::FlowStatsContainer &last = m_monitor->GetFlowStats ();
+  uint32_t lost = 0;
+  for (FlowMonitor::FlowStatsContainerCI it = last.begin (); it != last.end (); ++it)
+    {
+      lost += it->second.lostPackets - m_expected[it->first].lostPackets;
+    }
+  NS_TEST_ASSERT_MSG_EQ (lost, m_tracked.size (), "Packets in transit not declared lost");
+
+  Simulator::Destroy ();
+  m_monitor->Dispose ();
+  m_monitor = 0;
+  m_probe = 0;
+}
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief Export the statistics of a FlowMonitor in CSV and binary format
+ *
+ * Random packet events are reported while two exporters write the changes
+ * of the statistics every 100 ms, with a buffer too small for all the
+ * flows of an interval.  Both files are read back and the changes are
+ * added up and compared with the final statistics.
+ */
+class FlowStatsExporterTestCase : public TestCase
+{
+public:
+  FlowStatsExporterTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /// Report one random event
+  void Step (void);
+
+  /// A row read back from a file: the time and the other columns
+  typedef std::vector<int64_t> ExportedRow;
+
+  /**
+   * Read a CSV file
+   * \param fileName the file name
+   * \returns the rows
+   */
+  std::vector<ExportedRow> ReadCsv (std::string fileName);
+
+  /**
+   * Read a binary file
+   * \param fileName the file name
+   * \param maxRows the largest number of rows expected in a block
+   * \returns the rows
+   */
+  std::vector<ExportedRow> ReadBinary (std::string fileName, uint32_t maxRows);
+
+  Ptr<FlowMonitor> m_monitor;                          //!< the monitor
+  Ptr<FlowMonitorTestProbe> m_probe;                   //!< the reporting probe
+  Ptr<UniformRandomVariable> m_rng;                    //!< random events
+  std::vector<std::pair<FlowId, FlowPacketId> > m_tracked; //!< packets in transit
+  std::vector<FlowPacketId> m_nextPacket;              //!< FlowId --> next packet identifier
+};
+
+FlowStatsExporterTestCase::FlowStatsExporterTestCase ()
+  : TestCase ("FlowStatsExporter CSV and binary files")
+{
+}
+
+void
+FlowStatsExporterTestCase::Step (void)
+{
+  uint32_t action = m_rng->GetInteger (0, 9);
+  if (action < 4 || m_tracked.empty ())
+    {
+      FlowId flowId = m_rng->GetInteger (1, m_nextPacket.size () - 1);
+      FlowPacketId packetId = m_nextPacket[flowId]++;
+      m_tracked.push_back (std::make_pair (flowId, packetId));
+      m_monitor->ReportFirstTx (m_probe, flowId, packetId, 100 + flowId);
+    }
+  else
+    {
+      uint32_t i = m_rng->GetInteger (0, m_tracked.size () - 1);
+      FlowId flowId = m_tracked[i].first;
+      FlowPacketId packetId = m_tracked[i].second;
+      if (action < 6)
+        {
+          m_monitor->ReportForwarding (m_probe, flowId, packetId, 100 + flowId);
+          return;
+        }
+      if (action < 9)
+        {
+          m_monitor->ReportLastRx (m_probe, flowId, packetId, 100 + flowId);
+        }
+      else
+        {
+          m_monitor->ReportDrop (m_probe, flowId, packetId, 100 + flowId, m_rng->GetInteger (0, 2));
+        }
+      m_tracked[i] = m_tracked.back ();
+      m_tracked.pop_back ();
+    }
+}
+
+std::vector<FlowStatsExporterTestCase::ExportedRow>
+FlowStatsExporterTestCase::ReadCsv (std::string fileName)
+{
+  std::vector<ExportedRow> rows;
+  std::ifstream file (fileName.c_str ());
+  std::string line;
+  std::getline (file, line);
+  NS_TEST_EXPECT_MSG_EQ (line, "time,flowId,txPackets,rxPackets,lostPackets,timesForwarded,"
+                         "packetsDropped,txBytes,rxBytes,bytesDropped,delaySum,jitterSum",
+                         "Wrong CSV header");
+  while (std::getline (file, line))
+    {
+      std::istringstream fields (line);
+      ExportedRow row;
+      int64_t value;
+      char comma;
+      while (fields >> value)
+        {
+          row.push_back (value);
+          fields >> comma;
+        }
+      NS_TEST_EXPECT_MSG_EQ (row.size (), 12, "Wrong number of CSV fields");
+      rows.push_back (row);
+    }
+  return rows;
+}
+
+/**
+ * Read a little endian integer
+ * \param data the bytes
+ * \param offset the offset of the integer, moved past it
+ * \param bytes the size of the integer
+ * \returns the integer
+ */
+static int64_t
+ReadLittleEndian (const std::string &data, uint32_t &offset, uint32_t bytes)
+{
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < bytes; i++)
+    {
+      value |= static_cast<uint64_t> (static_cast<uint8_t> (data[offset + i])) << (8 * i);
+    }
+  offset += bytes;
+  return static_cast<int64_t> (value);
+}
+
+std::vector<FlowStatsExporterTestCase::ExportedRow>
+FlowStatsExporterTestCase::ReadBinary (std::string fileName, uint32_t maxRows)
+{
+  std::vector<ExportedRow> rows;
+  std::ifstream file (fileName.c_str (), std::ios::binary);
+  std::string data ((std::istreambuf_iterator<char> (file)), std::istreambuf_iterator<char> ());
+  NS_TEST_EXPECT_MSG_EQ (data.substr (0, 8), "ns3flows", "Wrong magic");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (data.size (), 12, "Truncated file");
+  if (data.size () < 12)
+    {
+      return rows;
+    }
+  uint32_t offset = 8;
+  NS_TEST_EXPECT_MSG_EQ (ReadLittleEndian (data, offset, 4), 1, "Wrong version");
+  while (offset + 12 <= data.size ())
+    {
+      int64_t time = ReadLittleEndian (data, offset, 8);
+      uint32_t n = ReadLittleEndian (data, offset, 4);
+      NS_TEST_EXPECT_MSG_GT (n, 0, "Empty block");
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (n, maxRows, "Block larger than the buffer");
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (offset + n * (6 * 4 + 5 * 8), data.size (), "Truncated block");
+      if (offset + n * (6 * 4 + 5 * 8) > data.size ())
+        {
+          return rows;
+        }
+      uint32_t first = rows.size ();
+      rows.resize (first + n, ExportedRow (1, time));
+      for (uint32_t column = 0; column < 11; column++)
+        {
+          for (uint32_t i = 0; i < n; i++)
+            {
+              rows[first + i].push_back (ReadLittleEndian (data, offset, column < 6 ? 4 : 8));
+            }
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (offset, data.size (), "Trailing bytes");
+  return rows;
+}
+
+void
+FlowStatsExporterTestCase::DoRun (void)
+{
+  m_monitor = CreateObject<FlowMonitor> ();
+  m_probe = CreateObject<FlowMonitorTestProbe> (m_monitor);
+  m_rng = CreateObject<UniformRandomVariable> ();
+  m_rng->SetStream (7);
+  m_nextPacket.assign (60, 0);
+  m_monitor->StartRightNow ();
+
+  // Ten rows fit in the buffer, fewer than the flows of an interval
+  const uint32_t maxRows = 10;
+  std::string csvName = CreateTempDirFilename ("flow-stats.csv");
+  std::string binaryName = CreateTempDirFilename ("flow-stats.bin");
+  Ptr<FlowStatsExporter> csv = CreateObjectWithAttributes<FlowStatsExporter> (
+      "FileName", StringValue (csvName),
+      "Interval", TimeValue (MilliSeconds (100)),
+      "BufferSize", UintegerValue (maxRows * 64 + 63));
+  Ptr<FlowStatsExporter> binary = CreateObjectWithAttributes<FlowStatsExporter> (
+      "FileName", StringValue (binaryName),
+      "Format", EnumValue (FlowStatsExporter::BINARY),
+      "Interval", TimeValue (MilliSeconds (100)),
+      "BufferSize", UintegerValue (maxRows * 64 + 63));
+  csv->Start (m_monitor);
+  binary->Start (m_monitor);
+
+  for (uint32_t i = 0; i < 5000; i++)
+    {
+      Simulator::Schedule (MicroSeconds (m_rng->GetInteger (0, 2049999)), &FlowStatsExporterTestCase::Step, this);
+    }
+  void (FlowMonitor::*check) (Time) = &FlowMonitor::CheckForLostPackets;
+  Simulator::Schedule (Seconds (1), check, m_monitor, MilliSeconds (10));
+  Simulator::Stop (MilliSeconds (2050));
+  Simulator::Run ();
+  // The last, partial interval is exported when the simulator is destroyed
+  Simulator::Destroy ();
+
+  std::vector<ExportedRow> csvRows = ReadCsv (csvName);
+  std::vector<ExportedRow> binaryRows = ReadBinary (binaryName, maxRows);
+  NS_TEST_ASSERT_MSG_EQ (csvRows.size (), binaryRows.size (), "The files have different rows");
+  NS_TEST_ASSERT_MSG_GT (csvRows.size (), 20 * maxRows, "Too few rows");
+
+  std::map<FlowId, ExportedRow> totals;
+  std::set<std::pair<int64_t, int64_t> > exported;
+  for (uint32_t i = 0; i < csvRows.size (); i++)
+    {
+      const ExportedRow &row = csvRows[i];
+      NS_TEST_ASSERT_MSG_EQ ((row == binaryRows[i]), true, "The files differ at row " << i);
+      int64_t time = row[0];
+      NS_TEST_EXPECT_MSG_EQ ((time % 100000000 == 0 || time == 2050000000), true,
+                             "Row not at the end of an interval: " << time);
+      NS_TEST_EXPECT_MSG_EQ ((row[2] || row[3] || row[4] || row[5] || row[6]), true,
+                             "Row without changes");
+      NS_TEST_EXPECT_MSG_EQ (exported.insert (std::make_pair (time, row[1])).second, true,
+                             "Flow exported twice in an interval");
+      ExportedRow &total = totals[row[1]];
+      total.resize (12, 0);
+      for (uint32_t column = 2; column < 12; column++)
+        {
+          total[column] += row[column];
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ ((exported.lower_bound (std::make_pair (2050000000, 0)) != exported.end ()), true,
+                         "Last partial interval not exported");
+
+  const FlowMonitor::FlowStatsContainer &stats = m_monitor->GetFlowStats ();
+  NS_TEST_ASSERT_MSG_EQ (totals.size (), stats.size (), "Wrong number of flows");
+  for (FlowMonitor::FlowStatsContainerCI it = stats.begin (); it != stats.end (); ++it)
+    {
+      const ExportedRow &total = totals[it->first];
+      const FlowMonitor::FlowStats &flow = it->second;
+      int64_t packetsDropped = 0;
+      int64_t bytesDropped = 0;
+      for (uint32_t i = 0; i < flow.packetsDropped.size (); i++)
+        {
+          packetsDropped += flow.packetsDropped[i];
+          bytesDropped += flow.bytesDropped[i];
+        }
+      NS_TEST_EXPECT_MSG_EQ (total[2], flow.txPackets, "Wrong txPackets for flow " << it->first);
+      NS_TEST_EXPECT_MSG_EQ (total[3], flow.rxPackets, "Wrong rxPackets for flow " << it->first);
+      NS_TEST_EXPECT_MSG_EQ (total[4], flow.lostPackets, "Wrong lostPackets for flow " << it->first);
+      NS_TEST_EXPECT_MSG_EQ (total[5], flow.timesForwarded, "Wrong timesForwarded for flow " << it->first);
+      NS_TEST_EXPECT_MSG_EQ (total[6], packetsDropped, "Wrong packetsDropped for flow " << it->first);
+      NS_TEST_EXPECT_MSG_EQ (total[7], static_cast<int64_t> (flow.txBytes), "Wrong txBytes for flow " << it->first);
+      NS_TEST_EXPECT_MSG_EQ (total[8], static_cast<int64_t> (flow.rxBytes), "Wrong rxBytes for flow " << it->first);
+      NS_TEST_EXPECT_MSG_EQ (total[9], bytesDropped, "Wrong bytesDropped for flow " << it->first);
+      NS_TEST_EXPECT_MSG_EQ (total[10], flow.delaySum.GetNanoSeconds (), "Wrong delaySum for flow " << it->first);
+      NS_TEST_EXPECT_MSG_EQ (total[11], flow.jitterSum.GetNanoSeconds (), "Wrong jitterSum for flow " << it->first);
+    }
+
+  csv->Dispose ();
+  binary->Dispose ();
+  m_monitor->Dispose ();
+  m_monitor = 0;
+  m_probe = 0;
+}
+
+/**
+ * \ingroup flow-monitor-test
+ * \ingroup tests
+ *
+ * \brief FlowMonitor TestSuite
+ */
+class FlowMonitorTestSuite : public TestSuite
+{
+public:
+  FlowMonitorTestSuite ();
+};
+
+FlowMonitorTestSuite::FlowMonitorTestSuite ()
+  : TestSuite ("flow-monitor", UNIT)
+{
+  AddTestCase (new FlowClassifierTestCase, TestCase::QUICK);
+  AddTestCase (new FlowMonitorTrackedPacketsTestCase, TestCase::QUICK);
+  AddTestCase (new FlowStatsExporterTestCase, TestCase::QUICK);
+}
+
+static FlowMonitorTestSuite g_flowMonitorTestSuite; //!< Static variable for test initialization
@@ -22,14 +22,42 @@
 #include "ipv4-end-point.h"
 #include "ipv4-interface-address.h"
 #include "ns3/log.h"
-
+#include <algorithm>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
+Ipv4EndPointDemux::EndPointKey::EndPointKey (Ipv4Address localAddress, uint16_t localPort,
+                                             Ipv4Address peerAddress, uint16_t peerPort)
+  : m_localAddress (localAddress),
+    m_localPort (localPort),
+    m_peerAddress (peerAddress),
+    m_peerPort (peerPort)
+{
+}
+
+bool
+Ipv4EndPointDemux::EndPointKey::operator == (const EndPointKey &other) const
+{
+  return m_localPort == other.m_localPort
+         && m_peerPort == other.m_peerPort
+         && m_localAddress == other.m_localAddress
+         && m_peerAddress == other.m_peerAddress;
+}
+
+std::size_t
+Ipv4EndPointDemux::EndPointKeyHash::operator () (const EndPointKey &key) const
+{
+  uint64_t addresses = (static_cast<uint64_t> (key.m_localAddress.Get ()) << 32) | key.m_peerAddress.Get ();
+  uint32_t ports = (static_cast<uint32_t> (key.m_localPort) << 16) | key.m_peerPort;
+  std::size_t h = std::hash<uint64_t> () (addresses);
+  h ^= std::hash<uint32_t> () (ports) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  return h;
+}
+
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
-  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
+  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152), m_nextOrder (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -43,35 +71,82 @@ Ipv4EndPointDemux::~Ipv4EndPointDemux ()
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_indexed.clear ();
+  m_fourTuples.clear ();
+  m_locals.clear ();
+  m_ports.clear ();
 }
 
-bool
-Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  NS_LOG_FUNCTION (this << endPoint);
+  EndPointKey key (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                   endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+  IndexedEndPoint indexed = { m_endPoints.insert (m_endPoints.end (), endPoint), m_nextOrder++, key };
+  m_indexed.insert (std::make_pair (endPoint, indexed));
+  m_ports[key.m_localPort].insert (std::make_pair (indexed.m_order, endPoint));
+  AddToIndex (endPoint, indexed.m_order, key);
+  endPoint->m_demux = this;
+}
+
+void
+Ipv4EndPointDemux::Update (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  std::unordered_map<Ipv4EndPoint *, IndexedEndPoint>::iterator it = m_indexed.find (endPoint);
+  NS_ASSERT (it != m_indexed.end ());
+  RemoveFromIndex (endPoint, it->second.m_key);
+  it->second.m_key = EndPointKey (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                                  endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+  AddToIndex (endPoint, it->second.m_order, it->second.m_key);
+}
+
+void
+Ipv4EndPointDemux::AddToIndex (Ipv4EndPoint *endPoint, uint64_t order, const EndPointKey &key)
+{
+  m_fourTuples[key].push_back (std::make_pair (order, endPoint));
+  m_locals[EndPointKey (key.m_localAddress, key.m_localPort, Ipv4Address::GetAny (), 0)]++;
+}
+
+void
+Ipv4EndPointDemux::RemoveFromIndex (Ipv4EndPoint *endPoint, const EndPointKey &key)
+{
+  std::unordered_map<EndPointKey, Bucket, EndPointKeyHash>::iterator bucket = m_fourTuples.find (key);
+  NS_ASSERT (bucket != m_fourTuples.end ());
+  for (Bucket::iterator i = bucket->second.begin (); i != bucket->second.end (); i++)
     {
-      if ((*i)->GetLocalPort  () == port) 
+      if (i->second == endPoint)
         {
-          return true;
+          bucket->second.erase (i);
+          break;
         }
     }
-  return false;
+  if (bucket->second.empty ())
+    {
+      m_fourTuples.erase (bucket);
+    }
+  std::unordered_map<EndPointKey, uint32_t, EndPointKeyHash>::iterator local =
+    m_locals.find (EndPointKey (key.m_localAddress, key.m_localPort, Ipv4Address::GetAny (), 0));
+  NS_ASSERT (local != m_locals.end ());
+  if (--local->second == 0)
+    {
+      m_locals.erase (local);
+    }
+}
+
+bool
+Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_locals.find (EndPointKey (addr, port, Ipv4Address::GetAny (), 0)) != m_locals.end ();
 }
 
 Ipv4EndPoint *
@@ -85,7 +160,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -101,7 +176,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -124,7 +199,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -134,21 +209,15 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (m_fourTuples.find (EndPointKey (localAddress, localPort, peerAddress, peerPort)) != m_fourTuples.end ())
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
-        {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
-        }
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -159,15 +228,22 @@ void
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::unordered_map<Ipv4EndPoint *, IndexedEndPoint>::iterator it = m_indexed.find (endPoint);
+  if (it == m_indexed.end ())
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
     }
+  RemoveFromIndex (endPoint, it->second.m_key);
+  std::unordered_map<uint16_t, std::map<uint64_t, Ipv4EndPoint *> >::iterator port =
+    m_ports.find (it->second.m_key.m_localPort);
+  port->second.erase (it->second.m_order);
+  if (port->second.empty ())
+    {
+      m_ports.erase (port);
+    }
+  m_endPoints.erase (it->second.m_position);
+  m_indexed.erase (it);
+  delete endPoint;
 }
 
 /*
@@ -206,9 +282,55 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  uint32_t nAddresses = incomingInterface ? incomingInterface->GetNAddresses () : 0;
+  for (uint32_t i = 0; i < nAddresses; i++)
     {
-      Ipv4EndPoint* endP = *i;
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+        {
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
+        }
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
+
+  // Only the endpoints bound to the destination address, to the address
+  // of the interface for a broadcast, or to any address, and either
+  // connected to the source or not connected, can match: collect them
+  // from the four-tuple index, in allocation order.
+  Ipv4Address localAddresses[3] = { daddr, incomingInterfaceAddr, Ipv4Address::GetAny () };
+  std::vector<EndPointKey> keys;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      EndPointKey connected (localAddresses[i], dport, saddr, sport);
+      if (std::find (keys.begin (), keys.end (), connected) == keys.end ())
+        {
+          keys.push_back (connected);
+        }
+      EndPointKey unconnected (localAddresses[i], dport, Ipv4Address::GetAny (), 0);
+      if (std::find (keys.begin (), keys.end (), unconnected) == keys.end ())
+        {
+          keys.push_back (unconnected);
+        }
+    }
+  Bucket candidates;
+  for (std::vector<EndPointKey>::const_iterator key = keys.begin (); key != keys.end (); key++)
+    {
+      std::unordered_map<EndPointKey, Bucket, EndPointKeyHash>::const_iterator bucket = m_fourTuples.find (*key);
+      if (bucket != m_fourTuples.end ())
+        {
+          candidates.insert (candidates.end (), bucket->second.begin (), bucket->second.end ());
+        }
+    }
+  std::sort (candidates.begin (), candidates.end ());
+
+  for (Bucket::const_iterator i = candidates.begin (); i != candidates.end (); i++)
+    {
+      Ipv4EndPoint* endP = i->second;
 
       NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
                                                  << " daddr=" << endP->GetLocalAddress ()
@@ -222,14 +344,6 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
           continue;
         }
 
-      if (endP->GetLocalPort () != dport) 
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
       if (endP->GetBoundNetDevice ())
         {
           if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
@@ -241,20 +355,6 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
               continue;
             }
         }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-        {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
-            {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
-            }
-        }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
       bool localAddressMatchesWildCard = 
         endP->GetLocalAddress () == Ipv4Address::GetAny ();
       bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
@@ -326,35 +426,37 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport);
 
+  std::unordered_map<EndPointKey, Bucket, EndPointKeyHash>::const_iterator exact =
+    m_fourTuples.find (EndPointKey (daddr, dport, saddr, sport));
+  if (exact != m_fourTuples.end ())
+    {
+      /* this is an exact match. */
+      return std::min_element (exact->second.begin (), exact->second.end ())->second;
+    }
+
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
+  std::unordered_map<uint16_t, std::map<uint64_t, Ipv4EndPoint *> >::const_iterator port = m_ports.find (dport);
+  if (port == m_ports.end ())
+    {
+      return 0;
+    }
   uint32_t genericity = 3;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (std::map<uint64_t, Ipv4EndPoint *>::const_iterator i = port->second.begin (); i != port->second.end (); i++)
     {
-      if ((*i)->GetLocalPort () != dport) 
-        {
-          continue;
-        }
-      if ((*i)->GetLocalAddress () == daddr &&
-          (*i)->GetPeerPort () == sport &&
-          (*i)->GetPeerAddress () == saddr) 
-        {
-          /* this is an exact match. */
-          return *i;
-        }
       uint32_t tmp = 0;
-      if ((*i)->GetLocalAddress () == Ipv4Address::GetAny ()) 
+      if (i->second->GetLocalAddress () == Ipv4Address::GetAny ()) 
         {
           tmp++;
         }
-      if ((*i)->GetPeerAddress () == Ipv4Address::GetAny ()) 
+      if (i->second->GetPeerAddress () == Ipv4Address::GetAny ()) 
         {
           tmp++;
         }
       if (tmp < genericity) 
         {
-          generic = (*i);
+          generic = i->second;
           genericity = tmp;
         }
     }
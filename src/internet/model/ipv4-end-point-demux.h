@@ -23,6 +23,9 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <vector>
+#include <unordered_map>
 #include "ns3/ipv4-address.h"
 #include "ipv4-interface.h"
 
@@ -40,6 +43,11 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * The endpoints are also indexed by four-tuple, by local address and
+ * port, and by local port, so that the cost of a lookup does not grow
+ * with the number of endpoints. The endpoints notify their demux when
+ * their addresses change, to keep the indexes up to date.
  */
 
 class Ipv4EndPointDemux {
@@ -163,6 +171,90 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief The four-tuple of an endpoint, key of the indexes.
+   */
+  struct EndPointKey
+  {
+    /**
+     * \brief Constructor.
+     * \param localAddress local address
+     * \param localPort local port
+     * \param peerAddress peer address
+     * \param peerPort peer port
+     */
+    EndPointKey (Ipv4Address localAddress, uint16_t localPort,
+                 Ipv4Address peerAddress, uint16_t peerPort);
+    /**
+     * \brief Equality operator.
+     * \param other the other key
+     * \returns true if the four-tuples are the same
+     */
+    bool operator == (const EndPointKey &other) const;
+
+    Ipv4Address m_localAddress; //!< local address
+    uint16_t m_localPort;       //!< local port
+    Ipv4Address m_peerAddress;  //!< peer address
+    uint16_t m_peerPort;        //!< peer port
+  };
+
+  /**
+   * \brief Hash function of an EndPointKey.
+   */
+  struct EndPointKeyHash
+  {
+    /**
+     * \param key the four-tuple
+     * \returns the hash of the four-tuple
+     */
+    std::size_t operator () (const EndPointKey &key) const;
+  };
+
+  /**
+   * \brief Endpoints, with their allocation order.
+   */
+  typedef std::vector<std::pair<uint64_t, Ipv4EndPoint *> > Bucket;
+
+  /**
+   * \brief Where an endpoint is in the list and in the indexes.
+   */
+  struct IndexedEndPoint
+  {
+    EndPointsI m_position; //!< position in the list of endpoints
+    uint64_t m_order;      //!< allocation order
+    EndPointKey m_key;     //!< four-tuple under which the endpoint is indexed
+  };
+
+  /**
+   * \brief Add a new end point to the list and to the indexes.
+   * \param endPoint the end point
+   */
+  void Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Index an end point under its current four-tuple.
+   *
+   * Called by the end point when its local or peer address changes.
+   * \param endPoint the end point
+   */
+  void Update (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Add an end point to the four-tuple and local address indexes.
+   * \param endPoint the end point
+   * \param order the allocation order of the end point
+   * \param key the four-tuple of the end point
+   */
+  void AddToIndex (Ipv4EndPoint *endPoint, uint64_t order, const EndPointKey &key);
+
+  /**
+   * \brief Remove an end point from the four-tuple and local address indexes.
+   * \param endPoint the end point
+   * \param key the four-tuple under which the end point is indexed
+   */
+  void RemoveFromIndex (Ipv4EndPoint *endPoint, const EndPointKey &key);
 
   /**
    * \brief Allocate an ephemeral port.
@@ -189,6 +281,32 @@ private:
    * \brief A list of IPv4 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The allocation order of the next end point.
+   */
+  uint64_t m_nextOrder;
+
+  /**
+   * \brief Position of each end point in the list and in the indexes.
+   */
+  std::unordered_map<Ipv4EndPoint *, IndexedEndPoint> m_indexed;
+
+  /**
+   * \brief The end points, indexed by four-tuple.
+   */
+  std::unordered_map<EndPointKey, Bucket, EndPointKeyHash> m_fourTuples;
+
+  /**
+   * \brief The number of end points of each local address and port
+   * (the peer of the key is unspecified).
+   */
+  std::unordered_map<EndPointKey, uint32_t, EndPointKeyHash> m_locals;
+
+  /**
+   * \brief The end points of each local port, in allocation order.
+   */
+  std::unordered_map<uint16_t, std::map<uint64_t, Ipv4EndPoint *> > m_ports;
 };
 
 } // namespace ns3
@@ -21,15 +21,44 @@
 #include "ipv6-end-point-demux.h"
 #include "ipv6-end-point.h"
 #include "ns3/log.h"
+#include <algorithm>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv6EndPointDemux");
 
+Ipv6EndPointDemux::EndPointKey::EndPointKey (Ipv6Address localAddress, uint16_t localPort,
+                                             Ipv6Address peerAddress, uint16_t peerPort)
+  : m_localAddress (localAddress),
+    m_localPort (localPort),
+    m_peerAddress (peerAddress),
+    m_peerPort (peerPort)
+{
+}
+
+bool Ipv6EndPointDemux::EndPointKey::operator == (const EndPointKey &other) const
+{
+  return m_localPort == other.m_localPort
+         && m_peerPort == other.m_peerPort
+         && m_localAddress == other.m_localAddress
+         && m_peerAddress == other.m_peerAddress;
+}
+
+std::size_t Ipv6EndPointDemux::EndPointKeyHash::operator () (const EndPointKey &key) const
+{
+  Ipv6AddressHash addressHash;
+  uint32_t ports = (static_cast<uint32_t> (key.m_localPort) << 16) | key.m_peerPort;
+  std::size_t h = addressHash (key.m_localAddress);
+  h ^= addressHash (key.m_peerAddress) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  h ^= std::hash<uint32_t> () (ports) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  return h;
+}
+
 Ipv6EndPointDemux::Ipv6EndPointDemux ()
   : m_ephemeral (49152),
     m_portFirst (49152),
-    m_portLast (65535)
+    m_portLast (65535),
+    m_nextOrder (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -43,33 +72,76 @@ Ipv6EndPointDemux::~Ipv6EndPointDemux ()
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_indexed.clear ();
+  m_fourTuples.clear ();
+  m_locals.clear ();
+  m_ports.clear ();
 }
 
-bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+void Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  NS_LOG_FUNCTION (this << endPoint);
+  EndPointKey key (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                   endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+  IndexedEndPoint indexed = { m_endPoints.insert (m_endPoints.end (), endPoint), m_nextOrder++, key };
+  m_indexed.insert (std::make_pair (endPoint, indexed));
+  m_ports[key.m_localPort].insert (std::make_pair (indexed.m_order, endPoint));
+  AddToIndex (endPoint, indexed.m_order, key);
+  endPoint->m_demux = this;
+}
+
+void Ipv6EndPointDemux::Update (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  std::unordered_map<Ipv6EndPoint *, IndexedEndPoint>::iterator it = m_indexed.find (endPoint);
+  NS_ASSERT (it != m_indexed.end ());
+  RemoveFromIndex (endPoint, it->second.m_key);
+  it->second.m_key = EndPointKey (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                                  endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+  AddToIndex (endPoint, it->second.m_order, it->second.m_key);
+}
+
+void Ipv6EndPointDemux::AddToIndex (Ipv6EndPoint *endPoint, uint64_t order, const EndPointKey &key)
+{
+  m_fourTuples[key].push_back (std::make_pair (order, endPoint));
+  m_locals[EndPointKey (key.m_localAddress, key.m_localPort, Ipv6Address::GetAny (), 0)]++;
+}
+
+void Ipv6EndPointDemux::RemoveFromIndex (Ipv6EndPoint *endPoint, const EndPointKey &key)
+{
+  std::unordered_map<EndPointKey, Bucket, EndPointKeyHash>::iterator bucket = m_fourTuples.find (key);
+  NS_ASSERT (bucket != m_fourTuples.end ());
+  for (Bucket::iterator i = bucket->second.begin (); i != bucket->second.end (); i++)
     {
-      if ((*i)->GetLocalPort  () == port)
+      if (i->second == endPoint)
         {
-          return true;
+          bucket->second.erase (i);
+          break;
         }
     }
-  return false;
+  if (bucket->second.empty ())
+    {
+      m_fourTuples.erase (bucket);
+    }
+  std::unordered_map<EndPointKey, uint32_t, EndPointKeyHash>::iterator local =
+    m_locals.find (EndPointKey (key.m_localAddress, key.m_localPort, Ipv6Address::GetAny (), 0));
+  NS_ASSERT (local != m_locals.end ());
+  if (--local->second == 0)
+    {
+      m_locals.erase (local);
+    }
+}
+
+bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
-    {
-      if ((*i)->GetLocalPort () == port
-          && (*i)->GetLocalAddress () == addr)
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_locals.find (EndPointKey (addr, port, Ipv6Address::GetAny (), 0)) != m_locals.end ();
 }
 
 Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
@@ -82,7 +154,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -97,7 +169,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -118,7 +190,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address, uint16_t port)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -127,21 +199,15 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (m_fourTuples.find (EndPointKey (localAddress, localPort, peerAddress, peerPort)) != m_fourTuples.end ())
     {
-      if ((*i)->GetLocalPort () == localPort
-          && (*i)->GetLocalAddress () == localAddress
-          && (*i)->GetPeerPort () == peerPort
-          && (*i)->GetPeerAddress () == peerAddress)
-        {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
-        }
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -151,15 +217,22 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::unordered_map<Ipv6EndPoint *, IndexedEndPoint>::iterator it = m_indexed.find (endPoint);
+  if (it == m_indexed.end ())
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
     }
+  RemoveFromIndex (endPoint, it->second.m_key);
+  std::unordered_map<uint16_t, std::map<uint64_t, Ipv6EndPoint *> >::iterator port =
+    m_ports.find (it->second.m_key.m_localPort);
+  port->second.erase (it->second.m_order);
+  if (port->second.empty ())
+    {
+      m_ports.erase (port);
+    }
+  m_endPoints.erase (it->second.m_position);
+  m_indexed.erase (it);
+  delete endPoint;
 }
 
 /*
@@ -179,9 +252,39 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval4; /* Exact match on all 4 */
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+
+  /* Only the endpoints bound to the destination address or to any
+     address, and either connected to the source or not connected, can
+     match: collect them from the four-tuple index, in allocation order. */
+  Ipv6Address localAddresses[2] = { daddr, Ipv6Address::GetAny () };
+  std::vector<EndPointKey> keys;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      EndPointKey connected (localAddresses[i], dport, saddr, sport);
+      if (std::find (keys.begin (), keys.end (), connected) == keys.end ())
+        {
+          keys.push_back (connected);
+        }
+      EndPointKey unconnected (localAddresses[i], dport, Ipv6Address::GetAny (), 0);
+      if (std::find (keys.begin (), keys.end (), unconnected) == keys.end ())
+        {
+          keys.push_back (unconnected);
+        }
+    }
+  Bucket candidates;
+  for (std::vector<EndPointKey>::const_iterator key = keys.begin (); key != keys.end (); key++)
+    {
+      std::unordered_map<EndPointKey, Bucket, EndPointKeyHash>::const_iterator bucket = m_fourTuples.find (*key);
+      if (bucket != m_fourTuples.end ())
+        {
+          candidates.insert (candidates.end (), bucket->second.begin (), bucket->second.end ());
+        }
+    }
+  std::sort (candidates.begin (), candidates.end ());
+
+  for (Bucket::const_iterator i = candidates.begin (); i != candidates.end (); i++)
     {
-      Ipv6EndPoint* endP = *i;
+      Ipv6EndPoint* endP = i->second;
 
       NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
                                                  << " daddr=" << endP->GetLocalAddress ()
@@ -195,15 +298,6 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
           continue;
         }
 
-      if (endP->GetLocalPort () != dport)
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
-
       if (endP->GetBoundNetDevice ())
         {
           if (!incomingInterface)
@@ -293,38 +387,39 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
 
 Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport, Ipv6Address src, uint16_t sport)
 {
+  std::unordered_map<EndPointKey, Bucket, EndPointKeyHash>::const_iterator exact =
+    m_fourTuples.find (EndPointKey (dst, dport, src, sport));
+  if (exact != m_fourTuples.end ())
+    {
+      /* this is an exact match. */
+      return std::min_element (exact->second.begin (), exact->second.end ())->second;
+    }
+
+  std::unordered_map<uint16_t, std::map<uint64_t, Ipv6EndPoint *> >::const_iterator port = m_ports.find (dport);
+  if (port == m_ports.end ())
+    {
+      return 0;
+    }
   uint32_t genericity = 3;
   Ipv6EndPoint *generic = 0;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (std::map<uint64_t, Ipv6EndPoint *>::const_iterator i = port->second.begin (); i != port->second.end (); i++)
     {
       uint32_t tmp = 0;
 
-      if ((*i)->GetLocalPort () != dport)
-        {
-          continue;
-        }
-
-      if ((*i)->GetLocalAddress () == dst && (*i)->GetPeerPort () == sport
-          && (*i)->GetPeerAddress () == src)
-        {
-          /* this is an exact match. */
-          return *i;
-        }
-
-      if ((*i)->GetLocalAddress () == Ipv6Address::GetAny ())
+      if (i->second->GetLocalAddress () == Ipv6Address::GetAny ())
         {
           tmp++;
         }
 
-      if ((*i)->GetPeerAddress () == Ipv6Address::GetAny ())
+      if (i->second->GetPeerAddress () == Ipv6Address::GetAny ())
         {
           tmp++;
         }
 
       if (tmp < genericity)
         {
-          generic = (*i);
+          generic = i->second;
           genericity = tmp;
         }
     }
@@ -107,4 +107,25 @@ Ipv6QueueDiscItem::GetUint8Value (QueueItem::Uint8Values field, uint8_t& value)
   return ret;
 }
 
+void *
+Ipv6QueueDiscItem::operator new (std::size_t size)
+{
+  return GetPool ().Allocate (size);
+}
+
+void
+Ipv6QueueDiscItem::operator delete (void *p, std::size_t size)
+{
+  GetPool ().Deallocate (p, size);
+}
+
+QueueDiscItemPool &
+Ipv6QueueDiscItem::GetPool (void)
+{
+  // one pool per thread, as the items are allocated and freed concurrently
+  // by the partitions of the MultithreadedSimulatorImpl
+  static thread_local QueueDiscItemPool pool (sizeof (Ipv6QueueDiscItem));
+  return pool;
+}
+
 } // namespace ns3
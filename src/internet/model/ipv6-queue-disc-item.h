@@ -24,6 +24,7 @@
 #include "ns3/net-device.h"
 #include "ns3/traced-value.h"
 #include "ns3/queue-disc.h"
+#include "ns3/queue-disc-item-pool.h"
 #include "ipv6-header.h"
 
 namespace ns3 {
@@ -85,6 +86,27 @@ public:
    */
   virtual bool Mark (void);
 
+  /**
+   * \brief Allocate memory for an item from the pool of IPv6 queue disc items
+   * \param size the size of the item
+   * \return a pointer to the allocated memory
+   */
+  static void * operator new (std::size_t size);
+
+  /**
+   * \brief Return the memory of an item to the pool of IPv6 queue disc items
+   * \param p the pointer to the memory
+   * \param size the size of the item
+   */
+  static void operator delete (void *p, std::size_t size);
+
+  /**
+   * \brief Get the pool of IPv6 queue disc items of the calling thread,
+   * e.g., to read its hit and miss counters
+   * \return the pool of IPv6 queue disc items of the calling thread
+   */
+  static QueueDiscItemPool & GetPool (void);
+
 private:
   /**
    * \brief Default constructor
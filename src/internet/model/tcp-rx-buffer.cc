@@ -18,9 +18,13 @@
  * Author: Adrian Sai-wah Tam <adrian.sw.tam@gmail.com>
  */
 
+#include <algorithm>
+#include <cstring>
 #include "ns3/packet.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
 #include "tcp-rx-buffer.h"
 
 namespace ns3 {
@@ -36,6 +40,14 @@ TcpRxBuffer::GetTypeId (void)
     .SetParent<Object> ()
     .SetGroupName ("Internet")
     .AddConstructor<TcpRxBuffer> ()
+    .AddAttribute ("ContiguousStorage",
+                   "Store the received data in a byte ring, with an interval "
+                   "set of the out-of-order ranges, instead of one packet "
+                   "per segment",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpRxBuffer::SetContiguousStorage,
+                                        &TcpRxBuffer::GetContiguousStorage),
+                   MakeBooleanChecker ())
     .AddTraceSource ("NextRxSequence",
                      "Next sequence number expected (RCV.NXT)",
                      MakeTraceSourceAccessor (&TcpRxBuffer::m_nextRxSeq),
@@ -52,7 +64,8 @@ TcpRxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpRxBuffer::TcpRxBuffer (uint32_t n)
-  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0)
+  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0),
+    m_contiguous (false), m_ringStart (0), m_stamp (0)
 {
 }
 
@@ -84,6 +97,20 @@ TcpRxBuffer::SetMaxBufferSize (uint32_t s)
   m_maxBuffer = s;
 }
 
+void
+TcpRxBuffer::SetContiguousStorage (bool contiguous)
+{
+  NS_LOG_FUNCTION (this << contiguous);
+  NS_ABORT_MSG_IF (m_size != 0, "Cannot change the storage of a non-empty TcpRxBuffer");
+  m_contiguous = contiguous;
+}
+
+bool
+TcpRxBuffer::GetContiguousStorage (void) const
+{
+  return m_contiguous;
+}
+
 uint32_t
 TcpRxBuffer::Size (void) const
 {
@@ -114,13 +141,39 @@ TcpRxBuffer::MaxRxSequence (void) const
     { // No data allowed beyond FIN
       return m_finSeq;
     }
-  else if (m_data.size () && m_nextRxSeq > m_data.begin ()->first)
+  SequenceNumber32 firstSeq;
+  if (GetFirstSequence (&firstSeq) && m_nextRxSeq > firstSeq)
     { // No data allowed beyond Rx window allowed
-      return m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      return firstSeq + SequenceNumber32 (m_maxBuffer);
     }
   return m_nextRxSeq + SequenceNumber32 (m_maxBuffer);
 }
 
+bool
+TcpRxBuffer::GetFirstSequence (SequenceNumber32 *seq) const
+{
+  if (!m_contiguous)
+    {
+      if (m_data.empty ())
+        {
+          return false;
+        }
+      *seq = m_data.begin ()->first;
+      return true;
+    }
+  if (m_availBytes > 0)
+    {
+      *seq = m_headSeq;
+      return true;
+    }
+  if (!m_intervals.empty ())
+    {
+      *seq = m_intervals.front ().m_head;
+      return true;
+    }
+  return false;
+}
+
 void
 TcpRxBuffer::SetFinSequence (const SequenceNumber32& s)
 {
@@ -150,12 +203,22 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
 
   // Trim packet to fit Rx window specification
   if (headSeq < m_nextRxSeq) headSeq = m_nextRxSeq;
-  if (m_data.size ())
+  SequenceNumber32 firstSeq;
+  if (GetFirstSequence (&firstSeq))
     {
-      SequenceNumber32 maxSeq = m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      SequenceNumber32 maxSeq = firstSeq + SequenceNumber32 (m_maxBuffer);
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
+  if (m_contiguous)
+    {
+      if (headSeq >= tailSeq)
+        {
+          NS_LOG_LOGIC ("Nothing to buffer");
+          return false;
+        }
+      return AddContiguous (p, headSeq, tailSeq, headSeq - tcph.GetSequenceNumber ());
+    }
   // Remove overlapped bytes from packet
   BufIterator i = m_data.begin ();
   while (i != m_data.end () && i->first <= tailSeq)
@@ -228,11 +291,127 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
   return true;
 }
 
+bool
+TcpRxBuffer::AddContiguous (Ptr<Packet> p, SequenceNumber32 headSeq,
+                            SequenceNumber32 tailSeq, uint32_t offset)
+{
+  NS_LOG_FUNCTION (this << p << headSeq << tailSeq << offset);
+  NS_ASSERT (headSeq >= m_nextRxSeq);
+
+  // Find the intervals that overlap or touch the new range, and count the
+  // bytes of the range that are already stored
+  std::vector<Interval>::iterator first = m_intervals.begin ();
+  while (first != m_intervals.end () && first->m_tail < headSeq)
+    {
+      ++first;
+    }
+  std::vector<Interval>::iterator last = first;
+  uint32_t stored = 0;
+  for (; last != m_intervals.end () && last->m_head <= tailSeq; ++last)
+    {
+      SequenceNumber32 h = std::max (headSeq, last->m_head);
+      SequenceNumber32 t = std::min (tailSeq, last->m_tail);
+      if (h < t)
+        {
+          stored += t - h;
+        }
+    }
+  uint32_t length = tailSeq - headSeq;
+  if (stored == length)
+    {
+      NS_LOG_LOGIC ("Nothing to buffer");
+      return false;
+    }
+
+  if (m_size == 0)
+    { // Restart the ring from the next expected byte
+      m_headSeq = m_nextRxSeq;
+      m_ringStart = 0;
+    }
+  uint32_t end = tailSeq - m_headSeq;
+  ReserveRing (end);
+  uint32_t mask = m_ring.size () - 1;
+  uint32_t pos = (m_ringStart + (headSeq - m_headSeq)) & mask;
+  uint32_t firstPart = std::min<uint32_t> (length, m_ring.size () - pos);
+  if (offset == 0 && firstPart == length)
+    {
+      p->CopyData (&m_ring[pos], length);
+    }
+  else
+    {
+      if (m_scratch.size () < offset + length)
+        {
+          m_scratch.resize (offset + length);
+        }
+      p->CopyData (&m_scratch[0], offset + length);
+      std::memcpy (&m_ring[pos], &m_scratch[offset], firstPart);
+      std::memcpy (&m_ring[0], &m_scratch[offset + firstPart], length - firstPart);
+    }
+
+  // Replace the touched intervals with their union with the new range
+  Interval merged;
+  merged.m_head = headSeq;
+  merged.m_tail = tailSeq;
+  merged.m_stamp = ++m_stamp;
+  if (first != last)
+    {
+      merged.m_head = std::min (headSeq, first->m_head);
+      merged.m_tail = std::max (tailSeq, (last - 1)->m_tail);
+      first = m_intervals.erase (first, last);
+    }
+  m_intervals.insert (first, merged);
+  m_size += length - stored;
+
+  // The first interval becomes in-order data once it reaches m_nextRxSeq
+  if (m_intervals.front ().m_head == m_nextRxSeq)
+    {
+      m_availBytes += m_intervals.front ().m_tail - m_nextRxSeq.Get ();
+      m_nextRxSeq = m_intervals.front ().m_tail;
+      m_intervals.erase (m_intervals.begin ());
+    }
+  NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
+  if (m_gotFin && m_nextRxSeq == m_finSeq)
+    { // Account for the FIN packet
+      ++m_nextRxSeq;
+    }
+  return true;
+}
+
+void
+TcpRxBuffer::ReserveRing (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+
+  uint32_t capacity = m_ring.size ();
+  if (size <= capacity)
+    {
+      return;
+    }
+  uint32_t newCapacity = std::max<uint32_t> (capacity, 4096);
+  while (newCapacity < size)
+    {
+      newCapacity *= 2;
+    }
+  // Unwrap the old ring at the beginning of the new one
+  std::vector<uint8_t> ring (newCapacity);
+  if (capacity > 0)
+    {
+      std::memcpy (&ring[0], &m_ring[m_ringStart], capacity - m_ringStart);
+      std::memcpy (&ring[capacity - m_ringStart], &m_ring[0], m_ringStart);
+    }
+  m_ring.swap (ring);
+  m_ringStart = 0;
+}
+
 uint32_t
 TcpRxBuffer::GetSackListSize () const
 {
   NS_LOG_FUNCTION (this);
 
+  if (m_contiguous)
+    {
+      return std::min<uint32_t> (m_intervals.size (), 4);
+    }
   return m_sackList.size ();
 }
 
@@ -354,7 +533,33 @@ TcpRxBuffer::ClearSackList (const SequenceNumber32 &seq)
 TcpOptionSack::SackList
 TcpRxBuffer::GetSackList () const
 {
-  return m_sackList;
+  if (!m_contiguous)
+    {
+      return m_sackList;
+    }
+
+  // Report up to 4 intervals, the most recently updated first, which follows
+  // the rules (a) and (c) of RFC 2018 quoted in UpdateSackList
+  TcpOptionSack::SackList sackList;
+  uint32_t below = m_stamp + 1;
+  while (sackList.size () < 4)
+    {
+      std::vector<Interval>::const_iterator best = m_intervals.end ();
+      for (std::vector<Interval>::const_iterator it = m_intervals.begin (); it != m_intervals.end (); ++it)
+        {
+          if (it->m_stamp < below && (best == m_intervals.end () || it->m_stamp > best->m_stamp))
+            {
+              best = it;
+            }
+        }
+      if (best == m_intervals.end ())
+        {
+          break;
+        }
+      sackList.push_back (TcpOptionSack::SackBlock (best->m_head, best->m_tail));
+      below = best->m_stamp;
+    }
+  return sackList;
 }
 
 Ptr<Packet>
@@ -365,6 +570,10 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   uint32_t extractSize = std::min (maxSize, m_availBytes);
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from TcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return 0;  // No contiguous block to return
+  if (m_contiguous)
+    {
+      return ExtractContiguous (extractSize);
+    }
   NS_ASSERT (m_data.size ()); // At least we have something to extract
   Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
   BufIterator i;
@@ -402,4 +611,35 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   return outPkt;
 }
 
+Ptr<Packet>
+TcpRxBuffer::ExtractContiguous (uint32_t extractSize)
+{
+  NS_LOG_FUNCTION (this << extractSize);
+  NS_ASSERT (extractSize <= m_availBytes);
+
+  Ptr<Packet> outPkt;
+  uint32_t firstPart = std::min<uint32_t> (extractSize, m_ring.size () - m_ringStart);
+  if (firstPart == extractSize)
+    {
+      outPkt = Create<Packet> (&m_ring[m_ringStart], extractSize);
+    }
+  else
+    {
+      if (m_scratch.size () < extractSize)
+        {
+          m_scratch.resize (extractSize);
+        }
+      std::memcpy (&m_scratch[0], &m_ring[m_ringStart], firstPart);
+      std::memcpy (&m_scratch[firstPart], &m_ring[0], extractSize - firstPart);
+      outPkt = Create<Packet> (&m_scratch[0], extractSize);
+    }
+  m_ringStart = (m_ringStart + extractSize) & (m_ring.size () - 1);
+  m_headSeq += extractSize;
+  m_size -= extractSize;
+  m_availBytes -= extractSize;
+  NS_LOG_LOGIC ("Extracted " << extractSize << " bytes, bufsize=" << m_size
+                             << ", num ranges in buffer=" << m_intervals.size ());
+  return outPkt;
+}
+
 } //namepsace ns3
@@ -22,6 +22,7 @@
 #define TCP_RX_BUFFER_H
 
 #include <map>
+#include <vector>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/sequence-number.h"
@@ -67,6 +68,20 @@ class Packet;
  * For more information about the SACK list, please check the documentation of
  * the method GetSackList.
  *
+ * Contiguous storage
+ * ------------------
+ *
+ * By default, each segment is stored as a Packet in a map indexed by its
+ * sequence number, and Extract rebuilds the data with one Packet::AddAtEnd
+ * per segment. When the attribute ContiguousStorage is set, the payload bytes
+ * are instead copied into a byte ring indexed by sequence number, and the
+ * out-of-order ranges are kept in a sorted set of intervals. In this mode
+ * Add does not allocate anything once the ring has grown to the window size,
+ * Extract returns a single Packet built from the ring, and the SACK list is
+ * generated from the interval set (most recently updated ranges first). The
+ * packets given to the application then carry the received bytes, but not the
+ * tags and metadata of the received segments.
+ *
  * \see GetSackList
  * \see UpdateSackList
  */
@@ -175,7 +190,70 @@ public:
    */
   uint32_t GetSackListSize () const;
 
+  /**
+   * \brief Select how the received data is stored
+   *
+   * Can be changed only while the buffer is empty.
+   *
+   * \param contiguous true to store the data in a byte ring with an interval
+   * set of out-of-order ranges, false to store one packet per segment
+   */
+  void SetContiguousStorage (bool contiguous);
+
+  /**
+   * \brief Check how the received data is stored
+   *
+   * \return true if the data is stored in a byte ring
+   */
+  bool GetContiguousStorage (void) const;
+
 private:
+  /**
+   * \brief A range of out-of-order data stored in the byte ring
+   */
+  struct Interval
+  {
+    SequenceNumber32 m_head;  //!< Sequence number of the first byte
+    SequenceNumber32 m_tail;  //!< Sequence number following the last byte
+    uint32_t m_stamp;         //!< Order of the last update, for the SACK list
+  };
+
+  /**
+   * \brief Add implementation for the contiguous storage
+   *
+   * \param p packet
+   * \param headSeq sequence number of the first byte to store (already trimmed)
+   * \param tailSeq sequence number following the last byte to store
+   * \param offset offset of headSeq in the packet
+   * \return True when new data has been stored, false otherwise.
+   */
+  bool AddContiguous (Ptr<Packet> p, SequenceNumber32 headSeq,
+                      SequenceNumber32 tailSeq, uint32_t offset);
+
+  /**
+   * \brief Extract implementation for the contiguous storage
+   *
+   * \param extractSize number of bytes to extract (not more than available)
+   * \returns a packet
+   */
+  Ptr<Packet> ExtractContiguous (uint32_t extractSize);
+
+  /**
+   * \brief Grow the byte ring so that it holds at least size bytes from m_headSeq
+   *
+   * \param size number of bytes needed
+   */
+  void ReserveRing (uint32_t size);
+
+  /**
+   * \brief Get the lowest sequence number stored in the buffer
+   *
+   * \param seq set to the lowest sequence number, if any
+   * \return false if the buffer is empty
+   */
+  bool GetFirstSequence (SequenceNumber32 *seq) const;
+
+
   /**
    * \brief Update the sack list, with the block seq starting at the beginning
    *
@@ -220,6 +298,14 @@ private:
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
   std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+
+  bool m_contiguous;                         //!< Store the data in the byte ring
+  std::vector<uint8_t> m_ring;               //!< Byte ring (size is a power of two, or zero)
+  uint32_t m_ringStart;                      //!< Position of m_headSeq in the ring
+  SequenceNumber32 m_headSeq;                //!< Seqnum of the first byte stored in the ring
+  std::vector<Interval> m_intervals;         //!< Out-of-order ranges, sorted and disjoint
+  uint32_t m_stamp;                          //!< Stamp of the last updated interval
+  std::vector<uint8_t> m_scratch;            //!< Copy area for the data that wraps around the ring
 };
 
 } //namepsace ns3
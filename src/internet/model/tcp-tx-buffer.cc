@@ -35,6 +35,7 @@ NS_LOG_COMPONENT_DEFINE ("TcpTxBuffer");
 
 TcpTxItem::TcpTxItem ()
   : m_packet (0),
+    m_startSeq (0),
     m_lost (false),
     m_retrans (false),
     m_lastSent (Time::Min ()),
@@ -44,6 +45,7 @@ TcpTxItem::TcpTxItem ()
 
 TcpTxItem::TcpTxItem (const TcpTxItem &other)
   : m_packet (other.m_packet),
+    m_startSeq (other.m_startSeq),
     m_lost (other.m_lost),
     m_retrans (other.m_retrans),
     m_lastSent (other.m_lastSent),
@@ -112,8 +114,14 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_maxBuffer (32768), m_size (0), m_sentSize (0), m_firstByteSeq (n)
+  : m_maxBuffer (32768), m_size (0), m_sentSize (0), m_firstByteSeq (n),
+    m_sentIndexHead (0), m_retransOut (0)
 {
+  for (uint32_t c = 0; c < N_COUNTERS; ++c)
+    {
+      m_counters[c].assign (1, 0);
+      m_totals[c] = 0;
+    }
 }
 
 TcpTxBuffer::~TcpTxBuffer (void)
@@ -179,7 +187,6 @@ TcpTxBuffer::SetHeadSequence (const SequenceNumber32& seq)
 
   // if you change the head with data already sent, something bad will happen
   NS_ASSERT (m_sentList.size () == 0);
-  m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
 }
 
 bool
@@ -249,7 +256,11 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
       // already sent this block completely
       outItem = GetTransmittedSegment (s, seq);
       NS_ASSERT (outItem != 0);
+      uint32_t pos = FindSequence (seq);
+      NS_ASSERT (m_sentIndex[pos] == outItem);
+      UpdateIndex (pos, false);
       outItem->m_retrans = true;
+      UpdateIndex (pos, true);
 
       NS_LOG_DEBUG ("Retransmitting [" << seq << ";" << seq + s << "|" << s <<
                     "] from " << *this);
@@ -284,8 +295,12 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
       return CopyFromSequence (numBytes, seq);
     }
 
+  uint32_t pos = FindSequence (seq);
+  NS_ASSERT (m_sentIndex[pos] == outItem);
+  UpdateIndex (pos, false);
   outItem->m_lost = false;
   outItem->m_lastSent = Simulator::Now ();
+  UpdateIndex (pos, true);
   Ptr<Packet> toRet = outItem->m_packet->Copy ();
 
   NS_ASSERT (toRet->GetSize () == s);
@@ -313,6 +328,8 @@ TcpTxBuffer::GetNewSegment (uint32_t numBytes)
   m_appList.erase (it);
   m_sentList.insert (m_sentList.end (), item);
   m_sentSize += item->m_packet->GetSize ();
+  item->m_startSeq = startOfAppList;
+  IndexPushBack ();
 
   return item;
 }
@@ -328,38 +345,191 @@ TcpTxBuffer::GetTransmittedSegment (uint32_t numBytes, const SequenceNumber32 &s
 
   TcpTxItem *item = GetPacketFromList (m_sentList, m_firstByteSeq, numBytes, seq, &listEdited);
 
-  if (listEdited && m_highestSack.second >= m_firstByteSeq)
+  if (listEdited)
     {
-      m_highestSack = GetHighestSacked ();
+      RebuildIndex ();
     }
 
   return item;
 }
 
-std::pair <TcpTxBuffer::PacketList::const_iterator, SequenceNumber32>
-TcpTxBuffer::GetHighestSacked () const
+uint32_t
+TcpTxBuffer::FindSequence (const SequenceNumber32 &seq) const
 {
-  NS_LOG_FUNCTION (this);
+  uint32_t first = m_sentIndexHead;
+  uint32_t count = m_sentIndex.size () - first;
+  while (count > 0)
+    {
+      uint32_t step = count / 2;
+      if (m_sentIndex[first + step]->m_startSeq < seq)
+        {
+          first += step + 1;
+          count -= step + 1;
+        }
+      else
+        {
+          count = step;
+        }
+    }
+  return first;
+}
 
-  PacketList::const_iterator it;
-  std::pair <TcpTxBuffer::PacketList::const_iterator, SequenceNumber32> ret;
-  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
+uint32_t
+TcpTxBuffer::GetPrefixSum (ScoreboardCounter counter, uint32_t n) const
+{
+  const std::vector<uint32_t> &tree = m_counters[counter];
+  uint32_t sum = 0;
+  for (uint32_t i = n; i > 0; i -= i & (~i + 1))
+    {
+      sum += tree[i];
+    }
+  return sum;
+}
 
-  ret = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+uint32_t
+TcpTxBuffer::FindPrefixSum (ScoreboardCounter counter, uint32_t value) const
+{
+  const std::vector<uint32_t> &tree = m_counters[counter];
+  uint32_t n = tree.size () - 1;
+  uint32_t mask = 1;
+  while (mask <= n / 2)
+    {
+      mask <<= 1;
+    }
+  // Walk down the tree to the largest index whose prefix sum is below value
+  uint32_t pos = 0;
+  for (; n > 0 && mask != 0; mask >>= 1)
+    {
+      if (pos + mask <= n && tree[pos + mask] < value)
+        {
+          pos += mask;
+          value -= tree[pos];
+        }
+    }
+  return pos;
+}
 
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+uint32_t
+TcpTxBuffer::GetCounters (const TcpTxItem *item, uint32_t *values)
+{
+  uint32_t size = item->m_packet->GetSize ();
+  bool plain = !item->m_sacked && !item->m_lost && !item->m_retrans;
+  values[SACKED_SEGMENTS] = item->m_sacked ? 1 : 0;
+  values[SACKED_BYTES] = item->m_sacked ? size : 0;
+  values[PLAIN_SEGMENTS] = plain ? 1 : 0;
+  values[PLAIN_BYTES] = plain ? size : 0;
+  values[LOST_SEGMENTS] = !item->m_sacked && item->m_lost && !item->m_retrans ? 1 : 0;
+  return !item->m_sacked && !item->m_lost && item->m_retrans ? size : 0;
+}
+
+void
+TcpTxBuffer::UpdateIndex (uint32_t pos, bool add)
+{
+  uint32_t values[N_COUNTERS];
+  uint32_t retransOut = GetCounters (m_sentIndex[pos], values);
+
+  // Unsigned arithmetic wraps around, so removing is adding the opposite
+  uint32_t sign = add ? 1 : -1;
+  for (uint32_t c = 0; c < N_COUNTERS; ++c)
     {
-      const TcpTxItem *item = *it;
-      if (item->m_sacked)
+      if (values[c] == 0)
         {
-          ret = std::make_pair (it, beginOfCurrentPacket);
+          continue;
         }
-      beginOfCurrentPacket += item->m_packet->GetSize ();
+      std::vector<uint32_t> &tree = m_counters[c];
+      for (uint32_t i = pos + 1; i < tree.size (); i += i & (~i + 1))
+        {
+          tree[i] += sign * values[c];
+        }
+      m_totals[c] += sign * values[c];
+    }
+  m_retransOut += sign * retransOut;
+}
+
+void
+TcpTxBuffer::IndexPushBack (void)
+{
+  NS_ASSERT (m_sentIndex.size () - m_sentIndexHead + 1 == m_sentList.size ());
+  m_sentIndex.push_back (m_sentList.back ());
+  // The new node of each tree covers the positions (n - lowbit (n), n]
+  uint32_t n = m_sentIndex.size ();
+  for (uint32_t c = 0; c < N_COUNTERS; ++c)
+    {
+      ScoreboardCounter counter = static_cast<ScoreboardCounter> (c);
+      m_counters[c].push_back (GetPrefixSum (counter, n - 1) - GetPrefixSum (counter, n - (n & (~n + 1))));
     }
+  UpdateIndex (n - 1, true);
+}
 
-  return ret;
+void
+TcpTxBuffer::IndexPopFront (void)
+{
+  NS_ASSERT (m_sentIndexHead < m_sentIndex.size ());
+  UpdateIndex (m_sentIndexHead, false);
+  m_sentIndex[m_sentIndexHead] = 0;
+  ++m_sentIndexHead;
+  // The positions of the items acknowledged are reclaimed once they are
+  // the majority, so that it takes constant amortized time
+  if (2 * m_sentIndexHead >= m_sentIndex.size ())
+    {
+      RebuildIndex ();
+    }
 }
 
+void
+TcpTxBuffer::IndexPopBack (void)
+{
+  NS_ASSERT (m_sentIndexHead < m_sentIndex.size ());
+  UpdateIndex (m_sentIndex.size () - 1, false);
+  m_sentIndex.pop_back ();
+  // No other node covers the last position
+  for (uint32_t c = 0; c < N_COUNTERS; ++c)
+    {
+      m_counters[c].pop_back ();
+    }
+}
+
+void
+TcpTxBuffer::RebuildIndex (void)
+{
+  m_sentIndex.assign (m_sentList.begin (), m_sentList.end ());
+  m_sentIndexHead = 0;
+  uint32_t n = m_sentIndex.size ();
+  for (uint32_t c = 0; c < N_COUNTERS; ++c)
+    {
+      m_counters[c].assign (n + 1, 0);
+      m_totals[c] = 0;
+    }
+  m_retransOut = 0;
+
+  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      TcpTxItem *item = m_sentIndex[i];
+      item->m_startSeq = beginOfCurrentPacket;
+      beginOfCurrentPacket += item->m_packet->GetSize ();
+      // Set the leaves only; the inner nodes are summed below
+      uint32_t values[N_COUNTERS];
+      m_retransOut += GetCounters (item, values);
+      for (uint32_t c = 0; c < N_COUNTERS; ++c)
+        {
+          m_counters[c][i + 1] = values[c];
+          m_totals[c] += values[c];
+        }
+    }
+  for (uint32_t c = 0; c < N_COUNTERS; ++c)
+    {
+      std::vector<uint32_t> &tree = m_counters[c];
+      for (uint32_t i = 1; i <= n; ++i)
+        {
+          uint32_t parent = i + (i & (~i + 1));
+          if (parent <= n)
+            {
+              tree[parent] += tree[i];
+            }
+        }
+    }
+}
 
 void
 TcpTxBuffer::SplitItems (TcpTxItem &t1, TcpTxItem &t2, uint32_t size) const
@@ -610,6 +780,7 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
           offset -= pktSize;
           m_firstByteSeq += pktSize;
           i = m_sentList.erase (i);
+          IndexPopFront ();
           delete item;
           NS_LOG_INFO ("While removing up to " << seq <<
                        ".Removed one packet of size " << pktSize <<
@@ -619,8 +790,11 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
       else if (offset > 0)
         { // Part of the packet is behind the seqnum. Fragment
           pktSize -= offset;
+          UpdateIndex (m_sentIndexHead, false);
           // PacketTags are preserved when fragmenting
           item->m_packet = item->m_packet->CreateFragment (offset, pktSize);
+          item->m_startSeq += offset;
+          UpdateIndex (m_sentIndexHead, true);
           m_size -= offset;
           m_sentSize -= offset;
           m_firstByteSeq += offset;
@@ -643,15 +817,12 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
           // It is not possible to have the UNA sacked; otherwise, it would
           // have been ACKed. This is, most likely, our wrong guessing
           // when crafting the SACK option for a non-SACK receiver.
+          UpdateIndex (m_sentIndexHead, false);
           head->m_sacked = false;
+          UpdateIndex (m_sentIndexHead, true);
         }
     }
 
-  if (m_highestSack.second <= m_firstByteSeq)
-    {
-      m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
-    }
-
   NS_LOG_DEBUG ("Discarded up to " << seq);
   NS_LOG_LOGIC ("Buffer status after discarding data " << *this);
   NS_ASSERT (m_firstByteSeq >= seq);
@@ -667,126 +838,98 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
   NS_LOG_INFO ("Updating scoreboard, got " << list.size () << " blocks to analyze");
   for (option_it = list.begin (); option_it != list.end (); ++option_it)
     {
-      Ptr<Packet> current;
-      TcpTxItem *item;
       const TcpOptionSack::SackBlock b = (*option_it);
 
-      PacketList::iterator item_it = m_sentList.begin ();
-      SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-
-      while (item_it != m_sentList.end ())
+      // Only the packets starting inside the block can be mapped over it
+      for (uint32_t pos = FindSequence (b.first); pos < m_sentIndex.size (); ++pos)
         {
-          item = *item_it;
-          current = item->m_packet;
+          TcpTxItem *item = m_sentIndex[pos];
+          SequenceNumber32 beginOfCurrentPacket = item->m_startSeq;
+          SequenceNumber32 endOfCurrentPacket = beginOfCurrentPacket + item->m_packet->GetSize ();
 
           // Check the boundary of this packet ... only mark as sacked if
           // it is precisely mapped over the option
-          if (beginOfCurrentPacket >= b.first
-              && beginOfCurrentPacket + current->GetSize () <= b.second)
-            {
-              if (item->m_sacked)
-                {
-                  NS_LOG_INFO ("Received block [" << b.first << ";" << b.second <<
-                               ", checking sentList for block " << beginOfCurrentPacket <<
-                               ";" << beginOfCurrentPacket + current->GetSize () <<
-                               "], found in the sackboard already sacked");
-                }
-              else
-                {
-                  item->m_sacked = true;
-                  NS_LOG_INFO ("Received block [" << b.first << ";" << b.second <<
-                               ", checking sentList for block " << beginOfCurrentPacket <<
-                               ";" << beginOfCurrentPacket + current->GetSize () <<
-                               "], found in the sackboard, sacking");
-                  if (m_highestSack.second <= beginOfCurrentPacket + current->GetSize ())
-                    {
-                      PacketList::iterator new_it = item_it;
-                      m_highestSack = std::make_pair (++new_it, beginOfCurrentPacket+current->GetSize ());
-                    }
-                }
-              modified = true;
-            }
-          else if (beginOfCurrentPacket + current->GetSize () > b.second)
+          if (endOfCurrentPacket > b.second)
             {
               // we missed the block. It's useless to iterate again; Say "ciao"
               // to the loop for optimization purposes
               NS_LOG_INFO ("Received block [" << b.first << ";" << b.second <<
                            ", checking sentList for block " << beginOfCurrentPacket <<
-                           ";" << beginOfCurrentPacket + current->GetSize () <<
-                           "], not found, breaking loop");
+                           ";" << endOfCurrentPacket << "], not found, breaking loop");
               break;
             }
 
-          beginOfCurrentPacket += current->GetSize ();
-          ++item_it;
+          if (item->m_sacked)
+            {
+              NS_LOG_INFO ("Received block [" << b.first << ";" << b.second <<
+                           ", checking sentList for block " << beginOfCurrentPacket <<
+                           ";" << endOfCurrentPacket <<
+                           "], found in the sackboard already sacked");
+            }
+          else
+            {
+              UpdateIndex (pos, false);
+              item->m_sacked = true;
+              UpdateIndex (pos, true);
+              NS_LOG_INFO ("Received block [" << b.first << ";" << b.second <<
+                           ", checking sentList for block " << beginOfCurrentPacket <<
+                           ";" << endOfCurrentPacket <<
+                           "], found in the sackboard, sacking");
+            }
+          modified = true;
         }
     }
 
-  NS_ASSERT ((*(m_sentList.begin ()))->m_sacked == false);
+  NS_ASSERT (m_sentList.empty () || (*(m_sentList.begin ()))->m_sacked == false);
 
   return modified;
 }
 
-bool
-TcpTxBuffer::IsLost (const SequenceNumber32 &seq, const PacketList::const_iterator &segment,
-                     uint32_t dupThresh, uint32_t segmentSize) const
+uint32_t
+TcpTxBuffer::GetLostBoundary (uint32_t dupThresh, uint32_t segmentSize) const
 {
-  NS_LOG_FUNCTION (this << seq << dupThresh << segmentSize);
-  uint32_t count = 0;
-  uint32_t bytes = 0;
-  PacketList::const_iterator it;
-  TcpTxItem *item;
-  Ptr<const Packet> current;
-  SequenceNumber32 beginOfCurrentPacket = seq;
-
-  NS_LOG_INFO ("Checking if seq=" << seq << " is lost from the buffer ");
-
-  if ((*segment)->m_lost == true)
-    {
-      NS_LOG_INFO ("seq=" << seq << " is lost because of lost flag");
-      return true;
-    }
-
-  if ((*segment)->m_sacked == true)
-    {
-      NS_LOG_INFO ("seq=" << seq << " is not lost because of sacked flag");
-      return false;
-    }
-
   // From RFC 6675:
   // > The routine returns true when either dupThresh discontiguous SACKed
   // > sequences have arrived above 'seq' or more than (dupThresh - 1) * SMSS bytes
   // > with sequence numbers greater than 'SeqNum' have been SACKed.  Otherwise, the
   // > routine returns false.
-  for (it = segment; it != m_highestSack.first; ++it)
+  //
+  // The segments SACKed above a position only decrease as the position
+  // grows, so each condition holds below the position of a SACKed segment.
+  uint32_t boundary = 0;
+  uint32_t sackedSegments = m_totals[SACKED_SEGMENTS];
+  uint32_t minSegments = std::max<uint32_t> (dupThresh, 1);
+  if (sackedSegments >= minSegments)
     {
-      if (beginOfCurrentPacket >= m_highestSack.second)
-        {
-          NS_LOG_INFO ("seq=" << seq << " is not lost because there are no sacked segment ahead");
-          return false;
-        }
+      boundary = FindPrefixSum (SACKED_SEGMENTS, sackedSegments - minSegments + 1);
+    }
+  uint32_t sackedBytes = m_totals[SACKED_BYTES];
+  uint32_t maxBytes = (dupThresh - 1) * segmentSize;
+  if (sackedBytes > maxBytes)
+    {
+      boundary = std::max (boundary, FindPrefixSum (SACKED_BYTES, sackedBytes - maxBytes));
+    }
+  return boundary;
+}
 
-      item = *it;
-      current = item->m_packet;
+bool
+TcpTxBuffer::IsLost (uint32_t pos, uint32_t boundary) const
+{
+  const TcpTxItem *item = m_sentIndex[pos];
 
-      if (item->m_sacked)
-        {
-          NS_LOG_INFO ("Segment [" << beginOfCurrentPacket << ", " <<
-                       beginOfCurrentPacket+item->m_packet->GetSize () <<
-                       "] found to be SACKed");
-          ++count;
-          bytes += current->GetSize ();
-          if ((count >= dupThresh) || (bytes > (dupThresh-1) * segmentSize))
-            {
-              NS_LOG_INFO ("seq=" << seq << " is lost because of 3 sacked blocks ahead");
-              return true;
-            }
-        }
+  if (item->m_lost == true)
+    {
+      NS_LOG_INFO ("seq=" << item->m_startSeq << " is lost because of lost flag");
+      return true;
+    }
 
-      beginOfCurrentPacket += current->GetSize ();
+  if (item->m_sacked == true)
+    {
+      NS_LOG_INFO ("seq=" << item->m_startSeq << " is not lost because of sacked flag");
+      return false;
     }
 
-  return false;
+  return pos < boundary;
 }
 
 bool
@@ -795,28 +938,24 @@ TcpTxBuffer::IsLost (const SequenceNumber32 &seq, uint32_t dupThresh,
 {
   NS_LOG_FUNCTION (this << seq << dupThresh);
 
-  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-  PacketList::const_iterator it;
-
-  if (seq >= m_highestSack.second)
+  if (m_totals[SACKED_SEGMENTS] == 0)
     {
       return false;
     }
 
-  // This O(n) method is called only once, and outside this class.
-  // It should not harm the performance
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  const TcpTxItem *highestSacked = m_sentIndex[FindPrefixSum (SACKED_SEGMENTS, m_totals[SACKED_SEGMENTS])];
+  if (seq >= highestSacked->m_startSeq + highestSacked->m_packet->GetSize ())
     {
-      // Search for the right iterator before calling IsLost()
-      if (beginOfCurrentPacket >= seq)
-        {
-          return IsLost (beginOfCurrentPacket, it, dupThresh, segmentSize);
-        }
+      return false;
+    }
 
-      beginOfCurrentPacket += (*it)->m_packet->GetSize ();
+  uint32_t pos = FindSequence (seq);
+  if (pos == m_sentIndex.size ())
+    {
+      return false;
     }
 
-  return false;
+  return IsLost (pos, GetLostBoundary (dupThresh, segmentSize));
 }
 
 bool
@@ -838,34 +977,25 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, uint32_t dupThresh,
    *           received SACK.
    *
    *     (1.c) IsLost (S2) returns true.
+   *
+   * The segments neither retransmitted nor SACKed are either flagged lost,
+   * and then they are lost, or "plain", and then they are lost when they
+   * are below the lost boundary.
    */
-  PacketList::const_iterator it;
-  TcpTxItem *item;
-  SequenceNumber32 seqPerRule3;
-  bool isSeqPerRule3Valid = false;
-  SequenceNumber32 beginOfCurrentPkt = m_firstByteSeq;
+  uint32_t end = m_sentIndex.size ();
+  uint32_t firstPlain = m_totals[PLAIN_SEGMENTS] > 0 ? FindPrefixSum (PLAIN_SEGMENTS, 1) : end;
+  uint32_t firstLost = m_totals[LOST_SEGMENTS] > 0 ? FindPrefixSum (LOST_SEGMENTS, 1) : end;
 
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  if (firstPlain < end && firstPlain < firstLost
+      && IsLost (firstPlain, GetLostBoundary (dupThresh, segmentSize)))
     {
-      item = *it;
-
-      // Condition 1.a , 1.b , and 1.c
-      if (item->m_retrans == false && item->m_sacked == false)
-        {
-          if (IsLost (beginOfCurrentPkt, it, dupThresh, segmentSize))
-            {
-              *seq = beginOfCurrentPkt;
-              return true;
-            }
-          else if (seqPerRule3.GetValue () == 0 && isRecovery)
-            {
-              isSeqPerRule3Valid = true;
-              seqPerRule3 = beginOfCurrentPkt;
-            }
-        }
-
-      // Nothing found, iterate
-      beginOfCurrentPkt += item->m_packet->GetSize ();
+      *seq = m_sentIndex[firstPlain]->m_startSeq;
+      return true;
+    }
+  if (firstLost < end)
+    {
+      *seq = m_sentIndex[firstLost]->m_startSeq;
+      return true;
     }
 
   /* (2) If no sequence number 'S2' per rule (1) exists but there
@@ -886,9 +1016,9 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, uint32_t dupThresh,
    *     (specifically excluding step (1.c)), then one segment of up to
    *     SMSS octets starting with S3 SHOULD be returned.
    */
-  if (isSeqPerRule3Valid)
+  if (isRecovery && firstPlain < end)
     {
-      *seq = seqPerRule3;
+      *seq = m_sentIndex[firstPlain]->m_startSeq;
       return true;
     }
 
@@ -910,36 +1040,18 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, uint32_t dupThresh,
 uint32_t
 TcpTxBuffer::BytesInFlight (uint32_t dupThresh, uint32_t segmentSize) const
 {
-  PacketList::const_iterator it;
-  TcpTxItem *item;
-  uint32_t size = 0; // "pipe" in RFC
-  SequenceNumber32 beginOfCurrentPkt = m_firstByteSeq;
-
   // After initializing pipe to zero, the following steps are taken for each
   // octet 'S1' in the sequence space between HighACK and HighData that has not
   // been SACKed:
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
-    {
-      item = *it;
-      if (!item->m_sacked)
-        {
-          // (a) If IsLost (S1) returns false: Pipe is incremented by 1 octet.
-          if (!IsLost (beginOfCurrentPkt, it, dupThresh, segmentSize))
-            {
-              size += item->m_packet->GetSize ();
-            }
-          // (b) If S1 <= HighRxt: Pipe is incremented by 1 octet.
-          // (NOTE: we use the m_retrans flag instead of keeping and updating
-          // another variable). Only if the item is not marked as lost
-          else if (item->m_retrans && !item->m_lost)
-            {
-              size += item->m_packet->GetSize ();
-            }
-        }
-      beginOfCurrentPkt += item->m_packet->GetSize ();
-    }
-
-  return size;
+  // (a) If IsLost (S1) returns false: Pipe is incremented by 1 octet.
+  // (b) If S1 <= HighRxt: Pipe is incremented by 1 octet.
+  // (NOTE: we use the m_retrans flag instead of keeping and updating
+  // another variable). Only if the item is not marked as lost
+  //
+  // The segments flagged lost are never counted, the retransmitted ones
+  // always are, and the plain ones are when they are above the lost boundary.
+  uint32_t boundary = GetLostBoundary (dupThresh, segmentSize);
+  return m_retransOut + m_totals[PLAIN_BYTES] - GetPrefixSum (PLAIN_BYTES, boundary);
 }
 
 void
@@ -948,15 +1060,13 @@ TcpTxBuffer::ResetScoreboard ()
   NS_LOG_FUNCTION (this);
 
   PacketList::iterator it;
-  SequenceNumber32 beginOfCurrentPkt = m_firstByteSeq;
 
   for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
     {
       (*it)->m_sacked = false;
-      beginOfCurrentPkt += (*it)->m_packet->GetSize ();
     }
 
-  m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  RebuildIndex ();
 }
 
 void
@@ -987,7 +1097,7 @@ TcpTxBuffer::ResetSentList ()
       m_sentSize = 0;
     }
 
-  m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  RebuildIndex ();
 }
 
 void
@@ -998,6 +1108,7 @@ TcpTxBuffer::ResetLastSegmentSent ()
     {
       TcpTxItem *item = m_sentList.back ();
 
+      IndexPopBack ();
       m_sentList.pop_back ();
       m_sentSize -= item->m_packet->GetSize ();
       m_appList.insert (m_appList.begin (), item);
@@ -1015,6 +1126,8 @@ TcpTxBuffer::SetSentListLost ()
     {
       (*it)->m_lost = true;
     }
+
+  RebuildIndex ();
 }
 
 bool
@@ -1036,46 +1149,45 @@ TcpTxBuffer::CraftSackOption (const SequenceNumber32 &seq, uint8_t available) co
 {
   NS_LOG_FUNCTION (this);
   Ptr<TcpOptionSack> sackBlock = 0;
-  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
+  SequenceNumber32 beginOfCurrentPacket;
   Ptr<Packet> current;
   TcpTxItem *item;
 
   NS_LOG_INFO ("Crafting a SACK block, available bytes: " << (uint32_t) available <<
                " from seq: " << seq << " buffer starts at seq " << m_firstByteSeq);
 
-  PacketList::const_iterator it;
-  if (m_highestSack.first == m_sentList.end ())
-    {
-      it = m_sentList.begin ();
-    }
-  else
+  // Start after the highest segment SACKed, if it is not the last one
+  uint32_t pos = m_sentIndexHead;
+  if (m_totals[SACKED_SEGMENTS] > 0)
     {
-      it = m_highestSack.first;
-      beginOfCurrentPacket = m_highestSack.second;
+      uint32_t highestSacked = FindPrefixSum (SACKED_SEGMENTS, m_totals[SACKED_SEGMENTS]);
+      if (highestSacked + 1 < m_sentIndex.size ())
+        {
+          pos = highestSacked + 1;
+        }
     }
 
-  while (it != m_sentList.end ())
+  for (; pos < m_sentIndex.size (); ++pos)
     {
-      item = *it;
+      item = m_sentIndex[pos];
       current = item->m_packet;
+      beginOfCurrentPacket = item->m_startSeq;
 
       SequenceNumber32 endOfCurrentPacket = beginOfCurrentPacket + current->GetSize ();
 
       // The first segment could not be sacked.. otherwise would be a
       // cumulative ACK :)
-      if (item->m_sacked || it == m_sentList.begin ())
+      if (item->m_sacked || pos == m_sentIndexHead)
         {
           NS_LOG_DEBUG ("Analyzing segment: [" << beginOfCurrentPacket <<
                         ";" << endOfCurrentPacket << "], not usable, sacked=" <<
                         item->m_sacked);
-          beginOfCurrentPacket += current->GetSize ();
         }
       else if (seq > beginOfCurrentPacket)
         {
           NS_LOG_DEBUG ("Analyzing segment: [" << beginOfCurrentPacket <<
                         ";" << endOfCurrentPacket << "], not usable, sacked=" <<
                         item->m_sacked);
-          beginOfCurrentPacket += current->GetSize ();
         }
       else
         {
@@ -1096,14 +1208,14 @@ TcpTxBuffer::CraftSackOption (const SequenceNumber32 &seq, uint8_t available) co
           // This means go backward until we finish space and include already SACKed block
           while (sackBlock->GetSerializedSize () + 8 < available)
             {
-              --it;
+              --pos;
 
-              if (it == m_sentList.begin ())
+              if (pos == m_sentIndexHead)
                 {
                   return sackBlock;
                 }
 
-              item = *it;
+              item = m_sentIndex[pos];
               current = item->m_packet;
               endOfCurrentPacket = beginOfCurrentPacket;
               beginOfCurrentPacket -= current->GetSize ();
@@ -1117,8 +1229,6 @@ TcpTxBuffer::CraftSackOption (const SequenceNumber32 &seq, uint8_t available) co
 
           return sackBlock;
         }
-
-      ++it;
     }
 
   return sackBlock;
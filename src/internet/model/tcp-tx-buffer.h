@@ -57,6 +57,8 @@ public:
   void Print (std::ostream &os) const;
 
   Ptr<Packet> m_packet; //!< Application packet
+  SequenceNumber32 m_startSeq; //!< Sequence number of the first byte of the
+                               //   packet (only valid in the sent list)
   bool m_lost;          //!< Indicates if the segment has been lost (RTO)
   bool m_retrans;       //!< Indicates if the segment is retransmitted
   Time m_lastSent;      //!< Timestamp of the time at which the segment has
@@ -106,18 +108,27 @@ public:
  * documentation) and maintaining the scoreboard is a matter of travelling the
  * list and set the SACK flag on the corresponding segment sent.
  *
- * Inefficiencies
- * --------------
+ * Scoreboard index
+ * ----------------
  *
- * The algorithms outlined in RFC 6675 are full of inefficiencies. In
- * particular, traveling all the sent list each time it is needed to compute
- * the bytes in flight is expensive. We try to overcome the issue by
- * maintaining a pointer to the highest sequence SACKed; in this way, we can
- * avoid traveling all the list in some cases. Another option could be keeping
- * a count of each critical value (e.g., the number of packets sacked).
- * However, this would be different from the algorithms in RFC. There are some
- * other possible improvements; if you wish, take a look and try  to add some
- * earlier exit conditions in the loops.
+ * Implemented literally, the algorithms outlined in RFC 6675 travel all the
+ * sent list each time the bytes in flight are computed, and they travel it
+ * again for each segment to check whether it is lost. With windows of tens
+ * of thousands of segments, this dominates the processing of every ACK.
+ *
+ * The items of the sent list are therefore also kept, in order, in an array
+ * (m_sentIndex), which is searched by sequence number, and over which some
+ * counters are summed with Fenwick (binary indexed) trees: the number and
+ * the size of the SACKed segments, and the number and the size of the
+ * segments neither SACKed, lost, nor retransmitted. Since the number of
+ * SACKed bytes and segments above a sequence number decreases as the
+ * sequence grows, the segments considered lost by the RFC 6675 IsLost
+ * rule are the ones below a boundary, which is found in logarithmic time.
+ * BytesInFlight, IsLost, NextSeg, and the processing of each SACK block
+ * take logarithmic time, and the results are the same as the RFC
+ * algorithms. Adding, acknowledging, and flagging segments update the
+ * index in logarithmic time; the rare operations that split or merge the
+ * segments already sent, or that change all of them, rebuild it.
  *
  * \see Size
  * \see SizeFromSequence
@@ -321,16 +332,101 @@ private:
 
   typedef std::list<TcpTxItem*> PacketList; //!< container for data stored in the buffer
 
+  /**
+   * \brief Counters summed over the sent list by the scoreboard index
+   */
+  enum ScoreboardCounter
+  {
+    SACKED_SEGMENTS = 0, //!< Number of SACKed segments
+    SACKED_BYTES,        //!< Size of the SACKed segments
+    PLAIN_SEGMENTS,      //!< Number of segments neither SACKed, lost nor retransmitted
+    PLAIN_BYTES,         //!< Size of the segments neither SACKed, lost nor retransmitted
+    LOST_SEGMENTS,       //!< Number of segments lost and neither SACKed nor retransmitted
+    N_COUNTERS           //!< Number of counters
+  };
+
   /**
    * \brief Check if a segment is lost per RFC 6675
-   * \param seq sequence to check
-   * \param segment Iterator pointing at seq
+   * \param pos position of the segment in m_sentIndex
+   * \param boundary the lost boundary, as returned by GetLostBoundary
+   * \return true if the segment is supposed to be lost, false otherwise
+   */
+  bool IsLost (uint32_t pos, uint32_t boundary) const;
+
+  /**
+   * \brief Get the boundary of the segments lost per the RFC 6675 IsLost rule
+   *
+   * A segment is lost when dupThresh segments, or more than (dupThresh - 1) *
+   * segmentSize bytes, have been SACKed above it. The segments neither SACKed
+   * nor flagged lost which are at a position below the boundary are lost,
+   * and those at or above it are not.
+   *
    * \param dupThresh dupAck threshold
    * \param segmentSize segment size
-   * \return true if the sequence is supposed to be lost, false otherwise
+   * \return the position in m_sentIndex of the boundary
+   */
+  uint32_t GetLostBoundary (uint32_t dupThresh, uint32_t segmentSize) const;
+
+  /**
+   * \brief Find the first segment of the sent list starting at or after a sequence
+   * \param seq the sequence number
+   * \return the position of the segment in m_sentIndex, or the size of
+   * m_sentIndex if there is none
+   */
+  uint32_t FindSequence (const SequenceNumber32 &seq) const;
+
+  /**
+   * \brief Get the sum of a counter over the first positions of m_sentIndex
+   * \param counter the counter
+   * \param n the number of positions
+   * \return the sum of the counter over the positions [0, n)
+   */
+  uint32_t GetPrefixSum (ScoreboardCounter counter, uint32_t n) const;
+
+  /**
+   * \brief Find the position at which the sum of a counter reaches a value
+   * \param counter the counter
+   * \param value the value, greater than 0
+   * \return the smallest position pos such that the sum over [0, pos] is
+   * at least value, or the size of m_sentIndex if there is none
+   */
+  uint32_t FindPrefixSum (ScoreboardCounter counter, uint32_t value) const;
+
+  /**
+   * \brief Get the counters of a segment
+   * \param item the segment
+   * \param values [out] the value of each ScoreboardCounter for the segment
+   * \return the size of the segment if it is retransmitted and neither
+   * SACKed nor lost, 0 otherwise
+   */
+  static uint32_t GetCounters (const TcpTxItem *item, uint32_t *values);
+
+  /**
+   * \brief Add or remove the counters of a segment to the scoreboard index
+   * \param pos position of the segment in m_sentIndex
+   * \param add true to add the counters, false to remove them
+   */
+  void UpdateIndex (uint32_t pos, bool add);
+
+  /**
+   * \brief Add the segment at the end of the sent list to the scoreboard index
+   */
+  void IndexPushBack (void);
+
+  /**
+   * \brief Remove the segment at the head of the sent list from the scoreboard index
    */
-  bool IsLost (const SequenceNumber32 &seq, const PacketList::const_iterator &segment, uint32_t dupThresh,
-               uint32_t segmentSize) const;
+  void IndexPopFront (void);
+
+  /**
+   * \brief Remove the segment at the end of the sent list from the scoreboard index
+   */
+  void IndexPopBack (void);
+
+  /**
+   * \brief Rebuild the scoreboard index from the sent list
+   */
+  void RebuildIndex (void);
 
   /**
    * \brief Get a block of data not transmitted yet and move it into SentList
@@ -461,13 +557,6 @@ private:
    */
   void SplitItems (TcpTxItem &t1, TcpTxItem &t2, uint32_t size) const;
 
-  /**
-   * \brief Find the highest SACK byte
-   * \return a pair with the highest byte and an iterator inside m_sentList
-   */
-  std::pair <TcpTxBuffer::PacketList::const_iterator, SequenceNumber32>
-  GetHighestSacked () const;
-
   PacketList m_appList;  //!< Buffer for application data
   PacketList m_sentList; //!< Buffer for sent (but not acked) data
   uint32_t m_maxBuffer;  //!< Max number of data bytes in buffer (SND.WND)
@@ -476,8 +565,11 @@ private:
 
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
 
-  std::pair <PacketList::const_iterator, SequenceNumber32> m_highestSack; //!< Highest SACK byte
-
+  std::vector<TcpTxItem*> m_sentIndex;            //!< Items of m_sentList, in the same order
+  uint32_t m_sentIndexHead;                       //!< Position of the head of m_sentList in m_sentIndex
+  std::vector<uint32_t> m_counters[N_COUNTERS];   //!< Fenwick trees of the counters over m_sentIndex
+  uint32_t m_totals[N_COUNTERS];                  //!< Sums of the counters over the sent list
+  uint32_t m_retransOut;                          //!< Size of the segments retransmitted and neither SACKed nor lost
 };
 
 /**
@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "../model/ipv4-end-point-demux.h"
+#include "../model/ipv4-end-point.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv4-interface-address.h"
+#include "../model/ipv6-end-point-demux.h"
+#include "../model/ipv6-end-point.h"
+#include "ns3/ipv6-interface.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Time the demultiplexing of the packets of a server holding a
+ * listening socket and many accepted connections on the same port.
+ */
+class EndPointDemuxBenchmarkTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param nConnections the number of connections of the server
+   */
+  EndPointDemuxBenchmarkTestCase (uint32_t nConnections);
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param nConnections the number of connections
+   * \returns the name of the test case
+   */
+  static std::string Name (uint32_t nConnections);
+  /**
+   * Print the time taken by a benchmark.
+   * \param what the benchmark
+   * \param seconds the time taken
+   * \param packets the number of packets demultiplexed
+   */
+  void Report (std::string what, double seconds, uint32_t packets) const;
+
+  uint32_t m_nConnections;  //!< Number of connections of the server
+};
+
+EndPointDemuxBenchmarkTestCase::EndPointDemuxBenchmarkTestCase (uint32_t nConnections)
+  : TestCase (Name (nConnections)),
+    m_nConnections (nConnections)
+{
+}
+
+std::string
+EndPointDemuxBenchmarkTestCase::Name (uint32_t nConnections)
+{
+  std::ostringstream oss;
+  oss << "Demultiplexing to " << nConnections << " connections";
+  return oss.str ();
+}
+
+void
+EndPointDemuxBenchmarkTestCase::Report (std::string what, double seconds, uint32_t packets) const
+{
+  std::cout << "end-point-demux-perf: " << m_nConnections << " connections, " << what << ": "
+            << 1e9 * seconds / packets << " ns/packet" << std::endl;
+}
+
+void
+EndPointDemuxBenchmarkTestCase::DoRun (void)
+{
+  typedef std::chrono::steady_clock Clock;
+  const uint32_t packets = 100000;
+
+  // IPv4: a listening socket and the connections it accepted
+  Ipv4EndPointDemux demux4;
+  Ptr<Ipv4Interface> interface4 = CreateObject<Ipv4Interface> ();
+  Ipv4Address local4 ("10.0.0.1");
+  Ipv4Address newPeer4 ("12.0.0.1");
+  interface4->AddAddress (Ipv4InterfaceAddress (local4, Ipv4Mask ("255.0.0.0")));
+  Ipv4EndPoint *listener4 = demux4.Allocate (80);
+  for (uint32_t i = 0; i < m_nConnections; i++)
+    {
+      demux4.Allocate (local4, 80, Ipv4Address (0x0b000000 + i / 1000), 1024 + i % 1000);
+    }
+
+  Clock::time_point start = Clock::now ();
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < packets; i++)
+    {
+      uint32_t peer = (i * 7919) % m_nConnections;
+      found += demux4.Lookup (local4, 80, Ipv4Address (0x0b000000 + peer / 1000),
+                              1024 + peer % 1000, interface4).size ();
+    }
+  Report ("IPv4 established", std::chrono::duration<double> (Clock::now () - start).count (), packets);
+  NS_TEST_ASSERT_MSG_EQ (found, packets, "Each packet should reach its connection");
+
+  start = Clock::now ();
+  for (uint32_t i = 0; i < packets; i++)
+    {
+      Ipv4EndPointDemux::EndPoints endPoints = demux4.Lookup (local4, 80, newPeer4, i % 60000, interface4);
+      NS_TEST_ASSERT_MSG_EQ ((endPoints.size () == 1 && endPoints.front () == listener4), true,
+                             "New connections should reach the listening socket");
+    }
+  Report ("IPv4 listening", std::chrono::duration<double> (Clock::now () - start).count (), packets);
+
+  // IPv6: the same server
+  Ipv6EndPointDemux demux6;
+  Ptr<Ipv6Interface> interface6 = CreateObject<Ipv6Interface> ();
+  Ipv6Address local ("2001:db8::1");
+  demux6.Allocate (80);
+  uint8_t peerBuffer[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 1 };
+  for (uint32_t i = 0; i < m_nConnections; i++)
+    {
+      peerBuffer[14] = (i / 1000) >> 8;
+      peerBuffer[15] = (i / 1000) & 0xff;
+      demux6.Allocate (local, 80, Ipv6Address (peerBuffer), 1024 + i % 1000);
+    }
+
+  start = Clock::now ();
+  found = 0;
+  for (uint32_t i = 0; i < packets; i++)
+    {
+      uint32_t peer = (i * 7919) % m_nConnections;
+      peerBuffer[14] = (peer / 1000) >> 8;
+      peerBuffer[15] = (peer / 1000) & 0xff;
+      found += demux6.Lookup (local, 80, Ipv6Address (peerBuffer), 1024 + peer % 1000, interface6).size ();
+    }
+  Report ("IPv6 established", std::chrono::duration<double> (Clock::now () - start).count (), packets);
+  NS_TEST_ASSERT_MSG_EQ (found, packets, "Each packet should reach its connection");
+
+  interface4 = 0;
+  interface6 = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief End point demux performance test suite
+ */
+class EndPointDemuxPerformanceSuite : public TestSuite
+{
+public:
+  EndPointDemuxPerformanceSuite ();
+};
+
+EndPointDemuxPerformanceSuite::EndPointDemuxPerformanceSuite ()
+  : TestSuite ("end-point-demux-perf", PERFORMANCE)
+{
+  AddTestCase (new EndPointDemuxBenchmarkTestCase (100), TestCase::QUICK);
+  AddTestCase (new EndPointDemuxBenchmarkTestCase (5000), TestCase::QUICK);
+  AddTestCase (new EndPointDemuxBenchmarkTestCase (50000), TestCase::QUICK);
+}
+
+static EndPointDemuxPerformanceSuite g_endPointDemuxPerformanceSuite; //!< Static variable for test initialization
@@ -0,0 +1,549 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simple-net-device.h"
+#include "../model/ipv4-end-point-demux.h"
+#include "../model/ipv4-end-point.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv4-interface-address.h"
+#include "../model/ipv6-end-point-demux.h"
+#include "../model/ipv6-end-point.h"
+#include "ns3/ipv6-interface.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the indexed Ipv4EndPointDemux lookups against a linear
+ * scan of all the endpoints, while endpoints are allocated, connected
+ * and removed.
+ */
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Compare the demux lookups with a linear scan, for random packets.
+   */
+  void Check (void);
+  /**
+   * Lookup by linear scan of all the endpoints.
+   * \param daddr destination address
+   * \param dport destination port
+   * \param saddr source address
+   * \param sport source port
+   * \returns the most-matching endpoints
+   */
+  Ipv4EndPointDemux::EndPoints ScanLookup (Ipv4Address daddr, uint16_t dport,
+                                           Ipv4Address saddr, uint16_t sport);
+  /**
+   * Simple lookup by linear scan of all the endpoints.
+   * \param daddr destination address
+   * \param dport destination port
+   * \param saddr source address
+   * \param sport source port
+   * \returns the best match, or 0
+   */
+  Ipv4EndPoint *ScanSimpleLookup (Ipv4Address daddr, uint16_t dport,
+                                  Ipv4Address saddr, uint16_t sport);
+  /**
+   * \returns a random address of the test
+   */
+  Ipv4Address RandomAddress (void);
+  /**
+   * \returns a random port of the test
+   */
+  uint16_t RandomPort (void);
+
+  Ipv4EndPointDemux m_demux;             //!< The demux under test
+  Ptr<Ipv4Interface> m_interface;        //!< The incoming interface
+  Ptr<UniformRandomVariable> m_random;   //!< Random packets
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Check Ipv4EndPointDemux lookups against a linear scan")
+{
+}
+
+Ipv4Address
+Ipv4EndPointDemuxTestCase::RandomAddress (void)
+{
+  static const char *addresses[] = { "10.0.0.1", "10.0.0.2", "10.0.0.3", "10.0.0.255",
+                                     "255.255.255.255", "0.0.0.0", "10.1.1.1" };
+  return Ipv4Address (addresses[m_random->GetInteger (0, 6)]);
+}
+
+uint16_t
+Ipv4EndPointDemuxTestCase::RandomPort (void)
+{
+  static const uint16_t ports[] = { 0, 53, 80, 1234, 49153 };
+  return ports[m_random->GetInteger (0, 4)];
+}
+
+Ipv4EndPointDemux::EndPoints
+Ipv4EndPointDemuxTestCase::ScanLookup (Ipv4Address daddr, uint16_t dport,
+                                       Ipv4Address saddr, uint16_t sport)
+{
+  Ipv4EndPointDemux::EndPoints retval[4];
+  Ipv4EndPointDemux::EndPoints all = m_demux.GetAllEndPoints ();
+  for (Ipv4EndPointDemux::EndPointsI i = all.begin (); i != all.end (); i++)
+    {
+      Ipv4EndPoint *endP = *i;
+      if (!endP->IsRxEnabled () || endP->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      if (endP->GetBoundNetDevice () && endP->GetBoundNetDevice () != m_interface->GetDevice ())
+        {
+          continue;
+        }
+      bool subnetDirected = false;
+      Ipv4Address incomingInterfaceAddr = daddr;
+      for (uint32_t j = 0; j < m_interface->GetNAddresses (); j++)
+        {
+          Ipv4InterfaceAddress addr = m_interface->GetAddress (j);
+          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ())
+              && daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+            {
+              subnetDirected = true;
+              incomingInterfaceAddr = addr.GetLocal ();
+            }
+        }
+      bool isBroadcast = daddr.IsBroadcast () || subnetDirected;
+      bool localWildCard = endP->GetLocalAddress () == Ipv4Address::GetAny ();
+      bool localExact = endP->GetLocalAddress () == daddr;
+      if (isBroadcast && !localWildCard)
+        {
+          localExact = endP->GetLocalAddress () == incomingInterfaceAddr;
+        }
+      bool portExact = endP->GetPeerPort () == sport;
+      bool portWildCard = endP->GetPeerPort () == 0;
+      bool addressExact = endP->GetPeerAddress () == saddr;
+      bool addressWildCard = endP->GetPeerAddress () == Ipv4Address::GetAny ();
+      if (!(localExact || localWildCard) || !(portExact || portWildCard) || !(addressExact || addressWildCard))
+        {
+          continue;
+        }
+      if (localWildCard && portWildCard && addressWildCard)
+        {
+          retval[0].push_back (endP);
+        }
+      if ((localExact || (isBroadcast && localWildCard)) && portWildCard && addressWildCard)
+        {
+          retval[1].push_back (endP);
+        }
+      if (localWildCard && portExact && addressExact)
+        {
+          retval[2].push_back (endP);
+        }
+      if (localExact && portExact && addressExact)
+        {
+          retval[3].push_back (endP);
+        }
+    }
+  for (uint32_t i = 3; i > 0; i--)
+    {
+      if (!retval[i].empty ())
+        {
+          return retval[i];
+        }
+    }
+  return retval[0];
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemuxTestCase::ScanSimpleLookup (Ipv4Address daddr, uint16_t dport,
+                                             Ipv4Address saddr, uint16_t sport)
+{
+  uint32_t genericity = 3;
+  Ipv4EndPoint *generic = 0;
+  Ipv4EndPointDemux::EndPoints all = m_demux.GetAllEndPoints ();
+  for (Ipv4EndPointDemux::EndPointsI i = all.begin (); i != all.end (); i++)
+    {
+      if ((*i)->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      if ((*i)->GetLocalAddress () == daddr && (*i)->GetPeerPort () == sport
+          && (*i)->GetPeerAddress () == saddr)
+        {
+          return *i;
+        }
+      uint32_t tmp = ((*i)->GetLocalAddress () == Ipv4Address::GetAny () ? 1 : 0)
+        + ((*i)->GetPeerAddress () == Ipv4Address::GetAny () ? 1 : 0);
+      if (tmp < genericity)
+        {
+          generic = *i;
+          genericity = tmp;
+        }
+    }
+  return generic;
+}
+
+void
+Ipv4EndPointDemuxTestCase::Check (void)
+{
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      Ipv4Address daddr = RandomAddress ();
+      uint16_t dport = RandomPort ();
+      Ipv4Address saddr = RandomAddress ();
+      uint16_t sport = RandomPort ();
+      Ipv4EndPointDemux::EndPoints expected = ScanLookup (daddr, dport, saddr, sport);
+      Ipv4EndPointDemux::EndPoints found = m_demux.Lookup (daddr, dport, saddr, sport, m_interface);
+      NS_TEST_ASSERT_MSG_EQ ((found == expected), true, "Wrong endpoints for " << daddr << ":" << dport
+                             << " from " << saddr << ":" << sport);
+      NS_TEST_ASSERT_MSG_EQ (m_demux.SimpleLookup (daddr, dport, saddr, sport),
+                             ScanSimpleLookup (daddr, dport, saddr, sport),
+                             "Wrong simple lookup for " << daddr << ":" << dport << " from " << saddr << ":" << sport);
+
+      bool portUsed = false;
+      bool localUsed = false;
+      Ipv4EndPointDemux::EndPoints all = m_demux.GetAllEndPoints ();
+      for (Ipv4EndPointDemux::EndPointsI j = all.begin (); j != all.end (); j++)
+        {
+          portUsed = portUsed || (*j)->GetLocalPort () == dport;
+          localUsed = localUsed || ((*j)->GetLocalPort () == dport && (*j)->GetLocalAddress () == daddr);
+        }
+      NS_TEST_ASSERT_MSG_EQ (m_demux.LookupPortLocal (dport), portUsed, "Wrong local port lookup");
+      NS_TEST_ASSERT_MSG_EQ (m_demux.LookupLocal (daddr, dport), localUsed, "Wrong local lookup");
+    }
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (1);
+  m_interface = CreateObject<Ipv4Interface> ();
+  m_interface->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.255.255.0")));
+
+  // listening sockets, some bound to an address
+  m_demux.Allocate (80);
+  m_demux.Allocate (Ipv4Address ("10.0.0.1"), 80);
+  m_demux.Allocate (Ipv4Address ("10.0.0.2"), 53);
+  m_demux.Allocate (53);
+  NS_TEST_ASSERT_MSG_EQ (m_demux.Allocate (Ipv4Address ("10.0.0.1"), 80), 0, "Duplicate address/port should fail");
+  Ipv4EndPoint *bound = m_demux.Allocate (1234);
+  bound->BindToNetDevice (CreateObject<SimpleNetDevice> ());
+  Ipv4EndPoint *disabled = m_demux.Allocate (Ipv4Address ("10.0.0.255"), 1234);
+  disabled->SetRxEnabled (false);
+  Check ();
+
+  // connections, allocated as by TCP accept and connect, and UDP connect
+  std::vector<Ipv4EndPoint *> connections;
+  for (uint32_t i = 0; i < 40; i++)
+    {
+      Ipv4EndPoint *endPoint = m_demux.Allocate (RandomAddress (), RandomPort (), RandomAddress (), RandomPort ());
+      if (endPoint != 0)
+        {
+          connections.push_back (endPoint);
+        }
+      endPoint = m_demux.Allocate ();
+      endPoint->SetPeer (RandomAddress (), RandomPort ());
+      endPoint->SetLocalAddress (RandomAddress ());
+      connections.push_back (endPoint);
+    }
+  NS_TEST_ASSERT_MSG_NE (m_demux.Allocate (Ipv4Address ("10.0.0.1"), 4321, Ipv4Address ("10.1.1.1"), 53), 0,
+                         "New four-tuple should be allocated");
+  NS_TEST_ASSERT_MSG_EQ (m_demux.Allocate (Ipv4Address ("10.0.0.1"), 4321, Ipv4Address ("10.1.1.1"), 53), 0,
+                         "Duplicate four-tuple should fail");
+  Check ();
+
+  // reconnections and closes
+  for (uint32_t i = 0; i < connections.size (); i += 3)
+    {
+      connections[i]->SetPeer (RandomAddress (), RandomPort ());
+    }
+  for (uint32_t i = 1; i < connections.size (); i += 3)
+    {
+      m_demux.DeAllocate (connections[i]);
+    }
+  Check ();
+
+  m_interface = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the indexed Ipv6EndPointDemux lookups against a linear
+ * scan of all the endpoints, while endpoints are allocated, connected
+ * and removed.
+ */
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Compare the demux lookups with a linear scan, for random packets.
+   */
+  void Check (void);
+  /**
+   * Lookup by linear scan of all the endpoints.
+   * \param daddr destination address
+   * \param dport destination port
+   * \param saddr source address
+   * \param sport source port
+   * \returns the most-matching endpoints
+   */
+  Ipv6EndPointDemux::EndPoints ScanLookup (Ipv6Address daddr, uint16_t dport,
+                                           Ipv6Address saddr, uint16_t sport);
+  /**
+   * Simple lookup by linear scan of all the endpoints.
+   * \param daddr destination address
+   * \param dport destination port
+   * \param saddr source address
+   * \param sport source port
+   * \returns the best match, or 0
+   */
+  Ipv6EndPoint *ScanSimpleLookup (Ipv6Address daddr, uint16_t dport,
+                                  Ipv6Address saddr, uint16_t sport);
+  /**
+   * \returns a random address of the test
+   */
+  Ipv6Address RandomAddress (void);
+  /**
+   * \returns a random port of the test
+   */
+  uint16_t RandomPort (void);
+
+  Ipv6EndPointDemux m_demux;             //!< The demux under test
+  Ptr<Ipv6Interface> m_interface;        //!< The incoming interface
+  Ptr<UniformRandomVariable> m_random;   //!< Random packets
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Check Ipv6EndPointDemux lookups against a linear scan")
+{
+}
+
+Ipv6Address
+Ipv6EndPointDemuxTestCase::RandomAddress (void)
+{
+  static const char *addresses[] = { "2001:db8::1", "2001:db8::2", "2001:db8::3", "ff02::2",
+                                     "::", "2001:db8:1::1" };
+  return Ipv6Address (addresses[m_random->GetInteger (0, 5)]);
+}
+
+uint16_t
+Ipv6EndPointDemuxTestCase::RandomPort (void)
+{
+  static const uint16_t ports[] = { 0, 53, 80, 1234, 49153 };
+  return ports[m_random->GetInteger (0, 4)];
+}
+
+Ipv6EndPointDemux::EndPoints
+Ipv6EndPointDemuxTestCase::ScanLookup (Ipv6Address daddr, uint16_t dport,
+                                       Ipv6Address saddr, uint16_t sport)
+{
+  Ipv6EndPointDemux::EndPoints retval[4];
+  Ipv6EndPointDemux::EndPoints all = m_demux.GetEndPoints ();
+  for (Ipv6EndPointDemux::EndPointsI i = all.begin (); i != all.end (); i++)
+    {
+      Ipv6EndPoint *endP = *i;
+      if (!endP->IsRxEnabled () || endP->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      if (endP->GetBoundNetDevice () && endP->GetBoundNetDevice () != m_interface->GetDevice ())
+        {
+          continue;
+        }
+      bool localWildCard = endP->GetLocalAddress () == Ipv6Address::GetAny ();
+      bool localExact = endP->GetLocalAddress () == daddr;
+      bool localAllRouters = endP->GetLocalAddress () == Ipv6Address::GetAllRoutersMulticast ();
+      bool portExact = endP->GetPeerPort () == sport;
+      bool portWildCard = endP->GetPeerPort () == 0;
+      bool addressExact = endP->GetPeerAddress () == saddr;
+      bool addressWildCard = endP->GetPeerAddress () == Ipv6Address::GetAny ();
+      if (!(localExact || localWildCard) || !(portExact || portWildCard) || !(addressExact || addressWildCard))
+        {
+          continue;
+        }
+      if (localWildCard && portWildCard && addressWildCard)
+        {
+          retval[0].push_back (endP);
+        }
+      if ((localExact || localAllRouters) && portWildCard && addressWildCard)
+        {
+          retval[1].push_back (endP);
+        }
+      if (localWildCard && portExact && addressExact)
+        {
+          retval[2].push_back (endP);
+        }
+      if (localExact && portExact && addressExact)
+        {
+          retval[3].push_back (endP);
+        }
+    }
+  for (uint32_t i = 3; i > 0; i--)
+    {
+      if (!retval[i].empty ())
+        {
+          return retval[i];
+        }
+    }
+  return retval[0];
+}
+
+Ipv6EndPoint *
+Ipv6EndPointDemuxTestCase::ScanSimpleLookup (Ipv6Address daddr, uint16_t dport,
+                                             Ipv6Address saddr, uint16_t sport)
+{
+  uint32_t genericity = 3;
+  Ipv6EndPoint *generic = 0;
+  Ipv6EndPointDemux::EndPoints all = m_demux.GetEndPoints ();
+  for (Ipv6EndPointDemux::EndPointsI i = all.begin (); i != all.end (); i++)
+    {
+      if ((*i)->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      if ((*i)->GetLocalAddress () == daddr && (*i)->GetPeerPort () == sport
+          && (*i)->GetPeerAddress () == saddr)
+        {
+          return *i;
+        }
+      uint32_t tmp = ((*i)->GetLocalAddress () == Ipv6Address::GetAny () ? 1 : 0)
+        + ((*i)->GetPeerAddress () == Ipv6Address::GetAny () ? 1 : 0);
+      if (tmp < genericity)
+        {
+          generic = *i;
+          genericity = tmp;
+        }
+    }
+  return generic;
+}
+
+void
+Ipv6EndPointDemuxTestCase::Check (void)
+{
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      Ipv6Address daddr = RandomAddress ();
+      uint16_t dport = RandomPort ();
+      Ipv6Address saddr = RandomAddress ();
+      uint16_t sport = RandomPort ();
+      Ipv6EndPointDemux::EndPoints expected = ScanLookup (daddr, dport, saddr, sport);
+      Ipv6EndPointDemux::EndPoints found = m_demux.Lookup (daddr, dport, saddr, sport, m_interface);
+      NS_TEST_ASSERT_MSG_EQ ((found == expected), true, "Wrong endpoints for " << daddr << ":" << dport
+                             << " from " << saddr << ":" << sport);
+      NS_TEST_ASSERT_MSG_EQ (m_demux.SimpleLookup (daddr, dport, saddr, sport),
+                             ScanSimpleLookup (daddr, dport, saddr, sport),
+                             "Wrong simple lookup for " << daddr << ":" << dport << " from " << saddr << ":" << sport);
+
+      bool portUsed = false;
+      bool localUsed = false;
+      Ipv6EndPointDemux::EndPoints all = m_demux.GetEndPoints ();
+      for (Ipv6EndPointDemux::EndPointsI j = all.begin (); j != all.end (); j++)
+        {
+          portUsed = portUsed || (*j)->GetLocalPort () == dport;
+          localUsed = localUsed || ((*j)->GetLocalPort () == dport && (*j)->GetLocalAddress () == daddr);
+        }
+      NS_TEST_ASSERT_MSG_EQ (m_demux.LookupPortLocal (dport), portUsed, "Wrong local port lookup");
+      NS_TEST_ASSERT_MSG_EQ (m_demux.LookupLocal (daddr, dport), localUsed, "Wrong local lookup");
+    }
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (2);
+  m_interface = CreateObject<Ipv6Interface> ();
+
+  // listening sockets, some bound to an address
+  m_demux.Allocate (80);
+  m_demux.Allocate (Ipv6Address ("2001:db8::1"), 80);
+  m_demux.Allocate (Ipv6Address::GetAllRoutersMulticast (), 53);
+  m_demux.Allocate (53);
+  NS_TEST_ASSERT_MSG_EQ (m_demux.Allocate (Ipv6Address ("2001:db8::1"), 80), 0, "Duplicate address/port should fail");
+  Ipv6EndPoint *bound = m_demux.Allocate (1234);
+  bound->BindToNetDevice (CreateObject<SimpleNetDevice> ());
+  Ipv6EndPoint *disabled = m_demux.Allocate (Ipv6Address ("2001:db8::2"), 1234);
+  disabled->SetRxEnabled (false);
+  Check ();
+
+  // connections, allocated as by TCP accept and connect, and UDP connect
+  std::vector<Ipv6EndPoint *> connections;
+  for (uint32_t i = 0; i < 40; i++)
+    {
+      Ipv6EndPoint *endPoint = m_demux.Allocate (RandomAddress (), RandomPort (), RandomAddress (), RandomPort ());
+      if (endPoint != 0)
+        {
+          connections.push_back (endPoint);
+        }
+      endPoint = m_demux.Allocate ();
+      endPoint->SetPeer (RandomAddress (), RandomPort ());
+      endPoint->SetLocalAddress (RandomAddress ());
+      connections.push_back (endPoint);
+    }
+  Check ();
+
+  // reconnections and closes
+  for (uint32_t i = 0; i < connections.size (); i += 3)
+    {
+      connections[i]->SetPeer (RandomAddress (), RandomPort ());
+    }
+  for (uint32_t i = 1; i < connections.size (); i += 3)
+    {
+      m_demux.DeAllocate (connections[i]);
+    }
+  Check ();
+
+  m_interface = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4EndPointDemux and Ipv6EndPointDemux Test Suite
+ */
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ();
+};
+
+EndPointDemuxTestSuite::EndPointDemuxTestSuite ()
+  : TestSuite ("end-point-demux", UNIT)
+{
+  AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv6EndPointDemuxTestCase, TestCase::QUICK);
+}
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite; //!< Static variable for test initialization
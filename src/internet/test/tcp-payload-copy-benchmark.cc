@@ -0,0 +1,222 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/buffer.h"
+#include "ns3/packet.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/uinteger.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Count the payload bytes copied by the buffers of the packets
+ * of a TCP transfer, with and without slabs.
+ */
+class TcpPayloadCopyBenchmarkTestCase : public TestCase
+{
+public:
+  TcpPayloadCopyBenchmarkTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Transfer the payload from a node to another one.
+   * \param slabs whether the payload is stored in slabs
+   * \returns the number of bytes copied by the buffers during the transfer
+   */
+  uint64_t Transfer (bool slabs);
+  /**
+   * Add a SimpleNetDevice to a node.
+   * \param node the node
+   * \param address the IPv4 address of the device
+   */
+  void AddDevice (Ptr<Node> node, Ipv4Address address);
+  /**
+   * Write as much of the payload as the socket accepts.
+   * \param socket the sending socket
+   * \param available the space available in the socket
+   */
+  void Send (Ptr<Socket> socket, uint32_t available);
+  /**
+   * Read all the bytes available in the socket.
+   * \param socket the receiving socket
+   */
+  void Receive (Ptr<Socket> socket);
+  /**
+   * Accept a connection.
+   * \param socket the accepted socket
+   * \param from the address of the peer
+   */
+  void Accept (Ptr<Socket> socket, const Address &from);
+
+  std::vector<uint8_t> m_payload; //!< bytes sent
+  std::vector<uint8_t> m_received; //!< bytes received
+  uint32_t m_sent; //!< number of bytes sent
+  uint32_t m_rxBytes; //!< number of bytes received
+  Ptr<SimpleChannel> m_channel; //!< channel between the nodes
+};
+
+TcpPayloadCopyBenchmarkTestCase::TcpPayloadCopyBenchmarkTestCase ()
+  : TestCase ("Bytes copied by a TCP transfer"),
+    m_sent (0),
+    m_rxBytes (0)
+{
+}
+
+void
+TcpPayloadCopyBenchmarkTestCase::AddDevice (Ptr<Node> node, Ipv4Address address)
+{
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  device->SetChannel (m_channel);
+  node->AddDevice (device);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->AddInterface (device);
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress (address, Ipv4Mask ("255.255.255.0")));
+  ipv4->SetUp (interface);
+}
+
+void
+TcpPayloadCopyBenchmarkTestCase::Send (Ptr<Socket> socket, uint32_t available)
+{
+  while (m_sent < m_payload.size () && socket->GetTxAvailable () > 0)
+    {
+      uint32_t size = std::min<uint32_t> (m_payload.size () - m_sent, socket->GetTxAvailable ());
+      size = std::min<uint32_t> (size, 65536);
+      int sent = socket->Send (Create<Packet> (&m_payload[m_sent], size));
+      NS_TEST_ASSERT_MSG_EQ (sent, (int)size, "The socket should accept the payload");
+      m_sent += size;
+    }
+  if (m_sent == m_payload.size ())
+    {
+      socket->Close ();
+    }
+}
+
+void
+TcpPayloadCopyBenchmarkTestCase::Receive (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv ()) != 0 && packet->GetSize () > 0)
+    {
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (m_rxBytes + packet->GetSize (), m_received.size (), "Too many bytes received");
+      packet->CopyData (&m_received[m_rxBytes], packet->GetSize ());
+      m_rxBytes += packet->GetSize ();
+    }
+}
+
+void
+TcpPayloadCopyBenchmarkTestCase::Accept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&TcpPayloadCopyBenchmarkTestCase::Receive, this));
+}
+
+uint64_t
+TcpPayloadCopyBenchmarkTestCase::Transfer (bool slabs)
+{
+  typedef std::chrono::steady_clock Clock;
+  m_sent = 0;
+  m_rxBytes = 0;
+  m_received.assign (m_payload.size (), 0);
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  m_channel = CreateObject<SimpleChannel> ();
+  AddDevice (nodes.Get (0), Ipv4Address ("10.0.0.1"));
+  AddDevice (nodes.Get (1), Ipv4Address ("10.0.0.2"));
+
+  Ptr<Socket> server = Socket::CreateSocket (nodes.Get (0), TcpSocketFactory::GetTypeId ());
+  server->Bind (InetSocketAddress (Ipv4Address::GetAny (), 5000));
+  server->Listen ();
+  server->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                             MakeCallback (&TcpPayloadCopyBenchmarkTestCase::Accept, this));
+  Ptr<Socket> source = Socket::CreateSocket (nodes.Get (1), TcpSocketFactory::GetTypeId ());
+  source->SetAttribute ("SegmentSize", UintegerValue (1448));
+  source->SetSendCallback (MakeCallback (&TcpPayloadCopyBenchmarkTestCase::Send, this));
+  source->Connect (InetSocketAddress (Ipv4Address ("10.0.0.1"), 5000));
+
+  if (slabs)
+    {
+      Buffer::EnableSlabs ();
+    }
+  uint64_t copied = Buffer::GetCopiedBytes ();
+  Clock::time_point start = Clock::now ();
+  Simulator::Run ();
+  double seconds = std::chrono::duration<double> (Clock::now () - start).count ();
+  copied = Buffer::GetCopiedBytes () - copied;
+  Buffer::DisableSlabs ();
+  Simulator::Destroy ();
+  m_channel = 0;
+
+  NS_TEST_EXPECT_MSG_EQ (m_rxBytes, m_payload.size (), "All the payload should be received");
+  NS_TEST_EXPECT_MSG_EQ ((m_received == m_payload), true, "The payload should be received unchanged");
+  uint32_t segments = (m_payload.size () + 1447) / 1448;
+  std::cout << "tcp-payload-copy-perf: " << (slabs ? "slabs" : "no slabs") << ": "
+            << (double)copied / segments << " bytes copied per segment, "
+            << 1e6 * seconds / segments << " us per segment" << std::endl;
+  return copied;
+}
+
+void
+TcpPayloadCopyBenchmarkTestCase::DoRun (void)
+{
+  m_payload.resize (4 * 1024 * 1024);
+  for (uint32_t i = 0; i < m_payload.size (); i++)
+    {
+      m_payload[i] = (i * 31 + i / 1024) & 0xff;
+    }
+  uint64_t copied = Transfer (false);
+  uint64_t slabCopied = Transfer (true);
+  NS_TEST_ASSERT_MSG_LT (slabCopied, copied, "Slabs should reduce the number of bytes copied");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP payload copy performance test suite
+ */
+class TcpPayloadCopyPerformanceSuite : public TestSuite
+{
+public:
+  TcpPayloadCopyPerformanceSuite ();
+};
+
+TcpPayloadCopyPerformanceSuite::TcpPayloadCopyPerformanceSuite ()
+  : TestSuite ("tcp-payload-copy-perf", PERFORMANCE)
+{
+  AddTestCase (new TcpPayloadCopyBenchmarkTestCase, TestCase::QUICK);
+}
+
+static TcpPayloadCopyPerformanceSuite g_tcpPayloadCopyPerformanceSuite; //!< Static variable for test initialization
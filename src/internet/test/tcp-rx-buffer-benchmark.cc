@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/tcp-rx-buffer.h"
+#include "ns3/packet.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Time a bulk transfer through TcpRxBuffer, with both storages
+ *
+ * Segments of 1448 bytes are received in order, except that one segment
+ * every 64 arrives after the following 8 ones. The application reads the
+ * available data after every 2 segments, as a delayed ACK receiver would.
+ */
+class TcpRxBufferBenchmarkTestCase : public TestCase
+{
+public:
+  TcpRxBufferBenchmarkTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Receive the bulk transfer
+   * \param contiguous use the contiguous storage
+   */
+  void Receive (bool contiguous);
+};
+
+TcpRxBufferBenchmarkTestCase::TcpRxBufferBenchmarkTestCase ()
+  : TestCase ("Bulk transfer through TcpRxBuffer")
+{
+}
+
+void
+TcpRxBufferBenchmarkTestCase::Receive (bool contiguous)
+{
+  typedef std::chrono::steady_clock Clock;
+  const uint32_t segmentSize = 1448;
+  const uint32_t segments = 200000;
+  SequenceNumber32 isn (1);
+
+  TcpRxBuffer rxBuf;
+  rxBuf.SetContiguousStorage (contiguous);
+  rxBuf.SetMaxBufferSize (131072);
+  rxBuf.SetNextRxSequence (isn);
+
+  Clock::time_point start = Clock::now ();
+  uint64_t delivered = 0;
+  TcpHeader h;
+  for (uint32_t i = 0; i < segments; ++i)
+    {
+      // Swap the first segment of every block of 64 with the 9th one
+      uint32_t n = i;
+      if (i % 64 == 0)
+        {
+          n = i + 8;
+        }
+      else if (i % 64 == 8)
+        {
+          n = i - 8;
+        }
+      h.SetSequenceNumber (isn + n * segmentSize);
+      rxBuf.Add (Create<Packet> (segmentSize), h);
+      if (i % 2 == 1)
+        {
+          Ptr<Packet> p = rxBuf.Extract (rxBuf.Available ());
+          if (p != 0)
+            {
+              delivered += p->GetSize ();
+            }
+        }
+    }
+  double seconds = std::chrono::duration<double> (Clock::now () - start).count ();
+  NS_TEST_EXPECT_MSG_EQ (delivered, static_cast<uint64_t> (segments) * segmentSize,
+                         "All the data should be delivered");
+
+  std::cout << "tcp-rx-buffer-perf: " << (contiguous ? "contiguous" : "per segment") << ": "
+            << 1e9 * seconds / segments << " ns per segment" << std::endl;
+}
+
+void
+TcpRxBufferBenchmarkTestCase::DoRun (void)
+{
+  Receive (false);
+  Receive (true);
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TcpRxBuffer performance test suite
+ */
+class TcpRxBufferPerformanceSuite : public TestSuite
+{
+public:
+  TcpRxBufferPerformanceSuite ();
+};
+
+TcpRxBufferPerformanceSuite::TcpRxBufferPerformanceSuite ()
+  : TestSuite ("tcp-rx-buffer-perf", PERFORMANCE)
+{
+  AddTestCase (new TcpRxBufferBenchmarkTestCase, TestCase::QUICK);
+}
+
+static TcpRxBufferPerformanceSuite g_tcpRxBufferPerformanceSuite; //!< Static variable for test initialization
@@ -18,9 +18,12 @@
 #include "ns3/test.h"
 #include "ns3/packet.h"
 #include "ns3/log.h"
+#include "ns3/random-variable-stream.h"
 
 #include "ns3/tcp-rx-buffer.h"
 
+#include <vector>
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("TcpRxBufferTestSuite");
@@ -34,7 +37,11 @@ NS_LOG_COMPONENT_DEFINE ("TcpRxBufferTestSuite");
 class TcpRxBufferTestCase : public TestCase
 {
 public:
-  TcpRxBufferTestCase ();
+  /**
+   * \brief Constructor
+   * \param contiguous test the contiguous storage of TcpRxBuffer
+   */
+  TcpRxBufferTestCase (bool contiguous);
 
 private:
   virtual void DoRun (void);
@@ -44,10 +51,13 @@ private:
    * \brief Test the SACK list update.
    */
   void TestUpdateSACKList ();
+
+  bool m_contiguous; //!< Test the contiguous storage
 };
 
-TcpRxBufferTestCase::TcpRxBufferTestCase ()
-  : TestCase ("TcpRxBuffer Test")
+TcpRxBufferTestCase::TcpRxBufferTestCase (bool contiguous)
+  : TestCase (contiguous ? "TcpRxBuffer Test with contiguous storage" : "TcpRxBuffer Test"),
+    m_contiguous (contiguous)
 {
 }
 
@@ -61,6 +71,7 @@ void
 TcpRxBufferTestCase::TestUpdateSACKList ()
 {
   TcpRxBuffer rxBuf;
+  rxBuf.SetContiguousStorage (m_contiguous);
   TcpOptionSack::SackList sackList;
   TcpOptionSack::SackList::iterator it;
   Ptr<Packet> p = Create<Packet> (100);
@@ -343,6 +354,142 @@ TcpRxBufferTestCase::DoTeardown ()
 {
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the contiguous storage of TcpRxBuffer against the default one
+ *
+ * A byte stream is received through random, overlapping and duplicated
+ * segments by two buffers, one for each storage, and extracted in random
+ * amounts. Both buffers must return the stream bytes, and agree on the
+ * sequence numbers and sizes. The SACK blocks of the contiguous storage must
+ * be maximal ranges of out-of-order data, the first one containing the last
+ * out-of-order segment.
+ */
+class TcpRxBufferContiguousTestCase : public TestCase
+{
+public:
+  TcpRxBufferContiguousTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpRxBufferContiguousTestCase::TcpRxBufferContiguousTestCase ()
+  : TestCase ("TcpRxBuffer contiguous storage against the default one")
+{
+}
+
+void
+TcpRxBufferContiguousTestCase::DoRun ()
+{
+  const uint32_t streamSize = 300000;
+  const SequenceNumber32 isn (4294900000U); // wraps around during the test
+  std::vector<uint8_t> stream (streamSize);
+  for (uint32_t i = 0; i < streamSize; ++i)
+    {
+      stream[i] = static_cast<uint8_t> (i * 7 + i / 251);
+    }
+  std::vector<bool> received (streamSize, false);
+
+  TcpRxBuffer list;
+  TcpRxBuffer ring;
+  ring.SetContiguousStorage (true);
+  list.SetNextRxSequence (isn);
+  ring.SetNextRxSequence (isn);
+  list.SetMaxBufferSize (65535);
+  ring.SetMaxBufferSize (65535);
+
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (11);
+
+  uint32_t delivered = 0;
+  std::vector<uint8_t> out (65535);
+  while (delivered < streamSize)
+    {
+      uint32_t next = ring.NextRxSequence () - isn;
+      if (rng->GetInteger (0, 3) > 0)
+        {
+          // A segment around the receive window, possibly already received
+          uint32_t start = next + rng->GetInteger (0, 30000);
+          start = start > 3000 ? start - 3000 : 0;
+          uint32_t size = rng->GetInteger (1, 1500);
+          if (start >= streamSize)
+            {
+              continue;
+            }
+          size = std::min (size, streamSize - start);
+          TcpHeader h;
+          h.SetSequenceNumber (isn + start);
+          Ptr<Packet> p = Create<Packet> (&stream[start], size);
+          bool addedList = list.Add (p, h);
+          bool addedRing = ring.Add (p, h);
+          NS_TEST_ASSERT_MSG_EQ (addedRing, addedList, "Add results differ");
+          NS_TEST_ASSERT_MSG_EQ (p->GetSize (), size, "Added packet modified");
+          if (addedRing)
+            {
+              SequenceNumber32 maxSeq = isn + start + size;
+              if (ring.Size () > 0 && ring.MaxRxSequence () < maxSeq)
+                {
+                  maxSeq = ring.MaxRxSequence ();
+                }
+              uint32_t end = maxSeq - isn;
+              for (uint32_t i = start; i < end; ++i)
+                {
+                  received[i] = true;
+                }
+            }
+
+          // Check the SACK blocks against the received ranges
+          TcpOptionSack::SackList sackList = ring.GetSackList ();
+          NS_TEST_ASSERT_MSG_EQ (sackList.size (), ring.GetSackListSize (), "SACK list size differs");
+          NS_TEST_ASSERT_MSG_LT_OR_EQ (sackList.size (), 4, "Too many SACK blocks");
+          for (TcpOptionSack::SackList::iterator it = sackList.begin (); it != sackList.end (); ++it)
+            {
+              uint32_t head = it->first - isn;
+              uint32_t tail = it->second - isn;
+              NS_TEST_ASSERT_MSG_GT (it->first, ring.NextRxSequence (), "SACK block below RCV.NXT");
+              NS_TEST_ASSERT_MSG_EQ (received[head - 1], false, "SACK block not maximal");
+              NS_TEST_ASSERT_MSG_EQ ((tail == streamSize || !received[tail]), true, "SACK block not maximal");
+              for (uint32_t i = head; i < tail; ++i)
+                {
+                  NS_TEST_ASSERT_MSG_EQ (received[i], true, "SACK block with missing data");
+                }
+            }
+          if (addedRing && isn + start > ring.NextRxSequence ())
+            {
+              NS_TEST_ASSERT_MSG_EQ (sackList.empty (), false, "No SACK block for out-of-order data");
+              NS_TEST_ASSERT_MSG_LT_OR_EQ (sackList.front ().first, isn + start, "First SACK block is not the last segment");
+              NS_TEST_ASSERT_MSG_GT (sackList.front ().second, isn + start, "First SACK block is not the last segment");
+            }
+        }
+      else
+        {
+          uint32_t maxSize = rng->GetInteger (1, 20000);
+          Ptr<Packet> fromList = list.Extract (maxSize);
+          Ptr<Packet> fromRing = ring.Extract (maxSize);
+          NS_TEST_ASSERT_MSG_EQ ((fromRing == 0), (fromList == 0), "Extract results differ");
+          if (fromRing != 0)
+            {
+              NS_TEST_ASSERT_MSG_EQ (fromRing->GetSize (), fromList->GetSize (), "Extracted sizes differ");
+              uint32_t size = fromRing->GetSize ();
+              fromRing->CopyData (&out[0], size);
+              NS_TEST_ASSERT_MSG_EQ (std::equal (out.begin (), out.begin () + size, stream.begin () + delivered),
+                                     true, "Extracted data differs from the stream");
+              fromList->CopyData (&out[0], size);
+              NS_TEST_ASSERT_MSG_EQ (std::equal (out.begin (), out.begin () + size, stream.begin () + delivered),
+                                     true, "Extracted data differs from the stream");
+              delivered += size;
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (ring.NextRxSequence (), list.NextRxSequence (), "RCV.NXT differs");
+      NS_TEST_ASSERT_MSG_EQ (ring.MaxRxSequence (), list.MaxRxSequence (), "Max sequence differs");
+      NS_TEST_ASSERT_MSG_EQ (ring.Size (), list.Size (), "Buffer occupancy differs");
+      NS_TEST_ASSERT_MSG_EQ (ring.Available (), list.Available (), "Available bytes differ");
+    }
+}
+
 
 /**
  * \ingroup internet-test
@@ -356,7 +503,9 @@ public:
   TcpRxBufferTestSuite ()
     : TestSuite ("tcp-rx-buffer", UNIT)
   {
-    AddTestCase (new TcpRxBufferTestCase, TestCase::QUICK);
+    AddTestCase (new TcpRxBufferTestCase (false), TestCase::QUICK);
+    AddTestCase (new TcpRxBufferTestCase (true), TestCase::QUICK);
+    AddTestCase (new TcpRxBufferContiguousTestCase, TestCase::QUICK);
   }
 };
 static TcpRxBufferTestSuite  g_tcpRxBufferTestSuite;
@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/tcp-tx-buffer.h"
+#include "ns3/packet.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Time the scoreboard operations done by TcpSocketBase on every
+ * ACK, during the recovery of a large window with SACK.
+ */
+class TcpTxBufferBenchmarkTestCase : public TestCase
+{
+public:
+  TcpTxBufferBenchmarkTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Recover from the loss of every other segment of a window.
+   * \param segments the number of segments of the window
+   */
+  void Recover (uint32_t segments);
+};
+
+TcpTxBufferBenchmarkTestCase::TcpTxBufferBenchmarkTestCase ()
+  : TestCase ("Scoreboard operations in a large window")
+{
+}
+
+void
+TcpTxBufferBenchmarkTestCase::Recover (uint32_t segments)
+{
+  typedef std::chrono::steady_clock Clock;
+  const uint32_t segmentSize = 1000;
+  const uint32_t dupThresh = 3;
+  SequenceNumber32 head (1);
+
+  TcpTxBuffer txBuf;
+  txBuf.SetMaxBufferSize (4 * segments * segmentSize);
+  txBuf.SetHeadSequence (head);
+  txBuf.Add (Create<Packet> (2 * segments * segmentSize));
+  for (uint32_t i = 0; i < segments; ++i)
+    {
+      txBuf.CopyFromSequence (segmentSize, head + i * segmentSize);
+    }
+
+  // Every odd segment arrives and is SACKed, one per ACK, and every ACK
+  // computes the pipe and asks for the next segment to send
+  Clock::time_point start = Clock::now ();
+  uint64_t pipe = 0;
+  uint32_t retransmitted = 0;
+  for (uint32_t i = 1; i < segments; i += 2)
+    {
+      Ptr<TcpOptionSack> sack = CreateObject<TcpOptionSack> ();
+      sack->AddSackBlock (TcpOptionSack::SackBlock (head + i * segmentSize,
+                                                    head + (i + 1) * segmentSize));
+      txBuf.Update (sack->GetSackList ());
+      pipe += txBuf.BytesInFlight (dupThresh, segmentSize);
+      SequenceNumber32 next;
+      if (txBuf.NextSeg (&next, dupThresh, segmentSize, true)
+          && next < head + segments * segmentSize)
+        {
+          txBuf.CopyFromSequence (segmentSize, next);
+          ++retransmitted;
+        }
+    }
+  double seconds = std::chrono::duration<double> (Clock::now () - start).count ();
+  NS_TEST_EXPECT_MSG_GT (pipe, 0, "Some bytes should be in flight");
+  NS_TEST_EXPECT_MSG_GT (retransmitted, segments / 4, "The lost segments should be retransmitted");
+
+  std::cout << "tcp-tx-buffer-perf: " << segments << " segments: "
+            << 1e6 * seconds / (segments / 2) << " us per ACK" << std::endl;
+}
+
+void
+TcpTxBufferBenchmarkTestCase::DoRun (void)
+{
+  Recover (1000);
+  Recover (4000);
+  Recover (16000);
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TcpTxBuffer performance test suite
+ */
+class TcpTxBufferPerformanceSuite : public TestSuite
+{
+public:
+  TcpTxBufferPerformanceSuite ();
+};
+
+TcpTxBufferPerformanceSuite::TcpTxBufferPerformanceSuite ()
+  : TestSuite ("tcp-tx-buffer-perf", PERFORMANCE)
+{
+  AddTestCase (new TcpTxBufferBenchmarkTestCase, TestCase::QUICK);
+}
+
+static TcpTxBufferPerformanceSuite g_tcpTxBufferPerformanceSuite; //!< Static variable for test initialization
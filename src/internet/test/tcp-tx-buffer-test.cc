@@ -20,6 +20,9 @@
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/random-variable-stream.h"
+
+#include <vector>
 
 using namespace ns3;
 
@@ -400,6 +403,278 @@ TcpTxBufferTestCase::DoTeardown ()
 {
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the indexed scoreboard of TcpTxBuffer against the RFC 6675
+ * algorithms run over a model of the segments sent
+ */
+class TcpTxBufferScoreboardTestCase : public TestCase
+{
+public:
+  /** \brief Constructor */
+  TcpTxBufferScoreboardTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /** \brief A segment of the model */
+  struct Segment
+  {
+    uint32_t size;  //!< size of the segment
+    bool sacked;    //!< whether the segment has been SACKed
+    bool retrans;   //!< whether the segment has been retransmitted
+    bool lost;      //!< whether the segment has been flagged lost
+  };
+
+  /**
+   * \brief Get the sequence number of a segment of the model
+   * \param i the index of the segment
+   * \return the sequence number of its first byte
+   */
+  SequenceNumber32 GetSequence (uint32_t i) const;
+  /**
+   * \brief RFC 6675 IsLost, walking the segments of the model
+   * \param i the index of the segment
+   * \return true if the segment is lost
+   */
+  bool IsLost (uint32_t i) const;
+  /**
+   * \brief Check the scoreboard queries against the model
+   * \param txBuf the buffer
+   * \param all whether IsLost is checked for all the segments
+   */
+  void Check (const TcpTxBuffer &txBuf, bool all);
+
+  std::vector<Segment> m_segments; //!< model of the segments sent
+  SequenceNumber32 m_head;         //!< sequence number of the first segment
+  uint32_t m_unsent;               //!< bytes not sent yet
+  uint32_t m_dupThresh;            //!< dupAck threshold
+  uint32_t m_segmentSize;          //!< segment size
+};
+
+TcpTxBufferScoreboardTestCase::TcpTxBufferScoreboardTestCase ()
+  : TestCase ("TcpTxBuffer indexed scoreboard against RFC 6675"),
+    m_head (1),
+    m_unsent (0),
+    m_dupThresh (3),
+    m_segmentSize (100)
+{
+}
+
+SequenceNumber32
+TcpTxBufferScoreboardTestCase::GetSequence (uint32_t i) const
+{
+  SequenceNumber32 seq = m_head;
+  for (uint32_t j = 0; j < i; ++j)
+    {
+      seq += m_segments[j].size;
+    }
+  return seq;
+}
+
+bool
+TcpTxBufferScoreboardTestCase::IsLost (uint32_t i) const
+{
+  if (m_segments[i].lost)
+    {
+      return true;
+    }
+  if (m_segments[i].sacked)
+    {
+      return false;
+    }
+  uint32_t count = 0;
+  uint32_t bytes = 0;
+  for (uint32_t j = i + 1; j < m_segments.size (); ++j)
+    {
+      if (m_segments[j].sacked)
+        {
+          ++count;
+          bytes += m_segments[j].size;
+          if (count >= m_dupThresh || bytes > (m_dupThresh - 1) * m_segmentSize)
+            {
+              return true;
+            }
+        }
+    }
+  return false;
+}
+
+void
+TcpTxBufferScoreboardTestCase::Check (const TcpTxBuffer &txBuf, bool all)
+{
+  uint32_t pipe = 0;
+  int32_t highestSacked = -1;
+  int32_t nextSeg = -1;
+  int32_t rule3 = -1;
+  for (uint32_t i = 0; i < m_segments.size (); ++i)
+    {
+      const Segment &segment = m_segments[i];
+      if (segment.sacked)
+        {
+          highestSacked = i;
+          continue;
+        }
+      bool lost = IsLost (i);
+      if (!lost || (segment.retrans && !segment.lost))
+        {
+          pipe += segment.size;
+        }
+      if (!segment.retrans && nextSeg < 0)
+        {
+          if (lost)
+            {
+              nextSeg = i;
+            }
+          else if (rule3 < 0)
+            {
+              rule3 = i;
+            }
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (m_dupThresh, m_segmentSize), pipe,
+                         "BytesInFlight differs from RFC 6675 SetPipe");
+
+  SequenceNumber32 tail = GetSequence (m_segments.size ());
+  for (uint32_t recovery = 0; recovery < 2; ++recovery)
+    {
+      SequenceNumber32 seq;
+      bool found = txBuf.NextSeg (&seq, m_dupThresh, m_segmentSize, recovery);
+      if (nextSeg >= 0)
+        {
+          NS_TEST_ASSERT_MSG_EQ (found, true, "NextSeg should find a lost segment");
+          NS_TEST_ASSERT_MSG_EQ (seq, GetSequence (nextSeg), "NextSeg differs from rule (1)");
+        }
+      else if (m_unsent > 0)
+        {
+          NS_TEST_ASSERT_MSG_EQ (found, true, "NextSeg should find new data");
+          NS_TEST_ASSERT_MSG_EQ (seq, tail, "NextSeg differs from rule (2)");
+        }
+      else if (recovery && rule3 >= 0)
+        {
+          NS_TEST_ASSERT_MSG_EQ (found, true, "NextSeg should find an unSACKed segment");
+          NS_TEST_ASSERT_MSG_EQ (seq, GetSequence (rule3), "NextSeg differs from rule (3)");
+        }
+      else
+        {
+          NS_TEST_ASSERT_MSG_EQ (found, false, "NextSeg should not find a segment");
+        }
+    }
+
+  for (uint32_t i = 0; i < m_segments.size (); ++i)
+    {
+      if (!all && i != m_segments.size () / 2)
+        {
+          continue;
+        }
+      bool lost = highestSacked >= 0 && (int32_t) i <= highestSacked && IsLost (i);
+      NS_TEST_ASSERT_MSG_EQ (txBuf.IsLost (GetSequence (i), m_dupThresh, m_segmentSize), lost,
+                             "IsLost differs from RFC 6675 for segment " << i);
+    }
+}
+
+void
+TcpTxBufferScoreboardTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  TcpTxBuffer txBuf;
+  txBuf.SetMaxBufferSize (1000000);
+  txBuf.SetHeadSequence (m_head);
+  m_unsent = 500000;
+  txBuf.Add (Create<Packet> (m_unsent));
+
+  for (uint32_t step = 0; step < 4000; ++step)
+    {
+      uint32_t action = random->GetInteger (0, 99);
+      uint32_t n = m_segments.size ();
+      if (action < 40 && m_unsent > 0)
+        {
+          // send a new segment
+          txBuf.CopyFromSequence (m_segmentSize, GetSequence (n));
+          Segment segment = { m_segmentSize, false, false, false };
+          m_segments.push_back (segment);
+          m_unsent -= m_segmentSize;
+        }
+      else if (action < 70 && n >= 2)
+        {
+          // SACK some segments, but never the head
+          uint32_t first = random->GetInteger (1, n - 1);
+          uint32_t last = std::min (n, first + random->GetInteger (1, 4));
+          Ptr<TcpOptionSack> sack = CreateObject<TcpOptionSack> ();
+          sack->AddSackBlock (TcpOptionSack::SackBlock (GetSequence (first), GetSequence (last)));
+          txBuf.Update (sack->GetSackList ());
+          for (uint32_t i = first; i < last; ++i)
+            {
+              m_segments[i].sacked = true;
+            }
+        }
+      else if (action < 85 && n > 0)
+        {
+          // retransmit what NextSeg asks for, sometimes only a part of it
+          SequenceNumber32 seq;
+          if (txBuf.NextSeg (&seq, m_dupThresh, m_segmentSize, true) && seq < GetSequence (n))
+            {
+              uint32_t i = 0;
+              while (GetSequence (i) != seq)
+                {
+                  ++i;
+                }
+              uint32_t size = m_segments[i].size;
+              if (size > 1 && action % 3 == 0)
+                {
+                  Segment firstPart = m_segments[i];
+                  firstPart.size = size / 2;
+                  m_segments[i].size -= firstPart.size;
+                  m_segments.insert (m_segments.begin () + i, firstPart);
+                  size = firstPart.size;
+                }
+              txBuf.CopyFromSequence (size, seq);
+              m_segments[i].retrans = true;
+              m_segments[i].lost = false;
+            }
+        }
+      else if (action < 96 && n > 0)
+        {
+          // cumulative ACK, sometimes in the middle of a segment
+          uint32_t acked = random->GetInteger (1, std::min<uint32_t> (n, 5));
+          uint32_t extra = 0;
+          if (action % 2 == 0 && acked < n && m_segments[acked].size > 1)
+            {
+              extra = random->GetInteger (1, m_segments[acked].size - 1);
+            }
+          SequenceNumber32 ack = GetSequence (acked) + extra;
+          txBuf.DiscardUpTo (ack);
+          m_segments.erase (m_segments.begin (), m_segments.begin () + acked);
+          m_head = ack;
+          if (!m_segments.empty ())
+            {
+              m_segments.front ().size -= extra;
+              m_segments.front ().sacked = false;
+            }
+        }
+      else if (action < 98)
+        {
+          // RTO
+          txBuf.SetSentListLost ();
+          for (uint32_t i = 0; i < n; ++i)
+            {
+              m_segments[i].lost = true;
+            }
+        }
+      else
+        {
+          txBuf.ResetScoreboard ();
+          for (uint32_t i = 0; i < n; ++i)
+            {
+              m_segments[i].sacked = false;
+            }
+        }
+      Check (txBuf, step % 50 == 0);
+    }
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -413,6 +688,7 @@ public:
     : TestSuite ("tcp-tx-buffer", UNIT)
   {
     AddTestCase (new TcpTxBufferTestCase, TestCase::QUICK);
+    AddTestCase (new TcpTxBufferScoreboardTestCase, TestCase::QUICK);
   }
 };
 
@@ -153,6 +153,12 @@ private:
       a new interference chunk is calculated */
   std::list<Ptr<LteChunkProcessor> > m_interfChunkProcessorList;
 
+  /// interference plus noise of the last chunk, reused across chunks
+  SpectrumValue m_interf;
+
+  /// SINR of the last chunk, reused across chunks
+  SpectrumValue m_sinr;
+
 
 };
 
@@ -0,0 +1,514 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef MOBILITY_GRID_INDEX_H
+#define MOBILITY_GRID_INDEX_H
+
+#include "mobility-model.h"
+#include "ns3/ptr.h"
+#include "ns3/callback.h"
+#include "ns3/vector.h"
+#include "ns3/assert.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief A uniform grid over the positions of a set of items, each
+ *        located by a MobilityModel.
+ *
+ * The index answers the question "which items are within a given
+ * distance of a position" without visiting every item, e.g., to find
+ * the receivers a transmission can reach. The plane (x, y) is divided
+ * into square cells of a given size, and an item is stored in the cell
+ * of its position; the z coordinate is only used to check the distance.
+ *
+ * The index is kept up to date by the CourseChange trace of the
+ * mobility models: the items whose velocity is null are stored in the
+ * cell of their position. The moving items are stored in a second grid,
+ * in the cell of their position when they were last binned. A query
+ * looks into the cells of this grid within the distance plus the
+ * distance the items may have covered since they were binned, i.e., the
+ * maximum speed of the moving items times the time elapsed since, then
+ * checks the current position of each candidate. When this slack
+ * exceeds half a cell, all the moving items are binned again at their
+ * current position, so that a query only visits the cells close to the
+ * position even when every item moves. Mobility models must therefore
+ * fire CourseChange whenever their velocity changes, which all the
+ * models of this module do.
+ *
+ * Several items may share the same MobilityModel. The index must not be
+ * copied, as it connects its own methods to the mobility models.
+ *
+ * \tparam T the type of the items, which must be less-than comparable
+ *           (e.g., a Ptr)
+ */
+template <typename T>
+class MobilityGridIndex
+{
+public:
+  /**
+   * Create an index with infinitely large cells, i.e., a single cell.
+   */
+  MobilityGridIndex ();
+  ~MobilityGridIndex ();
+
+  /**
+   * Set the size of the cells, which should be close to the typical
+   * query distance. The items are redistributed among the new cells.
+   *
+   * \param size the size of the side of the cells, in meters
+   */
+  void SetCellSize (double size);
+  /**
+   * \return the size of the side of the cells, in meters
+   */
+  double GetCellSize (void) const;
+
+  /**
+   * Add an item, or update the mobility model of an item already indexed.
+   *
+   * \param item the item
+   * \param mobility the mobility model giving the position of the item
+   */
+  void Add (T item, Ptr<MobilityModel> mobility);
+  /**
+   * Remove an item, if indexed.
+   *
+   * \param item the item
+   */
+  void Remove (T item);
+  /**
+   * Remove all the items.
+   */
+  void Clear (void);
+  /**
+   * \return the number of items
+   */
+  uint32_t GetN (void) const;
+
+  /**
+   * Get the items within a distance of a position, sorted in increasing
+   * order.
+   *
+   * \param position the position
+   * \param distance the distance, in meters
+   * \param items the vector the items are appended to
+   */
+  void Find (const Vector &position, double distance, std::vector<T> &items) const;
+
+private:
+  /// Copy constructor, defined and unimplemented to avoid misuse
+  MobilityGridIndex (const MobilityGridIndex &);
+  /**
+   * Assignment operator, defined and unimplemented to avoid misuse
+   * \returns
+   */
+  MobilityGridIndex & operator = (const MobilityGridIndex &);
+
+  /// The coordinates of a cell
+  typedef std::pair<int64_t, int64_t> Cell;
+
+  /// The state of an indexed item
+  struct Entry
+  {
+    Ptr<MobilityModel> mobility;  //!< The mobility model of the item
+    bool moving;                  //!< Whether the item is in the grid of moving items
+    mutable Cell cell;            //!< The cell of the item, in the grid of moving items if moving
+  };
+
+  /**
+   * \param coordinate a coordinate
+   * \return the index of the cell containing the coordinate
+   */
+  int64_t GetCellIndex (double coordinate) const;
+  /**
+   * Store an item in its cell, or in the grid of moving items.
+   * \param item the item
+   * \param entry the state of the item
+   */
+  void Insert (T item, Entry &entry);
+  /**
+   * Remove an item from its cell, or from the grid of moving items.
+   * \param item the item
+   * \param entry the state of the item
+   */
+  void Extract (T item, const Entry &entry);
+  /**
+   * Store a moving item in the cell of its current position, in the grid
+   * of moving items, and account for its speed.
+   * \param item the item
+   * \param entry the state of the item
+   */
+  void BinMoving (T item, const Entry &entry) const;
+  /**
+   * Bin all the moving items again, at their current position.
+   */
+  void RebinMoving (void) const;
+  /**
+   * Relocate the items of a mobility model whose course changed.
+   * \param mobility the mobility model
+   */
+  void CourseChanged (Ptr<const MobilityModel> mobility);
+
+  /// The items of a cell, with their positions
+  typedef std::vector<std::pair<T, Vector> > CellItems;
+
+  /**
+   * Append the items of a cell within a distance of a position.
+   * \param cell the items of the cell
+   * \param position the position
+   * \param distance the distance
+   * \param items the vector the items are appended to
+   */
+  static void FindInCell (const CellItems &cell, const Vector &position, double distance, std::vector<T> &items);
+  /**
+   * Get the non-empty cells of a grid which may hold items within a
+   * distance of a position.
+   * \param cells the grid
+   * \param position the position
+   * \param distance the distance
+   * \param found the vector the cells are appended to
+   */
+  void GetCells (const std::map<Cell, CellItems> &cells, const Vector &position, double distance,
+                 std::vector<const CellItems *> &found) const;
+  /**
+   * Remove an item from a cell of a grid.
+   * \param cells the grid
+   * \param cellIndex the cell of the item
+   * \param item the item
+   */
+  static void ExtractFromCell (std::map<Cell, CellItems> &cells, const Cell &cellIndex, T item);
+
+  double m_cellSize;                                    //!< The size of the cells
+  std::map<T, Entry> m_entries;                         //!< The state of the items
+  std::map<Cell, CellItems> m_cells;                    //!< The items at rest in each cell
+  std::set<T> m_moving;                                 //!< The moving items
+  /// The moving items of each cell, with their positions when binned
+  mutable std::map<Cell, CellItems> m_movingCells;
+  mutable Time m_binTime;                               //!< The time the moving items were all binned
+  mutable double m_maxSpeed;                            //!< The maximum speed of the moving items since then, in m/s
+  /// The items of each mobility model, whose CourseChange trace is connected
+  std::map<Ptr<MobilityModel>, std::vector<T> > m_mobilities;
+};
+
+} // namespace ns3
+
+/***************************************************************
+ *  Implementation of the templates declared above.
+ ***************************************************************/
+
+namespace ns3 {
+
+template <typename T>
+MobilityGridIndex<T>::MobilityGridIndex ()
+  : m_cellSize (std::numeric_limits<double>::infinity ()),
+    m_maxSpeed (0)
+{
+}
+
+template <typename T>
+MobilityGridIndex<T>::~MobilityGridIndex ()
+{
+  Clear ();
+}
+
+template <typename T>
+int64_t
+MobilityGridIndex<T>::GetCellIndex (double coordinate) const
+{
+  if (std::isinf (m_cellSize))
+    {
+      return 0;
+    }
+  return static_cast<int64_t> (std::floor (coordinate / m_cellSize));
+}
+
+template <typename T>
+void
+MobilityGridIndex<T>::SetCellSize (double size)
+{
+  NS_ASSERT (size > 0);
+  m_cellSize = size;
+  m_cells.clear ();
+  for (typename std::map<T, Entry>::iterator it = m_entries.begin (); it != m_entries.end (); ++it)
+    {
+      if (!it->second.moving)
+        {
+          Insert (it->first, it->second);
+        }
+    }
+  RebinMoving ();
+}
+
+template <typename T>
+double
+MobilityGridIndex<T>::GetCellSize (void) const
+{
+  return m_cellSize;
+}
+
+template <typename T>
+void
+MobilityGridIndex<T>::Insert (T item, Entry &entry)
+{
+  Vector velocity = entry.mobility->GetVelocity ();
+  entry.moving = velocity.x != 0 || velocity.y != 0 || velocity.z != 0;
+  if (entry.moving)
+    {
+      if (m_moving.empty ())
+        {
+          m_binTime = Simulator::Now ();
+          m_maxSpeed = 0;
+        }
+      m_moving.insert (item);
+      BinMoving (item, entry);
+      return;
+    }
+  Vector position = entry.mobility->GetPosition ();
+  entry.cell = Cell (GetCellIndex (position.x), GetCellIndex (position.y));
+  m_cells[entry.cell].push_back (std::make_pair (item, position));
+}
+
+template <typename T>
+void
+MobilityGridIndex<T>::BinMoving (T item, const Entry &entry) const
+{
+  Vector position = entry.mobility->GetPosition ();
+  entry.cell = Cell (GetCellIndex (position.x), GetCellIndex (position.y));
+  m_movingCells[entry.cell].push_back (std::make_pair (item, position));
+  m_maxSpeed = std::max (m_maxSpeed, CalculateDistance (entry.mobility->GetVelocity (), Vector ()));
+}
+
+template <typename T>
+void
+MobilityGridIndex<T>::RebinMoving (void) const
+{
+  m_movingCells.clear ();
+  m_binTime = Simulator::Now ();
+  m_maxSpeed = 0;
+  for (typename std::set<T>::const_iterator it = m_moving.begin (); it != m_moving.end (); ++it)
+    {
+      BinMoving (*it, m_entries.find (*it)->second);
+    }
+}
+
+template <typename T>
+void
+MobilityGridIndex<T>::Extract (T item, const Entry &entry)
+{
+  if (entry.moving)
+    {
+      m_moving.erase (item);
+      ExtractFromCell (m_movingCells, entry.cell, item);
+      return;
+    }
+  ExtractFromCell (m_cells, entry.cell, item);
+}
+
+template <typename T>
+void
+MobilityGridIndex<T>::ExtractFromCell (std::map<Cell, CellItems> &cells, const Cell &cellIndex, T item)
+{
+  typename std::map<Cell, CellItems>::iterator cell = cells.find (cellIndex);
+  NS_ASSERT (cell != cells.end ());
+  typename CellItems::iterator it = cell->second.begin ();
+  while (it->first != item)
+    {
+      ++it;
+      NS_ASSERT (it != cell->second.end ());
+    }
+  *it = cell->second.back ();
+  cell->second.pop_back ();
+  if (cell->second.empty ())
+    {
+      cells.erase (cell);
+    }
+}
+
+template <typename T>
+void
+MobilityGridIndex<T>::Add (T item, Ptr<MobilityModel> mobility)
+{
+  NS_ASSERT (mobility != 0);
+  Remove (item);
+  typename std::map<Ptr<MobilityModel>, std::vector<T> >::iterator it = m_mobilities.find (mobility);
+  if (it == m_mobilities.end ())
+    {
+      mobility->TraceConnectWithoutContext ("CourseChange", MakeCallback (&MobilityGridIndex<T>::CourseChanged, this));
+      it = m_mobilities.insert (std::make_pair (mobility, std::vector<T> ())).first;
+    }
+  it->second.push_back (item);
+  Entry &entry = m_entries[item];
+  entry.mobility = mobility;
+  Insert (item, entry);
+}
+
+template <typename T>
+void
+MobilityGridIndex<T>::Remove (T item)
+{
+  typename std::map<T, Entry>::iterator entry = m_entries.find (item);
+  if (entry == m_entries.end ())
+    {
+      return;
+    }
+  Extract (item, entry->second);
+  typename std::map<Ptr<MobilityModel>, std::vector<T> >::iterator it = m_mobilities.find (entry->second.mobility);
+  NS_ASSERT (it != m_mobilities.end ());
+  it->second.erase (std::find (it->second.begin (), it->second.end (), item));
+  if (it->second.empty ())
+    {
+      it->first->TraceDisconnectWithoutContext ("CourseChange", MakeCallback (&MobilityGridIndex<T>::CourseChanged, this));
+      m_mobilities.erase (it);
+    }
+  m_entries.erase (entry);
+}
+
+template <typename T>
+void
+MobilityGridIndex<T>::Clear (void)
+{
+  for (typename std::map<Ptr<MobilityModel>, std::vector<T> >::iterator it = m_mobilities.begin ();
+       it != m_mobilities.end (); ++it)
+    {
+      it->first->TraceDisconnectWithoutContext ("CourseChange", MakeCallback (&MobilityGridIndex<T>::CourseChanged, this));
+    }
+  m_mobilities.clear ();
+  m_entries.clear ();
+  m_cells.clear ();
+  m_moving.clear ();
+  m_movingCells.clear ();
+}
+
+template <typename T>
+uint32_t
+MobilityGridIndex<T>::GetN (void) const
+{
+  return m_entries.size ();
+}
+
+template <typename T>
+void
+MobilityGridIndex<T>::CourseChanged (Ptr<const MobilityModel> mobility)
+{
+  typename std::map<Ptr<MobilityModel>, std::vector<T> >::const_iterator it =
+    m_mobilities.find (Ptr<MobilityModel> (const_cast<MobilityModel *> (PeekPointer (mobility))));
+  if (it == m_mobilities.end ())
+    {
+      return;
+    }
+  for (typename std::vector<T>::const_iterator item = it->second.begin (); item != it->second.end (); ++item)
+    {
+      Entry &entry = m_entries[*item];
+      Extract (*item, entry);
+      Insert (*item, entry);
+    }
+}
+
+template <typename T>
+void
+MobilityGridIndex<T>::FindInCell (const CellItems &cell, const Vector &position, double distance, std::vector<T> &items)
+{
+  for (typename CellItems::const_iterator it = cell.begin (); it != cell.end (); ++it)
+    {
+      if (CalculateDistance (position, it->second) <= distance)
+        {
+          items.push_back (it->first);
+        }
+    }
+}
+
+template <typename T>
+void
+MobilityGridIndex<T>::GetCells (const std::map<Cell, CellItems> &cells, const Vector &position, double distance,
+                                std::vector<const CellItems *> &found) const
+{
+  // visit every cell if the distance spans more columns than there are cells
+  if (std::isinf (m_cellSize) || !(distance / m_cellSize < cells.size ()))
+    {
+      for (typename std::map<Cell, CellItems>::const_iterator cell = cells.begin ();
+           cell != cells.end (); ++cell)
+        {
+          found.push_back (&cell->second);
+        }
+      return;
+    }
+  int64_t xMin = GetCellIndex (position.x - distance);
+  int64_t xMax = GetCellIndex (position.x + distance);
+  int64_t yMin = GetCellIndex (position.y - distance);
+  int64_t yMax = GetCellIndex (position.y + distance);
+  for (int64_t x = xMin; x <= xMax; x++)
+    {
+      // the cells of a column are contiguous in the map
+      typename std::map<Cell, CellItems>::const_iterator cell = cells.lower_bound (Cell (x, yMin));
+      for (; cell != cells.end () && cell->first.first == x && cell->first.second <= yMax; ++cell)
+        {
+          found.push_back (&cell->second);
+        }
+    }
+}
+
+template <typename T>
+void
+MobilityGridIndex<T>::Find (const Vector &position, double distance, std::vector<T> &items) const
+{
+  std::size_t first = items.size ();
+  std::vector<const CellItems *> cells;
+  GetCells (m_cells, position, distance, cells);
+  for (typename std::vector<const CellItems *>::const_iterator cell = cells.begin (); cell != cells.end (); ++cell)
+    {
+      FindInCell (**cell, position, distance, items);
+    }
+
+  if (!m_moving.empty ())
+    {
+      // the moving items are at most this far from the position they were binned at
+      double slack = m_maxSpeed * (Simulator::Now () - m_binTime).GetSeconds ();
+      if (!std::isinf (m_cellSize) && slack > m_cellSize / 2)
+        {
+          RebinMoving ();
+          slack = 0;
+        }
+      cells.clear ();
+      GetCells (m_movingCells, position, distance + slack, cells);
+      for (typename std::vector<const CellItems *>::const_iterator cell = cells.begin (); cell != cells.end (); ++cell)
+        {
+          for (typename CellItems::const_iterator it = (*cell)->begin (); it != (*cell)->end (); ++it)
+            {
+              if (CalculateDistance (position, m_entries.find (it->first)->second.mobility->GetPosition ()) <= distance)
+                {
+                  items.push_back (it->first);
+                }
+            }
+        }
+    }
+  std::sort (items.begin () + first, items.end ());
+}
+
+} // namespace ns3
+
+#endif /* MOBILITY_GRID_INDEX_H */
@@ -0,0 +1,260 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/mobility-grid-index.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup mobility-test
+ * \ingroup tests
+ *
+ * \brief Check that MobilityGridIndex finds the same items as a
+ * linear scan of all the items, while the items move.
+ */
+class MobilityGridIndexTestCase : public TestCase
+{
+public:
+  MobilityGridIndexTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Compare the items found by the index with a linear scan.
+   * \param distance the query distance
+   */
+  void Check (double distance);
+
+  MobilityGridIndex<uint32_t> m_index;           //!< The index under test
+  std::vector<Ptr<MobilityModel> > m_mobilities; //!< The mobility model of each item
+  Ptr<UniformRandomVariable> m_random;           //!< Random positions
+};
+
+MobilityGridIndexTestCase::MobilityGridIndexTestCase ()
+  : TestCase ("Check MobilityGridIndex queries against a linear scan")
+{
+}
+
+void
+MobilityGridIndexTestCase::Check (double distance)
+{
+  for (uint32_t query = 0; query < 20; query++)
+    {
+      Vector position (m_random->GetValue (-100, 600), m_random->GetValue (-100, 600), 0);
+      std::vector<uint32_t> expected;
+      for (uint32_t i = 0; i < m_mobilities.size (); i++)
+        {
+          if (CalculateDistance (position, m_mobilities[i]->GetPosition ()) <= distance)
+            {
+              expected.push_back (i);
+            }
+        }
+      std::vector<uint32_t> found;
+      m_index.Find (position, distance, found);
+      NS_TEST_ASSERT_MSG_EQ (found.size (), expected.size (), "Wrong number of items within " << distance << " m");
+      for (uint32_t i = 0; i < found.size (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (found[i], expected[i], "Wrong item within " << distance << " m");
+        }
+    }
+}
+
+void
+MobilityGridIndexTestCase::DoRun (void)
+{
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (1);
+
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      Vector position (m_random->GetValue (0, 500), m_random->GetValue (0, 500), m_random->GetValue (0, 10));
+      Ptr<MobilityModel> mobility;
+      if (i % 3 == 0)
+        {
+          Ptr<ConstantVelocityMobilityModel> cv = CreateObject<ConstantVelocityMobilityModel> ();
+          cv->SetPosition (position);
+          cv->SetVelocity (Vector (m_random->GetValue (-10, 10), m_random->GetValue (-10, 10), 0));
+          mobility = cv;
+        }
+      else
+        {
+          mobility = CreateObject<ConstantPositionMobilityModel> ();
+          mobility->SetPosition (position);
+        }
+      m_mobilities.push_back (mobility);
+      m_index.Add (i, mobility);
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_index.GetN (), 300, "Wrong number of items");
+
+  // a single cell
+  Check (50);
+
+  m_index.SetCellSize (50);
+  Check (50);
+  Check (120);
+  Check (1e6);
+
+  // the moving items move, some static items jump, some start and stop moving
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+  for (uint32_t i = 1; i < m_mobilities.size (); i += 7)
+    {
+      m_mobilities[i]->SetPosition (Vector (m_random->GetValue (0, 500), m_random->GetValue (0, 500), 0));
+    }
+  for (uint32_t i = 0; i < m_mobilities.size (); i += 6)
+    {
+      DynamicCast<ConstantVelocityMobilityModel> (m_mobilities[i])->SetVelocity (Vector (0, 0, 0));
+    }
+  for (uint32_t i = 3; i < m_mobilities.size (); i += 6)
+    {
+      DynamicCast<ConstantVelocityMobilityModel> (m_mobilities[i])->SetVelocity (Vector (5, -5, 0));
+    }
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+  Check (50);
+  Check (120);
+
+  m_index.SetCellSize (20);
+  Check (50);
+
+  // removed items are no longer found, and no longer follow their mobility model
+  for (uint32_t i = 0; i < m_mobilities.size (); i += 2)
+    {
+      m_index.Remove (i);
+    }
+  std::vector<uint32_t> found;
+  m_index.Find (Vector (250, 250, 0), 1e6, found);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 150, "Wrong number of items after removal");
+  for (uint32_t i = 0; i < found.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (found[i] % 2, 1, "Removed item found");
+    }
+  m_mobilities[0]->SetPosition (Vector (0, 0, 0));
+
+  m_index.Clear ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup mobility-test
+ * \ingroup tests
+ *
+ * \brief Check that MobilityGridIndex finds the same items as a
+ * linear scan of all the items when every item moves, i.e., while the
+ * moving items leave the cells they were binned in and are binned again.
+ */
+class MobilityGridIndexMovingTestCase : public TestCase
+{
+public:
+  MobilityGridIndexMovingTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Compare the items found by the index with a linear scan.
+   * \param distance the query distance
+   */
+  void Check (double distance);
+
+  MobilityGridIndex<uint32_t> m_index;           //!< The index under test
+  std::vector<Ptr<MobilityModel> > m_mobilities; //!< The mobility model of each item
+  Ptr<UniformRandomVariable> m_random;           //!< Random positions and velocities
+  uint32_t m_nFound;                             //!< Number of items found by all the queries
+};
+
+MobilityGridIndexMovingTestCase::MobilityGridIndexMovingTestCase ()
+  : TestCase ("Check MobilityGridIndex queries against a linear scan when every item moves"),
+    m_nFound (0)
+{
+}
+
+void
+MobilityGridIndexMovingTestCase::Check (double distance)
+{
+  for (uint32_t query = 0; query < 20; query++)
+    {
+      Vector position (m_random->GetValue (0, 1000), m_random->GetValue (0, 1000), 0);
+      std::vector<uint32_t> expected;
+      for (uint32_t i = 0; i < m_mobilities.size (); i++)
+        {
+          if (CalculateDistance (position, m_mobilities[i]->GetPosition ()) <= distance)
+            {
+              expected.push_back (i);
+            }
+        }
+      std::vector<uint32_t> found;
+      m_index.Find (position, distance, found);
+      NS_TEST_ASSERT_MSG_EQ ((found == expected), true, "Wrong items within " << distance << " m at " << Simulator::Now ().GetSeconds () << " s");
+      m_nFound += found.size ();
+    }
+}
+
+void
+MobilityGridIndexMovingTestCase::DoRun (void)
+{
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (2);
+
+  for (uint32_t i = 0; i < 500; i++)
+    {
+      Ptr<ConstantVelocityMobilityModel> cv = CreateObject<ConstantVelocityMobilityModel> ();
+      cv->SetPosition (Vector (m_random->GetValue (0, 1000), m_random->GetValue (0, 1000), 0));
+      cv->SetVelocity (Vector (m_random->GetValue (-30, 30), m_random->GetValue (-30, 30), 0));
+      m_mobilities.push_back (cv);
+      m_index.Add (i, cv);
+    }
+  m_index.SetCellSize (50);
+
+  // the moving items are binned again every 25 m / (30 * sqrt (2) m/s), i.e., 0.59 s
+  for (uint32_t i = 0; i <= 100; i++)
+    {
+      Simulator::Schedule (MilliSeconds (97 * i), &MobilityGridIndexMovingTestCase::Check, this, 50);
+    }
+  // a vehicle changing course
+  Simulator::Schedule (Seconds (4.5), &ConstantVelocityMobilityModel::SetVelocity,
+                       DynamicCast<ConstantVelocityMobilityModel> (m_mobilities[0]), Vector (0, 60, 0));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_GT (m_nFound, 1000, "Too few items found to test anything");
+
+  m_index.Clear ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup mobility-test
+ * \ingroup tests
+ *
+ * \brief MobilityGridIndex Test Suite
+ */
+static class MobilityGridIndexTestSuite : public TestSuite
+{
+public:
+  MobilityGridIndexTestSuite ()
+    : TestSuite ("mobility-grid-index", UNIT)
+  {
+    AddTestCase (new MobilityGridIndexTestCase, TestCase::QUICK);
+    AddTestCase (new MobilityGridIndexMovingTestCase, TestCase::QUICK);
+  }
+} g_mobilityGridIndexTestSuite; ///< the test suite
@@ -28,6 +28,8 @@
 #include "ns3/names.h"
 #include "ns3/net-device.h"
 #include "ns3/pcap-file-wrapper.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
 
 #include "trace-helper.h"
 
@@ -62,6 +64,19 @@ PcapHelper::CreateFile (
   file->Init (dataLinkType, snapLen, tzCorrection);
   NS_ABORT_MSG_IF (file->Fail (), "Unable to Init " << filename);
 
+  //
+  // When the records are buffered (see the "BufferSize" and "AsyncWrite"
+  // attributes of PcapFileWrapper), make sure that they reach the file at
+  // the end of the simulation even if the object holding the trace source
+  // outlives the simulator.
+  //
+  UintegerValue bufferSize;
+  file->GetAttribute ("BufferSize", bufferSize);
+  if (bufferSize.Get () > 0)
+    {
+      Simulator::ScheduleDestroy (&PcapFileWrapper::Flush, file);
+    }
+
   //
   // Note that the pcap helper promptly forgets all about the pcap file.  We
   // rely on the reference count of the file object which will soon be owned
@@ -20,6 +20,8 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include <atomic>
+#include <mutex>
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -43,6 +45,12 @@ static struct Zeroes
   const uint32_t size;  //!< buffer size
 } g_zeroes; //!< Zero-filled buffer
 
+/**
+ * Maximum size of the buffer data of new buffers: larger packets
+ * resize their buffer data rather than making every buffer large.
+ */
+const uint32_t MAX_RECOMMENDED_SIZE = 2048;
+
 }
 
 namespace ns3 {
@@ -50,104 +58,308 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
-uint32_t Buffer::g_recommendedStart = 0;
+thread_local uint32_t Buffer::g_recommendedStart = 0;
+bool Buffer::g_slabsEnabled = false;
+thread_local uint64_t Buffer::g_copiedBytes = 0;
+thread_local uint32_t Buffer::g_recommendedSize = 0;
 #ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
+namespace {
+
+/** Size of the smallest class of buffer data, as a power of two. */
+const uint32_t BUFFER_MIN_CLASS_SHIFT = 6;
+/** Number of size classes of buffer data: 64 bytes to 64 KiB. */
+const uint32_t BUFFER_N_CLASSES = 11;
+/** Maximum number of free blocks kept per size class and per thread. */
+const uint32_t BUFFER_MAX_LOCAL_FREE = 256;
+/** Number of free blocks moved at once between a thread and the shared pool. */
+const uint32_t BUFFER_BATCH = 64;
+/** Maximum number of free blocks kept per size class in the shared pool. */
+const uint32_t BUFFER_MAX_SHARED_FREE = 4096;
+
+/**
+ * A free block, storing the link to the next free block over the
+ * header of the buffer data it used to hold.
  */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
-
-Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
+struct BufferFreeBlock
 {
-  NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
+  BufferFreeBlock *m_next; //!< Next free block
+};
+
+/**
+ * A list of free blocks of the same size class.
+ */
+struct BufferFreeList
+{
+  BufferFreeBlock *m_head; //!< First free block
+  uint32_t m_n;            //!< Number of free blocks
+};
+
+/**
+ * Move up to n blocks from the head of a list to another one.
+ * \param from the list to take the blocks from
+ * \param to the list to give the blocks to
+ * \param n the number of blocks to move
+ */
+void
+MoveFreeBlocks (BufferFreeList &from, BufferFreeList &to, uint32_t n)
+{
+  while (n-- > 0 && from.m_head != 0)
     {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
+      BufferFreeBlock *block = from.m_head;
+      from.m_head = block->m_next;
+      from.m_n--;
+      block->m_next = to.m_head;
+      to.m_head = block;
+      to.m_n++;
+    }
+}
+
+/**
+ * Release all the blocks of a list.
+ * \param list the list
+ */
+void
+DeleteFreeBlocks (BufferFreeList &list)
+{
+  while (list.m_head != 0)
+    {
+      BufferFreeBlock *block = list.m_head;
+      list.m_head = block->m_next;
+      delete [] reinterpret_cast<uint8_t *> (block);
+    }
+  list.m_n = 0;
+}
+
+/**
+ * The free lists of a thread.
+ *
+ * This is a POD, hence it is zero-initialized and does not need any
+ * run-time initialization check in the allocation fast path.
+ */
+struct BufferCache
+{
+  BufferFreeList m_free[BUFFER_N_CLASSES]; //!< Free list of each size class
+  uint64_t m_nAllocations;                 //!< Number of allocations
+  uint64_t m_nRecycled;                    //!< Number of allocations served from the free lists
+  uint64_t m_nShared;                      //!< Number of blocks taken from the shared pool
+  bool m_registered;                       //!< Whether the cleaner of this thread has been created
+  bool m_closed;                           //!< Whether this thread is exiting
+};
+
+/** The free lists of the current thread. */
+thread_local BufferCache g_bufferCache;
+
+/**
+ * The free lists shared by all the threads, which receive the blocks
+ * that a thread has in excess and the blocks of the exiting threads.
+ */
+struct BufferPool
+{
+  ~BufferPool ()
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    // blocks released from now on are freed immediately, and the
+    // mutex is not locked any more
+    m_destroyed = true;
+    for (uint32_t i = 0; i < BUFFER_N_CLASSES; i++)
+      {
+        DeleteFreeBlocks (m_free[i]);
+      }
+  }
+  std::mutex m_mutex;                      //!< Protects the free lists
+  BufferFreeList m_free[BUFFER_N_CLASSES]; //!< Free list of each size class
+  std::atomic<bool> m_destroyed;           //!< Whether the static destructors have run
+};
+
+/** The shared pool, zero-initialized before any constructor runs. */
+BufferPool g_bufferPool;
+
+/** Number of allocations of the threads which have exited. */
+std::atomic<uint64_t> g_bufferAllocations (0);
+/** Number of recycled allocations of the threads which have exited. */
+std::atomic<uint64_t> g_bufferRecycled (0);
+/** Number of blocks taken from the shared pool by the threads which have exited. */
+std::atomic<uint64_t> g_bufferShared (0);
+
+/**
+ * Give up to n blocks of a list to the shared pool, and free the blocks
+ * that the pool cannot keep.
+ * \param list the list
+ * \param sizeClass the size class of the blocks of the list
+ * \param n the number of blocks to give
+ */
+void
+SpillFreeBlocks (BufferFreeList &list, uint32_t sizeClass, uint32_t n)
+{
+  BufferFreeList spilled = { 0, 0 };
+  MoveFreeBlocks (list, spilled, n);
+  // the mutex of the pool must not be locked once it is destroyed
+  if (!g_bufferPool.m_destroyed)
+    {
+      std::lock_guard<std::mutex> lock (g_bufferPool.m_mutex);
+      if (!g_bufferPool.m_destroyed)
         {
-          Buffer::Deallocate (*i);
+          BufferFreeList &shared = g_bufferPool.m_free[sizeClass];
+          MoveFreeBlocks (spilled, shared, BUFFER_MAX_SHARED_FREE - std::min (shared.m_n, BUFFER_MAX_SHARED_FREE));
         }
-      delete g_freeList;
-      g_freeList = DESTROYED;
     }
+  DeleteFreeBlocks (spilled);
 }
 
+/** Give the free blocks of the current thread to the shared pool when it exits. */
+struct BufferCacheCleaner
+{
+  ~BufferCacheCleaner ()
+  {
+    BufferCache &cache = g_bufferCache;
+    for (uint32_t i = 0; i < BUFFER_N_CLASSES; i++)
+      {
+        SpillFreeBlocks (cache.m_free[i], i, cache.m_free[i].m_n);
+      }
+    g_bufferAllocations += cache.m_nAllocations;
+    g_bufferRecycled += cache.m_nRecycled;
+    g_bufferShared += cache.m_nShared;
+    cache.m_nAllocations = 0;
+    cache.m_nRecycled = 0;
+    cache.m_nShared = 0;
+    // buffer data released from now on is freed immediately
+    cache.m_closed = true;
+  }
+};
+
+/** Make sure that the free blocks of the current thread are released when it exits. */
+void
+RegisterBufferCacheCleaner (void)
+{
+  static thread_local BufferCacheCleaner cleaner;
+  (void) cleaner;
+  g_bufferCache.m_registered = true;
+}
+
+/**
+ * \param size a buffer data size
+ * \returns the smallest size class which holds this size
+ */
+uint32_t
+GetSizeClass (uint32_t size)
+{
+  uint32_t sizeClass = 0;
+  while (size > (1U << (BUFFER_MIN_CLASS_SHIFT + sizeClass)))
+    {
+      sizeClass++;
+    }
+  return sizeClass;
+}
+
+} // unnamed namespace
+
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
+  BufferCache &cache = g_bufferCache;
+  g_recommendedSize = std::max (g_recommendedSize, data->m_dirtyEnd);
+  uint32_t sizeClass = GetSizeClass (data->m_size);
+  // only the blocks allocated by Create have the exact size of a class
+  if (sizeClass >= BUFFER_N_CLASSES ||
+      data->m_size != (1U << (BUFFER_MIN_CLASS_SHIFT + sizeClass)) ||
+      cache.m_closed || g_bufferPool.m_destroyed)
     {
       Buffer::Deallocate (data);
+      return;
     }
-  else
+  if (!cache.m_registered)
+    {
+      RegisterBufferCacheCleaner ();
+    }
+  BufferFreeList &list = cache.m_free[sizeClass];
+  if (list.m_n >= BUFFER_MAX_LOCAL_FREE)
     {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
+      SpillFreeBlocks (list, sizeClass, BUFFER_BATCH);
     }
+  BufferFreeBlock *block = reinterpret_cast<BufferFreeBlock *> (data);
+  block->m_next = list.m_head;
+  list.m_head = block;
+  list.m_n++;
 }
 
 Buffer::Data *
 Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
+  BufferCache &cache = g_bufferCache;
+  cache.m_nAllocations++;
+  uint32_t sizeClass = GetSizeClass (dataSize);
+  if (sizeClass >= BUFFER_N_CLASSES)
     {
-      g_freeList = new Buffer::FreeList ();
+      return Buffer::Allocate (dataSize);
     }
-  else if (IS_INITIALIZED (g_freeList))
+  BufferFreeList &list = cache.m_free[sizeClass];
+  if (list.m_head == 0 && !cache.m_closed && !g_bufferPool.m_destroyed)
     {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
+      std::lock_guard<std::mutex> lock (g_bufferPool.m_mutex);
+      uint32_t n = list.m_n;
+      MoveFreeBlocks (g_bufferPool.m_free[sizeClass], list, BUFFER_BATCH);
+      cache.m_nShared += list.m_n - n;
     }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
+  if (list.m_head != 0)
+    {
+      BufferFreeBlock *block = list.m_head;
+      list.m_head = block->m_next;
+      list.m_n--;
+      cache.m_nRecycled++;
+      struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data *> (block);
+      data->m_size = 1U << (BUFFER_MIN_CLASS_SHIFT + sizeClass);
+      data->m_count = 1;
+      return data;
+    }
+  // allocate the size of the class, for the block to be reusable
+  // by any buffer data of the same class
+  struct Buffer::Data *data = Buffer::Allocate (1U << (BUFFER_MIN_CLASS_SHIFT + sizeClass));
   NS_ASSERT (data->m_count == 1);
   return data;
 }
+
+uint64_t
+Buffer::GetNAllocations (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return g_bufferAllocations + g_bufferCache.m_nAllocations;
+}
+
+uint64_t
+Buffer::GetNRecycled (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return g_bufferRecycled + g_bufferCache.m_nRecycled;
+}
+
+uint64_t
+Buffer::GetNShared (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return g_bufferShared + g_bufferCache.m_nShared;
+}
+
+void
+Buffer::ResetAllocationStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_bufferAllocations = 0;
+  g_bufferRecycled = 0;
+  g_bufferShared = 0;
+  g_bufferCache.m_nAllocations = 0;
+  g_bufferCache.m_nRecycled = 0;
+  g_bufferCache.m_nShared = 0;
+}
 #else /* BUFFER_FREE_LIST */
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
+  g_recommendedSize = std::max (g_recommendedSize, data->m_dirtyEnd);
   Deallocate (data);
 }
 
@@ -157,6 +369,29 @@ Buffer::Create (uint32_t size)
   NS_LOG_FUNCTION (size);
   return Allocate (size);
 }
+
+uint64_t
+Buffer::GetNAllocations (void)
+{
+  return 0;
+}
+
+uint64_t
+Buffer::GetNRecycled (void)
+{
+  return 0;
+}
+
+uint64_t
+Buffer::GetNShared (void)
+{
+  return 0;
+}
+
+void
+Buffer::ResetAllocationStats (void)
+{
+}
 #endif /* BUFFER_FREE_LIST */
 
 struct Buffer::Data *
@@ -185,6 +420,53 @@ Buffer::Deallocate (struct Buffer::Data *data)
   delete [] buf;
 }
 
+struct Buffer::Slab *
+Buffer::CreateSlab (uint8_t const *buffer, uint32_t size)
+{
+  NS_LOG_FUNCTION (&buffer << size);
+  NS_ASSERT (size >= 1);
+  uint8_t *b = new uint8_t [size - 1 + sizeof (struct Buffer::Slab)];
+  struct Buffer::Slab *slab = reinterpret_cast<struct Buffer::Slab*>(b);
+  slab->m_size = size;
+  slab->m_count = 1;
+  memcpy (slab->m_data, buffer, size);
+  g_copiedBytes += size;
+  return slab;
+}
+
+void
+Buffer::ReleaseSlab (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_slab != 0 && --m_slab->m_count == 0)
+    {
+      uint8_t *buf = reinterpret_cast<uint8_t *> (m_slab);
+      delete [] buf;
+    }
+  m_slab = 0;
+  m_slabStart = 0;
+}
+
+void
+Buffer::EnableSlabs (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_slabsEnabled = true;
+}
+
+void
+Buffer::DisableSlabs (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_slabsEnabled = false;
+}
+
+uint64_t
+Buffer::GetCopiedBytes (void)
+{
+  return g_copiedBytes;
+}
+
 Buffer::Buffer ()
 {
   NS_LOG_FUNCTION (this);
@@ -200,12 +482,32 @@ Buffer::Buffer (uint32_t dataSize)
 Buffer::Buffer (uint32_t dataSize, bool initialize)
 {
   NS_LOG_FUNCTION (this << dataSize << initialize);
+  m_slab = 0;
+  m_slabStart = 0;
   if (initialize == true)
     {
       Initialize (dataSize);
     }
 }
 
+Buffer::Buffer (uint8_t const *buffer, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << &buffer << size);
+  if (g_slabsEnabled && size > 0)
+    {
+      // the payload is the zero area, backed by the slab
+      Initialize (size);
+      m_slab = CreateSlab (buffer, size);
+    }
+  else
+    {
+      Initialize (0);
+      AddAtStart (size);
+      Begin ().Write (buffer, size);
+      g_copiedBytes += size;
+    }
+}
+
 bool
 Buffer::CheckInternalState (void) const
 {
@@ -244,7 +546,9 @@ void
 Buffer::Initialize (uint32_t zeroSize)
 {
   NS_LOG_FUNCTION (this << zeroSize);
-  m_data = Buffer::Create (0);
+  m_data = Buffer::Create (std::min (g_recommendedSize, MAX_RECOMMENDED_SIZE));
+  m_slab = 0;
+  m_slabStart = 0;
   m_start = std::min (m_data->m_size, g_recommendedStart);
   m_maxZeroAreaStart = m_start;
   m_zeroAreaStart = m_start;
@@ -262,14 +566,23 @@ Buffer::operator = (Buffer const&o)
   if (m_data != o.m_data) 
     {
       // not assignment to self.
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (--m_data->m_count == 0)
         {
           Recycle (m_data);
         }
       m_data = o.m_data;
       m_data->m_count++;
     }
+  if (m_slab != o.m_slab)
+    {
+      ReleaseSlab ();
+      m_slab = o.m_slab;
+      if (m_slab != 0)
+        {
+          m_slab->m_count++;
+        }
+    }
+  m_slabStart = o.m_slabStart;
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
   m_zeroAreaStart = o.m_zeroAreaStart;
@@ -285,11 +598,11 @@ Buffer::~Buffer ()
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (--m_data->m_count == 0)
     {
       Recycle (m_data);
     }
+  ReleaseSlab ();
 }
 
 uint32_t
@@ -328,8 +641,8 @@ Buffer::AddAtStart (uint32_t start)
       uint32_t newSize = GetInternalSize () + start;
       struct Buffer::Data *newData = Buffer::Create (newSize);
       memcpy (newData->m_data + start, m_data->m_data + m_start, GetInternalSize ());
-      m_data->m_count--;
-      if (m_data->m_count == 0)
+      g_copiedBytes += GetInternalSize ();
+      if (--m_data->m_count == 0)
         {
           Buffer::Recycle (m_data);
         }
@@ -373,8 +686,8 @@ Buffer::AddAtEnd (uint32_t end)
       uint32_t newSize = GetInternalSize () + end;
       struct Buffer::Data *newData = Buffer::Create (newSize);
       memcpy (newData->m_data, m_data->m_data + m_start, GetInternalSize ());
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      g_copiedBytes += GetInternalSize ();
+      if (--m_data->m_count == 0)
         {
           Buffer::Recycle (m_data);
         }
@@ -396,21 +709,63 @@ Buffer::AddAtEnd (uint32_t end)
   NS_ASSERT (CheckInternalState ());
 }
 
+void
+Buffer::Unshare (void)
+{
+  NS_LOG_FUNCTION (this);
+  struct Buffer::Data *newData = Buffer::Create (GetInternalSize ());
+  memcpy (newData->m_data, m_data->m_data + m_start, GetInternalSize ());
+  g_copiedBytes += GetInternalSize ();
+  if (--m_data->m_count == 0)
+    {
+      Buffer::Recycle (m_data);
+    }
+  m_data = newData;
+
+  int32_t delta = -m_start;
+  m_zeroAreaStart += delta;
+  m_zeroAreaEnd += delta;
+  m_end += delta;
+  m_start += delta;
+
+  // update dirty area
+  m_data->m_dirtyStart = m_start;
+  m_data->m_dirtyEnd = m_end;
+  NS_ASSERT (CheckInternalState ());
+}
+
 void
 Buffer::AddAtEnd (const Buffer &o)
 {
   NS_LOG_FUNCTION (this << &o);
-  if (m_data->m_count == 1 &&
-      m_end == m_zeroAreaEnd &&
-      m_end == m_data->m_dirtyEnd &&
+  bool slabs = m_slab != 0 || o.m_slab != 0;
+  /* the zero area of o must continue ours: either we have none yet,
+   * or both are zeroes, or both are adjacent views of the same slab
+   */
+  bool adjacentSlabs = m_zeroAreaEnd == m_zeroAreaStart ||
+    (m_slab == o.m_slab && m_slabStart + (m_zeroAreaEnd - m_zeroAreaStart) == o.m_slabStart);
+  if (m_end == m_zeroAreaEnd &&
       o.m_start == o.m_zeroAreaStart &&
-      o.m_zeroAreaEnd - o.m_zeroAreaStart > 0)
+      o.m_zeroAreaEnd - o.m_zeroAreaStart > 0 &&
+      ((!slabs && m_data->m_count == 1 && m_end == m_data->m_dirtyEnd) ||
+       (slabs && adjacentSlabs)))
     {
       /**
        * This is an optimization which kicks in when
        * we attempt to aggregate two buffers which contain
        * adjacent zero areas.
        */
+      if (m_data->m_count > 1)
+        {
+          // only copies the real bytes, which do not include the payload
+          Unshare ();
+        }
+      if (m_slab == 0 && o.m_slab != 0)
+        {
+          m_slab = o.m_slab;
+          m_slab->m_count++;
+          m_slabStart = o.m_slabStart;
+        }
       uint32_t zeroSize = o.m_zeroAreaEnd - o.m_zeroAreaStart;
       m_zeroAreaEnd += zeroSize;
       m_end = m_zeroAreaEnd;
@@ -457,6 +812,7 @@ Buffer::RemoveAtStart (uint32_t start)
       m_start = m_zeroAreaStart;
       m_zeroAreaEnd -= delta;
       m_end -= delta;
+      m_slabStart += delta;
     } 
   else if (newStart <= m_end)
     {
@@ -478,6 +834,10 @@ Buffer::RemoveAtStart (uint32_t start)
       m_zeroAreaEnd = m_end;
       m_zeroAreaStart = m_end;
     }
+  if (m_zeroAreaStart == m_zeroAreaEnd)
+    {
+      ReleaseSlab ();
+    }
   m_maxZeroAreaStart = std::max (m_maxZeroAreaStart, m_zeroAreaStart);
   LOG_INTERNAL_STATE ("rem start=" << start << ", ");
   NS_ASSERT (CheckInternalState ());
@@ -513,6 +873,10 @@ Buffer::RemoveAtEnd (uint32_t end)
       m_zeroAreaEnd = m_start;
       m_zeroAreaStart = m_start;
     }
+  if (m_zeroAreaStart == m_zeroAreaEnd)
+    {
+      ReleaseSlab ();
+    }
   m_maxZeroAreaStart = std::max (m_maxZeroAreaStart, m_zeroAreaStart);
   LOG_INTERNAL_STATE ("rem end=" << end << ", ");
   NS_ASSERT (CheckInternalState ());
@@ -539,7 +903,15 @@ Buffer::CreateFullCopy (void) const
     {
       Buffer tmp;
       tmp.AddAtStart (m_zeroAreaEnd - m_zeroAreaStart);
-      tmp.Begin ().WriteU8 (0, m_zeroAreaEnd - m_zeroAreaStart);
+      if (m_slab != 0)
+        {
+          tmp.Begin ().Write (m_slab->m_data + m_slabStart, m_zeroAreaEnd - m_zeroAreaStart);
+        }
+      else
+        {
+          tmp.Begin ().WriteU8 (0, m_zeroAreaEnd - m_zeroAreaStart);
+        }
+      g_copiedBytes += GetSize ();
       uint32_t dataStart = m_zeroAreaStart - m_start;
       tmp.AddAtStart (dataStart);
       tmp.Begin ().Write (m_data->m_data+m_start, dataStart);
@@ -559,6 +931,11 @@ uint32_t
 Buffer::GetSerializedSize (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_slab != 0)
+    {
+      // the serialized form can only describe a zero area
+      return CreateFullCopy ().GetSerializedSize ();
+    }
   uint32_t dataStart = (m_zeroAreaStart - m_start + 3) & (~0x3);
   uint32_t dataEnd = (m_end - m_zeroAreaEnd + 3) & (~0x3);
 
@@ -579,6 +956,11 @@ uint32_t
 Buffer::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
+  if (m_slab != 0)
+    {
+      // the serialized form can only describe a zero area
+      return CreateFullCopy ().Serialize (buffer, maxSize);
+    }
   uint32_t* p = reinterpret_cast<uint32_t *> (buffer);
   uint32_t size = 0;
 
@@ -726,7 +1108,11 @@ Buffer::CopyData (std::ostream *os, uint32_t size) const
         { 
           size -= m_zeroAreaStart-m_start;
           tmpsize = std::min (m_zeroAreaEnd - m_zeroAreaStart, size);
-          uint32_t left = tmpsize;
+          if (m_slab != 0)
+            {
+              os->write ((const char*)(m_slab->m_data + m_slabStart), tmpsize);
+            }
+          uint32_t left = m_slab != 0 ? 0 : tmpsize;
           while (left > 0)
             {
               uint32_t toWrite = std::min (left, g_zeroes.size);
@@ -757,7 +1143,12 @@ Buffer::CopyData (uint8_t *buffer, uint32_t size) const
       if (size > 0) 
         { 
           tmpsize = std::min (m_zeroAreaEnd - m_zeroAreaStart, size);
-          uint32_t left = tmpsize;
+          if (m_slab != 0)
+            {
+              memcpy (buffer, m_slab->m_data + m_slabStart, tmpsize);
+              buffer += tmpsize;
+            }
+          uint32_t left = m_slab != 0 ? 0 : tmpsize;
           while (left > 0)
             {
               uint32_t toWrite = std::min (left, g_zeroes.size);
@@ -846,6 +1237,7 @@ Buffer::Iterator::Write (Iterator start, Iterator end)
   uint32_t size = end.m_current - start.m_current;
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + size),
                  GetWriteErrorMessage ());
+  Buffer::g_copiedBytes += size;
   if (start.m_current <= start.m_zeroStart)
     {
       uint32_t toCopy = std::min (size, start.m_zeroStart - start.m_current);
@@ -857,7 +1249,14 @@ Buffer::Iterator::Write (Iterator start, Iterator end)
   if (start.m_current <= start.m_zeroEnd)
     {
       uint32_t toCopy = std::min (size, start.m_zeroEnd - start.m_current);
-      memset (&m_data[m_current], 0, toCopy);
+      if (start.m_slab != 0 && toCopy > 0)
+        {
+          memcpy (&m_data[m_current], &start.m_slab[start.m_current - start.m_zeroStart], toCopy);
+        }
+      else
+        {
+          memset (&m_data[m_current], 0, toCopy);
+        }
       start.m_current += toCopy;
       m_current += toCopy;
       size -= toCopy;
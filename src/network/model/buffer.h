@@ -21,6 +21,7 @@
 #define BUFFER_H
 
 #include <stdint.h>
+#include <atomic>
 #include <vector>
 #include <ostream>
 #include "ns3/assert.h"
@@ -88,6 +89,28 @@ namespace ns3 {
  * \endverbatim
  *
  * A simple state invariant is that m_start <= m_zeroStart <= m_zeroEnd <= m_end
+ *
+ * When slabs are enabled (see Buffer::EnableSlabs), a Buffer created from
+ * user bytes does not store them in its BufferData: they are copied once
+ * into a read-only "slab" which backs the virtual zero area instead of
+ * zeroes. The slab has its own reference count and is shared by all the
+ * copies and fragments of the Buffer, so that fragmenting, copying and
+ * re-assembling adjacent fragments, or adding headers and trailers around
+ * the payload, never copies the payload bytes again. The slab bytes are
+ * copied only when the Buffer must be turned into a real byte buffer, for
+ * example by PeekData or when non-adjacent payloads are concatenated.
+ * The slab bytes are not copied on write: like the zeroes it replaces,
+ * the slab cannot be written through a Buffer::Iterator, and such a
+ * write fails the same CheckNoZero assertion. Slabs must thus not be
+ * enabled when the payload of packets is modified in place.
+ *
+ * BufferData instances are allocated in power-of-two size classes, from
+ * 64 bytes to 64 KiB. A released BufferData is kept in a free list of
+ * its size class, owned by the releasing thread. When a thread has too
+ * many free BufferData of a class, it moves a batch of them to a pool
+ * shared by all the threads, from which the threads which run out of
+ * free BufferData refill their own lists. The allocation statistics
+ * are available through Buffer::GetNAllocations and Buffer::GetNRecycled.
  */
 class Buffer 
 {
@@ -481,6 +504,12 @@ private:
      * to this pointer.
      */
     uint8_t *m_data;
+    /**
+     * a pointer to the slab bytes which back the "virtual zero area",
+     * starting with the byte at offset m_zeroStart, or zero if this
+     * area is filled with zeroes.
+     */
+    uint8_t const *m_slab;
   };
 
   /**
@@ -640,7 +669,67 @@ private:
    * \param initialize initialize the buffer with zeroes.
    */
   Buffer (uint32_t dataSize, bool initialize);
+  /**
+   * \brief Constructor
+   *
+   * The buffer will hold a copy of the given bytes. If slabs are
+   * enabled, the bytes are copied into a shared read-only slab
+   * rather than into the buffer data.
+   *
+   * \param buffer the bytes to copy
+   * \param size the number of bytes to copy
+   */
+  Buffer (uint8_t const *buffer, uint32_t size);
   ~Buffer ();
+
+  /**
+   * \brief Store the bytes given to Buffer (uint8_t const *, uint32_t)
+   * in shared read-only slabs from now on.
+   *
+   * The bytes stored in a slab cannot be overwritten through a
+   * Buffer::Iterator.
+   */
+  static void EnableSlabs (void);
+  /**
+   * \brief Store the bytes given to Buffer (uint8_t const *, uint32_t)
+   * in the buffer data from now on, which is the default.
+   */
+  static void DisableSlabs (void);
+  /**
+   * \brief Get the number of payload and header bytes copied by the
+   * buffers of the calling thread so far.
+   *
+   * This counts the bytes copied into a new buffer when it is created
+   * from user bytes, when its data must be reallocated or unshared, and
+   * when bytes are copied from a buffer to another one. It does not
+   * count the bytes written by headers and trailers or read out of the
+   * buffers.
+   *
+   * \returns the number of bytes copied
+   */
+  static uint64_t GetCopiedBytes (void);
+  /**
+   * \brief Get the number of buffer data storages created so far, by
+   * the calling thread and by the threads which have exited.
+   * \returns the number of buffer data storages created
+   */
+  static uint64_t GetNAllocations (void);
+  /**
+   * \brief Get the number of buffer data storages which were served
+   * from the free lists rather than allocated.
+   * \returns the number of recycled buffer data storages
+   */
+  static uint64_t GetNRecycled (void);
+  /**
+   * \brief Get the number of free buffer data storages that threads
+   * took from the free lists shared by all the threads.
+   * \returns the number of buffer data storages taken from the shared pool
+   */
+  static uint64_t GetNShared (void);
+  /**
+   * \brief Reset the buffer allocation statistics.
+   */
+  static void ResetAllocationStats (void);
 private:
   /**
    * This data structure is variable-sized through its last member whose size
@@ -660,9 +749,10 @@ private:
   {
     /**
      * The reference count of an instance of this data structure.
-     * Each buffer which references an instance holds a count.
+     * Each buffer which references an instance holds a count. The
+     * buffers referencing an instance may belong to different threads.
      */
-    uint32_t m_count;
+    std::atomic<uint32_t> m_count;
     /**
      * the size of the m_data field below.
      */
@@ -684,6 +774,30 @@ private:
     uint8_t m_data[1];
   };
 
+  /**
+   * This data structure is variable-sized through its last member whose size
+   * is determined at allocation time and stored in the m_size field.
+   *
+   * A slab holds read-only user bytes which back the "virtual zero area"
+   * of the buffers which reference it.
+   */
+  struct Slab
+  {
+    /**
+     * The reference count of an instance of this data structure.
+     * Each buffer which references an instance holds a count.
+     */
+    std::atomic<uint32_t> m_count;
+    /**
+     * the size of the m_data field below.
+     */
+    uint32_t m_size;
+    /**
+     * The slab bytes. Its real size is stored in the m_size field.
+     */
+    uint8_t m_data[1];
+  };
+
   /**
    * \brief Create a full copy of the buffer, including
    * all the internal structures.
@@ -747,8 +861,31 @@ private:
    * \param data the buffer data storage
    */
   static void Deallocate (struct Buffer::Data *data);
+  /**
+   * \brief Create a slab holding a copy of the given bytes
+   * \param buffer the bytes to copy
+   * \param size the number of bytes to copy
+   * \returns a pointer to the created slab
+   */
+  static struct Buffer::Slab *CreateSlab (uint8_t const *buffer, uint32_t size);
+  /**
+   * \brief Drop the reference of this buffer to its slab, if any.
+   */
+  void ReleaseSlab (void);
+  /**
+   * \brief Give this buffer a private copy of its real bytes, so that
+   * they can be moved around without affecting the buffers which
+   * share its data storage.
+   */
+  void Unshare (void);
 
   struct Data *m_data; //!< the buffer data storage
+  struct Slab *m_slab; //!< the slab backing the zero area, if any
+  /**
+   * offset from the start of m_slab->m_data to the byte at
+   * m_zeroAreaStart
+   */
+  uint32_t m_slabStart;
 
   /**
    * keep track of the maximum value of m_zeroAreaStart across
@@ -766,7 +903,9 @@ private:
    * writing data. i.e., m_start should be initialized to this 
    * value.
    */
-  static uint32_t g_recommendedStart;
+  static thread_local uint32_t g_recommendedStart;
+  static bool g_slabsEnabled; //!< whether user bytes are stored in slabs
+  static thread_local uint64_t g_copiedBytes; //!< number of bytes copied so far
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -789,18 +928,12 @@ private:
    */
   uint32_t m_end;
 
-#ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
-#endif
+  /**
+   * size of the buffer data used so far by the buffers of this
+   * thread: new buffers are created with this size, so that adding
+   * their headers and trailers does not need to resize them.
+   */
+  static thread_local uint32_t g_recommendedSize;
 };
 
 } // namespace ns3
@@ -816,7 +949,8 @@ Buffer::Iterator::Iterator ()
     m_dataStart (0),
     m_dataEnd (0),
     m_current (0),
-    m_data (0)
+    m_data (0),
+    m_slab (0)
 {
 }
 Buffer::Iterator::Iterator (Buffer const*buffer)
@@ -838,6 +972,7 @@ Buffer::Iterator::Construct (const Buffer *buffer)
   m_dataStart = buffer->m_start;
   m_dataEnd = buffer->m_end;
   m_data = buffer->m_data->m_data;
+  m_slab = buffer->m_slab != 0 ? buffer->m_slab->m_data + buffer->m_slabStart : 0;
 }
 
 void 
@@ -1007,7 +1142,7 @@ Buffer::Iterator::PeekU8 (void)
     }
   else if (m_current < m_zeroEnd)
     {
-      return 0;
+      return m_slab != 0 ? m_slab[m_current - m_zeroStart] : 0;
     }
   else
     {
@@ -1048,6 +1183,8 @@ Buffer::Iterator::Read (Buffer::Iterator start, uint32_t size)
 
 Buffer::Buffer (Buffer const&o)
   : m_data (o.m_data),
+    m_slab (o.m_slab),
+    m_slabStart (o.m_slabStart),
     m_maxZeroAreaStart (o.m_zeroAreaStart),
     m_zeroAreaStart (o.m_zeroAreaStart),
     m_zeroAreaEnd (o.m_zeroAreaEnd),
@@ -1055,6 +1192,10 @@ Buffer::Buffer (Buffer const&o)
     m_end (o.m_end)
 {
   m_data->m_count++;
+  if (m_slab != 0)
+    {
+      m_slab->m_count++;
+    }
   NS_ASSERT (CheckInternalState ());
 }
 
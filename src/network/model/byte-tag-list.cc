@@ -19,6 +19,7 @@
  */
 #include "byte-tag-list.h"
 #include "ns3/log.h"
+#include <atomic>
 #include <vector>
 #include <cstring>
 #include <limits>
@@ -40,7 +41,7 @@ NS_LOG_COMPONENT_DEFINE ("ByteTagList");
  */
 struct ByteTagListData {
   uint32_t size;   //!< size of the data
-  uint32_t count;  //!< use counter (for smart deallocation)
+  std::atomic<uint32_t> count;  //!< use counter (for smart deallocation), possibly from several threads
   uint32_t dirty;  //!< number of bytes actually in use
   uint8_t data[4]; //!< data
 };
@@ -53,12 +54,13 @@ struct ByteTagListData {
  *
  * Internal use only.
  */
-static class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
+static thread_local class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
 {
 public:
   ~ByteTagListDataFreeList ();
-} g_freeList; //!< Container for struct ByteTagListData
-static uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
+} g_freeList; //!< Container for struct ByteTagListData, for each thread
+static thread_local bool g_freeListDestroyed = false; //!< Whether the thread is exiting
+static thread_local uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
 
 ByteTagListDataFreeList::~ByteTagListDataFreeList ()
 {
@@ -69,6 +71,7 @@ ByteTagListDataFreeList::~ByteTagListDataFreeList ()
       uint8_t *buffer = (uint8_t *)(*i);
       delete [] buffer;
     }
+  g_freeListDestroyed = true;
 }
 #endif /* USE_FREE_LIST */
 
@@ -159,6 +162,10 @@ ByteTagList::ByteTagList (const ByteTagList &o)
     {
       m_data->count++;
     }
+  else
+    {
+      std::memcpy (m_inline, o.m_inline, m_used);
+    }
 }
 ByteTagList &
 ByteTagList::operator = (const ByteTagList &o)
@@ -178,6 +185,10 @@ ByteTagList::operator = (const ByteTagList &o)
     {
       m_data->count++;
     }
+  else
+    {
+      std::memcpy (m_inline, o.m_inline, m_used);
+    }
   return *this;
 }
 ByteTagList::~ByteTagList ()
@@ -194,21 +205,22 @@ ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
   NS_LOG_FUNCTION (this << tid << bufferSize << start << end);
   uint32_t spaceNeeded = m_used + bufferSize + 4 + 4 + 4 + 4;
   NS_ASSERT (m_used <= spaceNeeded);
-  if (m_data == 0)
+  if (m_data == 0 && spaceNeeded <= INLINE_SIZE)
     {
-      m_data = Allocate (spaceNeeded);
-      m_used = 0;
-    } 
-  else if (m_data->size < spaceNeeded ||
+      // the tags still fit inline
+    }
+  else if (m_data == 0 ||
+           m_data->size < spaceNeeded ||
            (m_data->count != 1 && m_data->dirty != m_used))
     {
       struct ByteTagListData *newData = Allocate (spaceNeeded);
-      std::memcpy (&newData->data, &m_data->data, m_used);
+      std::memcpy (&newData->data, GetData (), m_used);
       Deallocate (m_data);
       m_data = newData;
     }
-  TagBuffer tag = TagBuffer (&m_data->data[m_used], 
-                             &m_data->data[spaceNeeded]);
+  uint8_t *data = GetData ();
+  TagBuffer tag = TagBuffer (&data[m_used], 
+                             &data[spaceNeeded]);
   tag.WriteU32 (tid.GetUid ());
   tag.WriteU32 (bufferSize);
   tag.WriteU32 (start - m_adjustment);
@@ -222,7 +234,10 @@ ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
       m_maxEnd = end - m_adjustment;
     }
   m_used = spaceNeeded;
-  m_data->dirty = m_used;
+  if (m_data != 0)
+    {
+      m_data->dirty = m_used;
+    }
   return tag;
 }
 
@@ -230,6 +245,16 @@ void
 ByteTagList::Add (const ByteTagList &o)
 {
   NS_LOG_FUNCTION (this << &o);
+  if (o.m_used == 0)
+    {
+      return;
+    }
+  if (m_used == 0 && o.m_minStart + o.m_adjustment >= 0)
+    {
+      // all the tags of o are kept as they are: share them
+      *this = o;
+      return;
+    }
   ByteTagList::Iterator i = o.BeginAll ();
   while (i.HasNext ())
     {
@@ -264,13 +289,14 @@ ByteTagList::Iterator
 ByteTagList::Begin (int32_t offsetStart, int32_t offsetEnd) const
 {
   NS_LOG_FUNCTION (this << offsetStart << offsetEnd);
-  if (m_data == 0)
+  if (m_used == 0)
     {
       return Iterator (0, 0, offsetStart, offsetEnd, 0);
     }
   else
     {
-      return Iterator (m_data->data, &m_data->data[m_used], offsetStart, offsetEnd, m_adjustment);
+      uint8_t *data = GetData ();
+      return Iterator (data, &data[m_used], offsetStart, offsetEnd, m_adjustment);
     }
 }
 
@@ -282,28 +308,7 @@ ByteTagList::AddAtEnd (int32_t appendOffset)
     {
       return;
     }
-  ByteTagList list;
-  ByteTagList::Iterator i = BeginAll ();
-  while (i.HasNext ())
-    {
-      ByteTagList::Iterator::Item item = i.Next ();
-
-      if (item.start >= appendOffset)
-        {
-          continue;
-        }
-      if (item.end > appendOffset)
-        {
-          item.end = appendOffset;
-        }
-      TagBuffer buf = list.Add (item.tid, item.size, item.start, item.end);
-      buf.CopyFrom (item.buf);
-      if (item.end > m_maxEnd)
-        {
-          m_maxEnd = item.end;
-        }
-    }
-  *this = list;
+  Clip (0, appendOffset);
 }
 
 void 
@@ -314,29 +319,66 @@ ByteTagList::AddAtStart (int32_t prependOffset)
     {
       return;
     }
-  m_minStart = INT32_MAX;
-  ByteTagList list;
-  ByteTagList::Iterator i = BeginAll ();
-  while (i.HasNext ())
-    {
-      ByteTagList::Iterator::Item item = i.Next ();
+  Clip (std::max (prependOffset, 0), OFFSET_MAX);
+}
 
-      if (item.end <= prependOffset)
-        {
-          continue;
-        }
-      if (item.start < prependOffset)
+uint8_t *
+ByteTagList::GetData (void) const
+{
+  return m_data != 0 ? m_data->data : (uint8_t *)m_inline;
+}
+
+void
+ByteTagList::Clip (int32_t offsetStart, int32_t offsetEnd)
+{
+  NS_LOG_FUNCTION (this << offsetStart << offsetEnd);
+  if (m_data != 0 && m_data->count != 1)
+    {
+      // the tags are shared: copy the ones we keep
+      ByteTagList list;
+      ByteTagList::Iterator i = Begin (offsetStart, offsetEnd);
+      while (i.HasNext ())
         {
-          item.start = prependOffset;
+          ByteTagList::Iterator::Item item = i.Next ();
+          TagBuffer buf = list.Add (item.tid, item.size, item.start, item.end);
+          buf.CopyFrom (item.buf);
         }
-      TagBuffer buf = list.Add (item.tid, item.size, item.start, item.end);
-      buf.CopyFrom (item.buf);
-      if (item.start < m_minStart)
+      *this = list;
+      return;
+    }
+  // the tags are ours: clip them in place
+  uint8_t *data = GetData ();
+  uint32_t read = 0;
+  uint32_t written = 0;
+  m_minStart = INT32_MAX;
+  m_maxEnd = INT32_MIN;
+  while (read < m_used)
+    {
+      TagBuffer buf = TagBuffer (&data[read], &data[m_used]);
+      uint32_t tid = buf.ReadU32 ();
+      uint32_t size = buf.ReadU32 ();
+      int32_t start = std::max<int32_t> (buf.ReadU32 () + m_adjustment, offsetStart);
+      int32_t end = std::min<int32_t> (buf.ReadU32 () + m_adjustment, offsetEnd);
+      uint32_t tagSize = 4 + 4 + 4 + 4 + size;
+      if (start < end)
         {
-          m_minStart = item.start;
+          std::memmove (&data[written + 16], &data[read + 16], size);
+          TagBuffer tag = TagBuffer (&data[written], &data[written + 16]);
+          tag.WriteU32 (tid);
+          tag.WriteU32 (size);
+          tag.WriteU32 (start - m_adjustment);
+          tag.WriteU32 (end - m_adjustment);
+          m_minStart = std::min (m_minStart, start - m_adjustment);
+          m_maxEnd = std::max (m_maxEnd, end - m_adjustment);
+          written += tagSize;
         }
+      read += tagSize;
+    }
+  m_used = written;
+  if (m_data != 0)
+    {
+      m_data->dirty = m_used;
     }
-  *this = list;
 }
 
 #ifdef USE_FREE_LIST
@@ -345,7 +387,7 @@ struct ByteTagListData *
 ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
-  while (!g_freeList.empty ())
+  while (!g_freeListDestroyed && !g_freeList.empty ())
     {
       struct ByteTagListData *data = g_freeList.back ();
       g_freeList.pop_back ();
@@ -376,10 +418,10 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
       return;
     }
   g_maxSize = std::max (g_maxSize, data->size);
-  data->count--;
-  if (data->count == 0)
+  if (--data->count == 0)
     {
-      if (g_freeList.size () > FREE_LIST_SIZE ||
+      if (g_freeListDestroyed ||
+          g_freeList.size () > FREE_LIST_SIZE ||
           data->size < g_maxSize)
         {
           uint8_t *buffer = (uint8_t *)data;
@@ -414,8 +456,7 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
     {
       return;
     }
-  data->count--;
-  if (data->count == 0)
+  if (--data->count == 0)
     {
       uint8_t *buffer = (uint8_t *)data;
       delete [] buffer;
@@ -45,9 +45,14 @@ struct ByteTagListData;
  *     as 4 32bit integers (TypeId, tag data size, start, end) followed 
  *     by the tag data as generated by Tag::Serialize.
  *
- *   - The struct ByteTagListData structure which contains the tag byte buffer
- *     is shared and, thus, reference-counted. This data structure is unshared
- *     as-needed to emulate COW semantics.
+ *   - As long as the tags fit in INLINE_SIZE bytes, the tag byte buffer is
+ *     stored inline in the ByteTagList and copied along with it, without
+ *     any allocation.
+ *
+ *   - Otherwise, the struct ByteTagListData structure which contains the tag
+ *     byte buffer is shared and, thus, reference-counted. This data structure
+ *     is unshared as-needed to emulate COW semantics. Concatenating a list
+ *     to an empty one shares the buffer of the former.
  *
  *   - Each tag tags a unique set of bytes identified by the pair of offsets
  *     (start,end). These offsets are relative to the start of the packet
@@ -58,7 +63,8 @@ struct ByteTagListData;
  *     boundaries remain in ByteTagList. It is not a problem as iterator fixes
  *     the boundaries before returning item. However, when packet is extending,
  *     it calls ByteTagList::AddAtStart or ByteTagList::AddAtEnd to cut byte
- *     tags that will otherwise cover new bytes.
+ *     tags that will otherwise cover new bytes. The tags are cut in place
+ *     unless their buffer is shared.
  */
 class ByteTagList
 {
@@ -246,11 +252,28 @@ private:
    */
   void Deallocate (struct ByteTagListData *data);
 
+  /**
+   * \brief Remove the tags which do not overlap a range of offsets,
+   * and cut the ones which overlap its boundaries.
+   * \param offsetStart the start of the range
+   * \param offsetEnd the end of the range
+   */
+  void Clip (int32_t offsetStart, int32_t offsetEnd);
+
+  /**
+   * \returns the tag byte buffer, inline or shared
+   */
+  uint8_t *GetData (void) const;
+
+  /// Number of bytes of tags stored inline, without any allocation
+  static const uint32_t INLINE_SIZE = 32;
+
   int32_t m_minStart; //!< minimal start offset
   int32_t m_maxEnd; //!< maximal end offset
   int32_t m_adjustment; //!< adjustment to byte tag offsets
   uint32_t m_used; //!< the number of used bytes in the buffer
-  struct ByteTagListData *m_data; //!< the ByteTagListData structure
+  struct ByteTagListData *m_data; //!< the ByteTagListData structure, or 0 if the tags are inline
+  uint32_t m_inline[INLINE_SIZE / 4]; //!< the inline tag byte buffer
 };
 
 void
@@ -259,6 +282,7 @@ ByteTagList::Adjust (int32_t adjustment)
   m_adjustment += adjustment;
 }
 
+
 } // namespace ns3
 
 #endif /* BYTE_TAG_LIST_H */
@@ -20,7 +20,7 @@
 
 /**
 \file   packet-tag-list.cc
-\brief  Implements a linked list of Packet tags, including copy-on-write semantics.
+\brief  Implements a flat array of Packet tags, including copy-on-write semantics.
 */
 
 #include "packet-tag-list.h"
@@ -28,232 +28,148 @@
 #include "tag.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include <cstddef>
 #include <cstring>
+#include <limits>
+#include <new>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
-PacketTagList::TagData *
-PacketTagList::CreateTagData (size_t dataSize)
+uint32_t
+PacketTagList::GetTagDataSize (uint32_t dataSize)
 {
-  NS_ASSERT_MSG (dataSize
-                 < std::numeric_limits<decltype(TagData::size)>::max (),
-                 "Requested TagData size " << dataSize
-                 << " exceeds maximum "
-                 << std::numeric_limits<decltype(TagData::size)>::max () );
-
-  void * p = std::malloc (sizeof (TagData) + dataSize - 1);
-  // The matching frees are in RemoveAll and RemoveWriter
-
-  TagData * tag = new (p) TagData;
-  tag->size = dataSize;
-  return tag;
+  return (offsetof (TagData, data) + dataSize + 3) & ~3U;
 }
 
-bool
-PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
+PacketTagList::TagListData *
+PacketTagList::CreateTagListData (uint32_t size)
 {
-  TypeId tid = tag.GetInstanceTypeId ();
-  NS_LOG_FUNCTION (this << tid);
-  NS_LOG_INFO     ("looking for " << tid);
+  void * p = std::malloc (offsetof (TagListData, data) + std::max<uint32_t> (size, 4));
+  // The matching frees are in RemoveAll and Erase
 
-  // trivial case when list is empty
-  if (m_next == 0)
-    {
-      return false;
-    }
-
-  bool found = false;
-
-  struct TagData ** prevNext = &m_next; // previous node's next pointer
-  struct TagData  * cur      =  m_next; // cursor to current node
-  struct TagData  * it = 0;             // utility
+  TagListData * data = new (p) TagListData;
+  data->count = 1;
+  data->size = size;
+  return data;
+}
 
-  // Search from the head of the list until we find tid or a merge
-  while (cur != 0)
+uint32_t
+PacketTagList::Find (TypeId tid) const
+{
+  const uint8_t *data = GetData ();
+  uint32_t offset = 0;
+  while (offset < m_used)
     {
-      if (cur->count > 1)
-        {
-          // found merge
-          NS_LOG_INFO ("found initial merge before tid");
-          break;
-        }
-      else if (cur->tid == tid)
+      const TagData *cur = reinterpret_cast<const TagData *> (data + offset);
+      if (cur->tid == tid)
         {
-          NS_LOG_INFO ("found tid before initial merge, calling writer");
-          found = (this->*Writer)(tag, true, cur, prevNext);
           break;
         }
-      else
-        {
-          // no merge or tid found yet, move on
-          prevNext = &cur->next;
-          cur      =  cur->next;
-        }
-    }  // while !found && !cow
-
-  // did we find it or run out of tags?
-  if (cur == 0 || found)
-    {
-      NS_LOG_INFO ("returning after header with found: " << found);
-      return found;
+      offset += GetTagDataSize (cur->size);
     }
+  return offset;
+}
 
-  // From here on out, we have to copy the list
-  // until we find tid, then link past it
-
-  // Before we do all that work, let's make sure tid really exists
-  for (it = cur; it != 0; it = it->next)
+void
+PacketTagList::Reserve (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  if (m_data == 0)
     {
-      if (it->tid == tid)
+      if (size <= INLINE_SIZE)
         {
-          break;
+          return;
         }
     }
-  if (it == 0)
+  else if (m_data->count == 1 && m_data->size >= size)
     {
-      // got to end of list without finding tid
-      NS_LOG_INFO ("tid not found after first merge");
-      return found;
+      return;
     }
-
-  // At this point cur is a merge, but untested for tid
-  NS_ASSERT (cur != 0);
-  NS_ASSERT (cur->count > 1);
-
-  /*
-     Walk the remainder of the list, copying, until we find tid
-     As we put a copy of the cur node onto our list,
-     we move the merge point down the list.
-
-     Starting position                  End position
-       T1 is a merge                     T1.count decremented
-                                         T2 is a merge
-                                         T1' is a copy of T1
-
-          other                             other
-               \                                 \
-      Prev  ->  T1  ->  T2  -> ...                T1  ->  T2  -> ...
-           /   /                                         /|
-      pNext cur                         Prev  ->  T1' --/ |
-                                                     /    |
-                                                pNext   cur
-
-     When we reach tid, we link past it, decrement count, and we're done.
-  */
-
-  // Should normally check for null cur pointer,
-  // but since we know tid exists, we'll skip this test
-  while ( /* cur && */ cur->tid != tid)
+  // grow geometrically, so that adding many tags is not quadratic
+  uint32_t capacity = size;
+  if (m_data != 0 && m_data->count == 1)
     {
-      NS_ASSERT (cur != 0);
-      NS_ASSERT (cur->count > 1);
-      cur->count--;                       // unmerge cur
-      struct TagData * copy = CreateTagData (cur->size);
-      copy->tid = cur->tid;
-      copy->count = 1;
-      copy->size = cur->size;
-      memcpy (copy->data, cur->data, copy->size);
-      copy->next = cur->next;             // merge into tail
-      copy->next->count++;                // mark new merge
-      *prevNext = copy;                   // point prior list at copy
-      prevNext = &copy->next;             // advance
-      cur      =  copy->next;
+      capacity = std::max (size, 2 * m_data->size);
     }
-  // Sanity check:
-  NS_ASSERT (cur != 0);                 // cur should be non-zero
-  NS_ASSERT (cur->tid == tid);          // cur->tid should be tid
-  NS_ASSERT (cur->count > 1);           // cur should be a merge
-
-  // link around tid, removing it from our list
-  found = (this->*Writer)(tag, false, cur, prevNext);
-  return found;
-
-}
-
-bool
-PacketTagList::Remove (Tag & tag)
-{
-  return COWTraverse (tag, &PacketTagList::RemoveWriter);
+  TagListData *data = CreateTagListData (capacity);
+  std::memcpy (data->data, GetData (), m_used);
+  uint32_t used = m_used;
+  RemoveAll ();
+  m_data = data;
+  m_used = used;
 }
 
-// COWWriter implementing Remove
-bool
-PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
-                             struct PacketTagList::TagData  * cur,
-                             struct PacketTagList::TagData ** prevNext)
+void
+PacketTagList::Erase (uint32_t offset)
 {
-  NS_LOG_FUNCTION_NOARGS ();
-
-  // found tid
-  bool found = true;
-  tag.Deserialize (TagBuffer (cur->data, cur->data + cur->size));
-  *prevNext = cur->next;            // link around cur
-
-  if (preMerge)
-    {
-      // found tid before first merge, so delete cur
-      cur->~TagData ();
-      std::free (cur);
-    }
-  else
+  NS_LOG_FUNCTION (this << offset);
+  NS_ASSERT (offset < m_used);
+  uint8_t *data = GetData ();
+  uint32_t size = GetTagDataSize (reinterpret_cast<TagData *> (data + offset)->size);
+  uint32_t used = m_used - size;
+  if (m_data != 0 && (m_data->count > 1 || used <= INLINE_SIZE))
     {
-      // cur is always a merge at this point
-      // unmerge cur, since we linked around it already
-      cur->count--;
-      if (cur->next != 0)
+      // copy the remaining tags into a private array, inline if they fit
+      TagListData *old = m_data;
+      m_data = used <= INLINE_SIZE ? 0 : CreateTagListData (used);
+      uint8_t *copy = GetData ();
+      std::memcpy (copy, old->data, offset);
+      std::memcpy (copy + offset, old->data + offset + size, used - offset);
+      m_used = used;
+      if (--old->count == 0)
         {
-          // there's a next, so make it a merge
-          cur->next->count++;
+          old->~TagListData ();
+          std::free (old);
         }
+      return;
     }
-  return found;
+  std::memmove (data + offset, data + offset + size, used - offset);
+  m_used = used;
 }
 
 bool
-PacketTagList::Replace (Tag & tag)
+PacketTagList::Remove (Tag & tag)
 {
-  bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
-  if (!found)
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t offset = Find (tid);
+  if (offset == m_used)
     {
-      Add (tag);
+      return false;
     }
-  return found;
+  TagData *cur = reinterpret_cast<TagData *> (GetData () + offset);
+  tag.Deserialize (TagBuffer (cur->data, cur->data + cur->size));
+  Erase (offset);
+  return true;
 }
 
-// COWWriter implementing Replace
 bool
-PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
-                              struct PacketTagList::TagData  * cur,
-                              struct PacketTagList::TagData ** prevNext)
+PacketTagList::Replace (Tag & tag)
 {
-  NS_LOG_FUNCTION_NOARGS ();
-
-  // found tid
-  bool found = true;
-  if (preMerge)
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t offset = Find (tid);
+  if (offset == m_used)
     {
-      // found tid before first merge, so just rewrite
+      Add (tag);
+      return false;
+    }
+  uint32_t size = tag.GetSerializedSize ();
+  if (reinterpret_cast<TagData *> (GetData () + offset)->size == size)
+    {
+      // same size: just rewrite, once the array is ours
+      Reserve (m_used);
+      TagData *cur = reinterpret_cast<TagData *> (GetData () + offset);
       tag.Serialize (TagBuffer (cur->data, cur->data + cur->size));
     }
   else
     {
-      // cur is always a merge at this point
-      // need to copy, replace, and link past cur
-      cur->count--;                     // unmerge cur
-      struct TagData * copy = CreateTagData (tag.GetSerializedSize ());
-      copy->tid = tag.GetInstanceTypeId ();
-      copy->count = 1;
-      tag.Serialize (TagBuffer (copy->data, copy->data + copy->size));
-      copy->next = cur->next;           // merge into tail
-      if (copy->next != 0)
-        {
-          copy->next->count++;          // mark new merge
-        }
-      *prevNext = copy;                 // point prior list at copy
+      Erase (offset);
+      Add (tag);
     }
-  return found;
+  return true;
 }
 
 void 
@@ -261,43 +177,65 @@ PacketTagList::Add (const Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   // ensure this id was not yet added
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
-    {
-      NS_ASSERT_MSG (cur->tid != tag.GetInstanceTypeId (),
-                     "Error: cannot add the same kind of tag twice.");
-    }
-  struct TagData * head = CreateTagData (tag.GetSerializedSize ());
-  head->count = 1;
-  head->next = 0;
+  NS_ASSERT_MSG (Find (tag.GetInstanceTypeId ()) == m_used,
+                 "Error: cannot add the same kind of tag twice.");
+  uint32_t dataSize = tag.GetSerializedSize ();
+  NS_ASSERT_MSG (dataSize
+                 < std::numeric_limits<uint32_t>::max () - m_used - GetTagDataSize (0),
+                 "Requested TagData size " << dataSize
+                 << " exceeds maximum "
+                 << std::numeric_limits<uint32_t>::max () - m_used - GetTagDataSize (0));
+  PacketTagList *self = const_cast<PacketTagList *> (this);
+  uint32_t size = GetTagDataSize (dataSize);
+  uint32_t used = m_used + size;
+  self->Reserve (used);
+  // insert at the start, so that the most recent tag is found and
+  // iterated first
+  uint8_t *data = GetData ();
+  std::memmove (data + size, data, m_used);
+  TagData *head = reinterpret_cast<TagData *> (data);
   head->tid = tag.GetInstanceTypeId ();
-  head->next = m_next;
+  head->size = dataSize;
   tag.Serialize (TagBuffer (head->data, head->data + head->size));
-
-  const_cast<PacketTagList *> (this)->m_next = head;
+  self->m_used = used;
 }
 
 bool
 PacketTagList::Peek (Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
-  TypeId tid = tag.GetInstanceTypeId ();
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  uint32_t offset = Find (tag.GetInstanceTypeId ());
+  if (offset == m_used)
     {
-      if (cur->tid == tid) 
-        {
-          /* found tag */
-          tag.Deserialize (TagBuffer (cur->data, cur->data + cur->size));
-          return true;
-        }
+      /* no tag found */
+      return false;
     }
-  /* no tag found */
-  return false;
+  /* found tag */
+  const TagData *cur = reinterpret_cast<const TagData *> (GetData () + offset);
+  tag.Deserialize (TagBuffer (const_cast<uint8_t *> (cur->data),
+                              const_cast<uint8_t *> (cur->data) + cur->size));
+  return true;
 }
 
 const struct PacketTagList::TagData *
 PacketTagList::Head (void) const
 {
-  return m_next;
+  if (m_used == 0)
+    {
+      return 0;
+    }
+  return reinterpret_cast<const TagData *> (GetData ());
+}
+
+const struct PacketTagList::TagData *
+PacketTagList::Next (const struct PacketTagList::TagData *cur) const
+{
+  const uint8_t *next = reinterpret_cast<const uint8_t *> (cur) + GetTagDataSize (cur->size);
+  if (next >= GetData () + m_used)
+    {
+      return 0;
+    }
+  return reinterpret_cast<const TagData *> (next);
 }
 
 } /* namespace ns3 */
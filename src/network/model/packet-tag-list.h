@@ -22,10 +22,13 @@
 
 /**
 \file   packet-tag-list.h
-\brief  Defines a linked list of Packet tags, including copy-on-write semantics.
+\brief  Defines a flat array of Packet tags, including copy-on-write semantics.
 */
 
 #include <stdint.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
 #include <ostream>
 #include "ns3/type-id.h"
 
@@ -43,88 +46,39 @@ class Tag;
  *
  * \internal
  *
- * The implementation of this class is a bit tricky.  Refer to this
- * diagram in the discussion that follows.
+ * The tags are stored in serialized form, one after the other, in a
+ * single byte array:
  *
- * \dot
- *    digraph {
- *        rankdir = "LR";
- *        clusterrank = local;
- *        node [ shape = record, fontname="FreeSans", fontsize="10" ];
- *        oth  [ label="<l> Other branch | <n> next | <c> ..." ];
- *        PTL1 [ label="<l> PacketTagList A | <n> m_next" , shape=Mrecord];
- *        PTL2 [ label="<l> PacketTagList B | <n> m_next" , shape=Mrecord];
- *        oth:n  -> T7:l ;
- *        PTL2:n -> T6:l ;
- *        PTL1:n -> T5:l ;
- *        T1   [ label="<l> T1  | <n> next | <c> count = 1" ];
- *        T2   [ label="<l> T2  | <n> next | <c> count = 1" ];
- *        T3   [ label="<l> T3  | <n> next | <c> count = 2" ];
- *        T4   [ label="<l> T4  | <n> next | <c> count = 1" ];
- *        T5   [ label="<l> T5  | <n> next | <c> count = 2" ];
- *        T6   [ label="<l> T6  | <n> next | <c> count = 1" ];
- *        T7   [ label="<l> T7  | <n> next | <c> count = 1" ];
- *        NULL [ label="0", shape = ellipse ];
- *        subgraph cluster_list {
- *          penwidth = 0;
- *          T6:n -> T5:l ;
- *          T5:n -> T4:l ;
- *          T4:n -> T3:l ;
- *          T7:n -> T3:l ;
- *          T3:n -> T2:l ;
- *          T2:n -> T1:l ;
- *          T1:n -> NULL ;
- *        };
- *      }
- * \enddot
+ * \verbatim
+ * | tid | size | data ... | pad | tid | size | data | pad | ...
+ * |<------ TagData ------------>|<------ TagData ------->|
+ * \endverbatim
  *
- *   - Tags are stored in serialized form in a tree of TagData
- *     structures. (<tt>T1-T7</tt> in the diagram)
+ * Each TagData is padded to a multiple of 4 bytes, so that the header
+ * of the next one is aligned.
  *
- *   - Each TagData points (\c next pointers in the diagram)
- *     toward the root of the tree, which is a null pointer.
+ *   - As long as the tags fit in #INLINE_SIZE bytes, the array is stored
+ *     inline in the PacketTagList, and copying a PacketTagList copies
+ *     these few bytes without any allocation. The handful of small tags
+ *     added by the sockets, the queue discs and the flow monitors on
+ *     every packet never hit the heap.
  *
- *   - \c count is the number of incoming pointers to this
- *     TagData.  Branch points, where branches merge or join, have
- *     <tt>count \> 1</tt> (\c T3, \c T5); successive links along
- *     a branch have <tt>count = 1</tt> (\c T1, \c T2, \c T4, \c T6, \c T7).
+ *   - Larger arrays are stored in a reference-counted TagListData on the
+ *     heap. The copy constructor and the assignment operator share it,
+ *     and #Add, #Remove and #Replace copy it first if it is shared
+ *     (<b>copy-on-write</b>). When a removal makes the tags fit inline
+ *     again, they are moved back into the PacketTagList.
  *
- *   - Each PacketTagList points to a specific TagData,
- *     which is the most recent Tag added to the packet. (<tt>T5-T7</tt>)
- *
- *   - Conceptually, therefore, each Packet has a PacketTagList which
- *     points to a singly-linked list of TagData.
- *
- * \par <b> Copy-on-write </b> is implemented as follows:
- *
- *   - #Add prepends the new tag to the list (growing that branch of the tree,
- *     as \c T6). This is a constant time operation, and does not affect
- *     any other #PacketTagList's, hence this is a \c const function.
- *
- *   - Copy constructor (PacketTagList(const PacketTagList & o))
- *     and assignment (#operator=(const PacketTagList & o))
- *     simply join the tree at the same place as the original
- *     PacketTagList \c o, incrementing the \c count.
- *     For assignment, the old branch is deleted, up to
- *     the first branch point, which has its \c count decremented.
- *     (PacketTagList \c B started as a copy of PacketTagList \c A,
- *     before \c T6 was added to \c B).
- *
- *   - #Remove and #Replace are a little tricky, depending on where the
- *     target tag is found relative to the first branch point:
- *     - \e Target before <em> the first branch point: </em> \n
- *       The target is just dealt with in place (linked around and deleted,
- *       in the case of #Remove; rewritten in the case of #Replace).
- *     - \e Target at or after <em> the first branch point: </em> \n
- *       The portion of the list between the first branch and the target is
- *       shared. This portion is copied before the #Remove or #Replace is
- *       performed.
+ *   - #Add inserts the new tag at the start of the array, so that the
+ *     tags are iterated from the most recently added one; #Peek, #Remove
+ *     and #Replace search the array linearly, which is fast for the few
+ *     tags a packet carries.
  */
 class PacketTagList 
 {
 public:
   /**
-   * Tree node for sharing serialized tags.
+   * Header of a tag stored in the list, followed by its serialized data.
    *
    * See PacketTagList for a discussion of the data structure.
    *
@@ -133,15 +87,9 @@ public:
    * PacketTagIterator::Item::GetTag() needs the data and size values.
    * The Item nested class can't be forward declared, so friending isn't
    * possible.
-   *
-   * We use placement new so we can allocate enough room for the Tag
-   * type which will be serialized into data.  See Object::Aggregates
-   * for a similar construction.
    */
   struct TagData
   {
-    struct TagData * next;      /**< Pointer to next in list */
-    uint32_t count;             /**< Number of incoming links */
     TypeId tid;                 /**< Type of the tag serialized into #data */
     uint32_t size;              /**< Size of the \c data buffer */
     uint8_t data[1];            /**< Serialization buffer */
@@ -156,8 +104,8 @@ public:
    *
    * \param [in] o The PacketTagList to copy.
    *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * This copies the inline tags of \pname{o}, or shares its
+   * heap-allocated tags.
    */
   inline PacketTagList (PacketTagList const &o);
   /**
@@ -167,18 +115,19 @@ public:
    * \returns the copied object
    *
    * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * copying the inline tags of \pname{o}, or sharing its
+   * heap-allocated tags.
    */
   inline PacketTagList &operator = (PacketTagList const &o);
   /**
    * Destructor
    *
-   * #RemoveAll's the tags up to the first merge.
+   * #RemoveAll's the tags.
    */
   inline ~PacketTagList ();
 
   /**
-   * Add a tag to the head of this branch.
+   * Add a tag at the head of the list.
    *
    * \param [in] tag The tag to add
    */
@@ -210,78 +159,78 @@ public:
    */
   bool Peek (Tag &tag) const;
   /**
-   * Remove all tags from this list (up to the first merge).
+   * Remove all tags from this list.
    */
   inline void RemoveAll (void);
   /**
-   * \returns pointer to head of tag list
+   * \returns pointer to the first tag of the list, or 0 if the list is empty
    */
   const struct PacketTagList::TagData *Head (void) const;
+  /**
+   * \param [in] cur A tag of the list.
+   * \returns pointer to the tag following \pname{cur}, or 0 if \pname{cur}
+   *          is the last one
+   */
+  const struct PacketTagList::TagData *Next (const struct PacketTagList::TagData *cur) const;
 
 private:
   /**
-   * Allocate and construct a TagData struct, sizing the data area
-   * large enough to serialize dataSize bytes from a Tag.
+   * Number of bytes of tags stored inline, without any allocation.
+   */
+  static const uint32_t INLINE_SIZE = 48;
+
+  /**
+   * Reference-counted array of tags, used when they do not fit inline.
+   */
+  struct TagListData
+  {
+    std::atomic<uint32_t> count; /**< Number of lists sharing this array, possibly from several threads */
+    uint32_t size;               /**< Size of the \c data buffer */
+    uint8_t data[4];             /**< The array of TagData */
+  };
+
+  /**
+   * \param [in] dataSize The serialized size of a tag.
+   * \returns The number of bytes of the TagData storing this tag.
+   */
+  static uint32_t GetTagDataSize (uint32_t dataSize);
+  /**
+   * Allocate and construct a TagListData struct, sizing the array
+   * large enough to hold size bytes of tags.
    *
-   * \param [in] dataSize The serialized size of the Tag.
-   * \returns The newly constructed TagData object.
+   * \param [in] size The size of the array to allocate.
+   * \returns The newly constructed TagListData object.
    */
   static
-  TagData * CreateTagData (size_t dataSize);
-  
+  TagListData * CreateTagListData (uint32_t size);
   /**
-   * Typedef of method function pointer for copy-on-write operations
-   *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True if operation successful, false otherwise
+   * \returns The array of tags of this list.
    */
-  typedef bool (PacketTagList::*COWWriter)
-    (Tag       & tag, bool         preMerge,
-    struct TagData * cur, struct TagData ** prevNext);
+  inline uint8_t *GetData (void) const;
   /**
-   * Traverse the list implementing copy-on-write, using \pname{Writer}.
+   * Find a tag.
    *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] Writer The copy-on-write function to use.
-   * \returns True if \pname{tag} found, false otherwise.
+   * \param [in] tid The type of the tag.
+   * \returns The offset of the tag in the array, or #m_used if not found.
    */
-  bool COWTraverse   (Tag & tag, PacketTagList::COWWriter Writer);
+  uint32_t Find (TypeId tid) const;
   /**
-   * Copy-on-write implementing Remove.
+   * Make sure that this list owns its array, and that the array can hold
+   * \pname{size} bytes, copying or growing it as needed.
    *
-   * \param [in] tag The target tag type to remove.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag will definitely be removed.
+   * \param [in] size The number of bytes the array must hold.
    */
-  bool RemoveWriter  (Tag & tag, bool preMerge,
-                      struct TagData * cur, struct TagData ** prevNext);
+  void Reserve (uint32_t size);
   /**
-   * Copy-on-write implementing Replace
+   * Remove a tag from the array.
    *
-   * \param [in] tag The target tag type to replace
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *          false otherwise.
-   * \param [in] cur Pointer to the tag
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag value will definitely be replaced.
+   * \param [in] offset The offset of the tag in the array.
    */
-  bool ReplaceWriter (Tag & tag, bool preMerge,
-                      struct TagData * cur, struct TagData ** prevNext);
+  void Erase (uint32_t offset);
 
-  /**
-   * Pointer to first \ref TagData on the list
-   */
-  struct TagData *m_next;
+  TagListData *m_data;              /**< Heap-allocated tags, or 0 if the tags are inline */
+  uint32_t m_used;                  /**< Number of bytes used in the array of tags */
+  uint32_t m_inline[INLINE_SIZE / 4]; /**< Inline array of tags */
 };
 
 } // namespace ns3
@@ -293,16 +242,22 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_data (0),
+    m_used (0)
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_data (o.m_data),
+    m_used (o.m_used)
 {
-  if (m_next != 0)
+  if (m_data != 0)
+    {
+      m_data->count++;
+    }
+  else
     {
-      m_next->count++;
+      std::memcpy (m_inline, o.m_inline, m_used);
     }
 }
 
@@ -310,15 +265,20 @@ PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o)
     {
       return *this;
     }
   RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  m_data = o.m_data;
+  m_used = o.m_used;
+  if (m_data != 0) 
     {
-      m_next->count++;
+      m_data->count++;
+    }
+  else
+    {
+      std::memcpy (m_inline, o.m_inline, m_used);
     }
   return *this;
 }
@@ -331,27 +291,19 @@ PacketTagList::~PacketTagList ()
 void
 PacketTagList::RemoveAll (void)
 {
-  struct TagData *prev = 0;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
-    {
-      cur->count--;
-      if (cur->count > 0) 
-        {
-          break;
-        }
-      if (prev != 0) 
-        {
-          prev->~TagData ();
-          std::free (prev);
-        }
-      prev = cur;
-    }
-  if (prev != 0) 
+  if (m_data != 0 && --m_data->count == 0)
     {
-      prev->~TagData ();
-      std::free (prev);
+      m_data->~TagListData ();
+      std::free (m_data);
     }
-  m_next = 0;
+  m_data = 0;
+  m_used = 0;
+}
+
+uint8_t *
+PacketTagList::GetData (void) const
+{
+  return m_data != 0 ? m_data->data : (uint8_t *)m_inline;
 }
 
 } // namespace ns3
@@ -28,7 +28,7 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Packet");
 
-uint32_t Packet::m_globalUid = 0;
+thread_local uint32_t Packet::m_globalUid = 0;
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -81,8 +81,9 @@ ByteTagIterator::ByteTagIterator (ByteTagList::Iterator i)
 }
 
 
-PacketTagIterator::PacketTagIterator (const struct PacketTagList::TagData *head)
-  : m_current (head)
+PacketTagIterator::PacketTagIterator (const PacketTagList *list)
+  : m_list (list),
+    m_current (list->Head ())
 {
 }
 bool
@@ -95,7 +96,7 @@ PacketTagIterator::Next (void)
 {
   NS_ASSERT (HasNext ());
   const struct PacketTagList::TagData *prev = m_current;
-  m_current = m_current->next;
+  m_current = m_list->Next (m_current);
   return PacketTagIterator::Item (prev);
 }
 
@@ -195,7 +196,7 @@ Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
 }
 
 Packet::Packet (uint8_t const*buffer, uint32_t size)
-  : m_buffer (),
+  : m_buffer (buffer, size),
     m_byteTagList (),
     m_packetTagList (),
     /* The upper 32 bits of the packet id in 
@@ -208,9 +209,6 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
     m_nixVector (0)
 {
   m_globalUid++;
-  m_buffer.AddAtStart (size);
-  Buffer::Iterator i = m_buffer.Begin ();
-  i.Write (buffer, size);
 }
 
 Packet::Packet (const Buffer &buffer,  const ByteTagList &byteTagList, 
@@ -544,6 +542,13 @@ Packet::EnableChecking (void)
   PacketMetadata::EnableChecking ();
 }
 
+void
+Packet::EnableZeroCopy (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Buffer::EnableSlabs ();
+}
+
 uint32_t Packet::GetSerializedSize (void) const
 {
   uint32_t size = 0;
@@ -871,7 +876,7 @@ Packet::PrintPacketTags (std::ostream &os) const
 PacketTagIterator 
 Packet::GetPacketTagIterator (void) const
 {
-  return PacketTagIterator (m_packetTagList.Head ());
+  return PacketTagIterator (&m_packetTagList);
 }
 
 std::ostream& operator<< (std::ostream& os, const Packet &packet)
@@ -169,9 +169,10 @@ private:
   friend class Packet;
   /**
    * Constructor
-   * \param head head of the items
+   * \param list the list of the items
    */
-  PacketTagIterator (const struct PacketTagList::TagData *head);
+  PacketTagIterator (const PacketTagList *list);
+  const PacketTagList *m_list;  //!< the set of tags in a packet
   const struct PacketTagList::TagData *m_current;  //!< actual position over the set of tags in a packet
 };
 
@@ -501,6 +502,19 @@ public:
    * errors will be detected and will abort the program.
    */
   static void EnableChecking (void);
+  /**
+   * \brief Enable zero-copy payloads.
+   *
+   * By default, the bytes given to Packet (uint8_t const*, uint32_t)
+   * are copied into the packet buffer, and copied again whenever the
+   * packet is fragmented and a header is added to a fragment, or when
+   * fragments are re-assembled. Once this method is invoked, these
+   * bytes are instead copied once into a read-only slab shared by all
+   * the copies and fragments of the packet (see Buffer::EnableSlabs).
+   * Invoke it during the simulation setup, before any such packet is
+   * created. These bytes cannot be overwritten in place afterwards.
+   */
+  static void EnableZeroCopy (void);
 
   /**
    * \brief Returns number of bytes required for packet
@@ -727,7 +741,7 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  static thread_local uint32_t m_globalUid; //!< Counter of packets Uid, for each thread
 };
 
 /**
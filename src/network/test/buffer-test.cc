@@ -23,6 +23,9 @@
 #include "ns3/double.h"
 #include "ns3/test.h"
 
+#include <thread>
+#include <vector>
+
 using namespace ns3;
 
 //-----------------------------------------------------------------------------
@@ -360,6 +363,195 @@ BufferTest::DoRun (void)
   val2 |= i.ReadU8 ();
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
+
+/**
+ * \brief Check that buffers backed by slabs behave like real buffers
+ * and do not copy their payload.
+ */
+class BufferSlabTest : public TestCase
+{
+public:
+  BufferSlabTest ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Check the content of a buffer.
+   * \param buffer the buffer
+   * \param expected the expected content
+   * \param size the expected size
+   */
+  void CheckContent (const Buffer &buffer, const uint8_t *expected, uint32_t size);
+};
+
+BufferSlabTest::BufferSlabTest ()
+  : TestCase ("Buffer slabs")
+{
+}
+
+void
+BufferSlabTest::CheckContent (const Buffer &buffer, const uint8_t *expected, uint32_t size)
+{
+  NS_TEST_ASSERT_MSG_EQ (buffer.GetSize (), size, "Bad buffer size");
+  std::vector<uint8_t> copy (size);
+  NS_TEST_ASSERT_MSG_EQ (buffer.CopyData (&copy[0], size), size, "Bad CopyData size");
+  Buffer::Iterator i = buffer.Begin ();
+  for (uint32_t j = 0; j < size; j++)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((uint16_t)copy[j], (uint16_t)expected[j], "Bad CopyData byte " << j);
+      NS_TEST_ASSERT_MSG_EQ ((uint16_t)i.ReadU8 (), (uint16_t)expected[j], "Bad iterator byte " << j);
+    }
+  NS_TEST_ASSERT_MSG_EQ (i.IsEnd (), true, "Iterator should be at the end");
+}
+
+void
+BufferSlabTest::DoRun (void)
+{
+  uint8_t payload[1000];
+  for (uint32_t j = 0; j < 1000; j++)
+    {
+      payload[j] = (j * 7) & 0xff;
+    }
+
+  Buffer::EnableSlabs ();
+  uint64_t copied = Buffer::GetCopiedBytes ();
+  Buffer buffer (payload, 1000);
+  Buffer::DisableSlabs ();
+  NS_TEST_ASSERT_MSG_EQ (Buffer::GetCopiedBytes () - copied, 1000, "The payload should be copied once");
+  CheckContent (buffer, payload, 1000);
+
+  // fragments, headers and trailers leave the payload in place
+  copied = Buffer::GetCopiedBytes ();
+  Buffer fragment = buffer.CreateFragment (100, 300);
+  fragment.AddAtStart (2);
+  fragment.Begin ().WriteHtonU16 (0xabcd);
+  fragment.AddAtEnd (1);
+  Buffer::Iterator i = fragment.End ();
+  i.Prev ();
+  i.WriteU8 (0xef);
+  uint8_t expected[1000];
+  expected[0] = 0xab;
+  expected[1] = 0xcd;
+  memcpy (expected + 2, payload + 100, 300);
+  expected[302] = 0xef;
+  CheckContent (fragment, expected, 303);
+  i = fragment.Begin ();
+  i.Next (1);
+  uint16_t expected16 = (0xcd << 8) | payload[100];
+  NS_TEST_ASSERT_MSG_EQ (i.ReadNtohU16 (), expected16, "Bad read across the payload start");
+  uint32_t expected32 = (payload[101] << 24) | (payload[102] << 16) | (payload[103] << 8) | payload[104];
+  NS_TEST_ASSERT_MSG_EQ (i.ReadNtohU32 (), expected32, "Bad read in the payload");
+  fragment.RemoveAtStart (2);
+  fragment.RemoveAtEnd (1);
+  CheckContent (fragment, payload + 100, 300);
+  NS_TEST_ASSERT_MSG_LT (Buffer::GetCopiedBytes () - copied, 10, "The payload should not be copied");
+
+  // adjacent fragments are re-assembled without copies
+  copied = Buffer::GetCopiedBytes ();
+  Buffer reassembled;
+  reassembled.AddAtEnd (buffer.CreateFragment (0, 400));
+  reassembled.AddAtEnd (buffer.CreateFragment (400, 100));
+  reassembled.AddAtEnd (buffer.CreateFragment (500, 500));
+  NS_TEST_ASSERT_MSG_EQ (Buffer::GetCopiedBytes () - copied, 0, "The payload should not be copied");
+  CheckContent (reassembled, payload, 1000);
+
+  // other fragments are copied
+  Buffer mixed = buffer.CreateFragment (0, 100);
+  mixed.AddAtEnd (buffer.CreateFragment (500, 100));
+  memcpy (expected, payload, 100);
+  memcpy (expected + 100, payload + 500, 100);
+  CheckContent (mixed, expected, 200);
+  Buffer zeroes (100);
+  zeroes.AddAtEnd (buffer.CreateFragment (0, 100));
+  memset (expected, 0, 100);
+  memcpy (expected + 100, payload, 100);
+  CheckContent (zeroes, expected, 200);
+
+  // full copies, iterator copies and serialization
+  fragment = buffer.CreateFragment (100, 300);
+  fragment.AddAtStart (1);
+  fragment.Begin ().WriteU8 (0x42);
+  expected[0] = 0x42;
+  memcpy (expected + 1, payload + 100, 300);
+  uint8_t const *data = fragment.PeekData ();
+  NS_TEST_ASSERT_MSG_EQ (memcmp (data, expected, 301), 0, "Bad PeekData");
+  fragment = buffer.CreateFragment (100, 300);
+  fragment.AddAtStart (1);
+  fragment.Begin ().WriteU8 (0x42);
+  Buffer target (0);
+  target.AddAtStart (301);
+  target.Begin ().Write (fragment.Begin (), fragment.End ());
+  CheckContent (target, expected, 301);
+  std::vector<uint8_t> serialized (fragment.GetSerializedSize ());
+  NS_TEST_ASSERT_MSG_EQ (fragment.Serialize (&serialized[0], serialized.size ()), 1, "Serialization failed");
+  Buffer deserialized (0, false);
+  // as done by Packet::Deserialize, the size includes the 4-byte length field
+  deserialized.Deserialize (&serialized[0], serialized.size () + 4);
+  CheckContent (deserialized, expected, 301);
+}
+
+/**
+ * \brief Check that the buffer data storages are recycled whatever
+ * their size, and that they move between threads.
+ */
+class BufferFreeListTest : public TestCase
+{
+public:
+  BufferFreeListTest ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Create and destroy buffers of various sizes, keeping up to
+   * n of them alive at a time.
+   * \param n the number of buffers alive at a time
+   */
+  static void CreateBuffers (uint32_t n);
+};
+
+BufferFreeListTest::BufferFreeListTest ()
+  : TestCase ("Buffer free lists")
+{
+}
+
+void
+BufferFreeListTest::CreateBuffers (uint32_t n)
+{
+  std::vector<Buffer> buffers;
+  for (uint32_t size = 20; size <= 20000; size *= 10)
+    {
+      for (uint32_t i = 0; i < n; i++)
+        {
+          Buffer buffer;
+          buffer.AddAtStart (size);
+          buffer.Begin ().WriteU8 (0xaa, size);
+          buffers.push_back (buffer);
+        }
+      buffers.clear ();
+    }
+}
+
+void
+BufferFreeListTest::DoRun (void)
+{
+  // small buffers are recycled after large ones have been used
+  Buffer::ResetAllocationStats ();
+  CreateBuffers (10);
+  CreateBuffers (10);
+  NS_TEST_ASSERT_MSG_GT (Buffer::GetNAllocations (), 0, "Buffers should have been created");
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (2 * Buffer::GetNRecycled (), Buffer::GetNAllocations (),
+                               "The second round should only use recycled buffer data");
+
+  // the buffer data released by a thread which exits is reused by another one
+  uint64_t allocations = Buffer::GetNAllocations ();
+  std::thread thread (&BufferFreeListTest::CreateBuffers, 1000);
+  thread.join ();
+  NS_TEST_ASSERT_MSG_GT (Buffer::GetNAllocations (), allocations + 3000,
+                         "The allocations of the thread should be counted");
+  uint64_t shared = Buffer::GetNShared ();
+  CreateBuffers (1000);
+  NS_TEST_ASSERT_MSG_GT (Buffer::GetNShared (), shared,
+                         "The buffer data of the thread should have been reused");
+}
+
 //-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
@@ -371,6 +563,8 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferSlabTest, TestCase::QUICK);
+  AddTestCase (new BufferFreeListTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
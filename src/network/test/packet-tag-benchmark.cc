@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/flow-id-tag.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace ns3;
+
+/**
+ * \brief Time the packet and byte tag operations done on every packet
+ * by the sockets, the queue discs and the fragmentation code.
+ */
+class PacketTagBenchmarkTestCase : public TestCase
+{
+public:
+  PacketTagBenchmarkTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Print the time taken by a benchmark.
+   * \param what the benchmark
+   * \param seconds the time taken
+   * \param packets the number of packets processed
+   */
+  void Report (std::string what, double seconds, uint32_t packets) const;
+};
+
+PacketTagBenchmarkTestCase::PacketTagBenchmarkTestCase ()
+  : TestCase ("Packet and byte tag churn")
+{
+}
+
+void
+PacketTagBenchmarkTestCase::Report (std::string what, double seconds, uint32_t packets) const
+{
+  std::cout << "packet-tag-perf: " << what << ": "
+            << 1e9 * seconds / packets << " ns/packet" << std::endl;
+}
+
+void
+PacketTagBenchmarkTestCase::DoRun (void)
+{
+  typedef std::chrono::steady_clock Clock;
+  const uint32_t packets = 200000;
+
+  // a socket tags the packet, which is copied by a queue, then the
+  // tags are read and removed by the lower layers
+  Ptr<Packet> packet = Create<Packet> (1000);
+  Clock::time_point start = Clock::now ();
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < packets; i++)
+    {
+      SocketPriorityTag priorityTag;
+      priorityTag.SetPriority (i & 0x7);
+      packet->AddPacketTag (priorityTag);
+      SocketIpTosTag tosTag;
+      tosTag.SetTos (0x10);
+      packet->AddPacketTag (tosTag);
+      packet->AddPacketTag (FlowIdTag (i));
+      Ptr<Packet> copy = packet->Copy ();
+      FlowIdTag flowIdTag;
+      found += copy->PeekPacketTag (flowIdTag) && flowIdTag.GetFlowId () == i;
+      found += copy->RemovePacketTag (priorityTag) && priorityTag.GetPriority () == (i & 0x7);
+      found += copy->RemovePacketTag (tosTag);
+      copy->ReplacePacketTag (flowIdTag);
+      packet->RemoveAllPacketTags ();
+    }
+  Report ("add, copy and remove packet tags", std::chrono::duration<double> (Clock::now () - start).count (), packets);
+  NS_TEST_ASSERT_MSG_EQ (found, 3 * packets, "The tags should be found");
+
+  // a tagged packet is fragmented and reassembled
+  start = Clock::now ();
+  found = 0;
+  for (uint32_t i = 0; i < packets; i++)
+    {
+      packet = Create<Packet> (1500);
+      packet->AddByteTag (FlowIdTag (i));
+      packet->AddPacketTag (FlowIdTag (i));
+      Ptr<Packet> reassembled = packet->CreateFragment (0, 500);
+      reassembled->AddAtEnd (packet->CreateFragment (500, 500));
+      reassembled->AddAtEnd (packet->CreateFragment (1000, 500));
+      FlowIdTag flowIdTag;
+      found += reassembled->FindFirstMatchingByteTag (flowIdTag) && flowIdTag.GetFlowId () == i;
+    }
+  Report ("fragment and reassemble a tagged packet", std::chrono::duration<double> (Clock::now () - start).count (), packets);
+  NS_TEST_ASSERT_MSG_EQ (found, packets, "The byte tags should be found");
+}
+
+/**
+ * \brief Packet tag performance test suite
+ */
+class PacketTagPerformanceSuite : public TestSuite
+{
+public:
+  PacketTagPerformanceSuite ();
+};
+
+PacketTagPerformanceSuite::PacketTagPerformanceSuite ()
+  : TestSuite ("packet-tag-perf", PERFORMANCE)
+{
+  AddTestCase (new PacketTagBenchmarkTestCase, TestCase::QUICK);
+}
+
+static PacketTagPerformanceSuite g_packetTagPerformanceSuite; //!< Static variable for test initialization
@@ -849,6 +849,37 @@ PacketTagListTest::DoRun (void)
 #   undef RemoveCheck
   }  // Removal
 
+  { // Inline and shared storage
+    std::cout << GetName () << "check inline and shared tags" << std::endl;
+    PacketTagList small;
+    small.Add (t1);
+    small.Add (t2);
+    PacketTagList copy = small;
+    copy.Remove (t1);
+    CheckRef (small, t1, "inline orig");
+    CheckRef (copy, t1, "inline copy", true);
+    CheckRef (copy, t2, "inline copy");
+
+    // grow past the inline storage, then shrink back into it
+    copy.Add (t5);
+    copy.Add (t6);
+    copy.Add (t7);
+    PacketTagList shared = copy;
+    shared.Remove (t7);
+    shared.Remove (t6);
+    CheckRef (copy, t7, "shared orig");
+    CheckRef (shared, t7, "shared copy", true);
+    CheckRef (shared, t5, "shared copy");
+
+    int n = 0;
+    for (const PacketTagList::TagData *cur = copy.Head (); cur != 0; cur = copy.Next (cur))
+      {
+        n++;
+      }
+    NS_TEST_EXPECT_MSG_EQ (n, 4, "iterate over the tags");
+    NS_TEST_EXPECT_MSG_EQ (copy.Head ()->tid, t7.GetInstanceTypeId (), "the last tag added is iterated first");
+  }
+
   { // Replace
 
     std::cout << GetName () << "check replacing each tag" << std::endl;
@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/pcap-file-wrapper.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+using namespace ns3;
+
+/**
+ * \brief Time the pcap traces written by PcapFileWrapper, with records
+ * written one by one, buffered, and written by a background thread.
+ */
+class PcapFileBenchmarkTestCase : public TestCase
+{
+public:
+  PcapFileBenchmarkTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Write a pcap trace.
+   * \param what the name of the write mode
+   * \param bufferSize the size of the record buffer
+   * \param async whether the buffers are written by a background thread
+   */
+  void WriteTrace (std::string what, uint32_t bufferSize, bool async);
+};
+
+PcapFileBenchmarkTestCase::PcapFileBenchmarkTestCase ()
+  : TestCase ("Pcap trace writes")
+{
+}
+
+void
+PcapFileBenchmarkTestCase::WriteTrace (std::string what, uint32_t bufferSize, bool async)
+{
+  typedef std::chrono::steady_clock Clock;
+  const uint32_t packets = 200000;
+  std::string filename = CreateTempDirFilename ("pcap-file-perf.pcap");
+
+  Ptr<PcapFileWrapper> file = CreateObject<PcapFileWrapper> ();
+  file->SetAttribute ("BufferSize", UintegerValue (bufferSize));
+  file->SetAttribute ("AsyncWrite", BooleanValue (async));
+  file->Open (filename, std::ios::out);
+  file->Init (1);
+  NS_TEST_ASSERT_MSG_EQ (file->Fail (), false, "The file should be created");
+
+  Ptr<Packet> packet = Create<Packet> (1000);
+  Clock::time_point start = Clock::now ();
+  for (uint32_t i = 0; i < packets; i++)
+    {
+      file->Write (MicroSeconds (10 * i), packet);
+    }
+  file->Close ();
+  double seconds = std::chrono::duration<double> (Clock::now () - start).count ();
+  NS_TEST_EXPECT_MSG_EQ (file->Fail (), false, "The packets should be written");
+  std::remove (filename.c_str ());
+
+  std::cout << "pcap-file-perf: " << what << ": "
+            << 1e9 * seconds / packets << " ns/packet" << std::endl;
+}
+
+void
+PcapFileBenchmarkTestCase::DoRun (void)
+{
+  WriteTrace ("write through", 0, false);
+  WriteTrace ("1 MiB buffer", 1 << 20, false);
+  WriteTrace ("1 MiB buffer, background thread", 1 << 20, true);
+}
+
+/**
+ * \brief Pcap file performance test suite
+ */
+class PcapFilePerformanceSuite : public TestSuite
+{
+public:
+  PcapFilePerformanceSuite ();
+};
+
+PcapFilePerformanceSuite::PcapFilePerformanceSuite ()
+  : TestSuite ("pcap-file-perf", PERFORMANCE)
+{
+  AddTestCase (new PcapFileBenchmarkTestCase, TestCase::QUICK);
+}
+
+static PcapFilePerformanceSuite g_pcapFilePerformanceSuite; //!< Static variable for test initialization
@@ -20,10 +20,13 @@
 #include <cstdio>
 #include <cstdlib>
 #include <sstream>
+#include <fstream>
 #include <cstring>
+#include <algorithm>
 
 #include "ns3/log.h"
 #include "ns3/test.h"
+#include "ns3/packet.h"
 #include "ns3/pcap-file.h"
 
 using namespace ns3;
@@ -1097,7 +1100,7 @@ DiffTestCase::DoRun (void)
   //
   // Create different PCAP file (with the same timestamps, but different packets) and check that it is indeed different 
   //
-  std::string filename2 = "different.pcap";
+  std::string filename2 = CreateTempDirFilename ("different.pcap");
   PcapFile f;
 
   f.Open (filename2, std::ios::out);
@@ -1119,6 +1122,114 @@ DiffTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (diff, true, "PcapDiff(file, file2) must be true");
   NS_TEST_EXPECT_MSG_EQ (sec,  2, "Files are different from 2.3696 seconds");
   NS_TEST_EXPECT_MSG_EQ (usec, 3696, "Files are different from 2.3696 seconds");
+  remove (filename2.c_str ());
+}
+
+// ===========================================================================
+// Test case to make sure that buffered and asynchronous writes produce the
+// same file as records written one by one.
+// ===========================================================================
+class BufferedWriteTestCase : public TestCase
+{
+public:
+  BufferedWriteTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Write a pcap file.
+   * \param filename the name of the file
+   * \param bufferSize the size of the record buffer
+   * \param async whether the buffers are written by a background thread
+   */
+  void WriteFile (std::string filename, uint32_t bufferSize, bool async);
+  /**
+   * Read a whole file.
+   * \param filename the name of the file
+   * \returns the contents of the file
+   */
+  std::string ReadFile (std::string filename);
+};
+
+BufferedWriteTestCase::BufferedWriteTestCase ()
+  : TestCase ("Check that buffered and asynchronous PcapFile writes produce the same file")
+{
+}
+
+void
+BufferedWriteTestCase::WriteFile (std::string filename, uint32_t bufferSize, bool async)
+{
+  PcapFile f;
+  f.Open (filename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << filename << ", \"std::ios::out\") returns error");
+  f.SetBufferSize (bufferSize);
+  f.SetAsyncWrite (async);
+  f.Init (1, 100);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Init (1, 100) returns error");
+
+  uint8_t data[128];
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      uint32_t size = 1 + (i * 7) % 128;
+      for (uint32_t j = 0; j < size; ++j)
+        {
+          data[j] = (i + j) & 0xff;
+        }
+      if (i % 2)
+        {
+          f.Write (i, 2 * i, data, size);
+        }
+      else
+        {
+          f.Write (i, 2 * i, Create<Packet> (data, size));
+        }
+      if (i == 500)
+        {
+          f.Flush ();
+          NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Flush () returns error");
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Write () returns error");
+  f.Close ();
+}
+
+std::string
+BufferedWriteTestCase::ReadFile (std::string filename)
+{
+  std::ifstream file (filename.c_str (), std::ios::binary);
+  std::ostringstream contents;
+  contents << file.rdbuf ();
+  return contents.str ();
+}
+
+void
+BufferedWriteTestCase::DoRun (void)
+{
+  std::string direct = CreateTempDirFilename ("direct.pcap");
+  std::string buffered = CreateTempDirFilename ("buffered.pcap");
+  std::string async = CreateTempDirFilename ("async.pcap");
+  WriteFile (direct, 0, false);
+  WriteFile (buffered, 1000, false);
+  WriteFile (async, 1000, true);
+
+  uint64_t length = 24;
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      length += 16 + std::min<uint32_t> (1 + (i * 7) % 128, 100);
+    }
+  NS_TEST_ASSERT_MSG_EQ (CheckFileLength (direct, length), true, "Incorrect length of the file");
+  std::string expected = ReadFile (direct);
+  NS_TEST_EXPECT_MSG_EQ ((ReadFile (buffered) == expected), true, "Buffered writes should produce the same file");
+  NS_TEST_EXPECT_MSG_EQ ((ReadFile (async) == expected), true, "Asynchronous writes should produce the same file");
+
+  uint32_t sec (0), usec (0), packets (0);
+  bool diff = PcapFile::Diff (direct, async, sec, usec, packets);
+  NS_TEST_EXPECT_MSG_EQ (diff, false, "Asynchronous writes should produce the same packets");
+  NS_TEST_EXPECT_MSG_EQ (packets, 1000, "All the packets should be written");
+
+  remove (direct.c_str ());
+  remove (buffered.c_str ());
+  remove (async.c_str ());
 }
 
 class PcapFileTestSuite : public TestSuite
@@ -1138,6 +1249,7 @@ PcapFileTestSuite::PcapFileTestSuite ()
   AddTestCase (new RecordHeaderTestCase, TestCase::QUICK);
   AddTestCase (new ReadFileTestCase, TestCase::QUICK);
   AddTestCase (new DiffTestCase, TestCase::QUICK);
+  AddTestCase (new BufferedWriteTestCase, TestCase::QUICK);
 }
 
 static PcapFileTestSuite pcapFileTestSuite;
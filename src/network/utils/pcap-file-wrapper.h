@@ -82,6 +82,12 @@ public:
    */
   void Close (void);
 
+  /**
+   * Write the records buffered according to the "BufferSize" attribute
+   * to the underlying pcap file and flush it.
+   */
+  void Flush (void);
+
   /**
    * Initialize the pcap file associated with this wrapper.  This file must have
    * been previously opened with write permissions.
@@ -224,6 +230,8 @@ private:
   PcapFile m_file; //!< Pcap file
   uint32_t m_snapLen; //!< max length of saved packets
   bool     m_nanosecMode; //!< Timestamps in nanosecond mode
+  uint32_t m_bufferSize; //!< size of the record buffer
+  bool     m_asyncWrite; //!< Write full buffers from a background thread
 };
 
 } // namespace ns3
@@ -50,7 +50,11 @@ const uint16_t VERSION_MINOR = 4;             /**< Minor version of supported pc
 PcapFile::PcapFile ()
   : m_file (),
     m_swapMode (false),
-    m_nanosecMode (false)
+    m_nanosecMode (false),
+    m_bufferSize (0),
+    m_async (false),
+    m_writing (false),
+    m_stop (false)
 {
   NS_LOG_FUNCTION (this);
   FatalImpl::RegisterStream (&m_file); 
@@ -68,18 +72,21 @@ bool
 PcapFile::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+  WaitForWriter ();
   return m_file.fail ();
 }
 bool 
 PcapFile::Eof (void) const
 {
   NS_LOG_FUNCTION (this);
+  WaitForWriter ();
   return m_file.eof ();
 }
 void 
 PcapFile::Clear (void)
 {
   NS_LOG_FUNCTION (this);
+  WaitForWriter ();
   m_file.clear ();
 }
 
@@ -88,9 +95,140 @@ void
 PcapFile::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  Flush ();
+  StopWriter ();
   m_file.close ();
 }
 
+void
+PcapFile::SetBufferSize (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  NS_ASSERT (m_buffer.empty ());
+  m_bufferSize = size;
+  m_buffer.reserve (size);
+}
+
+uint32_t
+PcapFile::GetBufferSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_bufferSize;
+}
+
+void
+PcapFile::SetAsyncWrite (bool async)
+{
+  NS_LOG_FUNCTION (this << async);
+  if (!async)
+    {
+      Flush ();
+      StopWriter ();
+    }
+  m_async = async;
+}
+
+void
+PcapFile::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_buffer.empty ())
+    {
+      WriteBuffer ();
+    }
+  WaitForWriter ();
+  if (m_file.is_open ())
+    {
+      m_file.flush ();
+    }
+}
+
+void
+PcapFile::WriteBuffer (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_async)
+    {
+      m_file.write ((const char *)&m_buffer[0], m_buffer.size ());
+      m_buffer.clear ();
+      return;
+    }
+
+  //
+  // Hand the full buffer over to the writer thread, and keep filling the
+  // buffer it wrote last.  The writer thread is the only one to touch
+  // the file stream until it is done with its buffer.
+  //
+  if (!m_writer.joinable ())
+    {
+      m_pending.reserve (m_bufferSize);
+      m_writer = std::thread (&PcapFile::RunWriter, this);
+    }
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (m_writing)
+    {
+      m_condition.wait (lock);
+    }
+  m_buffer.swap (m_pending);
+  m_writing = true;
+  lock.unlock ();
+  m_condition.notify_all ();
+}
+
+void
+PcapFile::WaitForWriter (void) const
+{
+  if (!m_writer.joinable ())
+    {
+      return;
+    }
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (m_writing)
+    {
+      m_condition.wait (lock);
+    }
+}
+
+void
+PcapFile::RunWriter (void)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (true)
+    {
+      while (!m_writing && !m_stop)
+        {
+          m_condition.wait (lock);
+        }
+      if (!m_writing)
+        {
+          return;
+        }
+      lock.unlock ();
+      m_file.write ((const char *)&m_pending[0], m_pending.size ());
+      m_pending.clear ();
+      lock.lock ();
+      m_writing = false;
+      m_condition.notify_all ();
+    }
+}
+
+void
+PcapFile::StopWriter (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_writer.joinable ())
+    {
+      return;
+    }
+  {
+    std::unique_lock<std::mutex> lock (m_mutex);
+    m_stop = true;
+  }
+  m_condition.notify_all ();
+  m_writer.join ();
+  m_stop = false;
+}
+
 uint32_t
 PcapFile::GetMagic (void)
 {
@@ -204,8 +342,9 @@ PcapFile::WriteFileHeader (void)
   NS_LOG_FUNCTION (this);
   //
   // If we're initializing the file, we need to write the pcap file header
-  // at the start of the file.
+  // at the start of the file, after any record still in flight.
   //
+  Flush ();
   m_file.seekp (0, std::ios::beg);
  
   //
@@ -326,6 +465,11 @@ PcapFile::Open (std::string const &filename, std::ios::openmode mode)
 {
   NS_LOG_FUNCTION (this << filename << mode);
   NS_ASSERT ((mode & std::ios::app) == 0);
+  //
+  // Records buffered for a previously opened file belong to that file.
+  //
+  Flush ();
+  StopWriter ();
   NS_ASSERT (!m_file.fail ());
   //
   // All pcap files are binary files, so we just do this automatically.
@@ -403,7 +547,7 @@ uint32_t
 PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << totalLen);
-  NS_ASSERT (m_file.good ());
+  NS_ASSERT (m_bufferSize > 0 || m_file.good ());
 
   uint32_t inclLen = totalLen > m_fileHeader.m_snapLen ? m_fileHeader.m_snapLen : totalLen;
 
@@ -422,21 +566,63 @@ PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
   // Watch out for memory alignment differences between machines, so write
   // them all individually.
   //
-  m_file.write ((const char *)&header.m_tsSec, sizeof(header.m_tsSec));
-  m_file.write ((const char *)&header.m_tsUsec, sizeof(header.m_tsUsec));
-  m_file.write ((const char *)&header.m_inclLen, sizeof(header.m_inclLen));
-  m_file.write ((const char *)&header.m_origLen, sizeof(header.m_origLen));
-  NS_BUILD_DEBUG(m_file.flush());
+  uint8_t buffer[16];
+  std::memcpy (buffer, &header.m_tsSec, sizeof(header.m_tsSec));
+  std::memcpy (buffer + 4, &header.m_tsUsec, sizeof(header.m_tsUsec));
+  std::memcpy (buffer + 8, &header.m_inclLen, sizeof(header.m_inclLen));
+  std::memcpy (buffer + 12, &header.m_origLen, sizeof(header.m_origLen));
+  WriteData (buffer, sizeof (buffer));
   return inclLen;
 }
 
+void
+PcapFile::WriteData (uint8_t const *data, uint32_t size)
+{
+  if (m_bufferSize == 0)
+    {
+      m_file.write ((const char *)data, size);
+    }
+  else
+    {
+      m_buffer.insert (m_buffer.end (), data, data + size);
+    }
+}
+
+void
+PcapFile::WritePacketData (Ptr<const Packet> p, uint32_t size)
+{
+  if (m_bufferSize == 0)
+    {
+      p->CopyData (&m_file, size);
+    }
+  else if (size > 0)
+    {
+      std::size_t offset = m_buffer.size ();
+      m_buffer.resize (offset + size);
+      p->CopyData (&m_buffer[offset], size);
+    }
+}
+
+void
+PcapFile::EndRecord (void)
+{
+  if (m_bufferSize == 0)
+    {
+      NS_BUILD_DEBUG (m_file.flush ());
+    }
+  else if (m_buffer.size () >= m_bufferSize)
+    {
+      WriteBuffer ();
+    }
+}
+
 void
 PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const * const data, uint32_t totalLen)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << &data << totalLen);
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalLen);
-  m_file.write ((const char *)data, inclLen);
-  NS_BUILD_DEBUG(m_file.flush());
+  WriteData (data, inclLen);
+  EndRecord ();
 }
 
 void 
@@ -444,8 +630,8 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << p);
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, p->GetSize ());
-  p->CopyData (&m_file, inclLen);
-  NS_BUILD_DEBUG(m_file.flush());
+  WritePacketData (p, inclLen);
+  EndRecord ();
 }
 
 void 
@@ -460,9 +646,19 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, const Header &header, Ptr<cons
   headerBuffer.AddAtStart (headerSize);
   header.Serialize (headerBuffer.Begin ());
   uint32_t toCopy = std::min (headerSize, inclLen);
-  headerBuffer.CopyData (&m_file, toCopy);
+  if (m_bufferSize == 0)
+    {
+      headerBuffer.CopyData (&m_file, toCopy);
+    }
+  else if (toCopy > 0)
+    {
+      std::size_t offset = m_buffer.size ();
+      m_buffer.resize (offset + toCopy);
+      headerBuffer.CopyData (&m_buffer[offset], toCopy);
+    }
   inclLen -= toCopy;
-  p->CopyData (&m_file, inclLen);
+  WritePacketData (p, inclLen);
+  EndRecord ();
 }
 
 void
@@ -23,6 +23,10 @@
 
 #include <string>
 #include <fstream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <stdint.h>
 #include "ns3/ptr.h"
 
@@ -38,6 +42,16 @@ class Header;
  * A class representing a pcap file.  This allows easy creation, writing and 
  * reading of files composed of stored packets; which may be viewed using
  * standard tools.
+ *
+ * By default, every record is written through to the underlying file
+ * stream as soon as it is received.  When a buffer size is set with
+ * SetBufferSize, the records are instead appended to a memory buffer
+ * which is written out as a whole once it is full, and, with
+ * SetAsyncWrite, full buffers are written by a background thread while
+ * the caller keeps filling another buffer.  Buffered records reach the
+ * file on Flush and Close.  They are lost on a fatal error: FatalImpl
+ * flushes the registered output streams, but records still in the
+ * buffer have not been handed to the stream yet.
  */
 class PcapFile
 {
@@ -51,6 +65,10 @@ public:
 
   /**
    * \return true if the 'fail' bit is set in the underlying iostream, false otherwise.
+   *
+   * The errors raised while writing buffered records are only reported
+   * once these records have been handed to the iostream, i.e., after
+   * the buffer filled up or after Flush.
    */
   bool Fail (void) const;
   /**
@@ -81,10 +99,43 @@ public:
   void Open (std::string const &filename, std::ios::openmode mode);
 
   /**
-   * Close the underlying file.
+   * Write the buffered records, if any, and close the underlying file.
    */
   void Close (void);
 
+  /**
+   * \brief Set the size of the memory buffer holding the records
+   * to write.
+   *
+   * The records are written to the underlying file once the buffer
+   * holds at least this many bytes.  A size of zero, the default,
+   * writes every record to the file as soon as it is received.  This
+   * must be called before the first record is written.
+   *
+   * \param size the size of the buffer, in bytes
+   */
+  void SetBufferSize (uint32_t size);
+
+  /**
+   * \return the size of the memory buffer holding the records to write
+   */
+  uint32_t GetBufferSize (void) const;
+
+  /**
+   * \brief Write the full buffers from a background thread.
+   *
+   * This only has an effect when a buffer size has been set.
+   *
+   * \param async whether the buffers are written by a background thread
+   */
+  void SetAsyncWrite (bool async);
+
+  /**
+   * \brief Write all the buffered records to the underlying file and
+   * flush it.
+   */
+  void Flush (void);
+
   /**
    * Initialize the pcap file associated with this object.  This file must have
    * been previously opened with write permissions.
@@ -361,6 +412,40 @@ private:
    */
   uint32_t WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen);
 
+  /**
+   * \brief Write part of a record, to the buffer if there is one and to
+   * the file otherwise
+   * \param data the bytes to write
+   * \param size the number of bytes to write
+   */
+  void WriteData (uint8_t const *data, uint32_t size);
+  /**
+   * \brief Write the payload of a record
+   * \param p the packet holding the payload
+   * \param size the number of bytes of the packet to write
+   */
+  void WritePacketData (Ptr<const Packet> p, uint32_t size);
+  /**
+   * \brief Complete a record, writing the buffer out if it is full
+   */
+  void EndRecord (void);
+  /**
+   * \brief Hand the buffered records to the file or to the writer thread
+   */
+  void WriteBuffer (void);
+  /**
+   * \brief Wait until the writer thread has written its records, if any
+   */
+  void WaitForWriter (void) const;
+  /**
+   * \brief Body of the writer thread
+   */
+  void RunWriter (void);
+  /**
+   * \brief Stop the writer thread, if any
+   */
+  void StopWriter (void);
+
   /**
    * \brief Read and verify a Pcap file header
    */
@@ -371,6 +456,16 @@ private:
   PcapFileHeader m_fileHeader;  //!< file header
   bool m_swapMode;              //!< swap mode
   bool m_nanosecMode;           //!< nanosecond timestamp mode
+
+  uint32_t m_bufferSize;           //!< size of the record buffer, 0 to write through
+  bool m_async;                    //!< whether full buffers are written by m_writer
+  std::vector<uint8_t> m_buffer;   //!< records not handed to the file yet
+  std::vector<uint8_t> m_pending;  //!< records being written by m_writer
+  bool m_writing;                  //!< whether m_pending is being written, guarded by m_mutex
+  bool m_stop;                     //!< whether m_writer must exit, guarded by m_mutex
+  std::thread m_writer;            //!< background writer thread
+  mutable std::mutex m_mutex;      //!< protects m_writing and m_stop
+  mutable std::condition_variable m_condition; //!< signals changes of m_writing and m_stop
 };
 
 } // namespace ns3
@@ -20,7 +20,9 @@
 #include "point-to-point-net-device.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/packet.h"
+#include "ns3/node.h"
 #include "ns3/simulator.h"
+#include "ns3/multithreaded-simulator-impl.h"
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -80,9 +82,25 @@ PointToPointChannel::Attach (Ptr<PointToPointNetDevice> device)
       m_link[1].m_dst = m_link[0].m_src;
       m_link[0].m_state = IDLE;
       m_link[1].m_state = IDLE;
+      GetDestinationNodeId (0);
+      GetDestinationNodeId (1);
     }
 }
 
+uint32_t
+PointToPointChannel::GetDestinationNodeId (uint32_t wire)
+{
+  if (m_link[wire].m_dstNodeId == Simulator::NO_CONTEXT)
+    {
+      Ptr<Node> node = m_link[wire].m_dst->GetNode ();
+      if (node != 0)
+        {
+          m_link[wire].m_dstNodeId = node->GetId ();
+        }
+    }
+  return m_link[wire].m_dstNodeId;
+}
+
 bool
 PointToPointChannel::TransmitStart (
   Ptr<Packet> p,
@@ -97,12 +115,19 @@ PointToPointChannel::TransmitStart (
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
-  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+  // The receiver may be simulated by another thread: the event does not
+  // hold a reference to the receiving device, and the packet is copied
+  // unless the simulation runs on a single thread
+  Simulator::ScheduleWithContext (GetDestinationNodeId (wire),
                                   txTime + m_delay, &PointToPointNetDevice::Receive,
-                                  m_link[wire].m_dst, p);
+                                  PeekPointer (m_link[wire].m_dst),
+                                  MultithreadedSimulatorImpl::IsInUse () ? p->Copy () : p);
 
   // Call the tx anim callback on the net device
-  m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
+  if (!m_txrxPointToPoint.IsEmpty ())
+    {
+      m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
+    }
   return true;
 }
 
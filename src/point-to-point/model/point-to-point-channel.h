@@ -25,6 +25,7 @@
 #include "ns3/nstime.h"
 #include "ns3/data-rate.h"
 #include "ns3/traced-callback.h"
+#include "ns3/simulator.h"
 
 namespace ns3 {
 
@@ -194,13 +195,26 @@ public:
     /** \brief Create the link, it will be in INITIALIZING state
      *
      */
-    Link() : m_state (INITIALIZING), m_src (0), m_dst (0) {}
+    Link() : m_state (INITIALIZING), m_src (0), m_dst (0), m_dstNodeId (Simulator::NO_CONTEXT) {}
 
     WireState                  m_state; //!< State of the link
     Ptr<PointToPointNetDevice> m_src;   //!< First NetDevice
     Ptr<PointToPointNetDevice> m_dst;   //!< Second NetDevice
+    uint32_t                   m_dstNodeId; //!< Id of the Node of the second NetDevice, if known
   };
 
+  /**
+   * \brief Get the id of the Node receiving the packets sent on a wire
+   *
+   * The id is cached so that the transmission of a packet does not
+   * reference the receiving Node, which may be simulated by another
+   * thread (see MultithreadedSimulatorImpl).
+   *
+   * \param wire The wire
+   * \returns The Node id
+   */
+  uint32_t GetDestinationNodeId (uint32_t wire);
+
   Link    m_link[N_DEVICES]; //!< Link model
 };
 
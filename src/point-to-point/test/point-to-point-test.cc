@@ -23,6 +23,13 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 using namespace ns3;
 
@@ -100,6 +107,162 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test class for the PointToPoint model with MultithreadedSimulatorImpl
+ *
+ * Packets are forwarded in both directions along a chain of nodes
+ * connected by PointToPointChannels with different delays. The packets
+ * received by each node must be the same as with DefaultSimulatorImpl.
+ */
+class PointToPointMultithreadedTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointMultithreadedTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  virtual void DoTeardown (void);
+
+  /** The packets received by a node: (time, size) */
+  typedef std::vector<std::pair<int64_t, uint32_t> > Log;
+
+  /**
+   * \brief Run the simulation with a simulator implementation
+   *
+   * \param simulatorType The simulator implementation
+   * \returns The packets received by each node
+   */
+  std::vector<Log> RunSimulation (std::string simulatorType);
+
+  /**
+   * \brief Receive a packet and forward it to the next node
+   *
+   * \param device The receiving device
+   * \param packet The packet
+   * \param protocol The protocol number
+   * \param from The sender address
+   * \returns true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  /**
+   * \brief Send packets from a node
+   *
+   * \param device The sending device
+   * \param size The size of the packet
+   */
+  void Send (Ptr<PointToPointNetDevice> device, uint32_t size);
+
+  /** Number of nodes */
+  static const uint32_t N_NODES = 6;
+  /** The devices, for each node: towards the first node and towards the last node */
+  std::vector<std::pair<Ptr<PointToPointNetDevice>, Ptr<PointToPointNetDevice> > > m_devices;
+  std::vector<Log> m_logs; //!< The packets received by each node
+};
+
+PointToPointMultithreadedTest::PointToPointMultithreadedTest ()
+  : TestCase ("PointToPoint with MultithreadedSimulatorImpl")
+{
+}
+
+bool
+PointToPointMultithreadedTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  uint32_t node = device->GetNode ()->GetId ();
+  m_logs[node].push_back (std::make_pair (Simulator::Now ().GetTimeStep (), packet->GetSize ()));
+  // forward the packet away from the device it was received from
+  Ptr<PointToPointNetDevice> next = device == m_devices[node].first ? m_devices[node].second : m_devices[node].first;
+  if (next != 0)
+    {
+      next->Send (packet->Copy (), next->GetBroadcast (), 0x800);
+    }
+  return true;
+}
+
+void
+PointToPointMultithreadedTest::Send (Ptr<PointToPointNetDevice> device, uint32_t size)
+{
+  device->Send (Create<Packet> (size), device->GetBroadcast (), 0x800);
+}
+
+std::vector<PointToPointMultithreadedTest::Log>
+PointToPointMultithreadedTest::RunSimulation (std::string simulatorType)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (simulatorType));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (3));
+  m_logs.assign (N_NODES, Log ());
+  m_devices.assign (N_NODES, std::make_pair (Ptr<PointToPointNetDevice> (), Ptr<PointToPointNetDevice> ()));
+
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      nodes.push_back (CreateObject<Node> ());
+    }
+  for (uint32_t i = 0; i + 1 < N_NODES; i++)
+    {
+      Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (MicroSeconds (2 + i)));
+      Ptr<PointToPointNetDevice> devices[2];
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          devices[j] = CreateObject<PointToPointNetDevice> ();
+          devices[j]->SetAttribute ("DataRate", StringValue ("100Mbps"));
+          devices[j]->SetAddress (Mac48Address::Allocate ());
+          devices[j]->SetQueue (CreateObject<DropTailQueue> ());
+          nodes[i + j]->AddDevice (devices[j]);
+          devices[j]->Attach (channel);
+          devices[j]->SetReceiveCallback (MakeCallback (&PointToPointMultithreadedTest::Receive, this));
+          Ptr<NetDeviceQueueInterface> iface = CreateObject<NetDeviceQueueInterface> ();
+          devices[j]->AggregateObject (iface);
+          iface->CreateTxQueues ();
+        }
+      m_devices[i].second = devices[0];
+      m_devices[i + 1].first = devices[1];
+    }
+
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Simulator::ScheduleWithContext (0, MicroSeconds (10 * i), &PointToPointMultithreadedTest::Send,
+                                      this, m_devices[0].second, 100 + i);
+      Simulator::ScheduleWithContext (N_NODES - 1, MicroSeconds (7 * i), &PointToPointMultithreadedTest::Send,
+                                      this, m_devices[N_NODES - 1].first, 1000 + i);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_devices.clear ();
+  return m_logs;
+}
+
+void
+PointToPointMultithreadedTest::DoRun (void)
+{
+  std::vector<Log> expected = RunSimulation ("ns3::DefaultSimulatorImpl");
+  std::vector<Log> logs = RunSimulation ("ns3::MultithreadedSimulatorImpl");
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      // the end nodes only receive the packets sent from the other end
+      uint32_t nPackets = (i == 0 || i == N_NODES - 1) ? 100 : 200;
+      NS_TEST_ASSERT_MSG_EQ (expected[i].size (), nPackets, "Wrong number of packets received by node " << i);
+      std::sort (expected[i].begin (), expected[i].end ());
+      std::sort (logs[i].begin (), logs[i].end ());
+      NS_TEST_ASSERT_MSG_EQ ((logs[i] == expected[i]), true, "Wrong packets received by node " << i);
+    }
+}
+
+void
+PointToPointMultithreadedTest::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (0));
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -116,6 +279,7 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointMultithreadedTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
@@ -20,6 +20,8 @@
 
 #include "jakes-propagation-loss-model.h"
 #include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
 #include "ns3/log.h"
 
 namespace ns3
@@ -47,6 +49,33 @@ JakesPropagationLossModel::GetTypeId ()
     .SetParent<PropagationLossModel> ()
     .SetGroupName ("Propagation")
     .AddConstructor<JakesPropagationLossModel> ()
+    .AddAttribute ("CacheSize",
+                   "The maximum number of paths whose fading process is kept, or 0 for no limit. "
+                   "When the limit is reached, the fading process of an evicted path is "
+                   "started again the next time the path is used.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&JakesPropagationLossModel::SetCacheSize,
+                                         &JakesPropagationLossModel::GetCacheSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("CacheEvictionPolicy",
+                   "The policy used to choose the path evicted when the cache is full.",
+                   EnumValue (PropagationCache<JakesProcess>::LRU),
+                   MakeEnumAccessor (&JakesPropagationLossModel::SetCacheEvictionPolicy,
+                                     &JakesPropagationLossModel::GetCacheEvictionPolicy),
+                   MakeEnumChecker (PropagationCache<JakesProcess>::LRU, "Lru",
+                                    PropagationCache<JakesProcess>::CLOCK, "Clock"))
+    .AddAttribute ("CacheHits",
+                   "The number of path lookups which found a cached fading process.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0), // this value is ignored because there is no setter
+                   MakeUintegerAccessor (&JakesPropagationLossModel::GetCacheHits),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("CacheMisses",
+                   "The number of path lookups which created a new fading process.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0), // this value is ignored because there is no setter
+                   MakeUintegerAccessor (&JakesPropagationLossModel::GetCacheMisses),
+                   MakeUintegerChecker<uint64_t> ())
   ;
   return tid;
 }
@@ -72,6 +101,42 @@ JakesPropagationLossModel::GetUniformRandomVariable () const
   return m_uniformVariable;
 }
 
+void
+JakesPropagationLossModel::SetCacheSize (uint32_t size)
+{
+  m_propagationCache.SetMaxSize (size);
+}
+
+uint32_t
+JakesPropagationLossModel::GetCacheSize (void) const
+{
+  return m_propagationCache.GetMaxSize ();
+}
+
+void
+JakesPropagationLossModel::SetCacheEvictionPolicy (PropagationCache<JakesProcess>::EvictionPolicy policy)
+{
+  m_propagationCache.SetEvictionPolicy (policy);
+}
+
+PropagationCache<JakesProcess>::EvictionPolicy
+JakesPropagationLossModel::GetCacheEvictionPolicy (void) const
+{
+  return m_propagationCache.GetEvictionPolicy ();
+}
+
+uint64_t
+JakesPropagationLossModel::GetCacheHits (void) const
+{
+  return m_propagationCache.GetHits ();
+}
+
+uint64_t
+JakesPropagationLossModel::GetCacheMisses (void) const
+{
+  return m_propagationCache.GetMisses ();
+}
+
 int64_t
 JakesPropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -43,7 +43,16 @@ public:
   static TypeId GetTypeId ();
   JakesPropagationLossModel ();
   virtual ~JakesPropagationLossModel ();
-  
+
+  /**
+   * \return the number of path lookups which found a cached fading process
+   */
+  uint64_t GetCacheHits (void) const;
+  /**
+   * \return the number of path lookups which created a new fading process
+   */
+  uint64_t GetCacheMisses (void) const;
+
 private:
   friend class JakesProcess;
 
@@ -71,6 +80,25 @@ private:
    */
   Ptr<UniformRandomVariable> GetUniformRandomVariable () const;
 
+  /**
+   * Set the maximum number of paths whose fading process is kept.
+   * \param size the maximum number of paths, or 0 for no limit
+   */
+  void SetCacheSize (uint32_t size);
+  /**
+   * \return the maximum number of paths whose fading process is kept
+   */
+  uint32_t GetCacheSize (void) const;
+  /**
+   * Set the policy used to choose the path evicted from a full cache.
+   * \param policy the eviction policy
+   */
+  void SetCacheEvictionPolicy (PropagationCache<JakesProcess>::EvictionPolicy policy);
+  /**
+   * \return the policy used to choose the path evicted from a full cache
+   */
+  PropagationCache<JakesProcess>::EvictionPolicy GetCacheEvictionPolicy (void) const;
+
   Ptr<UniformRandomVariable> m_uniformVariable; //!< random stream
   mutable PropagationCache<JakesProcess> m_propagationCache; //!< Propagation cache
 };
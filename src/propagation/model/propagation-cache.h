@@ -21,7 +21,11 @@
 #define PROPAGATION_CACHE_H_
 
 #include "ns3/mobility-model.h"
-#include <map>
+#include <unordered_map>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <stdint.h>
 
 namespace ns3
 {
@@ -30,12 +34,35 @@ namespace ns3
  * \brief Constructs a cache of objects, where each object is responsible for a single propagation path loss calculations.
  * Propagation path a-->b and b-->a is the same thing. Propagation path is identified by
  * a couple of MobilityModels and a spectrum model UID
+ *
+ * Paths are looked up in a hash table. By default the cache grows
+ * without limit; when a maximum size is set, adding a path to a full
+ * cache evicts another one, chosen either as the least recently used
+ * path (LRU) or by the CLOCK approximation of it, which only marks the
+ * paths on lookup. An evicted path is simply created again the next
+ * time it is needed.
  */
 template<class T>
 class PropagationCache
 {
 public:
-  PropagationCache () {};
+  /// The policy used to choose the path evicted from a full cache
+  enum EvictionPolicy
+  {
+    LRU,  //!< Evict the least recently used path
+    CLOCK //!< Evict the first path not used since the clock hand last passed it
+  };
+
+  PropagationCache ()
+    : m_maxSize (0),
+      m_policy (LRU),
+      m_head (NONE),
+      m_tail (NONE),
+      m_hand (0),
+      m_hits (0),
+      m_misses (0),
+      m_evictions (0)
+  {};
   ~PropagationCache () {};
 
   /**
@@ -48,12 +75,15 @@ public:
   Ptr<T> GetPathData (Ptr<const MobilityModel> a, Ptr<const MobilityModel> b, uint32_t modelUid)
   {
     PropagationPathIdentifier key = PropagationPathIdentifier (a, b, modelUid);
-    typename PathCache::iterator it = m_pathCache.find (key);
-    if (it == m_pathCache.end ())
+    typename PathIndex::iterator it = m_pathIndex.find (key);
+    if (it == m_pathIndex.end ())
       {
+        m_misses++;
         return 0;
       }
-    return it->second;
+    m_hits++;
+    Touch (it->second);
+    return m_entries[it->second].m_data;
   };
 
   /**
@@ -66,61 +96,287 @@ public:
   void AddPathData (Ptr<T> data, Ptr<const MobilityModel> a, Ptr<const MobilityModel> b, uint32_t modelUid)
   {
     PropagationPathIdentifier key = PropagationPathIdentifier (a, b, modelUid);
-    NS_ASSERT (m_pathCache.find (key) == m_pathCache.end ());
-    m_pathCache.insert (std::make_pair (key, data)); 
+    NS_ASSERT (m_pathIndex.find (key) == m_pathIndex.end ());
+    uint32_t index;
+    if (m_maxSize != 0 && m_entries.size () >= m_maxSize)
+      {
+        index = Evict ();
+        m_entries[index].m_key = key;
+        m_entries[index].m_data = data;
+        m_entries[index].m_referenced = false;
+      }
+    else
+      {
+        index = m_entries.size ();
+        m_entries.push_back (Entry (key, data));
+      }
+    if (m_policy == LRU)
+      {
+        LinkFront (index);
+      }
+    m_pathIndex.insert (std::make_pair (key, index));
+  };
+
+  /**
+   * Set the maximum number of paths in the cache. Changing the
+   * maximum size of a non-empty cache clears it.
+   * \param maxSize the maximum number of paths, or 0 for no limit
+   */
+  void SetMaxSize (uint32_t maxSize)
+  {
+    if (maxSize != m_maxSize)
+      {
+        Clear ();
+        m_maxSize = maxSize;
+      }
+  };
+
+  /**
+   * \return the maximum number of paths in the cache, or 0 for no limit
+   */
+  uint32_t GetMaxSize (void) const
+  {
+    return m_maxSize;
+  };
+
+  /**
+   * Set the eviction policy. Changing the policy of a non-empty cache
+   * clears it.
+   * \param policy the eviction policy
+   */
+  void SetEvictionPolicy (EvictionPolicy policy)
+  {
+    if (policy != m_policy)
+      {
+        Clear ();
+        m_policy = policy;
+      }
+  };
+
+  /**
+   * \return the eviction policy
+   */
+  EvictionPolicy GetEvictionPolicy (void) const
+  {
+    return m_policy;
+  };
+
+  /**
+   * \return the number of paths in the cache
+   */
+  uint32_t GetSize (void) const
+  {
+    return m_entries.size ();
+  };
+
+  /**
+   * \return the number of lookups which found their path
+   */
+  uint64_t GetHits (void) const
+  {
+    return m_hits;
+  };
+
+  /**
+   * \return the number of lookups which did not find their path
+   */
+  uint64_t GetMisses (void) const
+  {
+    return m_misses;
+  };
+
+  /**
+   * \return the number of paths evicted to make room for new ones
+   */
+  uint64_t GetEvictions (void) const
+  {
+    return m_evictions;
+  };
+
+  /**
+   * Remove all the paths from the cache. The counters are kept.
+   */
+  void Clear (void)
+  {
+    m_pathIndex.clear ();
+    m_entries.clear ();
+    m_head = NONE;
+    m_tail = NONE;
+    m_hand = 0;
   };
+
 private:
   /// Each path is identified by
   struct PropagationPathIdentifier
   {
     /**
-     * Constructor
+     * Constructor. Links are supposed to be symmetrical, so the two
+     * mobility models are stored in a canonical order.
      * @param a 1st node mobility model
      * @param b 2nd node mobility model
      * @param modelUid model UID
      */
     PropagationPathIdentifier (Ptr<const MobilityModel> a, Ptr<const MobilityModel> b, uint32_t modelUid) :
-      m_srcMobility (a), m_dstMobility (b), m_spectrumModelUid (modelUid)
+      m_srcMobility (std::min (a, b)), m_dstMobility (std::max (a, b)), m_spectrumModelUid (modelUid)
     {};
     Ptr<const MobilityModel> m_srcMobility; //!< 1st node mobility model
     Ptr<const MobilityModel> m_dstMobility; //!< 2nd node mobility model
     uint32_t m_spectrumModelUid; //!< model UID
 
     /**
-     * Less-than operator.
-     *
-     * The goal of this operator is just to provide a stable comparison
-     * to be used in containers requiring a order (of any kind).
-     *
-     * If the models are different, the comparison is based on their Uid.
-     * Otherwise, the comparison is based on the pointers of the Mobility models.
-     *
+     * Equality operator.
      * \param other Right value of the operator.
-     * \returns True if the Left value is less than the Right value.
+     * \returns True if both identify the same path.
      */
-    bool operator < (const PropagationPathIdentifier & other) const
+    bool operator == (const PropagationPathIdentifier & other) const
     {
-      if (m_spectrumModelUid != other.m_spectrumModelUid)
-        {
-          return m_spectrumModelUid < other.m_spectrumModelUid;
-        }
-      /// Links are supposed to be symmetrical!
-      if (std::min (m_dstMobility, m_srcMobility) != std::min (other.m_dstMobility, other.m_srcMobility))
-        {
-          return std::min (m_dstMobility, m_srcMobility) < std::min (other.m_dstMobility, other.m_srcMobility);
-        }
-      if (std::max (m_dstMobility, m_srcMobility) != std::max (other.m_dstMobility, other.m_srcMobility))
-        {
-          return std::max (m_dstMobility, m_srcMobility) < std::max (other.m_dstMobility, other.m_srcMobility);
-        }
-      return false;
+      return m_spectrumModelUid == other.m_spectrumModelUid
+             && m_srcMobility == other.m_srcMobility
+             && m_dstMobility == other.m_dstMobility;
     }
   };
 
-  /// Typedef: PropagationPathIdentifier, Ptr<T>
-  typedef std::map<PropagationPathIdentifier, Ptr<T> > PathCache;
-private:
-  PathCache m_pathCache; //!< Path cache
+  /// Hash function of a PropagationPathIdentifier
+  struct PropagationPathIdentifierHash
+  {
+    /**
+     * \param key the path
+     * \returns the hash of the path
+     */
+    std::size_t operator () (const PropagationPathIdentifier & key) const
+    {
+      std::hash<const MobilityModel *> hasher;
+      std::size_t h = hasher (PeekPointer (key.m_srcMobility));
+      h ^= hasher (PeekPointer (key.m_dstMobility)) + 0x9e3779b9 + (h << 6) + (h >> 2);
+      h ^= key.m_spectrumModelUid + 0x9e3779b9 + (h << 6) + (h >> 2);
+      return h;
+    }
+  };
+
+  /// A path in the cache
+  struct Entry
+  {
+    /**
+     * Constructor
+     * \param key the path
+     * \param data the model associated to the path
+     */
+    Entry (const PropagationPathIdentifier & key, Ptr<T> data)
+      : m_key (key), m_data (data), m_referenced (false), m_prev (NONE), m_next (NONE)
+    {};
+    PropagationPathIdentifier m_key; //!< the path
+    Ptr<T> m_data;                   //!< the model associated to the path
+    bool m_referenced;               //!< CLOCK: looked up since the hand last passed
+    uint32_t m_prev;                 //!< LRU: the more recently used entry
+    uint32_t m_next;                 //!< LRU: the less recently used entry
+  };
+
+  /// Typedef: index of the entry of each path
+  typedef std::unordered_map<PropagationPathIdentifier, uint32_t, PropagationPathIdentifierHash> PathIndex;
+
+  static const uint32_t NONE = 0xffffffff; //!< Invalid entry index
+
+  /**
+   * Record that an entry was used.
+   * \param index the entry
+   */
+  void Touch (uint32_t index)
+  {
+    if (m_policy == CLOCK)
+      {
+        m_entries[index].m_referenced = true;
+      }
+    else if (index != m_head)
+      {
+        Unlink (index);
+        LinkFront (index);
+      }
+  };
+
+  /**
+   * Remove the entry chosen by the eviction policy from the index.
+   * \returns the index of the entry, to be reused
+   */
+  uint32_t Evict (void)
+  {
+    uint32_t victim;
+    if (m_policy == CLOCK)
+      {
+        while (m_entries[m_hand].m_referenced)
+          {
+            m_entries[m_hand].m_referenced = false;
+            m_hand = (m_hand + 1) % m_entries.size ();
+          }
+        victim = m_hand;
+        m_hand = (m_hand + 1) % m_entries.size ();
+      }
+    else
+      {
+        victim = m_tail;
+        Unlink (victim);
+      }
+    m_pathIndex.erase (m_entries[victim].m_key);
+    m_evictions++;
+    return victim;
+  };
+
+  /**
+   * LRU: remove an entry from the recency list.
+   * \param index the entry
+   */
+  void Unlink (uint32_t index)
+  {
+    Entry &entry = m_entries[index];
+    if (entry.m_prev != NONE)
+      {
+        m_entries[entry.m_prev].m_next = entry.m_next;
+      }
+    else
+      {
+        m_head = entry.m_next;
+      }
+    if (entry.m_next != NONE)
+      {
+        m_entries[entry.m_next].m_prev = entry.m_prev;
+      }
+    else
+      {
+        m_tail = entry.m_prev;
+      }
+    entry.m_prev = NONE;
+    entry.m_next = NONE;
+  };
+
+  /**
+   * LRU: insert an entry at the front of the recency list.
+   * \param index the entry
+   */
+  void LinkFront (uint32_t index)
+  {
+    Entry &entry = m_entries[index];
+    entry.m_prev = NONE;
+    entry.m_next = m_head;
+    if (m_head != NONE)
+      {
+        m_entries[m_head].m_prev = index;
+      }
+    m_head = index;
+    if (m_tail == NONE)
+      {
+        m_tail = index;
+      }
+  };
+
+  PathIndex m_pathIndex;         //!< Path index
+  std::vector<Entry> m_entries;  //!< Cached paths
+  uint32_t m_maxSize;            //!< Maximum number of paths, 0 for no limit
+  EvictionPolicy m_policy;       //!< Eviction policy
+  uint32_t m_head;               //!< LRU: most recently used entry
+  uint32_t m_tail;               //!< LRU: least recently used entry
+  uint32_t m_hand;               //!< CLOCK: next entry considered for eviction
+  uint64_t m_hits;               //!< Number of lookups which found their path
+  uint64_t m_misses;             //!< Number of lookups which did not find their path
+  uint64_t m_evictions;          //!< Number of evicted paths
 };
 } // namespace ns3
 
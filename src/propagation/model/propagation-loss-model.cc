@@ -29,6 +29,8 @@
 #include "ns3/string.h"
 #include "ns3/pointer.h"
 #include <cmath>
+#include <algorithm>
+#include <limits>
 
 namespace ns3 {
 
@@ -82,6 +84,58 @@ PropagationLossModel::CalcRxPower (double txPowerDbm,
   return self;
 }
 
+double
+PropagationLossModel::GetMinLossDb (double distance) const
+{
+  double self = DoGetMinLossDb (distance);
+  if (m_next != 0)
+    {
+      self += m_next->GetMinLossDb (distance);
+    }
+  return self;
+}
+
+double
+PropagationLossModel::GetMaxRange (double maxLossDb) const
+{
+  NS_LOG_FUNCTION (this << maxLossDb);
+  const double maxDistance = 1e8;
+  if (!(GetMinLossDb (maxDistance) > maxLossDb))
+    {
+      return std::numeric_limits<double>::infinity ();
+    }
+  // the bound does not decrease with the distance: find an interval
+  // [low, high] such that the bound is exceeded at high but not at low,
+  // then bisect it
+  double low = 0;
+  double high = 1;
+  while (!(GetMinLossDb (high) > maxLossDb))
+    {
+      low = high;
+      high *= 2;
+    }
+  for (uint32_t i = 0; i < 64 && high - low > 1e-3; i++)
+    {
+      double mid = (low + high) / 2;
+      if (GetMinLossDb (mid) > maxLossDb)
+        {
+          high = mid;
+        }
+      else
+        {
+          low = mid;
+        }
+    }
+  NS_LOG_DEBUG ("maximum range=" << high << "m for a loss of " << maxLossDb << "dB");
+  return high;
+}
+
+double
+PropagationLossModel::DoGetMinLossDb (double distance) const
+{
+  return -std::numeric_limits<double>::infinity ();
+}
+
 int64_t
 PropagationLossModel::AssignStreams (int64_t stream)
 {
@@ -271,6 +325,18 @@ FriisPropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm - std::max (lossDb, m_minLoss);
 }
 
+double
+FriisPropagationLossModel::DoGetMinLossDb (double distance) const
+{
+  if (distance <= 0)
+    {
+      return m_minLoss;
+    }
+  double numerator = m_lambda * m_lambda;
+  double denominator = 16 * M_PI * M_PI * distance * distance * m_systemLoss;
+  return std::max (-10 * log10 (numerator / denominator), m_minLoss);
+}
+
 int64_t
 FriisPropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -534,6 +600,16 @@ LogDistancePropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm + rxc;
 }
 
+double
+LogDistancePropagationLossModel::DoGetMinLossDb (double distance) const
+{
+  if (distance <= m_referenceDistance)
+    {
+      return m_referenceLoss;
+    }
+  return m_referenceLoss + 10 * m_exponent * std::log10 (distance / m_referenceDistance);
+}
+
 int64_t
 LogDistancePropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -636,6 +712,26 @@ ThreeLogDistancePropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm - pathLossDb;
 }
 
+double
+ThreeLogDistancePropagationLossModel::DoGetMinLossDb (double distance) const
+{
+  if (distance < m_distance0)
+    {
+      return 0;
+    }
+  double pathLossDb = m_referenceLoss
+    + 10 * m_exponent0 * std::log10 (std::min (distance, m_distance1) / m_distance0);
+  if (distance >= m_distance1)
+    {
+      pathLossDb += 10 * m_exponent1 * std::log10 (std::min (distance, m_distance2) / m_distance1);
+    }
+  if (distance >= m_distance2)
+    {
+      pathLossDb += 10 * m_exponent2 * std::log10 (distance / m_distance2);
+    }
+  return pathLossDb;
+}
+
 int64_t
 ThreeLogDistancePropagationLossModel::DoAssignStreams (int64_t stream)
 {
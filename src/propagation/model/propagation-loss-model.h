@@ -93,6 +93,32 @@ public:
                       Ptr<MobilityModel> a,
                       Ptr<MobilityModel> b) const;
 
+  /**
+   * Returns a lower bound of the loss between any two positions separated
+   * by the given distance, taking into account all the
+   * PropagationLossModel(s) chained to the current one.
+   *
+   * The bound is used to find how far a signal can travel, hence it must
+   * not decrease with the distance. A model which cannot bound its loss
+   * (e.g., a random fading model, whose loss may be negative) returns
+   * minus infinity, which is the default.
+   *
+   * \param distance the distance between the transmitter and the receiver (in meters)
+   * \returns the minimum loss (in dB)
+   */
+  double GetMinLossDb (double distance) const;
+
+  /**
+   * Returns the distance beyond which the loss computed by GetMinLossDb
+   * is larger than the given loss, taking into account all the
+   * PropagationLossModel(s) chained to the current one.
+   *
+   * \param maxLossDb the maximum loss (in dB)
+   * \returns the maximum range (in meters), or infinity if the loss
+   * cannot be bounded or if it is not reached within 100,000 km
+   */
+  double GetMaxRange (double maxLossDb) const;
+
   /**
    * If this loss model uses objects of type RandomVariableStream,
    * set the stream numbers to the integers starting with the offset
@@ -140,6 +166,15 @@ private:
    */
   virtual int64_t DoAssignStreams (int64_t stream) = 0;
 
+  /**
+   * Returns a lower bound of the loss of this particular
+   * PropagationLossModel, minus infinity by default.
+   *
+   * \param distance the distance between the transmitter and the receiver (in meters)
+   * \returns the minimum loss (in dB)
+   */
+  virtual double DoGetMinLossDb (double distance) const;
+
   Ptr<PropagationLossModel> m_next; //!< Next propagation loss model in the list
 };
 
@@ -322,6 +357,7 @@ private:
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual double DoGetMinLossDb (double distance) const;
 
   /**
    * Transforms a Dbm value to Watt
@@ -530,6 +566,7 @@ private:
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual double DoGetMinLossDb (double distance) const;
 
   /**
    *  Creates a default reference loss model
@@ -613,6 +650,7 @@ private:
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual double DoGetMinLossDb (double distance) const;
 
   double m_distance0; //!< Beginning of the first (near) distance field
   double m_distance1; //!< Beginning of the second (middle) distance field.
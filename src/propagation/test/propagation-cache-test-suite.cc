@@ -0,0 +1,288 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/propagation-cache.h"
+#include "ns3/jakes-propagation-loss-model.h"
+#include "ns3/constant-position-mobility-model.h"
+
+#include <list>
+#include <vector>
+#include <algorithm>
+
+using namespace ns3;
+
+/**
+ * \ingroup propagation
+ *
+ * \brief The data cached for each path by the tests
+ */
+class CacheTestData : public SimpleRefCount<CacheTestData>
+{
+public:
+  /**
+   * Constructor
+   * \param id the identifier of the path
+   */
+  CacheTestData (uint32_t id) : m_id (id) {}
+  uint32_t m_id; //!< the identifier of the path
+};
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Check the lookups and the counters of a cache without size limit
+ */
+class PropagationCacheUnboundedTestCase : public TestCase
+{
+public:
+  PropagationCacheUnboundedTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+PropagationCacheUnboundedTestCase::PropagationCacheUnboundedTestCase ()
+  : TestCase ("Check PropagationCache lookups without size limit")
+{
+}
+
+void
+PropagationCacheUnboundedTestCase::DoRun (void)
+{
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<MobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<MobilityModel> c = CreateObject<ConstantPositionMobilityModel> ();
+
+  PropagationCache<CacheTestData> cache;
+  NS_TEST_ASSERT_MSG_EQ (cache.GetPathData (a, b, 0), 0, "Empty cache should not find a path");
+  cache.AddPathData (Create<CacheTestData> (1), a, b, 0);
+  cache.AddPathData (Create<CacheTestData> (2), a, b, 1);
+  cache.AddPathData (Create<CacheTestData> (3), b, c, 0);
+
+  NS_TEST_ASSERT_MSG_EQ (cache.GetPathData (a, b, 0)->m_id, 1, "Wrong path data");
+  NS_TEST_ASSERT_MSG_EQ (cache.GetPathData (b, a, 0)->m_id, 1, "Paths should be symmetrical");
+  NS_TEST_ASSERT_MSG_EQ (cache.GetPathData (b, a, 1)->m_id, 2, "Model UID should identify the path");
+  NS_TEST_ASSERT_MSG_EQ (cache.GetPathData (c, b, 0)->m_id, 3, "Wrong path data");
+  NS_TEST_ASSERT_MSG_EQ (cache.GetPathData (a, c, 0), 0, "Path not added should not be found");
+
+  NS_TEST_ASSERT_MSG_EQ (cache.GetSize (), 3, "Wrong number of paths");
+  NS_TEST_ASSERT_MSG_EQ (cache.GetHits (), 4, "Wrong number of hits");
+  NS_TEST_ASSERT_MSG_EQ (cache.GetMisses (), 2, "Wrong number of misses");
+  NS_TEST_ASSERT_MSG_EQ (cache.GetEvictions (), 0, "Unbounded cache should not evict");
+
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      Ptr<MobilityModel> d = CreateObject<ConstantPositionMobilityModel> ();
+      cache.AddPathData (Create<CacheTestData> (i + 10), a, d, 0);
+    }
+  NS_TEST_ASSERT_MSG_EQ (cache.GetSize (), 1003, "Unbounded cache should keep all the paths");
+  NS_TEST_ASSERT_MSG_EQ (cache.GetPathData (a, b, 0)->m_id, 1, "Wrong path data");
+}
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Check the paths evicted from a full cache with the LRU and
+ * CLOCK policies
+ */
+class PropagationCacheEvictionTestCase : public TestCase
+{
+public:
+  PropagationCacheEvictionTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Check the cache against a reference LRU list, for random lookups.
+   */
+  void CheckLruAgainstReference (void);
+};
+
+PropagationCacheEvictionTestCase::PropagationCacheEvictionTestCase ()
+  : TestCase ("Check PropagationCache eviction policies")
+{
+}
+
+void
+PropagationCacheEvictionTestCase::CheckLruAgainstReference (void)
+{
+  std::vector<Ptr<MobilityModel> > nodes;
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      nodes.push_back (CreateObject<ConstantPositionMobilityModel> ());
+    }
+  PropagationCache<CacheTestData> cache;
+  cache.SetMaxSize (16);
+  std::list<uint32_t> reference; // most recently used first
+  uint64_t misses = 0;
+  uint32_t state = 12345;
+  for (uint32_t i = 0; i < 5000; i++)
+    {
+      state = state * 1103515245 + 12345;
+      uint32_t x = (state >> 16) % nodes.size ();
+      state = state * 1103515245 + 12345;
+      uint32_t y = (state >> 16) % nodes.size ();
+      if (x == y)
+        {
+          continue;
+        }
+      uint32_t id = std::min (x, y) * nodes.size () + std::max (x, y);
+      std::list<uint32_t>::iterator it = std::find (reference.begin (), reference.end (), id);
+      Ptr<CacheTestData> data = cache.GetPathData (nodes[x], nodes[y], 0);
+      if (it != reference.end ())
+        {
+          NS_TEST_ASSERT_MSG_NE (data, 0, "Path " << id << " should be cached");
+          NS_TEST_ASSERT_MSG_EQ (data->m_id, id, "Wrong path data");
+          reference.erase (it);
+        }
+      else
+        {
+          NS_TEST_ASSERT_MSG_EQ (data, 0, "Path " << id << " should have been evicted");
+          cache.AddPathData (Create<CacheTestData> (id), nodes[y], nodes[x], 0);
+          misses++;
+          if (reference.size () == 16)
+            {
+              reference.pop_back ();
+            }
+        }
+      reference.push_front (id);
+    }
+  NS_TEST_ASSERT_MSG_EQ (cache.GetSize (), 16, "Cache should be full");
+  NS_TEST_ASSERT_MSG_EQ (cache.GetMisses (), misses, "Wrong number of misses");
+  NS_TEST_ASSERT_MSG_EQ (cache.GetEvictions (), misses - 16, "Wrong number of evictions");
+}
+
+void
+PropagationCacheEvictionTestCase::DoRun (void)
+{
+  std::vector<Ptr<MobilityModel> > n;
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      n.push_back (CreateObject<ConstantPositionMobilityModel> ());
+    }
+
+  // LRU: the least recently looked up path is evicted
+  PropagationCache<CacheTestData> lru;
+  lru.SetMaxSize (3);
+  lru.AddPathData (Create<CacheTestData> (1), n[0], n[1], 0);
+  lru.AddPathData (Create<CacheTestData> (2), n[0], n[2], 0);
+  lru.AddPathData (Create<CacheTestData> (3), n[0], n[3], 0);
+  NS_TEST_ASSERT_MSG_NE (lru.GetPathData (n[1], n[0], 0), 0, "Path 1 should be cached");
+  lru.AddPathData (Create<CacheTestData> (4), n[0], n[4], 0);
+  NS_TEST_ASSERT_MSG_EQ (lru.GetSize (), 3, "Cache should not grow beyond its maximum size");
+  NS_TEST_ASSERT_MSG_EQ (lru.GetEvictions (), 1, "Wrong number of evictions");
+  NS_TEST_ASSERT_MSG_EQ (lru.GetPathData (n[0], n[2], 0), 0, "Path 2 should have been evicted");
+  NS_TEST_ASSERT_MSG_EQ (lru.GetPathData (n[0], n[1], 0)->m_id, 1, "Path 1 should be cached");
+  NS_TEST_ASSERT_MSG_EQ (lru.GetPathData (n[0], n[3], 0)->m_id, 3, "Path 3 should be cached");
+  NS_TEST_ASSERT_MSG_EQ (lru.GetPathData (n[0], n[4], 0)->m_id, 4, "Path 4 should be cached");
+  lru.AddPathData (Create<CacheTestData> (5), n[0], n[5], 0);
+  NS_TEST_ASSERT_MSG_EQ (lru.GetPathData (n[0], n[1], 0), 0, "Path 1 should have been evicted");
+
+  // CLOCK: the hand skips, and clears, the paths looked up since it last passed
+  PropagationCache<CacheTestData> clock;
+  clock.SetEvictionPolicy (PropagationCache<CacheTestData>::CLOCK);
+  clock.SetMaxSize (3);
+  clock.AddPathData (Create<CacheTestData> (1), n[0], n[1], 0);
+  clock.AddPathData (Create<CacheTestData> (2), n[0], n[2], 0);
+  clock.AddPathData (Create<CacheTestData> (3), n[0], n[3], 0);
+  NS_TEST_ASSERT_MSG_NE (clock.GetPathData (n[0], n[1], 0), 0, "Path 1 should be cached");
+  clock.AddPathData (Create<CacheTestData> (4), n[0], n[4], 0);
+  NS_TEST_ASSERT_MSG_EQ (clock.GetPathData (n[0], n[2], 0), 0, "Path 2 should have been evicted");
+  clock.AddPathData (Create<CacheTestData> (5), n[0], n[5], 0);
+  NS_TEST_ASSERT_MSG_EQ (clock.GetPathData (n[0], n[3], 0), 0, "Path 3 should have been evicted");
+  NS_TEST_ASSERT_MSG_EQ (clock.GetPathData (n[0], n[1], 0)->m_id, 1, "Path 1 should be cached");
+  NS_TEST_ASSERT_MSG_EQ (clock.GetPathData (n[0], n[4], 0)->m_id, 4, "Path 4 should be cached");
+  NS_TEST_ASSERT_MSG_EQ (clock.GetPathData (n[0], n[5], 0)->m_id, 5, "Path 5 should be cached");
+  NS_TEST_ASSERT_MSG_EQ (clock.GetEvictions (), 2, "Wrong number of evictions");
+
+  // changing the size clears the cache
+  clock.SetMaxSize (2);
+  NS_TEST_ASSERT_MSG_EQ (clock.GetSize (), 0, "Resized cache should be empty");
+
+  CheckLruAgainstReference ();
+}
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Check the cache attributes of JakesPropagationLossModel
+ */
+class JakesPropagationCacheTestCase : public TestCase
+{
+public:
+  JakesPropagationCacheTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+JakesPropagationCacheTestCase::JakesPropagationCacheTestCase ()
+  : TestCase ("Check the cache attributes of JakesPropagationLossModel")
+{
+}
+
+void
+JakesPropagationCacheTestCase::DoRun (void)
+{
+  Ptr<JakesPropagationLossModel> jakes = CreateObject<JakesPropagationLossModel> ();
+  jakes->SetAttribute ("CacheSize", UintegerValue (2));
+  jakes->SetAttribute ("CacheEvictionPolicy", EnumValue (PropagationCache<JakesProcess>::CLOCK));
+
+  std::vector<Ptr<MobilityModel> > n;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      n.push_back (CreateObject<ConstantPositionMobilityModel> ());
+    }
+  double rx01 = jakes->CalcRxPower (0, n[0], n[1]);
+  NS_TEST_ASSERT_MSG_EQ (jakes->CalcRxPower (0, n[1], n[0]), rx01, "Cached path should give the same fading");
+  jakes->CalcRxPower (0, n[0], n[2]);
+  jakes->CalcRxPower (0, n[0], n[3]);
+  jakes->CalcRxPower (0, n[0], n[3]);
+
+  UintegerValue hits;
+  UintegerValue misses;
+  jakes->GetAttribute ("CacheHits", hits);
+  jakes->GetAttribute ("CacheMisses", misses);
+  NS_TEST_ASSERT_MSG_EQ (hits.Get (), 2, "Wrong number of cache hits");
+  NS_TEST_ASSERT_MSG_EQ (misses.Get (), 3, "Wrong number of cache misses");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup propagation
+ *
+ * \brief PropagationCache Test Suite
+ */
+class PropagationCacheTestSuite : public TestSuite
+{
+public:
+  PropagationCacheTestSuite ();
+};
+
+PropagationCacheTestSuite::PropagationCacheTestSuite ()
+  : TestSuite ("propagation-cache", UNIT)
+{
+  AddTestCase (new PropagationCacheUnboundedTestCase, TestCase::QUICK);
+  AddTestCase (new PropagationCacheEvictionTestCase, TestCase::QUICK);
+  AddTestCase (new JakesPropagationCacheTestCase, TestCase::QUICK);
+}
+
+static PropagationCacheTestSuite g_propagationCacheTestSuite; //!< Static variable for test initialization
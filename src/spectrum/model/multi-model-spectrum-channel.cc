@@ -34,8 +34,12 @@
 #include <ns3/propagation-delay-model.h>
 #include <ns3/antenna-model.h>
 #include <ns3/angles.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <utility>
+#include <vector>
 #include "multi-model-spectrum-channel.h"
 
 
@@ -82,6 +86,8 @@ RxSpectrumModelInfo::RxSpectrumModelInfo (Ptr<const SpectrumModel> rxSpectrumMod
 
 
 MultiModelSpectrumChannel::MultiModelSpectrumChannel ()
+  : m_maxRange (std::numeric_limits<double>::infinity ()),
+    m_maxRangeLossDb (std::numeric_limits<double>::quiet_NaN ())
 {
   NS_LOG_FUNCTION (this);
 }
@@ -95,6 +101,8 @@ MultiModelSpectrumChannel::DoDispose ()
   m_spectrumPropagationLoss = 0;
   m_txSpectrumModelInfoMap.clear ();
   m_rxSpectrumModelInfoMap.clear ();
+  m_rxPhyIndex.Clear ();
+  m_unindexedRxPhys.clear ();
   SpectrumChannel::DoDispose ();
 }
 
@@ -115,10 +123,26 @@ MultiModelSpectrumChannel::GetTypeId (void)
                    "the computational load by not propagating signals that "
                    "are far beyond the interference range. Note that the "
                    "default value corresponds to considering all signals "
-                   "for reception. Tune this value with care. ",
+                   "for reception. Tune this value with care. "
+                   "If the PropagationLossModel can bound its loss, the "
+                   "receivers beyond the corresponding range are skipped "
+                   "without computing their loss.",
                    DoubleValue (1.0e9),
                    MakeDoubleAccessor (&MultiModelSpectrumChannel::m_maxLossDb),
                    MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxAntennaGainDb",
+                   "An upper bound of the sum of the TX and RX antenna "
+                   "gains in dB, used together with MaxLossDb to compute "
+                   "the range beyond which receivers are skipped. "
+                   "The default value, infinity, disables the culling of "
+                   "receivers: set it to 0 for isotropic antennas, or to "
+                   "the sum of the maximum TX and RX gains when directional "
+                   "antennas are used, otherwise receivers within range "
+                   "could be skipped.",
+                   DoubleValue (std::numeric_limits<double>::infinity ()),
+                   MakeDoubleAccessor (&MultiModelSpectrumChannel::m_maxAntennaGainDb),
+                   MakeDoubleChecker<double> (-std::numeric_limits<double>::max (),
+                                              std::numeric_limits<double>::infinity ()))
     .AddTraceSource ("PathLoss",
                      "This trace is fired whenever a new path loss value "
                      "is calculated. The first and second parameters "
@@ -131,7 +155,9 @@ MultiModelSpectrumChannel::GetTypeId (void)
                      "PropagationLossModel. In particular, note that "
                      "SpectrumPropagationLossModel (even if present) "
                      "is never used to evaluate the loss value "
-                     "reported in this trace. ",
+                     "reported in this trace. Receivers skipped because "
+                     "they are beyond the range given by MaxLossDb are "
+                     "not reported.",
                      MakeTraceSourceAccessor (&MultiModelSpectrumChannel::m_pathLossTrace),
                      "ns3::SpectrumChannel::LossTracedCallback")
   ;
@@ -151,6 +177,11 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
 
   SpectrumModelUid_t rxSpectrumModelUid = rxSpectrumModel->GetUid ();
 
+  // the mobility model of the phy might have changed too: index it again
+  // at the next transmission
+  m_rxPhyIndex.Remove (phy);
+  m_unindexedRxPhys.insert (phy);
+
   // remove a previous entry of this phy if it exists
   // we need to scan for all rxSpectrumModel values since we don't
   // know which spectrum model the phy had when it was previously added
@@ -275,10 +306,50 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
   NS_LOG_LOGIC ("converter map size: " << txInfoIteratorerator->second.m_spectrumConverterMap.size ());
   NS_LOG_LOGIC ("converter map first element: " << txInfoIteratorerator->second.m_spectrumConverterMap.begin ()->first);
 
+  // if possible, find the receivers within range, sorted like the sets of
+  // receivers of RxSpectrumModelInfo
+  bool culling = false;
+  std::vector<Ptr<SpectrumPhy> > rxPhyCandidates;
+  if (txMobility)
+    {
+      double maxRange = GetMaxRange ();
+      if (!std::isinf (maxRange))
+        {
+          culling = true;
+          IndexRxPhys ();
+          m_rxPhyIndex.Find (txMobility->GetPosition (), maxRange, rxPhyCandidates);
+          std::vector<Ptr<SpectrumPhy> >::iterator middle = rxPhyCandidates.insert (rxPhyCandidates.end (),
+                                                                                    m_unindexedRxPhys.begin (),
+                                                                                    m_unindexedRxPhys.end ());
+          std::inplace_merge (rxPhyCandidates.begin (), middle, rxPhyCandidates.end ());
+          NS_LOG_LOGIC ("receivers within " << maxRange << " m: " << rxPhyCandidates.size ());
+        }
+    }
+
   for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
        rxInfoIterator != m_rxSpectrumModelInfoMap.end ();
        ++rxInfoIterator)
     {
+      const std::set<Ptr<SpectrumPhy> > &rxPhySet = rxInfoIterator->second.m_rxPhySet;
+      std::vector<Ptr<SpectrumPhy> > rxPhys;
+      if (culling)
+        {
+          for (std::vector<Ptr<SpectrumPhy> >::const_iterator rxPhyIterator = rxPhyCandidates.begin ();
+               rxPhyIterator != rxPhyCandidates.end ();
+               ++rxPhyIterator)
+            {
+              if (rxPhySet.find (*rxPhyIterator) != rxPhySet.end ())
+                {
+                  rxPhys.push_back (*rxPhyIterator);
+                }
+            }
+          if (rxPhys.empty ())
+            {
+              // no need to convert the PSD
+              continue;
+            }
+        }
+
       SpectrumModelUid_t rxSpectrumModelUid = rxInfoIterator->second.m_rxSpectrumModel->GetUid ();
       NS_LOG_LOGIC (" rxSpectrumModelUids " << rxSpectrumModelUid);
 
@@ -300,87 +371,156 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
           convertedTxPowerSpectrum = rxConverterIterator->second.Convert (txParams->psd);
         }
 
-
-      for (std::set<Ptr<SpectrumPhy> >::const_iterator rxPhyIterator = rxInfoIterator->second.m_rxPhySet.begin ();
-           rxPhyIterator != rxInfoIterator->second.m_rxPhySet.end ();
-           ++rxPhyIterator)
+      if (culling)
         {
-          NS_ASSERT_MSG ((*rxPhyIterator)->GetRxSpectrumModel ()->GetUid () == rxSpectrumModelUid,
-                         "SpectrumModel change was not notified to MultiModelSpectrumChannel (i.e., AddRx should be called again after model is changed)");
-
-          if ((*rxPhyIterator) != txParams->txPhy)
+          for (std::vector<Ptr<SpectrumPhy> >::const_iterator rxPhyIterator = rxPhys.begin ();
+               rxPhyIterator != rxPhys.end ();
+               ++rxPhyIterator)
+            {
+              StartTxToRx (txParams, txMobility, convertedTxPowerSpectrum, *rxPhyIterator);
+            }
+        }
+      else
+        {
+          for (std::set<Ptr<SpectrumPhy> >::const_iterator rxPhyIterator = rxPhySet.begin ();
+               rxPhyIterator != rxPhySet.end ();
+               ++rxPhyIterator)
             {
-              NS_LOG_LOGIC (" copying signal parameters " << txParams);
-              Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
-              rxParams->psd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
-              Time delay = MicroSeconds (0);
+              StartTxToRx (txParams, txMobility, convertedTxPowerSpectrum, *rxPhyIterator);
+            }
+        }
+    }
 
-              Ptr<MobilityModel> receiverMobility = (*rxPhyIterator)->GetMobility ();
+}
 
-              if (txMobility && receiverMobility)
-                {
-                  double pathLossDb = 0;
-                  if (rxParams->txAntenna != 0)
-                    {
-                      Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
-                      double txAntennaGain = rxParams->txAntenna->GetGainDb (txAngles);
-                      NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
-                      pathLossDb -= txAntennaGain;
-                    }
-                  Ptr<AntennaModel> rxAntenna = (*rxPhyIterator)->GetRxAntenna ();
-                  if (rxAntenna != 0)
-                    {
-                      Angles rxAngles (txMobility->GetPosition (), receiverMobility->GetPosition ());
-                      double rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
-                      NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
-                      pathLossDb -= rxAntennaGain;
-                    }
-                  if (m_propagationLoss)
-                    {
-                      double propagationGainDb = m_propagationLoss->CalcRxPower (0, txMobility, receiverMobility);
-                      NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
-                      pathLossDb -= propagationGainDb;
-                    }                    
-                  NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");    
-                  m_pathLossTrace (txParams->txPhy, *rxPhyIterator, pathLossDb);
-                  if ( pathLossDb > m_maxLossDb)
-                    {
-                      // beyond range
-                      continue;
-                    }
-                  double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
-                  *(rxParams->psd) *= pathGainLinear;              
-
-                  if (m_spectrumPropagationLoss)
-                    {
-                      rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
-                    }
-
-                  if (m_propagationDelay)
-                    {
-                      delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
-                    }
-                }
+void
+MultiModelSpectrumChannel::StartTxToRx (Ptr<SpectrumSignalParameters> txParams, Ptr<MobilityModel> txMobility,
+                                        Ptr<SpectrumValue> convertedTxPowerSpectrum, Ptr<SpectrumPhy> rxPhy)
+{
+  NS_ASSERT_MSG (rxPhy->GetRxSpectrumModel ()->GetUid () == convertedTxPowerSpectrum->GetSpectrumModelUid (),
+                 "SpectrumModel change was not notified to MultiModelSpectrumChannel (i.e., AddRx should be called again after model is changed)");
 
-              Ptr<NetDevice> netDev = (*rxPhyIterator)->GetDevice ();
-              if (netDev)
-                {
-                  // the receiver has a NetDevice, so we expect that it is attached to a Node
-                  uint32_t dstNode =  netDev->GetNode ()->GetId ();
-                  Simulator::ScheduleWithContext (dstNode, delay, &MultiModelSpectrumChannel::StartRx, this,
-                                                  rxParams, *rxPhyIterator);
-                }
-              else
-                {
-                  // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
-                  Simulator::Schedule (delay, &MultiModelSpectrumChannel::StartRx, this,
-                                       rxParams, *rxPhyIterator);
-                }
-            }
+  if (rxPhy == txParams->txPhy)
+    {
+      return;
+    }
+
+  Time delay = MicroSeconds (0);
+  Ptr<SpectrumValue> rxPsd;
+
+  Ptr<MobilityModel> receiverMobility = rxPhy->GetMobility ();
+
+  if (txMobility && receiverMobility)
+    {
+      double pathLossDb = 0;
+      if (txParams->txAntenna != 0)
+        {
+          Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
+          double txAntennaGain = txParams->txAntenna->GetGainDb (txAngles);
+          NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
+          pathLossDb -= txAntennaGain;
+        }
+      Ptr<AntennaModel> rxAntenna = rxPhy->GetRxAntenna ();
+      if (rxAntenna != 0)
+        {
+          Angles rxAngles (txMobility->GetPosition (), receiverMobility->GetPosition ());
+          double rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
+          NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
+          pathLossDb -= rxAntennaGain;
         }
+      if (m_propagationLoss)
+        {
+          double propagationGainDb = m_propagationLoss->CalcRxPower (0, txMobility, receiverMobility);
+          NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
+          pathLossDb -= propagationGainDb;
+        }
+      NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");
+      m_pathLossTrace (txParams->txPhy, rxPhy, pathLossDb);
+      if ( pathLossDb > m_maxLossDb)
+        {
+          // beyond range
+          return;
+        }
+      double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
+      rxPsd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
+      *rxPsd *= pathGainLinear;
+
+      if (m_spectrumPropagationLoss)
+        {
+          rxPsd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxPsd, txMobility, receiverMobility);
+        }
+
+      if (m_propagationDelay)
+        {
+          delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
+        }
+    }
+  else
+    {
+      rxPsd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
+    }
+
+  NS_LOG_LOGIC (" copying signal parameters " << txParams);
+  Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
+  rxParams->psd = rxPsd;
+
+  Ptr<NetDevice> netDev = rxPhy->GetDevice ();
+  if (netDev)
+    {
+      // the receiver has a NetDevice, so we expect that it is attached to a Node
+      uint32_t dstNode =  netDev->GetNode ()->GetId ();
+      Simulator::ScheduleWithContext (dstNode, delay, &MultiModelSpectrumChannel::StartRx, this,
+                                      rxParams, rxPhy);
+    }
+  else
+    {
+      // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
+      Simulator::Schedule (delay, &MultiModelSpectrumChannel::StartRx, this,
+                           rxParams, rxPhy);
+    }
+}
 
+double
+MultiModelSpectrumChannel::GetMaxRange (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_propagationLoss || std::isinf (m_maxAntennaGainDb))
+    {
+      // only the antennas contribute to the path loss, or their gain
+      // is not bounded
+      return std::numeric_limits<double>::infinity ();
+    }
+  double maxLossDb = m_maxLossDb + m_maxAntennaGainDb;
+  if (maxLossDb != m_maxRangeLossDb)
+    {
+      m_maxRange = m_propagationLoss->GetMaxRange (maxLossDb);
+      m_maxRangeLossDb = maxLossDb;
+      NS_LOG_DEBUG ("maximum range " << m_maxRange << " m for MaxLossDb=" << m_maxLossDb);
+      if (!std::isinf (m_maxRange))
+        {
+          m_rxPhyIndex.SetCellSize (std::max (m_maxRange, 1.0));
+        }
     }
+  return m_maxRange;
+}
 
+void
+MultiModelSpectrumChannel::IndexRxPhys (void)
+{
+  std::set<Ptr<SpectrumPhy> >::iterator it = m_unindexedRxPhys.begin ();
+  while (it != m_unindexedRxPhys.end ())
+    {
+      Ptr<MobilityModel> mobility = (*it)->GetMobility ();
+      if (mobility)
+        {
+          m_rxPhyIndex.Add (*it, mobility);
+          m_unindexedRxPhys.erase (it++);
+        }
+      else
+        {
+          ++it;
+        }
+    }
 }
 
 void
@@ -27,6 +27,7 @@
 #include <ns3/spectrum-channel.h>
 #include <ns3/spectrum-propagation-loss-model.h>
 #include <ns3/propagation-delay-model.h>
+#include <ns3/mobility-grid-index.h>
 #include <map>
 #include <set>
 
@@ -102,6 +103,17 @@ typedef std::map<SpectrumModelUid_t, RxSpectrumModelInfo> RxSpectrumModelInfoMap
  * for this to work is that, after the SpectrumPhy switched its
  * SpectrumModel,  MultiModelSpectrumChannel::AddRx () is
  * called again passing the pointer to that SpectrumPhy.
+ *
+ * When the MaxLossDb and MaxAntennaGainDb attributes are set and the
+ * PropagationLossModel provides a lower bound of its loss (see
+ * PropagationLossModel::GetMinLossDb), the receivers that are
+ * farther from the transmitter than the distance at which the loss
+ * exceeds MaxLossDb are not considered at all: the receivers are kept
+ * in a MobilityGridIndex, and only the ones within range are visited
+ * by StartTx.  No PathLoss trace is fired for the other receivers.
+ * MaxAntennaGainDb must bound the sum of the TX and RX antenna gains,
+ * which the channel cannot derive from the AntennaModel: until it is
+ * set, every receiver is considered.
  */
 class MultiModelSpectrumChannel : public SpectrumChannel
 {
@@ -158,6 +170,33 @@ private:
    */
   virtual void StartRx (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver);
 
+  /**
+   * Used internally to propagate a transmission to a single receiver.
+   *
+   * @param txParams The signal parameters of the transmission.
+   * @param txMobility The mobility model of the transmitter, if any.
+   * @param convertedTxPowerSpectrum The TX PSD converted to the RX SpectrumModel.
+   * @param rxPhy A pointer to the receiver SpectrumPhy.
+   */
+  void StartTxToRx (Ptr<SpectrumSignalParameters> txParams, Ptr<MobilityModel> txMobility,
+                    Ptr<SpectrumValue> convertedTxPowerSpectrum, Ptr<SpectrumPhy> rxPhy);
+
+  /**
+   * Get the distance beyond which no receiver can be in range, i.e.,
+   * the distance beyond which the path loss is larger than m_maxLossDb.
+   * The value is cached until m_maxLossDb or m_maxAntennaGainDb change.
+   *
+   * @return The maximum range in meters, or infinity if the receivers
+   * cannot be culled.
+   */
+  double GetMaxRange (void);
+
+  /**
+   * Add to m_rxPhyIndex the receivers in m_unindexedRxPhys that have
+   * a mobility model.
+   */
+  void IndexRxPhys (void);
+
   /**
    * Propagation delay model to be used with this channel.
    */
@@ -201,6 +240,27 @@ private:
    */
   double m_maxLossDb;
 
+  /**
+   * Upper bound of the sum of the TX and RX antenna gains [dB], used
+   * to compute the maximum range.
+   */
+  double m_maxAntennaGainDb;
+
+  double m_maxRange;               //!< Cached maximum range [m]
+  double m_maxRangeLossDb;         //!< Loss for which m_maxRange was computed [dB]
+
+  /**
+   * The receivers having a mobility model, indexed by position. The
+   * index is only filled when receivers can be culled.
+   */
+  MobilityGridIndex<Ptr<SpectrumPhy> > m_rxPhyIndex;
+
+  /**
+   * The receivers not in m_rxPhyIndex, either because they were added
+   * since the last indexing or because they have no mobility model.
+   */
+  std::set<Ptr<SpectrumPhy> > m_unindexedRxPhys;
+
   /**
    * \deprecated The non-const \c Ptr<SpectrumPhy> argument
    * is deprecated and will be changed to \c Ptr<const SpectrumPhy>
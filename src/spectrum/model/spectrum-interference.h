@@ -147,6 +147,9 @@ private:
 
   Ptr<SpectrumErrorModel> m_errorModel; //!< Error model
 
+  SpectrumValue m_interference; //!< Interference plus noise of the last chunk, reused across chunks
+  SpectrumValue m_sinr;         //!< SINR of the last chunk, reused across chunks
+
 
 
 };
@@ -23,10 +23,184 @@
 #include <ns3/math.h>
 #include <ns3/log.h>
 
+/*
+ * The component by component operations below are written as plain
+ * loops over contiguous arrays so that the compiler can vectorize them.
+ * When the compiler supports function multiversioning, an AVX2 version
+ * of each loop is also built and selected at load time on the CPUs
+ * supporting it, the default version using SSE2 on x86-64.
+ */
+#if defined (__GNUC__) && !defined (__clang__) && (__GNUC__ >= 6) && defined (__x86_64__) && defined (__linux__)
+#define SPECTRUM_VALUE_KERNEL __attribute__ ((target_clones ("avx2", "default")))
+#else
+#define SPECTRUM_VALUE_KERNEL
+#endif
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("SpectrumValue");
 
+namespace {
+
+/**
+ * Add two arrays component by component: a[i] += b[i].
+ * \param a the first array, which receives the result
+ * \param b the second array
+ * \param n the number of components
+ */
+SPECTRUM_VALUE_KERNEL void
+AddKernel (double *a, const double *b, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    {
+      a[i] += b[i];
+    }
+}
+
+/**
+ * Subtract two arrays component by component: a[i] -= b[i].
+ * \param a the first array, which receives the result
+ * \param b the second array
+ * \param n the number of components
+ */
+SPECTRUM_VALUE_KERNEL void
+SubtractKernel (double *a, const double *b, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    {
+      a[i] -= b[i];
+    }
+}
+
+/**
+ * Multiply two arrays component by component: a[i] *= b[i].
+ * \param a the first array, which receives the result
+ * \param b the second array
+ * \param n the number of components
+ */
+SPECTRUM_VALUE_KERNEL void
+MultiplyKernel (double *a, const double *b, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    {
+      a[i] *= b[i];
+    }
+}
+
+/**
+ * Divide two arrays component by component: a[i] /= b[i].
+ * \param a the first array, which receives the result
+ * \param b the second array
+ * \param n the number of components
+ */
+SPECTRUM_VALUE_KERNEL void
+DivideKernel (double *a, const double *b, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    {
+      a[i] /= b[i];
+    }
+}
+
+/**
+ * Add a scalar to each component of an array: a[i] += s.
+ * \param a the array
+ * \param s the scalar
+ * \param n the number of components
+ */
+SPECTRUM_VALUE_KERNEL void
+AddScalarKernel (double *a, double s, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    {
+      a[i] += s;
+    }
+}
+
+/**
+ * Multiply each component of an array by a scalar: a[i] *= s.
+ * \param a the array
+ * \param s the scalar
+ * \param n the number of components
+ */
+SPECTRUM_VALUE_KERNEL void
+MultiplyScalarKernel (double *a, double s, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    {
+      a[i] *= s;
+    }
+}
+
+/**
+ * Divide each component of an array by a scalar: a[i] /= s.
+ * \param a the array
+ * \param s the scalar
+ * \param n the number of components
+ */
+SPECTRUM_VALUE_KERNEL void
+DivideScalarKernel (double *a, double s, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    {
+      a[i] /= s;
+    }
+}
+
+/**
+ * Change the sign of each component of an array: a[i] = -a[i].
+ * \param a the array
+ * \param n the number of components
+ */
+SPECTRUM_VALUE_KERNEL void
+ChangeSignKernel (double *a, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    {
+      a[i] = -a[i];
+    }
+}
+
+/**
+ * Add an array multiplied by a scalar: a[i] += b[i] * s.
+ * \param a the first array, which receives the result
+ * \param b the array to scale and add
+ * \param s the scalar
+ * \param n the number of components
+ */
+SPECTRUM_VALUE_KERNEL void
+AddScaledKernel (double *a, const double *b, double s, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    {
+      a[i] += b[i] * s;
+    }
+}
+
+/**
+ * Compute the interference plus noise and the SINR of a signal,
+ * component by component.
+ * \param signal the PSD of the signal
+ * \param allSignals the PSD of all the signals, including this one
+ * \param noise the PSD of the noise
+ * \param interference receives allSignals - signal + noise
+ * \param sinr receives signal / interference
+ * \param n the number of components
+ */
+SPECTRUM_VALUE_KERNEL void
+SinrKernel (const double *signal, const double *allSignals, const double *noise,
+            double *interference, double *sinr, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    {
+      double interf = allSignals[i] - signal[i] + noise[i];
+      interference[i] = interf;
+      sinr[i] = signal[i] / interf;
+    }
+}
+
+} // unnamed namespace
+
 SpectrumValue::SpectrumValue ()
 {
 }
@@ -106,31 +280,16 @@ SpectrumValue::ConstBandsEnd () const
 void
 SpectrumValue::Add (const SpectrumValue& x)
 {
-  Values::iterator it1 = m_values.begin ();
-  Values::const_iterator it2 = x.m_values.begin ();
-
   NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
-
-  while (it1 != m_values.end ())
-    {
-      NS_ASSERT ( it2 != x.m_values.end ());
-      *it1 += *it2;
-      ++it1;
-      ++it2;
-    }
+  NS_ASSERT (m_values.size () == x.m_values.size ());
+  AddKernel (m_values.data (), x.m_values.data (), m_values.size ());
 }
 
 
 void
 SpectrumValue::Add (double s)
 {
-  Values::iterator it1 = m_values.begin ();
-
-  while (it1 != m_values.end ())
-    {
-      *it1 += s;
-      ++it1;
-    }
+  AddScalarKernel (m_values.data (), s, m_values.size ());
 }
 
 
@@ -138,18 +297,9 @@ SpectrumValue::Add (double s)
 void
 SpectrumValue::Subtract (const SpectrumValue& x)
 {
-  Values::iterator it1 = m_values.begin ();
-  Values::const_iterator it2 = x.m_values.begin ();
-
   NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
-
-  while (it1 != m_values.end ())
-    {
-      NS_ASSERT ( it2 != x.m_values.end ());
-      *it1 -= *it2;
-      ++it1;
-      ++it2;
-    }
+  NS_ASSERT (m_values.size () == x.m_values.size ());
+  SubtractKernel (m_values.data (), x.m_values.data (), m_values.size ());
 }
 
 
@@ -164,31 +314,16 @@ SpectrumValue::Subtract (double s)
 void
 SpectrumValue::Multiply (const SpectrumValue& x)
 {
-  Values::iterator it1 = m_values.begin ();
-  Values::const_iterator it2 = x.m_values.begin ();
-
   NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
-
-  while (it1 != m_values.end ())
-    {
-      NS_ASSERT ( it2 != x.m_values.end ());
-      *it1 *= *it2;
-      ++it1;
-      ++it2;
-    }
+  NS_ASSERT (m_values.size () == x.m_values.size ());
+  MultiplyKernel (m_values.data (), x.m_values.data (), m_values.size ());
 }
 
 
 void
 SpectrumValue::Multiply (double s)
 {
-  Values::iterator it1 = m_values.begin ();
-
-  while (it1 != m_values.end ())
-    {
-      *it1 *= s;
-      ++it1;
-    }
+  MultiplyScalarKernel (m_values.data (), s, m_values.size ());
 }
 
 
@@ -197,18 +332,9 @@ SpectrumValue::Multiply (double s)
 void
 SpectrumValue::Divide (const SpectrumValue& x)
 {
-  Values::iterator it1 = m_values.begin ();
-  Values::const_iterator it2 = x.m_values.begin ();
-
   NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
-
-  while (it1 != m_values.end ())
-    {
-      NS_ASSERT ( it2 != x.m_values.end ());
-      *it1 /= *it2;
-      ++it1;
-      ++it2;
-    }
+  NS_ASSERT (m_values.size () == x.m_values.size ());
+  DivideKernel (m_values.data (), x.m_values.data (), m_values.size ());
 }
 
 
@@ -216,13 +342,7 @@ void
 SpectrumValue::Divide (double s)
 {
   NS_LOG_FUNCTION (this << s);
-  Values::iterator it1 = m_values.begin ();
-
-  while (it1 != m_values.end ())
-    {
-      *it1 /= s;
-      ++it1;
-    }
+  DivideScalarKernel (m_values.data (), s, m_values.size ());
 }
 
 
@@ -231,13 +351,37 @@ SpectrumValue::Divide (double s)
 void
 SpectrumValue::ChangeSign ()
 {
-  Values::iterator it1 = m_values.begin ();
+  ChangeSignKernel (m_values.data (), m_values.size ());
+}
 
-  while (it1 != m_values.end ())
+
+void
+SpectrumValue::AddScaled (const SpectrumValue& x, double s)
+{
+  NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
+  NS_ASSERT (m_values.size () == x.m_values.size ());
+  AddScaledKernel (m_values.data (), x.m_values.data (), s, m_values.size ());
+}
+
+
+void
+ComputeSinr (const SpectrumValue& signal, const SpectrumValue& allSignals, const SpectrumValue& noise,
+             SpectrumValue& interference, SpectrumValue& sinr)
+{
+  NS_ASSERT (signal.m_spectrumModel == allSignals.m_spectrumModel);
+  NS_ASSERT (signal.m_spectrumModel == noise.m_spectrumModel);
+  NS_ASSERT (signal.m_values.size () == allSignals.m_values.size ());
+  NS_ASSERT (signal.m_values.size () == noise.m_values.size ());
+  if (interference.m_spectrumModel != signal.m_spectrumModel)
     {
-      *it1 = -(*it1);
-      ++it1;
+      interference = SpectrumValue (signal.m_spectrumModel);
+    }
+  if (sinr.m_spectrumModel != signal.m_spectrumModel)
+    {
+      sinr = SpectrumValue (signal.m_spectrumModel);
     }
+  SinrKernel (signal.m_values.data (), allSignals.m_values.data (), noise.m_values.data (),
+              interference.m_values.data (), sinr.m_values.data (), signal.m_values.size ());
 }
 
 
@@ -467,9 +611,8 @@ operator+ (double lhs, const SpectrumValue& rhs)
 SpectrumValue
 operator- (const SpectrumValue& lhs, const SpectrumValue& rhs)
 {
-  SpectrumValue res = rhs;
-  res.ChangeSign ();
-  res.Add (lhs);
+  SpectrumValue res = lhs;
+  res.Subtract (rhs);
   return res;
 }
 
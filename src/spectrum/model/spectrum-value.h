@@ -409,6 +409,33 @@ public:
    */
   SpectrumValue& operator= (double rhs);
 
+  /**
+   * Add the first argument multiplied by the second one to *this,
+   * component by component, without creating a temporary
+   * SpectrumValue, i.e., *this += x * s
+   *
+   * @param x the SpectrumValue to add
+   * @param s the factor applied to x
+   */
+  void AddScaled (const SpectrumValue& x, double s);
+
+  /**
+   * Compute in a single pass, without creating temporary
+   * SpectrumValues, the interference plus noise
+   * allSignals - signal + noise and the SINR signal / (allSignals -
+   * signal + noise), component by component. The results are stored
+   * in the last two arguments, which are reset to the SpectrumModel of
+   * signal if needed: they can be reused across calls.
+   *
+   * @param signal the signal of interest
+   * @param allSignals the sum of all the signals, including the signal of interest
+   * @param noise the noise
+   * @param interference the interference plus noise
+   * @param sinr the SINR
+   */
+  friend void ComputeSinr (const SpectrumValue& signal, const SpectrumValue& allSignals, const SpectrumValue& noise,
+                           SpectrumValue& interference, SpectrumValue& sinr);
+
 
 
   /**
@@ -619,6 +646,8 @@ SpectrumValue Log10 (const SpectrumValue& arg);
 SpectrumValue Log2 (const SpectrumValue& arg);
 SpectrumValue Log (const SpectrumValue& arg);
 double Integral (const SpectrumValue& arg);
+void ComputeSinr (const SpectrumValue& signal, const SpectrumValue& allSignals, const SpectrumValue& noise,
+                  SpectrumValue& interference, SpectrumValue& sinr);
 
 
 } // namespace ns3
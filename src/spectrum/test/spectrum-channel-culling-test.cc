@@ -0,0 +1,287 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/double.h>
+#include <ns3/random-variable-stream.h>
+#include <ns3/spectrum-phy.h>
+#include <ns3/spectrum-signal-parameters.h>
+#include <ns3/multi-model-spectrum-channel.h>
+#include <ns3/spectrum-model-ism2400MHz-res1MHz.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/constant-position-mobility-model.h>
+#include <ns3/constant-velocity-mobility-model.h>
+#include <ns3/net-device.h>
+#include <ns3/antenna-model.h>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup spectrum-tests
+ *
+ * \brief A SpectrumPhy counting the signals it receives
+ */
+class CullingTestPhy : public SpectrumPhy
+{
+public:
+  CullingTestPhy ();
+
+  // inherited from SpectrumPhy
+  virtual void SetDevice (Ptr<NetDevice> d);
+  virtual Ptr<NetDevice> GetDevice () const;
+  virtual void SetMobility (Ptr<MobilityModel> m);
+  virtual Ptr<MobilityModel> GetMobility ();
+  virtual void SetChannel (Ptr<SpectrumChannel> c);
+  virtual Ptr<const SpectrumModel> GetRxSpectrumModel () const;
+  virtual Ptr<AntennaModel> GetRxAntenna ();
+  virtual void StartRx (Ptr<SpectrumSignalParameters> params);
+
+  uint32_t m_rxCount;                //!< Number of signals received
+  Ptr<MobilityModel> m_mobility;     //!< Mobility model
+};
+
+CullingTestPhy::CullingTestPhy ()
+  : m_rxCount (0)
+{
+}
+
+void
+CullingTestPhy::SetDevice (Ptr<NetDevice> d)
+{
+}
+
+Ptr<NetDevice>
+CullingTestPhy::GetDevice () const
+{
+  return 0;
+}
+
+void
+CullingTestPhy::SetMobility (Ptr<MobilityModel> m)
+{
+  m_mobility = m;
+}
+
+Ptr<MobilityModel>
+CullingTestPhy::GetMobility ()
+{
+  return m_mobility;
+}
+
+void
+CullingTestPhy::SetChannel (Ptr<SpectrumChannel> c)
+{
+}
+
+Ptr<const SpectrumModel>
+CullingTestPhy::GetRxSpectrumModel () const
+{
+  return SpectrumModelIsm2400MhzRes1Mhz;
+}
+
+Ptr<AntennaModel>
+CullingTestPhy::GetRxAntenna ()
+{
+  return 0;
+}
+
+void
+CullingTestPhy::StartRx (Ptr<SpectrumSignalParameters> params)
+{
+  m_rxCount++;
+}
+
+/**
+ * \ingroup spectrum-tests
+ *
+ * \brief Check that the receivers culled by MultiModelSpectrumChannel
+ * are exactly the ones whose loss exceeds MaxLossDb, while some of
+ * them move, and that none is culled until MaxAntennaGainDb is set.
+ */
+class SpectrumChannelCullingTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param setMaxAntennaGain whether to set the MaxAntennaGainDb attribute
+   */
+  SpectrumChannelCullingTestCase (bool setMaxAntennaGain);
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Transmit a signal from a phy, and compute which phys should receive it.
+   * \param tx the index of the transmitting phy
+   */
+  void Transmit (uint32_t tx);
+  /**
+   * Count the path losses computed by the channel.
+   * \param txPhy the transmitting phy
+   * \param rxPhy the receiving phy
+   * \param lossDb the path loss
+   */
+  void PathLoss (Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy, double lossDb);
+
+  Ptr<MultiModelSpectrumChannel> m_channel;  //!< The channel under test
+  Ptr<PropagationLossModel> m_loss;          //!< The loss model of the channel
+  std::vector<Ptr<CullingTestPhy> > m_phys;  //!< The phys
+  std::vector<uint32_t> m_expected;          //!< Expected number of signals received by each phy
+  uint32_t m_pathLossCount;                  //!< Number of path losses computed
+  uint32_t m_pairCount;                      //!< Number of path losses computed without culling
+  double m_maxLossDb;                        //!< The maximum loss
+  bool m_setMaxAntennaGain;                  //!< Whether MaxAntennaGainDb is set
+};
+
+SpectrumChannelCullingTestCase::SpectrumChannelCullingTestCase (bool setMaxAntennaGain)
+  : TestCase (setMaxAntennaGain
+              ? "Check that MultiModelSpectrumChannel only culls out of range receivers"
+              : "Check that MultiModelSpectrumChannel does not cull receivers with unbounded antenna gains"),
+    m_pathLossCount (0),
+    m_pairCount (0),
+    m_maxLossDb (110),
+    m_setMaxAntennaGain (setMaxAntennaGain)
+{
+}
+
+void
+SpectrumChannelCullingTestCase::PathLoss (Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy, double lossDb)
+{
+  m_pathLossCount++;
+}
+
+void
+SpectrumChannelCullingTestCase::Transmit (uint32_t tx)
+{
+  Ptr<MobilityModel> txMobility = m_phys[tx]->GetMobility ();
+  for (uint32_t i = 0; i < m_phys.size (); i++)
+    {
+      if (i == tx)
+        {
+          continue;
+        }
+      Ptr<MobilityModel> rxMobility = m_phys[i]->GetMobility ();
+      if (txMobility && rxMobility)
+        {
+          m_pairCount++;
+        }
+      if (!rxMobility || -m_loss->CalcRxPower (0, txMobility, rxMobility) <= m_maxLossDb)
+        {
+          m_expected[i]++;
+        }
+    }
+
+  Ptr<SpectrumSignalParameters> params = Create<SpectrumSignalParameters> ();
+  params->txPhy = m_phys[tx];
+  params->psd = Create<SpectrumValue> (SpectrumModelIsm2400MhzRes1Mhz);
+  *(params->psd) = 1e-9;
+  params->duration = MicroSeconds (100);
+  m_channel->StartTx (params);
+}
+
+void
+SpectrumChannelCullingTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+
+  m_loss = CreateObject<LogDistancePropagationLossModel> ();
+  m_channel = CreateObject<MultiModelSpectrumChannel> ();
+  m_channel->SetAttribute ("MaxLossDb", DoubleValue (m_maxLossDb));
+  if (m_setMaxAntennaGain)
+    {
+      // the phys have no antenna model
+      m_channel->SetAttribute ("MaxAntennaGainDb", DoubleValue (0));
+    }
+  m_channel->AddPropagationLossModel (m_loss);
+  m_channel->TraceConnectWithoutContext ("PathLoss", MakeCallback (&SpectrumChannelCullingTestCase::PathLoss, this));
+
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      Ptr<CullingTestPhy> phy = Create<CullingTestPhy> ();
+      Vector position (random->GetValue (0, 500), random->GetValue (0, 500), 0);
+      if (i % 4 == 0)
+        {
+          Ptr<ConstantVelocityMobilityModel> mobility = CreateObject<ConstantVelocityMobilityModel> ();
+          mobility->SetPosition (position);
+          mobility->SetVelocity (Vector (random->GetValue (-20, 20), random->GetValue (-20, 20), 0));
+          phy->SetMobility (mobility);
+        }
+      else if (i % 50 != 1)
+        {
+          Ptr<MobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+          mobility->SetPosition (position);
+          phy->SetMobility (mobility);
+        }
+      m_phys.push_back (phy);
+      m_channel->AddRx (phy);
+    }
+  m_expected.resize (m_phys.size (), 0);
+
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      Simulator::Schedule (Seconds (i), &SpectrumChannelCullingTestCase::Transmit, this, (i * 37) % 200);
+    }
+  Simulator::Run ();
+
+  uint32_t rxCount = 0;
+  for (uint32_t i = 0; i < m_phys.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_phys[i]->m_rxCount, m_expected[i], "Wrong number of signals received by phy " << i);
+      rxCount += m_phys[i]->m_rxCount;
+    }
+  // the receivers without mobility model receive every signal
+  NS_TEST_EXPECT_MSG_GT (rxCount, 20 * 4, "Some receivers should be within range");
+  if (m_setMaxAntennaGain)
+    {
+      NS_TEST_EXPECT_MSG_LT (m_pathLossCount, m_pairCount, "Out of range receivers should be culled");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_pathLossCount, m_pairCount, "No receiver should be culled");
+    }
+
+  for (uint32_t i = 0; i < m_phys.size (); i++)
+    {
+      m_phys[i]->SetMobility (0);
+    }
+  m_channel->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup spectrum-tests
+ *
+ * \brief MultiModelSpectrumChannel culling Test Suite
+ */
+class SpectrumChannelCullingTestSuite : public TestSuite
+{
+public:
+  SpectrumChannelCullingTestSuite ();
+};
+
+SpectrumChannelCullingTestSuite::SpectrumChannelCullingTestSuite ()
+  : TestSuite ("spectrum-channel-culling", UNIT)
+{
+  AddTestCase (new SpectrumChannelCullingTestCase (true), TestCase::QUICK);
+  AddTestCase (new SpectrumChannelCullingTestCase (false), TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static SpectrumChannelCullingTestSuite g_spectrumChannelCullingTestSuite;
@@ -0,0 +1,159 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/test.h>
+#include <ns3/spectrum-value.h>
+#include <ns3/spectrum-model.h>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "spectrum-test.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup spectrum-tests
+ *
+ * \brief Time the SINR computation done for each chunk by
+ * SpectrumInterference and LteInterference, written with the
+ * SpectrumValue operators and with the fused operations, and check that
+ * both give the same result.
+ */
+class SpectrumValueBenchmarkTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param nBands the number of bands of the SpectrumModel
+   * \param iterations the number of chunks to evaluate
+   */
+  SpectrumValueBenchmarkTestCase (uint32_t nBands, uint32_t iterations);
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param nBands the number of bands
+   * \returns the name of the test case
+   */
+  static std::string Name (uint32_t nBands);
+  /**
+   * Print the time taken by a benchmark.
+   * \param what the benchmark
+   * \param seconds the time taken
+   */
+  void Report (std::string what, double seconds) const;
+
+  uint32_t m_nBands;     //!< Number of bands
+  uint32_t m_iterations; //!< Number of chunks evaluated
+};
+
+SpectrumValueBenchmarkTestCase::SpectrumValueBenchmarkTestCase (uint32_t nBands, uint32_t iterations)
+  : TestCase (Name (nBands)),
+    m_nBands (nBands),
+    m_iterations (iterations)
+{
+}
+
+std::string
+SpectrumValueBenchmarkTestCase::Name (uint32_t nBands)
+{
+  std::ostringstream oss;
+  oss << "SpectrumValue SINR computation over " << nBands << " bands";
+  return oss.str ();
+}
+
+void
+SpectrumValueBenchmarkTestCase::Report (std::string what, double seconds) const
+{
+  std::cout << "spectrum-value-perf: " << m_nBands << " bands, " << what << ": "
+            << 1e9 * seconds / m_iterations << " ns/chunk" << std::endl;
+}
+
+void
+SpectrumValueBenchmarkTestCase::DoRun (void)
+{
+  std::vector<double> freqs;
+  for (uint32_t i = 0; i < m_nBands; i++)
+    {
+      freqs.push_back (2.1e9 + i * 180e3);
+    }
+  Ptr<SpectrumModel> model = Create<SpectrumModel> (freqs);
+
+  SpectrumValue rxSignal (model);
+  SpectrumValue allSignals (model);
+  SpectrumValue noise (model);
+  for (uint32_t i = 0; i < m_nBands; i++)
+    {
+      rxSignal[i] = 1e-16 * (1 + i % 7);
+      allSignals[i] = rxSignal[i] + 1e-17 * (1 + i % 5);
+      noise[i] = 4e-21;
+    }
+  double duration = 1e-3 / 14;
+
+  typedef std::chrono::steady_clock Clock;
+
+  // SINR, as written with the SpectrumValue operators
+  SpectrumValue sumSinr (model);
+  Clock::time_point start = Clock::now ();
+  for (uint32_t i = 0; i < m_iterations; i++)
+    {
+      SpectrumValue interf = allSignals - rxSignal + noise;
+      SpectrumValue sinr = rxSignal / interf;
+      sumSinr += sinr * duration;
+    }
+  Report ("operators", std::chrono::duration<double> (Clock::now () - start).count ());
+
+  // SINR, with the fused operations and reused buffers
+  SpectrumValue fusedSumSinr (model);
+  SpectrumValue interf;
+  SpectrumValue sinr;
+  start = Clock::now ();
+  for (uint32_t i = 0; i < m_iterations; i++)
+    {
+      ComputeSinr (rxSignal, allSignals, noise, interf, sinr);
+      fusedSumSinr.AddScaled (sinr, duration);
+    }
+  Report ("fused operations", std::chrono::duration<double> (Clock::now () - start).count ());
+
+  NS_TEST_ASSERT_MSG_SPECTRUM_VALUE_EQ_TOL (fusedSumSinr, sumSinr, 1e-9, "fused operations give a different SINR");
+}
+
+/**
+ * \ingroup spectrum-tests
+ *
+ * \brief SpectrumValue performance test suite
+ */
+class SpectrumValuePerformanceSuite : public TestSuite
+{
+public:
+  SpectrumValuePerformanceSuite ();
+};
+
+SpectrumValuePerformanceSuite::SpectrumValuePerformanceSuite ()
+  : TestSuite ("spectrum-value-perf", PERFORMANCE)
+{
+  // 6 and 100 resource blocks (1.4 and 20 MHz LTE), and a finer model
+  AddTestCase (new SpectrumValueBenchmarkTestCase (6, 1000000), TestCase::QUICK);
+  AddTestCase (new SpectrumValueBenchmarkTestCase (100, 200000), TestCase::QUICK);
+  AddTestCase (new SpectrumValueBenchmarkTestCase (1000, 20000), TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static SpectrumValuePerformanceSuite g_spectrumValuePerformanceSuite;
@@ -242,6 +242,21 @@ SpectrumValueTestSuite::SpectrumValueTestSuite ()
   AddTestCase (new SpectrumValueTestCase (tv1rs3, v1rs3, "tv1rs3 = v1 >> 3"), TestCase::QUICK);
 
 
+  SpectrumValue tv11 (f);
+  tv11 = v1;
+  tv11.AddScaled (v2, doubleValue);
+  AddTestCase (new SpectrumValueTestCase (tv11, v1 + v2 * doubleValue, "tv11.AddScaled (v2, doubleValue)"), TestCase::QUICK);
+
+  // the results are allocated by ComputeSinr, then reused
+  SpectrumValue interference, sinr;
+  SpectrumValue allSignals = v1 + v2 + v3;
+  ComputeSinr (v1, allSignals, v4, interference, sinr);
+  AddTestCase (new SpectrumValueTestCase (interference, allSignals - v1 + v4, "ComputeSinr interference"), TestCase::QUICK);
+  AddTestCase (new SpectrumValueTestCase (sinr, v1 / (allSignals - v1 + v4), "ComputeSinr sinr"), TestCase::QUICK);
+  ComputeSinr (v2, allSignals, v4, interference, sinr);
+  AddTestCase (new SpectrumValueTestCase (sinr, v2 / (allSignals - v2 + v4), "ComputeSinr sinr, reused"), TestCase::QUICK);
+
+
 }
 
 
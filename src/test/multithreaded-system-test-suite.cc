@@ -0,0 +1,236 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-container.h"
+#include "ns3/application-container.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/bulk-send-helper.h"
+#include "ns3/on-off-helper.h"
+#include "ns3/packet-sink.h"
+#include "ns3/packet-sink-helper.h"
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup tests
+ *
+ * \brief End to end simulation with the MultithreadedSimulatorImpl
+ *
+ * A TCP bulk transfer runs in each direction between the ends of a chain
+ * of nodes connected by point-to-point links. In addition, an event of
+ * each node creates, while the simulation runs, an OnOffApplication whose
+ * random on and off times send UDP packets to the next node: the streams
+ * of these random variables are allocated by the partitions running in
+ * parallel. The packets received by each node must be the same with any
+ * number of threads, and when the simulation is repeated.
+ */
+class MultithreadedSystemTestCase : public TestCase
+{
+public:
+  MultithreadedSystemTestCase ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /** The packets received by a node: (time, size) */
+  typedef std::vector<std::pair<int64_t, uint32_t> > Log;
+
+  /**
+   * \brief Run the simulation
+   *
+   * \param threadCount The number of threads
+   * \param tcpRx Set to the number of bytes received by the TCP sinks
+   * \returns The packets received by each node
+   */
+  std::vector<Log> RunSimulation (uint32_t threadCount, uint64_t &tcpRx);
+
+  /**
+   * \brief Install an OnOffApplication, from an event of the node
+   *
+   * \param node The node
+   * \param to The destination of the packets
+   */
+  void InstallOnOff (Ptr<Node> node, Address to);
+
+  /**
+   * \brief Log a packet received by a sink
+   *
+   * \param packet The packet
+   * \param from The source of the packet
+   */
+  void Receive (Ptr<const Packet> packet, const Address &from);
+
+  /** Number of nodes */
+  static const uint32_t N_NODES = 4;
+  /** Number of bytes sent by each TCP bulk transfer */
+  static const uint32_t TCP_BYTES = 300000;
+  std::vector<Log> m_logs; //!< The packets received by each node
+};
+
+MultithreadedSystemTestCase::MultithreadedSystemTestCase ()
+  : TestCase ("TCP and run time applications over point-to-point links with MultithreadedSimulatorImpl")
+{
+}
+
+void
+MultithreadedSystemTestCase::InstallOnOff (Ptr<Node> node, Address to)
+{
+  // The random variables are created, hence get their streams, now
+  OnOffHelper onoff ("ns3::UdpSocketFactory", to);
+  onoff.SetAttribute ("OnTime", StringValue ("ns3::ExponentialRandomVariable[Mean=0.05]"));
+  onoff.SetAttribute ("OffTime", StringValue ("ns3::ExponentialRandomVariable[Mean=0.05]"));
+  onoff.SetAttribute ("DataRate", StringValue ("1Mbps"));
+  onoff.SetAttribute ("PacketSize", UintegerValue (200 + 100 * node->GetId ()));
+  ApplicationContainer apps = onoff.Install (node);
+  apps.Stop (Seconds (2));
+}
+
+void
+MultithreadedSystemTestCase::Receive (Ptr<const Packet> packet, const Address &from)
+{
+  // The sinks are executed by the partition of their node
+  m_logs[Simulator::GetContext ()].push_back (std::make_pair (Simulator::Now ().GetTimeStep (),
+                                                              packet->GetSize ()));
+}
+
+std::vector<MultithreadedSystemTestCase::Log>
+MultithreadedSystemTestCase::RunSimulation (uint32_t threadCount, uint64_t &tcpRx)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (threadCount));
+  m_logs.assign (N_NODES, Log ());
+
+  NodeContainer nodes;
+  nodes.Create (N_NODES);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  internet.AssignStreams (nodes, 0);
+
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("5Mbps"));
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.0.0", "255.255.255.0");
+  std::vector<Ipv4InterfaceContainer> interfaces;
+  for (uint32_t i = 0; i + 1 < N_NODES; i++)
+    {
+      p2p.SetChannelAttribute ("Delay", TimeValue (MicroSeconds (500 + 100 * i)));
+      interfaces.push_back (ipv4.Assign (p2p.Install (nodes.Get (i), nodes.Get (i + 1))));
+      ipv4.NewNetwork ();
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  // TCP between the ends of the chain, UDP from each node to the next one
+  PacketSinkHelper tcpSink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  ApplicationContainer tcpSinks;
+  tcpSinks.Add (tcpSink.Install (nodes.Get (0)));
+  tcpSinks.Add (tcpSink.Install (nodes.Get (N_NODES - 1)));
+  PacketSinkHelper udpSink ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), 9));
+  ApplicationContainer sinks = udpSink.Install (nodes);
+  sinks.Add (tcpSinks);
+  for (uint32_t i = 0; i < sinks.GetN (); i++)
+    {
+      sinks.Get (i)->TraceConnectWithoutContext ("Rx", MakeCallback (&MultithreadedSystemTestCase::Receive, this));
+    }
+
+  Address first (InetSocketAddress (interfaces.front ().GetAddress (0), 50000));
+  Address last (InetSocketAddress (interfaces.back ().GetAddress (1), 50000));
+  BulkSendHelper bulk ("ns3::TcpSocketFactory", last);
+  bulk.SetAttribute ("MaxBytes", UintegerValue (TCP_BYTES));
+  ApplicationContainer bulks = bulk.Install (nodes.Get (0));
+  bulk.SetAttribute ("Remote", AddressValue (first));
+  bulks.Add (bulk.Install (nodes.Get (N_NODES - 1)));
+  bulks.Start (Seconds (0.1));
+
+  for (uint32_t i = 0; i + 1 < N_NODES; i++)
+    {
+      Address to (InetSocketAddress (interfaces[i].GetAddress (1), 9));
+      Simulator::ScheduleWithContext (i, Seconds (0.2) + MicroSeconds (i),
+                                      &MultithreadedSystemTestCase::InstallOnOff, this,
+                                      nodes.Get (i), to);
+    }
+
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+
+  tcpRx = 0;
+  for (uint32_t i = 0; i < tcpSinks.GetN (); i++)
+    {
+      tcpRx += DynamicCast<PacketSink> (tcpSinks.Get (i))->GetTotalRx ();
+    }
+  Simulator::Destroy ();
+  return m_logs;
+}
+
+void
+MultithreadedSystemTestCase::DoRun (void)
+{
+  uint64_t expectedTcpRx;
+  std::vector<Log> expected = RunSimulation (1, expectedTcpRx);
+  NS_TEST_ASSERT_MSG_EQ (expectedTcpRx, 2 * TCP_BYTES, "The TCP transfers did not complete");
+  for (uint32_t i = 1; i < N_NODES; i++)
+    {
+      NS_TEST_ASSERT_MSG_GT (expected[i].size (), 100, "Too few packets received by node " << i);
+    }
+
+  uint32_t threadCounts[] = { 2, N_NODES, N_NODES };
+  for (uint32_t t = 0; t < sizeof (threadCounts) / sizeof (threadCounts[0]); t++)
+    {
+      uint64_t tcpRx;
+      std::vector<Log> logs = RunSimulation (threadCounts[t], tcpRx);
+      NS_TEST_ASSERT_MSG_EQ (tcpRx, expectedTcpRx, "Wrong TCP bytes with " << threadCounts[t] << " threads");
+      for (uint32_t i = 0; i < N_NODES; i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (logs[i].size (), expected[i].size (),
+                                 "Wrong number of packets received by node " << i << " with " << threadCounts[t] << " threads");
+          NS_TEST_ASSERT_MSG_EQ ((logs[i] == expected[i]), true,
+                                 "Wrong packets received by node " << i << " with " << threadCounts[t] << " threads");
+        }
+    }
+}
+
+void
+MultithreadedSystemTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (0));
+}
+
+/**
+ * \ingroup tests
+ *
+ * \brief MultithreadedSimulatorImpl end to end test suite
+ */
+static class MultithreadedSystemTestSuite : public TestSuite
+{
+public:
+  MultithreadedSystemTestSuite ()
+    : TestSuite ("multithreaded-system", SYSTEM)
+  {
+    AddTestCase (new MultithreadedSystemTestCase (), TestCase::QUICK);
+  }
+} g_multithreadedSystemTestSuite; ///< the test suite
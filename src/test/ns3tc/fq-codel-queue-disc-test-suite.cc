@@ -22,6 +22,7 @@
 #include "ns3/test.h"
 #include "ns3/simulator.h"
 #include "ns3/fq-codel-queue-disc.h"
+#include "ns3/fq-codel-flat-queue-disc.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/ipv4-packet-filter.h"
 #include "ns3/ipv4-queue-disc-item.h"
@@ -33,6 +34,7 @@
 #include "ns3/udp-header.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/random-variable-stream.h"
 
 using namespace ns3;
 
@@ -485,6 +487,126 @@ FqCoDelQueueDiscUDPFlowsSeparation::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * This class tests that FqCoDelFlatQueueDisc dequeues packets in the same
+ * order as FqCoDelQueueDisc
+ */
+class FqCoDelFlatQueueDiscSameOrder : public TestCase
+{
+public:
+  FqCoDelFlatQueueDiscSameOrder ();
+  virtual ~FqCoDelFlatQueueDiscSameOrder ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Enqueue and dequeue the same packets into and from both queue discs
+   * \param nArrivals the number of packets to enqueue
+   * \param nDepartures the number of packets to dequeue
+   */
+  void Step (uint32_t nArrivals, uint32_t nDepartures);
+
+  Ptr<FqCoDelQueueDisc> m_fqCoDel;          //!< the FqCoDel queue disc
+  Ptr<FqCoDelFlatQueueDisc> m_fqCoDelFlat;  //!< the flat FqCoDel queue disc
+  Ptr<UniformRandomVariable> m_rng;         //!< random flows and packet sizes
+  uint16_t m_seq;                           //!< sequence number of the next packet
+  uint32_t m_nDequeued;                     //!< number of dequeued packets
+};
+
+FqCoDelFlatQueueDiscSameOrder::FqCoDelFlatQueueDiscSameOrder ()
+  : TestCase ("Test that the flat FqCoDel dequeues packets in the same order as FqCoDel"),
+    m_seq (0),
+    m_nDequeued (0)
+{
+}
+
+FqCoDelFlatQueueDiscSameOrder::~FqCoDelFlatQueueDiscSameOrder ()
+{
+}
+
+void
+FqCoDelFlatQueueDiscSameOrder::Step (uint32_t nArrivals, uint32_t nDepartures)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nArrivals; i++)
+    {
+      uint32_t flow = m_rng->GetInteger (0, 39);
+      uint32_t size = m_rng->GetInteger (40, 1460);
+
+      Ipv4Header hdr;
+      hdr.SetPayloadSize (size);
+      hdr.SetSource (Ipv4Address ("10.10.1.1"));
+      hdr.SetDestination (Ipv4Address (Ipv4Address ("10.10.2.0").Get () + flow));
+      hdr.SetProtocol (7);
+      hdr.SetIdentification (m_seq++);
+
+      m_fqCoDel->Enqueue (Create<Ipv4QueueDiscItem> (Create<Packet> (size), dest, 0, hdr));
+      m_fqCoDelFlat->Enqueue (Create<Ipv4QueueDiscItem> (Create<Packet> (size), dest, 0, hdr));
+    }
+
+  for (uint32_t i = 0; i < nDepartures; i++)
+    {
+      Ptr<QueueDiscItem> item = m_fqCoDel->Dequeue ();
+      Ptr<QueueDiscItem> flatItem = m_fqCoDelFlat->Dequeue ();
+      NS_TEST_ASSERT_MSG_EQ ((item == 0), (flatItem == 0), "Both queue discs should return a packet or none");
+      if (item == 0)
+        {
+          break;
+        }
+      m_nDequeued++;
+      NS_TEST_ASSERT_MSG_EQ (DynamicCast<Ipv4QueueDiscItem> (flatItem)->GetHeader ().GetIdentification (),
+                             DynamicCast<Ipv4QueueDiscItem> (item)->GetHeader ().GetIdentification (),
+                             "The queue discs should dequeue the same packet");
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (m_fqCoDelFlat->GetNPackets (), m_fqCoDel->GetNPackets (), "The queue discs should hold the same packets");
+  NS_TEST_ASSERT_MSG_EQ (m_fqCoDelFlat->GetNBytes (), m_fqCoDel->GetNBytes (), "The queue discs should hold the same bytes");
+}
+
+void
+FqCoDelFlatQueueDiscSameOrder::DoRun (void)
+{
+  // Use fewer flow queues than flows, so that some flows share a queue
+  m_fqCoDel = CreateObjectWithAttributes<FqCoDelQueueDisc> ("PacketLimit", UintegerValue (200),
+                                                            "Flows", UintegerValue (32),
+                                                            "DropBatchSize", UintegerValue (8));
+  m_fqCoDel->AddPacketFilter (CreateObject<FqCoDelIpv4PacketFilter> ());
+  m_fqCoDel->SetQuantum (1500);
+  m_fqCoDel->Initialize ();
+
+  m_fqCoDelFlat = CreateObjectWithAttributes<FqCoDelFlatQueueDisc> ("PacketLimit", UintegerValue (200),
+                                                                    "Flows", UintegerValue (32),
+                                                                    "DropBatchSize", UintegerValue (8));
+  m_fqCoDelFlat->AddPacketFilter (CreateObject<FqCoDelIpv4PacketFilter> ());
+  m_fqCoDelFlat->SetQuantum (1500);
+  m_fqCoDelFlat->Initialize ();
+
+  m_rng = CreateObject<UniformRandomVariable> ();
+  m_rng->SetStream (7);
+
+  // Overload the queue discs for 2 seconds, so that both CoDel and overlimit
+  // drops occur, then drain them at a lower load
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      Simulator::Schedule (MilliSeconds (i), &FqCoDelFlatQueueDiscSameOrder::Step, this, 3, 2);
+    }
+  for (uint32_t i = 2000; i < 3000; i++)
+    {
+      Simulator::Schedule (MilliSeconds (i), &FqCoDelFlatQueueDiscSameOrder::Step, this, 1, 3);
+    }
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_GT (m_fqCoDelFlat->GetOverlimitDroppedPackets (), 0, "There should be overlimit drops");
+  NS_TEST_EXPECT_MSG_GT (m_fqCoDelFlat->GetCoDelDroppedPackets (), 0, "There should be CoDel drops");
+  NS_TEST_EXPECT_MSG_EQ (m_fqCoDelFlat->GetTotalDroppedPackets (), m_fqCoDel->GetTotalDroppedPackets (),
+                         "The queue discs should drop the same number of packets");
+  NS_TEST_EXPECT_MSG_GT (m_nDequeued, 4000, "Most packets should have been dequeued");
+
+  m_fqCoDel = 0;
+  m_fqCoDelFlat = 0;
+  Simulator::Destroy ();
+}
+
 class FqCoDelQueueDiscTestSuite : public TestSuite
 {
 public:
@@ -499,6 +621,7 @@ FqCoDelQueueDiscTestSuite::FqCoDelQueueDiscTestSuite ()
   AddTestCase (new FqCoDelQueueDiscDeficit, TestCase::QUICK);
   AddTestCase (new FqCoDelQueueDiscTCPFlowsSeparation, TestCase::QUICK);
   AddTestCase (new FqCoDelQueueDiscUDPFlowsSeparation, TestCase::QUICK);
+  AddTestCase (new FqCoDelFlatQueueDiscSameOrder, TestCase::QUICK);
 }
 
 static FqCoDelQueueDiscTestSuite fqCoDelQueueDiscTestSuite;
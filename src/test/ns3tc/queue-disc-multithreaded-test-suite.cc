@@ -0,0 +1,251 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/node-container.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/traffic-control-helper.h"
+#include "ns3/queue-disc.h"
+#include "ns3/socket.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue discs of an IPv4 and IPv6 network with the MultithreadedSimulatorImpl
+ *
+ * UDP packets are exchanged over IPv4 between the ends of a chain of
+ * nodes connected by point-to-point links, and over IPv6 between the
+ * nodes of each link, so that the IPv4 and IPv6 queue disc items are
+ * allocated and freed by all the partitions at the same time. The packets
+ * received by each node must be the same as with the DefaultSimulatorImpl.
+ */
+class QueueDiscMultithreadedTestCase : public TestCase
+{
+public:
+  QueueDiscMultithreadedTestCase ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /** The packets received by a node: (time, size) */
+  typedef std::vector<std::pair<int64_t, uint32_t> > Log;
+
+  /**
+   * \brief Run the simulation with a simulator implementation
+   *
+   * \param simulatorType The simulator implementation
+   * \param nQueued Set to the number of packets received by the queue discs
+   * \returns The packets received by each node
+   */
+  std::vector<Log> RunSimulation (std::string simulatorType, uint32_t &nQueued);
+
+  /**
+   * \brief Receive the packets of a socket
+   *
+   * \param socket The socket
+   */
+  void Receive (Ptr<Socket> socket);
+
+  /**
+   * \brief Send a packet
+   *
+   * \param socket The sending socket
+   * \param to The destination
+   * \param size The size of the packet
+   */
+  void Send (Ptr<Socket> socket, Address to, uint32_t size);
+
+  /** Number of nodes */
+  static const uint32_t N_NODES = 4;
+  std::vector<Log> m_logs; //!< The packets received by each node
+};
+
+QueueDiscMultithreadedTestCase::QueueDiscMultithreadedTestCase ()
+  : TestCase ("Queue discs of IPv4 and IPv6 point-to-point links with MultithreadedSimulatorImpl")
+{
+}
+
+void
+QueueDiscMultithreadedTestCase::Receive (Ptr<Socket> socket)
+{
+  uint32_t node = socket->GetNode ()->GetId ();
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv ()))
+    {
+      m_logs[node].push_back (std::make_pair (Simulator::Now ().GetTimeStep (), packet->GetSize ()));
+    }
+}
+
+void
+QueueDiscMultithreadedTestCase::Send (Ptr<Socket> socket, Address to, uint32_t size)
+{
+  socket->SendTo (Create<Packet> (size), 0, to);
+}
+
+std::vector<QueueDiscMultithreadedTestCase::Log>
+QueueDiscMultithreadedTestCase::RunSimulation (std::string simulatorType, uint32_t &nQueued)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (simulatorType));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (N_NODES));
+  // The duplicate address detection is scheduled without a context, i.e.,
+  // in a partition which may not be the one of the node
+  Config::SetDefault ("ns3::Icmpv6L4Protocol::DAD", BooleanValue (false));
+  m_logs.assign (N_NODES, Log ());
+
+  NodeContainer nodes;
+  nodes.Create (N_NODES);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  internet.AssignStreams (nodes, 0);
+
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  TrafficControlHelper tch = TrafficControlHelper::Default ();
+  QueueDiscContainer queueDiscs;
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.0.0", "255.255.255.0");
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  std::vector<Ipv4InterfaceContainer> ipv4Interfaces;
+  std::vector<Ipv6InterfaceContainer> ipv6Interfaces;
+  for (uint32_t i = 0; i + 1 < N_NODES; i++)
+    {
+      p2p.SetChannelAttribute ("Delay", TimeValue (MicroSeconds (500 + 100 * i)));
+      NetDeviceContainer devices = p2p.Install (nodes.Get (i), nodes.Get (i + 1));
+      queueDiscs.Add (tch.Install (devices));
+      ipv4Interfaces.push_back (ipv4.Assign (devices));
+      ipv4.NewNetwork ();
+      ipv6Interfaces.push_back (ipv6.Assign (devices));
+      ipv6.NewNetwork ();
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  std::vector<Ptr<Socket> > sockets;
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      Ptr<Socket> socket = Socket::CreateSocket (nodes.Get (i), UdpSocketFactory::GetTypeId ());
+      socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 9));
+      socket->SetRecvCallback (MakeCallback (&QueueDiscMultithreadedTestCase::Receive, this));
+      Ptr<Socket> socket6 = Socket::CreateSocket (nodes.Get (i), UdpSocketFactory::GetTypeId ());
+      socket6->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), 9));
+      socket6->SetRecvCallback (MakeCallback (&QueueDiscMultithreadedTestCase::Receive, this));
+      sockets.push_back (socket);
+      sockets.push_back (socket6);
+    }
+
+  // IPv4 between the ends of the chain, once the links are up
+  Address first (InetSocketAddress (ipv4Interfaces.front ().GetAddress (0), 9));
+  Address last (InetSocketAddress (ipv4Interfaces.back ().GetAddress (1), 9));
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      Simulator::ScheduleWithContext (0, Seconds (1) + MicroSeconds (70 * i),
+                                      &QueueDiscMultithreadedTestCase::Send, this,
+                                      sockets[0], last, 100 + i);
+      Simulator::ScheduleWithContext (N_NODES - 1, Seconds (1) + MicroSeconds (90 * i),
+                                      &QueueDiscMultithreadedTestCase::Send, this,
+                                      sockets[2 * (N_NODES - 1)], first, 300 + i);
+    }
+  // IPv6 across each link
+  for (uint32_t link = 0; link + 1 < N_NODES; link++)
+    {
+      for (uint32_t side = 0; side < 2; side++)
+        {
+          uint32_t node = link + side;
+          Address to (Inet6SocketAddress (ipv6Interfaces[link].GetAddress (1 - side, 1), 9));
+          for (uint32_t i = 0; i < 100; i++)
+            {
+              Simulator::ScheduleWithContext (node, Seconds (3) + MicroSeconds (110 * i + 13 * node),
+                                              &QueueDiscMultithreadedTestCase::Send, this,
+                                              sockets[2 * node + 1], to, 500 + i);
+            }
+        }
+    }
+
+  Simulator::Stop (Seconds (4));
+  Simulator::Run ();
+
+  nQueued = 0;
+  for (uint32_t i = 0; i < queueDiscs.GetN (); i++)
+    {
+      nQueued += queueDiscs.Get (i)->GetTotalReceivedPackets ();
+    }
+  Simulator::Destroy ();
+  return m_logs;
+}
+
+void
+QueueDiscMultithreadedTestCase::DoRun (void)
+{
+  uint32_t expectedQueued;
+  uint32_t nQueued;
+  std::vector<Log> expected = RunSimulation ("ns3::DefaultSimulatorImpl", expectedQueued);
+  std::vector<Log> logs = RunSimulation ("ns3::MultithreadedSimulatorImpl", nQueued);
+  // IPv4 packets in both directions across three links, IPv6 packets from each side of each link
+  NS_TEST_ASSERT_MSG_EQ (expectedQueued, 2 * 3 * 200 + 3 * 2 * 100, "Wrong number of packets went through the queue discs");
+  NS_TEST_ASSERT_MSG_EQ (nQueued, expectedQueued, "Wrong number of packets received by the queue discs");
+  for (uint32_t i = 0; i < N_NODES; i++)
+    {
+      // IPv4 packets from the other end, IPv6 packets from each neighbor
+      uint32_t nPackets = (i == 0 || i == N_NODES - 1) ? 200 + 100 : 2 * 100;
+      NS_TEST_ASSERT_MSG_EQ (expected[i].size (), nPackets, "Wrong number of packets received by node " << i);
+      std::sort (expected[i].begin (), expected[i].end ());
+      std::sort (logs[i].begin (), logs[i].end ());
+      NS_TEST_ASSERT_MSG_EQ ((logs[i] == expected[i]), true, "Wrong packets received by node " << i);
+    }
+}
+
+void
+QueueDiscMultithreadedTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (0));
+  Config::SetDefault ("ns3::Icmpv6L4Protocol::DAD", BooleanValue (true));
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue discs with the MultithreadedSimulatorImpl test suite
+ */
+static class QueueDiscMultithreadedTestSuite : public TestSuite
+{
+public:
+  QueueDiscMultithreadedTestSuite ()
+    : TestSuite ("queue-disc-multithreaded", SYSTEM)
+  {
+    AddTestCase (new QueueDiscMultithreadedTestCase (), TestCase::QUICK);
+  }
+} g_queueDiscMultithreadedTestSuite; ///< the test suite
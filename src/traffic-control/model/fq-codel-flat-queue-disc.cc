@@ -0,0 +1,677 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "codel-queue-disc.h"
+#include "fq-codel-flat-queue-disc.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FqCoDelFlatQueueDisc");
+
+/**
+ * Performs a reciprocal divide, similar to the
+ * Linux kernel reciprocal_divide function
+ * \param A numerator
+ * \param R reciprocal of the denominator B
+ * \return the value of A/B
+ */
+static inline uint32_t ReciprocalDivide (uint32_t A, uint32_t R)
+{
+  return (uint32_t)(((uint64_t)A * R) >> 32);
+}
+
+/**
+ * Translates a time in CoDel time representation
+ * \param t the time
+ * \return the time in CoDel time units
+ */
+static inline uint32_t Time2CoDel (Time t)
+{
+  return (t.GetNanoSeconds () >> CODEL_SHIFT);
+}
+
+/**
+ * Check if CoDel time a is successive to b
+ * \param a left operand
+ * \param b right operand
+ * \return true if a is greater than b
+ */
+static inline bool CoDelTimeAfter (uint32_t a, uint32_t b)
+{
+  return ((int)(a) - (int)(b) > 0);
+}
+
+/**
+ * Check if CoDel time a is successive or equal to b
+ * \param a left operand
+ * \param b right operand
+ * \return true if a is greater than or equal to b
+ */
+static inline bool CoDelTimeAfterEq (uint32_t a, uint32_t b)
+{
+  return ((int)(a) - (int)(b) >= 0);
+}
+
+/**
+ * Check if CoDel time a is preceding b
+ * \param a left operand
+ * \param b right operand
+ * \return true if a is less than b
+ */
+static inline bool CoDelTimeBefore (uint32_t a, uint32_t b)
+{
+  return ((int)(a) - (int)(b) < 0);
+}
+
+NS_OBJECT_ENSURE_REGISTERED (FqCoDelFlatQueueDisc);
+
+TypeId FqCoDelFlatQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FqCoDelFlatQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<FqCoDelFlatQueueDisc> ()
+    .AddAttribute ("Interval",
+                   "The CoDel algorithm interval for each FQCoDel queue",
+                   StringValue ("100ms"),
+                   MakeStringAccessor (&FqCoDelFlatQueueDisc::m_interval),
+                   MakeStringChecker ())
+    .AddAttribute ("Target",
+                   "The CoDel algorithm target queue delay for each FQCoDel queue",
+                   StringValue ("5ms"),
+                   MakeStringAccessor (&FqCoDelFlatQueueDisc::m_target),
+                   MakeStringChecker ())
+    .AddAttribute ("PacketLimit",
+                   "The hard limit on the real queue size, measured in packets",
+                   UintegerValue (10 * 1024),
+                   MakeUintegerAccessor (&FqCoDelFlatQueueDisc::m_limit),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Flows",
+                   "The number of queues into which the incoming packets are classified",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&FqCoDelFlatQueueDisc::m_flows),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("DropBatchSize",
+                   "The maximum number of packets dropped from the fat flow",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&FqCoDelFlatQueueDisc::m_dropBatchSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MinBytes",
+                   "The CoDel algorithm minbytes parameter for each FQCoDel queue",
+                   UintegerValue (1500),
+                   MakeUintegerAccessor (&FqCoDelFlatQueueDisc::m_minBytes),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+FqCoDelFlatQueueDisc::FqCoDelFlatQueueDisc ()
+  : m_quantum (0),
+    m_overlimitDroppedPackets (0),
+    m_codelDroppedPackets (0),
+    m_codelInterval (0),
+    m_codelTarget (0),
+    m_freeSlots (NONE)
+{
+  NS_LOG_FUNCTION (this);
+  m_newFlows.m_head = m_newFlows.m_tail = NONE;
+  m_oldFlows.m_head = m_oldFlows.m_tail = NONE;
+}
+
+FqCoDelFlatQueueDisc::~FqCoDelFlatQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FqCoDelFlatQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_flowTable.clear ();
+  m_flowOrder.clear ();
+  m_slots.clear ();
+  m_freeSlots = NONE;
+  m_newFlows.m_head = m_newFlows.m_tail = NONE;
+  m_oldFlows.m_head = m_oldFlows.m_tail = NONE;
+  QueueDisc::DoDispose ();
+}
+
+void
+FqCoDelFlatQueueDisc::SetQuantum (uint32_t quantum)
+{
+  NS_LOG_FUNCTION (this << quantum);
+  m_quantum = quantum;
+}
+
+uint32_t
+FqCoDelFlatQueueDisc::GetQuantum (void) const
+{
+  return m_quantum;
+}
+
+uint32_t
+FqCoDelFlatQueueDisc::GetOverlimitDroppedPackets (void) const
+{
+  return m_overlimitDroppedPackets;
+}
+
+uint32_t
+FqCoDelFlatQueueDisc::GetCoDelDroppedPackets (void) const
+{
+  return m_codelDroppedPackets;
+}
+
+void
+FqCoDelFlatQueueDisc::PushBack (FlowList &list, uint32_t flow)
+{
+  m_flowTable[flow].m_next = NONE;
+  if (list.m_tail == NONE)
+    {
+      list.m_head = flow;
+    }
+  else
+    {
+      m_flowTable[list.m_tail].m_next = flow;
+    }
+  list.m_tail = flow;
+}
+
+void
+FqCoDelFlatQueueDisc::PopFront (FlowList &list)
+{
+  NS_ASSERT (list.m_head != NONE);
+  uint32_t flow = list.m_head;
+  list.m_head = m_flowTable[flow].m_next;
+  if (list.m_head == NONE)
+    {
+      list.m_tail = NONE;
+    }
+  m_flowTable[flow].m_next = NONE;
+}
+
+void
+FqCoDelFlatQueueDisc::FlowEnqueue (uint32_t flow, Ptr<QueueDiscItem> item)
+{
+  uint32_t slot = m_freeSlots;
+  if (slot == NONE)
+    {
+      // all the preallocated slots are in use
+      slot = m_slots.size ();
+      m_slots.push_back (Slot ());
+    }
+  else
+    {
+      m_freeSlots = m_slots[slot].m_next;
+    }
+
+  m_slots[slot].m_item = item;
+  m_slots[slot].m_enqueueTime = Simulator::Now ();
+  m_slots[slot].m_next = NONE;
+
+  Flow &f = m_flowTable[flow];
+  if (f.m_tail == NONE)
+    {
+      f.m_head = slot;
+    }
+  else
+    {
+      m_slots[f.m_tail].m_next = slot;
+    }
+  f.m_tail = slot;
+  f.m_nPackets++;
+  f.m_nBytes += item->GetPacketSize ();
+}
+
+Ptr<QueueDiscItem>
+FqCoDelFlatQueueDisc::FlowRemove (uint32_t flow, Time &enqueueTime)
+{
+  Flow &f = m_flowTable[flow];
+  if (f.m_head == NONE)
+    {
+      return 0;
+    }
+
+  uint32_t slot = f.m_head;
+  Ptr<QueueDiscItem> item = m_slots[slot].m_item;
+  enqueueTime = m_slots[slot].m_enqueueTime;
+
+  f.m_head = m_slots[slot].m_next;
+  if (f.m_head == NONE)
+    {
+      f.m_tail = NONE;
+    }
+  f.m_nPackets--;
+  f.m_nBytes -= item->GetPacketSize ();
+
+  m_slots[slot].m_item = 0;
+  m_slots[slot].m_next = m_freeSlots;
+  m_freeSlots = slot;
+
+  return item;
+}
+
+bool
+FqCoDelFlatQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  int32_t ret = Classify (item);
+
+  if (ret == PacketFilter::PF_NO_MATCH)
+    {
+      NS_LOG_ERROR ("No filter has been able to classify this packet, drop it.");
+      Drop (item);
+      return false;
+    }
+
+  uint32_t h = ret % m_flows;
+  Flow &flow = m_flowTable[h];
+
+  if (!flow.m_created)
+    {
+      NS_LOG_DEBUG ("Creating a new flow queue with index " << h);
+      flow.m_created = true;
+      m_flowOrder.push_back (h);
+    }
+
+  if (flow.m_status == INACTIVE)
+    {
+      flow.m_status = NEW_FLOW;
+      flow.m_deficit = m_quantum;
+      PushBack (m_newFlows, h);
+    }
+
+  // A flow queue cannot hold more than PacketLimit + 1 packets, hence the
+  // CoDel limit check is never triggered
+  FlowEnqueue (h, item);
+
+  NS_LOG_DEBUG ("Packet enqueued into flow " << h);
+
+  if (GetNPackets () > m_limit)
+    {
+      FqCoDelDrop ();
+    }
+
+  return true;
+}
+
+Ptr<QueueDiscItem>
+FqCoDelFlatQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t flow = NONE;
+  Ptr<QueueDiscItem> item;
+
+  do
+    {
+      bool found = false;
+
+      while (!found && m_newFlows.m_head != NONE)
+        {
+          flow = m_newFlows.m_head;
+
+          if (m_flowTable[flow].m_deficit <= 0)
+            {
+              m_flowTable[flow].m_deficit += m_quantum;
+              m_flowTable[flow].m_status = OLD_FLOW;
+              PopFront (m_newFlows);
+              PushBack (m_oldFlows, flow);
+            }
+          else
+            {
+              NS_LOG_DEBUG ("Found a new flow with positive deficit");
+              found = true;
+            }
+        }
+
+      while (!found && m_oldFlows.m_head != NONE)
+        {
+          flow = m_oldFlows.m_head;
+
+          if (m_flowTable[flow].m_deficit <= 0)
+            {
+              m_flowTable[flow].m_deficit += m_quantum;
+              PopFront (m_oldFlows);
+              PushBack (m_oldFlows, flow);
+            }
+          else
+            {
+              NS_LOG_DEBUG ("Found an old flow with positive deficit");
+              found = true;
+            }
+        }
+
+      if (!found)
+        {
+          NS_LOG_DEBUG ("No flow found to dequeue a packet");
+          return 0;
+        }
+
+      item = FlowDequeue (flow);
+
+      if (!item)
+        {
+          NS_LOG_DEBUG ("Could not get a packet from the selected flow queue");
+          if (m_newFlows.m_head != NONE)
+            {
+              m_flowTable[flow].m_status = OLD_FLOW;
+              PopFront (m_newFlows);
+              PushBack (m_oldFlows, flow);
+            }
+          else
+            {
+              m_flowTable[flow].m_status = INACTIVE;
+              PopFront (m_oldFlows);
+            }
+        }
+      else
+        {
+          NS_LOG_DEBUG ("Dequeued packet " << item->GetPacket ());
+        }
+    } while (item == 0);
+
+  m_flowTable[flow].m_deficit -= item->GetPacketSize ();
+
+  return item;
+}
+
+Ptr<QueueDiscItem>
+FqCoDelFlatQueueDisc::FlowDequeue (uint32_t flow)
+{
+  NS_LOG_FUNCTION (this << flow);
+
+  Flow &f = m_flowTable[flow];
+  Time enqueueTime;
+  Ptr<QueueDiscItem> item = FlowRemove (flow, enqueueTime);
+  if (!item)
+    {
+      // Leave dropping state when queue is empty
+      f.m_dropping = false;
+      NS_LOG_LOGIC ("Flow queue empty");
+      return 0;
+    }
+  uint32_t now = Time2CoDel (Simulator::Now ());
+
+  // Determine if item should be dropped
+  bool okToDrop = OkToDrop (flow, item, enqueueTime, now);
+
+  if (f.m_dropping)
+    {
+      if (!okToDrop)
+        {
+          /* sojourn time fell below target - leave dropping state */
+          f.m_dropping = false;
+        }
+      else if (CoDelTimeAfterEq (now, f.m_dropNext))
+        {
+          while (f.m_dropping && CoDelTimeAfterEq (now, f.m_dropNext))
+            {
+              // It's time for the next drop. Drop the current packet and
+              // dequeue the next. The dequeue might take us out of dropping
+              // state. If not, schedule the next drop.
+              NS_LOG_LOGIC ("Sojourn time is still above target and it's time for next drop; dropping " << item);
+              Drop (item);
+              ++m_codelDroppedPackets;
+              ++f.m_count;
+              NewtonStep (flow);
+              item = FlowRemove (flow, enqueueTime);
+
+              if (!OkToDrop (flow, item, enqueueTime, now))
+                {
+                  /* leave dropping state */
+                  f.m_dropping = false;
+                }
+              else
+                {
+                  /* schedule the next drop */
+                  f.m_dropNext = ControlLaw (flow, f.m_dropNext);
+                }
+            }
+        }
+    }
+  else if (okToDrop)
+    {
+      // Drop the first packet and enter dropping state unless the queue is empty
+      NS_LOG_LOGIC ("Sojourn time goes above target, dropping the first packet " << item << " and entering the dropping state");
+      Drop (item);
+      ++m_codelDroppedPackets;
+      item = FlowRemove (flow, enqueueTime);
+
+      OkToDrop (flow, item, enqueueTime, now);
+      f.m_dropping = true;
+      /*
+       * if min went above target close to when we last went below it
+       * assume that the drop rate that controlled the queue on the
+       * last cycle is a good starting point to control it now.
+       */
+      int delta = f.m_count - f.m_lastCount;
+      if (delta > 1 && CoDelTimeBefore (now - f.m_dropNext, 16 * m_codelInterval))
+        {
+          f.m_count = delta;
+          NewtonStep (flow);
+        }
+      else
+        {
+          f.m_count = 1;
+          f.m_recInvSqrt = ~0U >> REC_INV_SQRT_SHIFT;
+        }
+      f.m_lastCount = f.m_count;
+      f.m_dropNext = ControlLaw (flow, now);
+    }
+  return item;
+}
+
+bool
+FqCoDelFlatQueueDisc::OkToDrop (uint32_t flow, Ptr<QueueDiscItem> item, Time enqueueTime, uint32_t now)
+{
+  Flow &f = m_flowTable[flow];
+
+  if (!item)
+    {
+      f.m_firstAboveTime = 0;
+      return false;
+    }
+
+  uint32_t sojournTime = Time2CoDel (Simulator::Now () - enqueueTime);
+
+  if (CoDelTimeBefore (sojournTime, m_codelTarget) || f.m_nBytes < m_minBytes)
+    {
+      // went below so we'll stay below for at least q->interval
+      f.m_firstAboveTime = 0;
+      return false;
+    }
+
+  bool okToDrop = false;
+  if (f.m_firstAboveTime == 0)
+    {
+      /* just went above from below. If we stay above
+       * for at least q->interval we'll say it's ok to drop
+       */
+      f.m_firstAboveTime = now + m_codelInterval;
+    }
+  else if (CoDelTimeAfter (now, f.m_firstAboveTime))
+    {
+      okToDrop = true;
+    }
+  return okToDrop;
+}
+
+void
+FqCoDelFlatQueueDisc::NewtonStep (uint32_t flow)
+{
+  Flow &f = m_flowTable[flow];
+  uint32_t invsqrt = ((uint32_t) f.m_recInvSqrt) << REC_INV_SQRT_SHIFT;
+  uint32_t invsqrt2 = ((uint64_t) invsqrt * invsqrt) >> 32;
+  uint64_t val = (3ll << 32) - ((uint64_t) f.m_count * invsqrt2);
+
+  val >>= 2; /* avoid overflow */
+  val = (val * invsqrt) >> (32 - 2 + 1);
+  f.m_recInvSqrt = val >> REC_INV_SQRT_SHIFT;
+}
+
+uint32_t
+FqCoDelFlatQueueDisc::ControlLaw (uint32_t flow, uint32_t t) const
+{
+  return t + ReciprocalDivide (m_codelInterval, m_flowTable[flow].m_recInvSqrt << REC_INV_SQRT_SHIFT);
+}
+
+Ptr<const QueueDiscItem>
+FqCoDelFlatQueueDisc::DoPeek (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t flow;
+
+  if (m_newFlows.m_head != NONE)
+    {
+      flow = m_newFlows.m_head;
+    }
+  else
+    {
+      if (m_oldFlows.m_head != NONE)
+        {
+          flow = m_oldFlows.m_head;
+        }
+      else
+        {
+          return 0;
+        }
+    }
+
+  if (m_flowTable[flow].m_head == NONE)
+    {
+      return 0;
+    }
+  return m_slots[m_flowTable[flow].m_head].m_item;
+}
+
+bool
+FqCoDelFlatQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNQueueDiscClasses () > 0)
+    {
+      NS_LOG_ERROR ("FqCoDelFlatQueueDisc cannot have classes");
+      return false;
+    }
+
+  if (GetNPacketFilters () == 0)
+    {
+      NS_LOG_ERROR ("FqCoDelFlatQueueDisc needs at least a packet filter");
+      return false;
+    }
+
+  if (GetNInternalQueues () > 0)
+    {
+      NS_LOG_ERROR ("FqCoDelFlatQueueDisc cannot have internal queues");
+      return false;
+    }
+
+  return true;
+}
+
+void
+FqCoDelFlatQueueDisc::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // we are at initialization time. If the user has not set a quantum value,
+  // set the quantum to the MTU of the device
+  if (!m_quantum)
+    {
+      Ptr<NetDevice> device = GetNetDevice ();
+      NS_ASSERT_MSG (device, "Device not set for the queue disc");
+      m_quantum = device->GetMtu ();
+      NS_LOG_DEBUG ("Setting the quantum to the MTU of the device: " << m_quantum);
+    }
+
+  m_codelInterval = Time2CoDel (Time (m_interval));
+  m_codelTarget = Time2CoDel (Time (m_target));
+
+  Flow flow;
+  flow.m_deficit = 0;
+  flow.m_status = INACTIVE;
+  flow.m_created = false;
+  flow.m_next = NONE;
+  flow.m_head = NONE;
+  flow.m_tail = NONE;
+  flow.m_nPackets = 0;
+  flow.m_nBytes = 0;
+  flow.m_count = 0;
+  flow.m_lastCount = 0;
+  flow.m_dropping = false;
+  flow.m_recInvSqrt = ~0U >> REC_INV_SQRT_SHIFT;
+  flow.m_firstAboveTime = 0;
+  flow.m_dropNext = 0;
+  m_flowTable.assign (m_flows, flow);
+  m_flowOrder.clear ();
+
+  // the queue disc holds at most PacketLimit + 1 packets at a time
+  m_slots.resize (m_limit + 1);
+  for (uint32_t i = 0; i < m_slots.size (); i++)
+    {
+      m_slots[i].m_next = (i + 1 < m_slots.size () ? i + 1 : NONE);
+    }
+  m_freeSlots = (m_slots.empty () ? NONE : 0);
+}
+
+uint32_t
+FqCoDelFlatQueueDisc::FqCoDelDrop (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t maxBacklog = 0, index = (m_flowOrder.empty () ? 0 : m_flowOrder[0]);
+
+  /* Queue is full! Find the fat flow and drop packet(s) from it */
+  for (uint32_t i = 0; i < m_flowOrder.size (); i++)
+    {
+      uint32_t bytes = m_flowTable[m_flowOrder[i]].m_nBytes;
+      if (bytes > maxBacklog)
+        {
+          maxBacklog = bytes;
+          index = m_flowOrder[i];
+        }
+    }
+
+  /* Our goal is to drop half of this fat flow backlog */
+  uint32_t len = 0, count = 0, threshold = maxBacklog >> 1;
+  Time enqueueTime;
+  Ptr<QueueDiscItem> item;
+
+  do
+    {
+      item = FlowRemove (index, enqueueTime);
+      if (!item)
+        {
+          break;
+        }
+      len += item->GetPacketSize ();
+      Drop (item);
+    } while (++count < m_dropBatchSize && len < threshold);
+
+  m_overlimitDroppedPackets += count;
+
+  return index;
+}
+
+} // namespace ns3
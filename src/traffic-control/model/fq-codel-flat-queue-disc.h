@@ -0,0 +1,242 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FQ_CODEL_FLAT_QUEUE_DISC
+#define FQ_CODEL_FLAT_QUEUE_DISC
+
+#include "ns3/queue-disc.h"
+#include "ns3/nstime.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief A FqCoDel packet queue disc with flat flow state
+ *
+ * This queue disc implements the same algorithm as FqCoDelQueueDisc, and
+ * dequeues packets in the same order, but keeps the state of the flows in
+ * preallocated arrays rather than in per-flow objects:
+ *
+ * - the state of all the flows (deficit, status and CoDel state) is kept in
+ *   a vector indexed by the flow hash, hence looking up the flow of a packet
+ *   does not require a map lookup nor the creation of any object;
+ * - the new and old flow lists are intrusive FIFO lists of flow indices,
+ *   linked through the flow state itself;
+ * - the packets of all the flows are stored in a single preallocated array
+ *   of slots, each flow queue being a list of slots, and the CoDel enqueue
+ *   timestamp is stored in the slot instead of a packet tag.
+ *
+ * The CoDel algorithm run on every flow queue is the same as the one of
+ * CoDelQueueDisc in packet mode.
+ */
+class FqCoDelFlatQueueDisc : public QueueDisc {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief FqCoDelFlatQueueDisc constructor
+   */
+  FqCoDelFlatQueueDisc ();
+
+  virtual ~FqCoDelFlatQueueDisc ();
+
+  /**
+   * \brief Set the quantum value.
+   *
+   * \param quantum The number of bytes each queue gets to dequeue on each round of the scheduling algorithm
+   */
+  void SetQuantum (uint32_t quantum);
+
+  /**
+   * \brief Get the quantum value.
+   *
+   * \returns The number of bytes each queue gets to dequeue on each round of the scheduling algorithm
+   */
+  uint32_t GetQuantum (void) const;
+
+  /**
+   * \brief Get the number of packets dropped because the queue disc was full
+   *
+   * \returns The number of overlimit dropped packets
+   */
+  uint32_t GetOverlimitDroppedPackets (void) const;
+
+  /**
+   * \brief Get the number of packets dropped by the CoDel algorithm
+   *
+   * \returns The number of packets dropped by CoDel on all the flow queues
+   */
+  uint32_t GetCoDelDroppedPackets (void) const;
+
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
+private:
+  /// Value used to mark the end of a list of flows or slots
+  static const uint32_t NONE = 0xffffffff;
+
+  /**
+   * \brief Used to determine the status of a flow queue
+   */
+  enum FlowStatus
+    {
+      INACTIVE,
+      NEW_FLOW,
+      OLD_FLOW
+    };
+
+  /**
+   * \brief The state of a flow queue
+   */
+  struct Flow
+  {
+    int32_t m_deficit;          //!< the deficit for this flow
+    FlowStatus m_status;        //!< the status of this flow
+    bool m_created;             //!< whether this flow has received a packet yet
+    uint32_t m_next;            //!< the next flow in the new or old flow list
+    uint32_t m_head;            //!< the first packet slot of this flow queue
+    uint32_t m_tail;            //!< the last packet slot of this flow queue
+    uint32_t m_nPackets;        //!< the number of packets in this flow queue
+    uint32_t m_nBytes;          //!< the number of bytes in this flow queue
+    // CoDel state
+    uint32_t m_count;           //!< number of packets dropped since entering the dropping state
+    uint32_t m_lastCount;       //!< last number of packets dropped since entering the dropping state
+    bool m_dropping;            //!< true if in the dropping state
+    uint16_t m_recInvSqrt;      //!< reciprocal inverse square root
+    uint32_t m_firstAboveTime;  //!< time to declare sojourn time above target
+    uint32_t m_dropNext;        //!< time to drop the next packet
+  };
+
+  /**
+   * \brief A packet slot
+   */
+  struct Slot
+  {
+    Ptr<QueueDiscItem> m_item;  //!< the stored item
+    Time m_enqueueTime;         //!< the time the item was enqueued
+    uint32_t m_next;            //!< the next slot of the same flow queue or of the free list
+  };
+
+  /**
+   * \brief A FIFO list of flows, linked through Flow::m_next
+   */
+  struct FlowList
+  {
+    uint32_t m_head;            //!< the first flow of the list
+    uint32_t m_tail;            //!< the last flow of the list
+  };
+
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+
+  /**
+   * \brief Drop a number of packets from the flow with the largest queue
+   * \return the index of the fat flow
+   */
+  uint32_t FqCoDelDrop (void);
+
+  /**
+   * \brief Append a flow to a list of flows
+   * \param list the list
+   * \param flow the flow index
+   */
+  void PushBack (FlowList &list, uint32_t flow);
+  /**
+   * \brief Remove the first flow of a list of flows
+   * \param list the list
+   */
+  void PopFront (FlowList &list);
+
+  /**
+   * \brief Store an item at the tail of a flow queue
+   * \param flow the flow index
+   * \param item the item
+   */
+  void FlowEnqueue (uint32_t flow, Ptr<QueueDiscItem> item);
+  /**
+   * \brief Extract the item at the head of a flow queue
+   * \param flow the flow index
+   * \param enqueueTime the time the item was enqueued
+   * \return the item, or 0 if the flow queue is empty
+   */
+  Ptr<QueueDiscItem> FlowRemove (uint32_t flow, Time &enqueueTime);
+  /**
+   * \brief Run CoDel to dequeue a packet from a flow queue
+   * \param flow the flow index
+   * \return the dequeued item, or 0 if the flow queue is empty
+   */
+  Ptr<QueueDiscItem> FlowDequeue (uint32_t flow);
+  /**
+   * \brief Check if a packet extracted from a flow queue can be dropped by CoDel
+   * \param flow the flow index
+   * \param item the item
+   * \param enqueueTime the time the item was enqueued
+   * \param now the current time in CoDel time units
+   * \return true if the packet can be dropped
+   */
+  bool OkToDrop (uint32_t flow, Ptr<QueueDiscItem> item, Time enqueueTime, uint32_t now);
+  /**
+   * \brief Calculate the reciprocal square root of the count of a flow
+   * \param flow the flow index
+   */
+  void NewtonStep (uint32_t flow);
+  /**
+   * \brief Determine the time for the next drop of a flow
+   * \param flow the flow index
+   * \param t the current time in CoDel time units
+   * \return the time of the next drop in CoDel time units
+   */
+  uint32_t ControlLaw (uint32_t flow, uint32_t t) const;
+
+  std::string m_interval;    //!< CoDel interval attribute
+  std::string m_target;      //!< CoDel target attribute
+  uint32_t m_limit;          //!< Maximum number of packets in the queue disc
+  uint32_t m_quantum;        //!< Deficit assigned to flows at each round
+  uint32_t m_flows;          //!< Number of flow queues
+  uint32_t m_dropBatchSize;  //!< Max number of packets dropped from the fat flow
+  uint32_t m_minBytes;       //!< CoDel minbytes parameter
+
+  uint32_t m_overlimitDroppedPackets; //!< Number of overlimit dropped packets
+  uint32_t m_codelDroppedPackets;     //!< Number of packets dropped by CoDel
+
+  uint32_t m_codelInterval;  //!< CoDel interval in CoDel time units
+  uint32_t m_codelTarget;    //!< CoDel target in CoDel time units
+
+  std::vector<Flow> m_flowTable;      //!< The state of the flows, indexed by flow hash
+  std::vector<uint32_t> m_flowOrder;  //!< The flows in the order they received their first packet
+  std::vector<Slot> m_slots;          //!< The packet slots
+  uint32_t m_freeSlots;               //!< The first free packet slot
+
+  FlowList m_newFlows;       //!< The list of new flows
+  FlowList m_oldFlows;       //!< The list of old flows
+};
+
+} // namespace ns3
+
+#endif /* FQ_CODEL_FLAT_QUEUE_DISC */
@@ -112,6 +112,62 @@ PfifoFastQueueDisc::DoDequeue (void)
   return item;
 }
 
+uint32_t
+PfifoFastQueueDisc::DoEnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+  NotifyEnqueueBatch (items);
+
+  uint32_t nEnqueued = 0;
+  uint32_t nLeft = items.size ();
+  for (std::vector<Ptr<QueueDiscItem> >::const_iterator it = items.begin (); it != items.end (); it++)
+    {
+      // GetNPackets already counts the whole burst: do not count the items
+      // that follow this one, as DoEnqueue would do
+      nLeft--;
+      if (GetNPackets () - nLeft > m_limit)
+        {
+          NS_LOG_LOGIC ("Queue disc limit exceeded -- dropping packet");
+          Drop (*it);
+          continue;
+        }
+
+      uint8_t priority = 0;
+      SocketPriorityTag priorityTag;
+      if ((*it)->GetPacket ()->PeekPacketTag (priorityTag))
+        {
+          priority = priorityTag.GetPriority ();
+        }
+
+      if (GetInternalQueue (prio2band[priority & 0x0f])->Enqueue (*it))
+        {
+          nEnqueued++;
+        }
+    }
+  return nEnqueued;
+}
+
+uint32_t
+PfifoFastQueueDisc::DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxItems)
+{
+  NS_LOG_FUNCTION (this << maxItems);
+
+  // Drain the bands in order of priority, instead of scanning them again
+  // for every packet
+  uint32_t nDequeued = 0;
+  for (uint32_t i = 0; i < GetNInternalQueues () && nDequeued < maxItems; i++)
+    {
+      Ptr<Queue> queue = GetInternalQueue (i);
+      while (nDequeued < maxItems && !queue->IsEmpty ())
+        {
+          items.push_back (StaticCast<QueueDiscItem> (queue->Dequeue ()));
+          nDequeued++;
+        }
+      NS_LOG_LOGIC ("Number packets band " << i << ": " << queue->GetNPackets ());
+    }
+  return nDequeued;
+}
+
 Ptr<const QueueDiscItem>
 PfifoFastQueueDisc::DoPeek (void) const
 {
@@ -71,6 +71,8 @@ private:
 
   virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
   virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual uint32_t DoEnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items);
+  virtual uint32_t DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxItems);
   virtual Ptr<const QueueDiscItem> DoPeek (void) const;
   virtual bool CheckConfig (void);
   virtual void InitializeParams (void);
@@ -289,6 +289,7 @@ bool PieQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
 void PieQueueDisc::CalculateP ()
 {
   NS_LOG_FUNCTION (this);
+  uint64_t start = ProfileStart ();
   Time qDelay;
   double p = 0.0;
   bool missingInitFlag = false;
@@ -393,6 +394,7 @@ void PieQueueDisc::CalculateP ()
     }
 
   m_qDelayOld = qDelay;
+  ProfileStop (PROFILE_UPDATE, start);
   m_rtrsEvent = Simulator::Schedule (m_tUpdate, &PieQueueDisc::CalculateP, this);
 }
 
@@ -461,6 +463,39 @@ PieQueueDisc::DoDequeue ()
   return item;
 }
 
+uint32_t
+PieQueueDisc::DoEnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+  NotifyEnqueueBatch (items);
+
+  uint32_t nEnqueued = 0;
+  for (std::vector<Ptr<QueueDiscItem> >::const_iterator it = items.begin (); it != items.end (); it++)
+    {
+      if (PieQueueDisc::DoEnqueue (*it))
+        {
+          nEnqueued++;
+        }
+    }
+  return nEnqueued;
+}
+
+uint32_t
+PieQueueDisc::DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxItems)
+{
+  NS_LOG_FUNCTION (this << maxItems);
+
+  // The departure rate estimation is updated for every packet
+  uint32_t nDequeued = 0;
+  Ptr<QueueDiscItem> item;
+  while (nDequeued < maxItems && (item = PieQueueDisc::DoDequeue ()) != 0)
+    {
+      items.push_back (item);
+      nDequeued++;
+    }
+  return nDequeued;
+}
+
 Ptr<const QueueDiscItem>
 PieQueueDisc::DoPeek () const
 {
@@ -0,0 +1,126 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <new>
+#include "ns3/log.h"
+#include "queue-disc-item-pool.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("QueueDiscItemPool");
+
+QueueDiscItemPool::QueueDiscItemPool (std::size_t size, uint32_t maxFree)
+  : m_size (size),
+    m_free (0),
+    m_nFree (0),
+    m_maxFree (maxFree),
+    m_hits (0),
+    m_misses (0),
+    m_destroyed (false)
+{
+  NS_LOG_FUNCTION (this << size << maxFree);
+}
+
+QueueDiscItemPool::~QueueDiscItemPool ()
+{
+  NS_LOG_FUNCTION (this);
+  SetMaxFree (0);
+  // blocks released from now on are freed immediately
+  m_destroyed = true;
+}
+
+void *
+QueueDiscItemPool::Allocate (std::size_t size)
+{
+  if (size == m_size && m_free != 0 && !m_destroyed)
+    {
+      FreeBlock *block = m_free;
+      m_free = block->m_next;
+      m_nFree--;
+      m_hits++;
+      return block;
+    }
+  m_misses++;
+  return ::operator new (size);
+}
+
+void
+QueueDiscItemPool::Deallocate (void *p, std::size_t size)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  if (size == m_size && m_nFree < m_maxFree && !m_destroyed)
+    {
+      FreeBlock *block = static_cast<FreeBlock *> (p);
+      block->m_next = m_free;
+      m_free = block;
+      m_nFree++;
+      return;
+    }
+  ::operator delete (p);
+}
+
+void
+QueueDiscItemPool::SetMaxFree (uint32_t maxFree)
+{
+  NS_LOG_FUNCTION (this << maxFree);
+  m_maxFree = maxFree;
+  while (m_nFree > m_maxFree)
+    {
+      FreeBlock *block = m_free;
+      m_free = block->m_next;
+      m_nFree--;
+      ::operator delete (block);
+    }
+}
+
+uint32_t
+QueueDiscItemPool::GetMaxFree (void) const
+{
+  return m_maxFree;
+}
+
+uint32_t
+QueueDiscItemPool::GetNFree (void) const
+{
+  return m_nFree;
+}
+
+uint64_t
+QueueDiscItemPool::GetHits (void) const
+{
+  return m_hits;
+}
+
+uint64_t
+QueueDiscItemPool::GetMisses (void) const
+{
+  return m_misses;
+}
+
+void
+QueueDiscItemPool::ResetStats (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_hits = 0;
+  m_misses = 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUEUE_DISC_ITEM_POOL_H
+#define QUEUE_DISC_ITEM_POOL_H
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Free list of memory blocks for objects of a given size
+ *
+ * Queue disc items are allocated for every packet crossing the traffic
+ * control layer and freed as soon as the packet leaves the queue disc.
+ * A QueueDiscItem subclass can recycle the memory of its instances by
+ * declaring a class-specific operator new and operator delete which
+ * forward to a QueueDiscItemPool, e.g.:
+ *
+ * \code
+ *   void *
+ *   Ipv4QueueDiscItem::operator new (std::size_t size)
+ *   {
+ *     return GetPool ().Allocate (size);
+ *   }
+ *
+ *   void
+ *   Ipv4QueueDiscItem::operator delete (void *p, std::size_t size)
+ *   {
+ *     GetPool ().Deallocate (p, size);
+ *   }
+ * \endcode
+ *
+ * Since items are still created with Create<> and released by Ptr<> through
+ * their virtual destructor, pooled items are fully compatible with Ptr<>.
+ * Requests for a size other than the one of the pool (e.g., from a subclass
+ * which does not declare its own operators) are forwarded to the global
+ * operator new and delete.
+ *
+ * The pool keeps at most MaxFree blocks; setting it to zero disables the
+ * pool (useful, e.g., when looking for memory leaks with valgrind). A pool
+ * is not thread-safe: a subclass whose items may be allocated or freed by
+ * several threads (e.g., with the MultithreadedSimulatorImpl) should keep
+ * one pool per thread, in a \c thread_local variable. Blocks may be freed
+ * to the pool of another thread than the one which allocated them.
+ *
+ * A pool is usually a static or thread_local object, which may be destroyed
+ * before some of the items it allocated (e.g., items still held by other
+ * static objects).
+ * Once the destructor has run, the pool forwards every request to the
+ * global operator new and delete.
+ */
+class QueueDiscItemPool
+{
+public:
+  /**
+   * \brief Constructor
+   * \param size the size of the blocks managed by the pool
+   * \param maxFree the maximum number of free blocks kept by the pool
+   */
+  QueueDiscItemPool (std::size_t size, uint32_t maxFree = 65536);
+
+  ~QueueDiscItemPool ();
+
+  /**
+   * \brief Allocate a block of memory
+   * \param size the size of the block
+   * \return a pointer to the block
+   */
+  void *Allocate (std::size_t size);
+
+  /**
+   * \brief Return a block of memory to the pool
+   * \param p the pointer to the block
+   * \param size the size of the block
+   */
+  void Deallocate (void *p, std::size_t size);
+
+  /**
+   * \brief Set the maximum number of free blocks kept by the pool
+   * \param maxFree the maximum number of free blocks
+   *
+   * Free blocks in excess are released immediately.
+   */
+  void SetMaxFree (uint32_t maxFree);
+
+  /**
+   * \return the maximum number of free blocks kept by the pool
+   */
+  uint32_t GetMaxFree (void) const;
+
+  /**
+   * \return the number of free blocks currently kept by the pool
+   */
+  uint32_t GetNFree (void) const;
+
+  /**
+   * \return the number of allocations served from the free list
+   */
+  uint64_t GetHits (void) const;
+
+  /**
+   * \return the number of allocations forwarded to the global operator new
+   */
+  uint64_t GetMisses (void) const;
+
+  /**
+   * \brief Reset the hit and miss counters
+   */
+  void ResetStats (void);
+
+private:
+  /// copy constructor (not implemented)
+  QueueDiscItemPool (const QueueDiscItemPool &);
+  /// assignment operator (not implemented)
+  QueueDiscItemPool &operator = (const QueueDiscItemPool &);
+
+  /// A free block, storing the link to the next free block
+  struct FreeBlock
+  {
+    FreeBlock *m_next; //!< Next free block
+  };
+
+  std::size_t m_size;   //!< Size of the blocks
+  FreeBlock *m_free;    //!< Head of the free list
+  uint32_t m_nFree;     //!< Number of free blocks
+  uint32_t m_maxFree;   //!< Maximum number of free blocks
+  uint64_t m_hits;      //!< Allocations served from the free list
+  uint64_t m_misses;    //!< Allocations forwarded to the global operator new
+  bool m_destroyed;     //!< Whether the destructor has run
+};
+
+} // namespace ns3
+
+#endif /* QUEUE_DISC_ITEM_POOL_H */
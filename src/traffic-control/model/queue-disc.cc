@@ -25,12 +25,65 @@
 #include "ns3/packet.h"
 #include "ns3/socket.h"
 #include "ns3/unused.h"
+#include "ns3/boolean.h"
+#include "ns3/global-value.h"
+#include "ns3/simulator.h"
 #include "queue-disc.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#if defined (__x86_64__) || defined (__i386__)
+#include <x86intrin.h>
+#endif
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("QueueDisc");
 
+/**
+ * \brief A global switch to measure the time spent by the queue discs.
+ */
+static GlobalValue g_queueDiscProfiling = GlobalValue ("QueueDiscProfiling",
+                                                       "Measure the wall-clock time spent by the queue discs "
+                                                       "in each operation and print a summary at Simulator::Destroy",
+                                                       BooleanValue (false),
+                                                       MakeBooleanChecker ());
+
+namespace {
+
+/**
+ * \ingroup traffic-control
+ *
+ * The time spent by the profiled queue discs. The queue discs may be
+ * simulated by different threads, hence the mutex.
+ */
+struct ProfileRegistry
+{
+  ProfileRegistry () : reportScheduled (false) {}
+
+  std::mutex mutex;                     //!< Mutex protecting the registry
+  std::set<QueueDisc *> live;           //!< Queue discs being profiled
+  /// Time spent by the queue discs no longer profiled, by TypeId name
+  std::map<std::string, std::vector<QueueDisc::ProfileStats> > totals;
+  bool reportScheduled;                 //!< Whether the summary is scheduled at Simulator::Destroy
+};
+
+/**
+ * \ingroup traffic-control
+ * \return the registry of the profiled queue discs
+ */
+ProfileRegistry &
+GetProfileRegistry (void)
+{
+  static ProfileRegistry registry;
+  return registry;
+}
+
+} // unnamed namespace
+
 QueueDiscItem::QueueDiscItem (Ptr<Packet> p, const Address& addr, uint16_t protocol)
   : QueueItem (p),
     m_address (addr),
@@ -181,15 +234,23 @@ QueueDisc::QueueDisc ()
      m_nTotalDroppedBytes (0),
      m_nTotalRequeuedPackets (0),
      m_nTotalRequeuedBytes (0),
-     m_running (false)
+     m_running (false),
+     m_profiling (false)
 {
   NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < PROFILE_N_OPERATIONS; i++)
+    {
+      m_profileCount[i] = 0;
+      m_profileTicks[i] = 0;
+      m_profileMaxTicks[i] = 0;
+    }
 }
 
 void
 QueueDisc::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  FoldProfile ();
   m_queues.clear ();
   m_filters.clear ();
   m_classes.clear ();
@@ -216,6 +277,21 @@ QueueDisc::DoInitialize (void)
   NS_UNUSED (ok); // suppress compiler warning
   InitializeParams ();
 
+  BooleanValue profiling;
+  g_queueDiscProfiling.GetValue (profiling);
+  if (profiling.Get () && !m_profiling)
+    {
+      ProfileRegistry &registry = GetProfileRegistry ();
+      std::lock_guard<std::mutex> lock (registry.mutex);
+      m_profiling = true;
+      registry.live.insert (this);
+      if (!registry.reportScheduled)
+        {
+          Simulator::ScheduleDestroy (&QueueDisc::ReportProfile);
+          registry.reportScheduled = true;
+        }
+    }
+
   // Check the configuration and initialize the parameters of the child queue discs
   for (std::vector<Ptr<QueueDiscClass> >::iterator cl = m_classes.begin ();
        cl != m_classes.end (); cl++)
@@ -460,7 +536,11 @@ QueueDisc::Enqueue (Ptr<QueueDiscItem> item)
   NS_LOG_LOGIC ("m_traceEnqueue (p)");
   m_traceEnqueue (item);
 
-  return DoEnqueue (item);
+  uint64_t start = ProfileStart ();
+  bool ret = DoEnqueue (item);
+  ProfileStop (PROFILE_ENQUEUE, start);
+
+  return ret;
 }
 
 Ptr<QueueDiscItem>
@@ -468,8 +548,10 @@ QueueDisc::Dequeue (void)
 {
   NS_LOG_FUNCTION (this);
 
+  uint64_t start = ProfileStart ();
   Ptr<QueueDiscItem> item;
   item = DoDequeue ();
+  ProfileStop (PROFILE_DEQUEUE, start);
 
   if (item != 0)
     {
@@ -483,6 +565,237 @@ QueueDisc::Dequeue (void)
   return item;
 }
 
+uint32_t
+QueueDisc::EnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+
+  uint64_t start = ProfileStart ();
+  uint32_t nEnqueued = DoEnqueueBatch (items);
+  ProfileStop (PROFILE_ENQUEUE, start);
+
+  return nEnqueued;
+}
+
+uint32_t
+QueueDisc::DequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxItems)
+{
+  NS_LOG_FUNCTION (this << maxItems);
+
+  std::size_t first = items.size ();
+  uint64_t start = ProfileStart ();
+  uint32_t nDequeued = DoDequeueBatch (items, maxItems);
+  ProfileStop (PROFILE_DEQUEUE, start);
+  NS_ASSERT (items.size () == first + nDequeued);
+
+  if (nDequeued > 0)
+    {
+      uint32_t bytes = 0;
+      for (std::size_t i = first; i < items.size (); i++)
+        {
+          bytes += items[i]->GetPacketSize ();
+          NS_LOG_LOGIC ("m_traceDequeue (p)");
+          m_traceDequeue (items[i]);
+        }
+      m_nPackets -= nDequeued;
+      m_nBytes -= bytes;
+    }
+
+  return nDequeued;
+}
+
+void
+QueueDisc::NotifyEnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+
+  uint32_t bytes = 0;
+  for (std::vector<Ptr<QueueDiscItem> >::const_iterator it = items.begin (); it != items.end (); it++)
+    {
+      bytes += (*it)->GetPacketSize ();
+    }
+
+  m_nPackets += items.size ();
+  m_nBytes += bytes;
+  m_nTotalReceivedPackets += items.size ();
+  m_nTotalReceivedBytes += bytes;
+
+  for (std::vector<Ptr<QueueDiscItem> >::const_iterator it = items.begin (); it != items.end (); it++)
+    {
+      NS_LOG_LOGIC ("m_traceEnqueue (p)");
+      m_traceEnqueue (*it);
+    }
+}
+
+uint32_t
+QueueDisc::DoEnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+
+  uint32_t nEnqueued = 0;
+  for (std::vector<Ptr<QueueDiscItem> >::const_iterator it = items.begin (); it != items.end (); it++)
+    {
+      if (Enqueue (*it))
+        {
+          nEnqueued++;
+        }
+    }
+  return nEnqueued;
+}
+
+uint32_t
+QueueDisc::DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxItems)
+{
+  NS_LOG_FUNCTION (this << maxItems);
+
+  uint32_t nDequeued = 0;
+  Ptr<QueueDiscItem> item;
+  while (nDequeued < maxItems && (item = DoDequeue ()) != 0)
+    {
+      items.push_back (item);
+      nDequeued++;
+    }
+  return nDequeued;
+}
+
+uint64_t
+QueueDisc::ReadProfileClock (void)
+{
+#if defined (__x86_64__) || defined (__i386__)
+  return __rdtsc ();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>
+           (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+#endif
+}
+
+uint64_t
+QueueDisc::ProfileTicksToNs (uint64_t ticks)
+{
+#if defined (__x86_64__) || defined (__i386__)
+  // The rate of the time stamp counter is measured once, against the
+  // steady clock, the first time it is needed
+  static const double ticksPerNs = [] ()
+    {
+      std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now ();
+      uint64_t c0 = ReadProfileClock ();
+      std::chrono::steady_clock::time_point t1;
+      do
+        {
+          t1 = std::chrono::steady_clock::now ();
+        }
+      while (t1 - t0 < std::chrono::milliseconds (10));
+      uint64_t c1 = ReadProfileClock ();
+      return static_cast<double> (c1 - c0) /
+             std::chrono::duration_cast<std::chrono::nanoseconds> (t1 - t0).count ();
+    } ();
+  return static_cast<uint64_t> (ticks / ticksPerNs);
+#else
+  return ticks;
+#endif
+}
+
+uint64_t
+QueueDisc::ProfileStart (void) const
+{
+  return m_profiling ? ReadProfileClock () : 0;
+}
+
+void
+QueueDisc::ProfileStop (ProfiledOperation op, uint64_t start)
+{
+  if (!m_profiling)
+    {
+      return;
+    }
+  uint64_t ticks = ReadProfileClock () - start;
+  m_profileCount[op]++;
+  m_profileTicks[op] += ticks;
+  m_profileMaxTicks[op] = std::max (m_profileMaxTicks[op], ticks);
+}
+
+QueueDisc::ProfileStats
+QueueDisc::GetProfileStats (ProfiledOperation op) const
+{
+  NS_LOG_FUNCTION (this << op);
+  NS_ASSERT (op < PROFILE_N_OPERATIONS);
+  ProfileStats stats;
+  stats.count = m_profileCount[op];
+  stats.totalNs = ProfileTicksToNs (m_profileTicks[op]);
+  stats.maxNs = ProfileTicksToNs (m_profileMaxTicks[op]);
+  return stats;
+}
+
+void
+QueueDisc::FoldProfile (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_profiling)
+    {
+      return;
+    }
+  ProfileRegistry &registry = GetProfileRegistry ();
+  std::lock_guard<std::mutex> lock (registry.mutex);
+  std::vector<ProfileStats> &totals = registry.totals[GetInstanceTypeId ().GetName ()];
+  totals.resize (PROFILE_N_OPERATIONS, ProfileStats ());
+  for (uint32_t i = 0; i < PROFILE_N_OPERATIONS; i++)
+    {
+      ProfileStats stats = GetProfileStats (static_cast<ProfiledOperation> (i));
+      totals[i].count += stats.count;
+      totals[i].totalNs += stats.totalNs;
+      totals[i].maxNs = std::max (totals[i].maxNs, stats.maxNs);
+    }
+  registry.live.erase (this);
+  m_profiling = false;
+}
+
+void
+QueueDisc::PrintProfile (std::ostream &os)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  static const char * const names[PROFILE_N_OPERATIONS] = { "enqueue", "dequeue", "update" };
+  ProfileRegistry &registry = GetProfileRegistry ();
+  std::lock_guard<std::mutex> lock (registry.mutex);
+  os << "Queue disc wall-clock time:" << std::endl;
+  for (std::map<std::string, std::vector<ProfileStats> >::const_iterator it = registry.totals.begin ();
+       it != registry.totals.end (); it++)
+    {
+      for (uint32_t i = 0; i < PROFILE_N_OPERATIONS; i++)
+        {
+          const ProfileStats &stats = it->second[i];
+          if (stats.count == 0)
+            {
+              continue;
+            }
+          os << "  " << it->first << " " << names[i] << ": "
+             << stats.count << " calls, "
+             << stats.totalNs << " ns, "
+             << stats.totalNs / stats.count << " ns/call, "
+             << stats.maxNs << " ns max" << std::endl;
+        }
+    }
+}
+
+void
+QueueDisc::ReportProfile (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  ProfileRegistry &registry = GetProfileRegistry ();
+  std::set<QueueDisc *> live;
+  {
+    std::lock_guard<std::mutex> lock (registry.mutex);
+    live = registry.live;
+  }
+  for (std::set<QueueDisc *>::const_iterator it = live.begin (); it != live.end (); it++)
+    {
+      (*it)->FoldProfile ();
+    }
+  PrintProfile (std::cout);
+  std::lock_guard<std::mutex> lock (registry.mutex);
+  registry.totals.clear ();
+  registry.reportScheduled = false;
+}
+
 Ptr<const QueueDiscItem>
 QueueDisc::Peek (void) const
 {
@@ -25,6 +25,7 @@
 #include <ns3/queue.h>
 #include "ns3/net-device.h"
 #include <vector>
+#include <ostream>
 #include "packet-filter.h"
 
 namespace ns3 {
@@ -322,6 +323,26 @@ public:
    */
   Ptr<QueueDiscItem> Dequeue (void);
 
+  /**
+   * Pass a burst of packets to store to the queue discipline. This function
+   * calls the (private) DoEnqueueBatch function. The default implementation of
+   * DoEnqueueBatch calls Enqueue for every item, while subclasses may override
+   * it to amortize the per-packet costs over the whole burst.
+   * \param items the items to enqueue
+   * \return the number of items that were successfully enqueued
+   */
+  uint32_t EnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items);
+
+  /**
+   * Request the queue discipline to extract up to maxItems packets. This function
+   * calls the (private) DoDequeueBatch function, then updates the statistics
+   * once for the whole burst and fires the Dequeue trace for every item.
+   * \param items the vector the extracted items are appended to
+   * \param maxItems the maximum number of items to extract
+   * \return the number of items extracted
+   */
+  uint32_t DequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxItems);
+
   /**
    * Get a copy of the next packet the queue discipline will extract, without
    * actually extracting the packet. This function only calls the (private)
@@ -440,6 +461,46 @@ public:
    */
   virtual void SetParentDropCallback (ParentDropCallback cb);
 
+  /**
+   * \enum ProfiledOperation
+   * \brief The operations whose wall-clock duration is measured when the
+   *        QueueDiscProfiling global value is true
+   */
+  enum ProfiledOperation
+    {
+      PROFILE_ENQUEUE = 0,   //!< DoEnqueue
+      PROFILE_DEQUEUE,       //!< DoDequeue (and DoDequeueBatch)
+      PROFILE_UPDATE,        //!< Periodic update of the AQM state (e.g., PieQueueDisc::CalculateP)
+      PROFILE_N_OPERATIONS   //!< Number of operations
+    };
+
+  /// Wall-clock time spent in an operation
+  struct ProfileStats
+  {
+    uint64_t count;     //!< Number of calls
+    uint64_t totalNs;   //!< Total time, in nanoseconds
+    uint64_t maxNs;     //!< Longest call, in nanoseconds
+  };
+
+  /**
+   * \brief Get the wall-clock time this queue disc spent in an operation
+   * \param op the operation
+   * \return the time spent, which is zero if profiling is disabled
+   *
+   * The time spent in the child queue discs, if any, is included.
+   */
+  ProfileStats GetProfileStats (ProfiledOperation op) const;
+
+  /**
+   * \brief Print the wall-clock time spent in each operation, by TypeId
+   * \param os the output stream
+   *
+   * The times of all the queue discs of the same type are added up. The
+   * summary is printed on the standard output by Simulator::Destroy when
+   * profiling is enabled.
+   */
+  static void PrintProfile (std::ostream &os);
+
 protected:
   /**
    * \brief Dispose of the object
@@ -462,6 +523,33 @@ protected:
    */
   void Drop (Ptr<QueueItem> item);
 
+  /**
+   *  \brief Update the statistics and fire the Enqueue trace for a burst
+   *  \param items the items about to be enqueued
+   *
+   *  Subclasses overriding DoEnqueueBatch must call this method before storing
+   *  the items. The counters are updated once for the whole burst, hence, unlike
+   *  in DoEnqueue, GetNPackets and GetNBytes already include all the items of
+   *  the burst when the items are processed.
+   */
+  void NotifyEnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items);
+
+  /**
+   *  \brief Start measuring the duration of an operation
+   *  \return the current value of the profiling clock, or 0 if profiling is disabled
+   *
+   *  Subclasses call this method, then ProfileStop, around their periodic
+   *  update routine.
+   */
+  uint64_t ProfileStart (void) const;
+
+  /**
+   *  \brief Stop measuring the duration of an operation
+   *  \param op the operation
+   *  \param start the value returned by ProfileStart
+   */
+  void ProfileStop (ProfiledOperation op, uint64_t start);
+
 private:
   /**
    *  \brief Notify the parent queue disc of a packet drop
@@ -482,6 +570,26 @@ private:
    */
   virtual Ptr<QueueDiscItem> DoDequeue (void) = 0;
 
+  /**
+   * This function actually enqueues a burst of packets into the queue disc.
+   * The default implementation calls Enqueue for every item. Subclasses
+   * overriding this method must call NotifyEnqueueBatch first.
+   * \param items the items to enqueue
+   * \return the number of items that were successfully enqueued
+   */
+  virtual uint32_t DoEnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items);
+
+  /**
+   * This function actually extracts up to maxItems packets from the queue disc.
+   * The default implementation calls DoDequeue until it returns 0 or maxItems
+   * items are extracted. Note that GetNPackets and GetNBytes are only updated
+   * after this function returns.
+   * \param items the vector the extracted items are appended to
+   * \param maxItems the maximum number of items to extract
+   * \return the number of items extracted
+   */
+  virtual uint32_t DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxItems);
+
   /**
    * This function returns a copy of the next packet the queue disc will extract.
    * \return 0 if the operation was not successful; the packet otherwise.
@@ -542,6 +650,31 @@ private:
    */
   bool Transmit (Ptr<QueueDiscItem> item);
 
+  /**
+   * Read the profiling clock, i.e., the time stamp counter where available
+   * \return the current value of the clock, in ticks
+   */
+  static uint64_t ReadProfileClock (void);
+
+  /**
+   * Convert a duration measured with the profiling clock to nanoseconds
+   * \param ticks the duration, in clock ticks
+   * \return the duration, in nanoseconds
+   */
+  static uint64_t ProfileTicksToNs (uint64_t ticks);
+
+  /**
+   * Add the time spent by this queue disc to the totals of its TypeId
+   * and stop profiling it.
+   */
+  void FoldProfile (void);
+
+  /**
+   * Print the profiling summary and reset the totals. Scheduled to run
+   * at Simulator::Destroy.
+   */
+  static void ReportProfile (void);
+
   static const uint32_t DEFAULT_QUOTA = 64; //!< Default quota (as in /proc/sys/net/core/dev_weight)
 
   std::vector<Ptr<Queue> > m_queues;            //!< Internal queues
@@ -563,6 +696,10 @@ private:
   bool m_running;                   //!< The queue disc is performing multiple dequeue operations
   Ptr<QueueDiscItem> m_requeued;    //!< The last packet that failed to be transmitted
   ParentDropCallback m_parentDropCallback;   //!< Parent drop callback
+  bool m_profiling;                 //!< Whether the operations are timed
+  uint64_t m_profileCount[PROFILE_N_OPERATIONS];    //!< Number of calls of each operation
+  uint64_t m_profileTicks[PROFILE_N_OPERATIONS];    //!< Time spent in each operation, in clock ticks
+  uint64_t m_profileMaxTicks[PROFILE_N_OPERATIONS]; //!< Longest call of each operation, in clock ticks
 
   /// Traced callback: fired when a packet is enqueued
   TracedCallback<Ptr<const QueueItem> > m_traceEnqueue;
@@ -813,6 +813,54 @@ RedQueueDisc::DoDequeue (void)
     }
 }
 
+uint32_t
+RedQueueDisc::DoEnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+  NotifyEnqueueBatch (items);
+
+  // The average queue size has to be estimated for every packet
+  uint32_t nEnqueued = 0;
+  for (std::vector<Ptr<QueueDiscItem> >::const_iterator it = items.begin (); it != items.end (); it++)
+    {
+      if (RedQueueDisc::DoEnqueue (*it))
+        {
+          nEnqueued++;
+        }
+    }
+  return nEnqueued;
+}
+
+uint32_t
+RedQueueDisc::DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxItems)
+{
+  NS_LOG_FUNCTION (this << maxItems);
+
+  Ptr<Queue> queue = GetInternalQueue (0);
+  uint32_t nDequeued = 0;
+  while (nDequeued < maxItems && !queue->IsEmpty ())
+    {
+      items.push_back (StaticCast<QueueDiscItem> (queue->Dequeue ()));
+      nDequeued++;
+    }
+
+  if (nDequeued > 0)
+    {
+      m_idle = 0;
+    }
+
+  if (nDequeued < maxItems)
+    {
+      // Same as a DoDequeue call finding the queue empty
+      NS_LOG_LOGIC ("Queue empty");
+      m_idle = 1;
+      m_idleTime = Simulator::Now ();
+    }
+
+  NS_LOG_LOGIC ("Popped " << nDequeued << " items");
+  return nDequeued;
+}
+
 Ptr<const QueueDiscItem>
 RedQueueDisc::DoPeek (void) const
 {
@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "rem-price-tag.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RemPriceTag");
+
+NS_OBJECT_ENSURE_REGISTERED (RemPriceTag);
+
+TypeId
+RemPriceTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RemPriceTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<RemPriceTag> ()
+  ;
+  return tid;
+}
+
+TypeId
+RemPriceTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+RemPriceTag::GetSerializedSize (void) const
+{
+  return 9;
+}
+
+void
+RemPriceTag::Serialize (TagBuffer buf) const
+{
+  buf.WriteDouble (m_pathPrice);
+  buf.WriteU8 (m_nLinks);
+}
+
+void
+RemPriceTag::Deserialize (TagBuffer buf)
+{
+  m_pathPrice = buf.ReadDouble ();
+  m_nLinks = buf.ReadU8 ();
+}
+
+void
+RemPriceTag::Print (std::ostream &os) const
+{
+  os << "PathPrice=" << m_pathPrice << " NLinks=" << (uint16_t) m_nLinks;
+}
+
+RemPriceTag::RemPriceTag ()
+  : Tag (),
+    m_pathPrice (0.0),
+    m_nLinks (0)
+{
+}
+
+void
+RemPriceTag::AddLinkPrice (double price)
+{
+  NS_LOG_FUNCTION (this << price);
+  m_pathPrice += price;
+  if (m_nLinks < 0xff)
+    {
+      m_nLinks++;
+    }
+}
+
+double
+RemPriceTag::GetPathPrice (void) const
+{
+  return m_pathPrice;
+}
+
+uint8_t
+RemPriceTag::GetNLinks (void) const
+{
+  return m_nLinks;
+}
+
+} // namespace ns3
@@ -0,0 +1,76 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef REM_PRICE_TAG_H
+#define REM_PRICE_TAG_H
+
+#include "ns3/tag.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Packet tag carrying the sum of the REM link prices along a path
+ *
+ * A RemQueueDisc with the PathPrice attribute set adds its current link
+ * price to this tag (creating it if needed) whenever a packet is dequeued.
+ * A host can then read the end-to-end price with Packet::PeekPacketTag.
+ */
+class RemPriceTag : public Tag
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer buf) const;
+  virtual void Deserialize (TagBuffer buf);
+  virtual void Print (std::ostream &os) const;
+
+  RemPriceTag ();
+
+  /**
+   * \brief Add the price of a link to the path price
+   * \param price the link price
+   */
+  void AddLinkPrice (double price);
+
+  /**
+   * \brief Get the sum of the prices of the links traversed so far
+   * \return the path price
+   */
+  double GetPathPrice (void) const;
+
+  /**
+   * \brief Get the number of REM links traversed so far
+   * \return the number of links
+   */
+  uint8_t GetNLinks (void) const;
+
+private:
+  double m_pathPrice; //!< Sum of the link prices
+  uint8_t m_nLinks;   //!< Number of REM links which added their price
+};
+
+} // namespace ns3
+
+#endif /* REM_PRICE_TAG_H */
@@ -32,7 +32,11 @@
 #include "ns3/simulator.h"
 #include "ns3/abort.h"
 #include "rem-queue-disc.h"
+#include "rem-price-tag.h"
 #include "ns3/drop-tail-queue.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace ns3 {
 
@@ -102,6 +106,22 @@ TypeId RemQueueDisc::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&RemQueueDisc::m_useEcn),
                    MakeBooleanChecker ())
+    .AddAttribute ("FastProbability",
+                   "True to compute the drop probability with a fast exp approximation and "
+                   "draw random numbers with an inline generator seeded from the ns-3 stream",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RemQueueDisc::m_fastProbability),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PathPrice",
+                   "True to add the link price to the RemPriceTag of each dequeued packet",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RemQueueDisc::m_pathPrice),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LazyUpdate",
+                   "True to run the update rule when packets arrive or leave instead of periodically",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RemQueueDisc::m_lazyUpdate),
+                   MakeBooleanChecker ())
 
   ;
 
@@ -176,11 +196,26 @@ RemQueueDisc::GetStats ()
   return m_stats;
 }
 
+double
+RemQueueDisc::GetLinkPrice (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_lazyUpdate)
+    {
+      CatchUpUpdateRule ();
+    }
+  return m_linkPrice;
+}
+
 int64_t
 RemQueueDisc::AssignStreams (int64_t stream)
 {
   NS_LOG_FUNCTION (this << stream);
   m_uv->SetStream (stream);
+  if (m_fastProbability)
+    {
+      SeedFastUniform ();
+    }
   return 1;
 }
 
@@ -200,12 +235,66 @@ RemQueueDisc::InitializeParams (void)
   m_stats.unforcedMark = 0;
 
   m_ptc = m_linkBandwidth.GetBitRate () / (8.0 * m_meanPktSize);
+  m_logPhi = std::log (m_phi);
+  if (m_fastProbability)
+    {
+      SeedFastUniform ();
+    }
+
+  if (m_lazyUpdate)
+    {
+      // Keep the grid of update times the constructor set up, but drop the
+      // event. Updates that would have run before now are reset above anyway.
+      m_nextUpdate = TimeStep (m_rtrsEvent.GetTs ());
+      Simulator::Remove (m_rtrsEvent);
+
+      Time now = Simulator::Now ();
+      if (m_nextUpdate < now)
+        {
+          int64_t interval = m_updateInterval.GetTimeStep ();
+          int64_t elapsed = (now - m_nextUpdate).GetTimeStep ();
+          m_nextUpdate += TimeStep (interval * ((elapsed + interval - 1) / interval));
+        }
+    }
 }
 
 bool
 RemQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
+  if (m_lazyUpdate)
+    {
+      CatchUpUpdateRule ();
+    }
+  return EnqueueItem (item);
+}
+
+uint32_t
+RemQueueDisc::DoEnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+  NotifyEnqueueBatch (items);
+
+  // All the items arrive at the same time, so catching up once is enough
+  if (m_lazyUpdate)
+    {
+      CatchUpUpdateRule ();
+    }
+
+  uint32_t nEnqueued = 0;
+  for (std::vector<Ptr<QueueDiscItem> >::const_iterator it = items.begin (); it != items.end (); it++)
+    {
+      if (EnqueueItem (*it))
+        {
+          nEnqueued++;
+        }
+    }
+  return nEnqueued;
+}
+
+bool
+RemQueueDisc::EnqueueItem (Ptr<QueueDiscItem> item)
+{
   if (GetMode () == Queue::QUEUE_MODE_PACKETS)
     {
       m_count++;
@@ -251,7 +340,7 @@ bool RemQueueDisc::DropEarly (Ptr<QueueDiscItem> item)
 
   double p = m_dropProb;
   bool earlyDrop = true;
-  double u = m_uv->GetValue ();
+  double u = m_fastProbability ? FastUniform () : m_uv->GetValue ();
 
   if (u > p)
     {
@@ -266,6 +355,36 @@ RemQueueDisc::DoDequeue (void)
 {
   NS_LOG_FUNCTION (this);
 
+  if (m_lazyUpdate)
+    {
+      CatchUpUpdateRule ();
+    }
+  return DequeueItem ();
+}
+
+uint32_t
+RemQueueDisc::DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxItems)
+{
+  NS_LOG_FUNCTION (this << maxItems);
+
+  if (m_lazyUpdate)
+    {
+      CatchUpUpdateRule ();
+    }
+
+  uint32_t nDequeued = 0;
+  Ptr<QueueDiscItem> item;
+  while (nDequeued < maxItems && (item = DequeueItem ()) != 0)
+    {
+      items.push_back (item);
+      nDequeued++;
+    }
+  return nDequeued;
+}
+
+Ptr<QueueDiscItem>
+RemQueueDisc::DequeueItem (void)
+{
   if (GetInternalQueue (0)->IsEmpty ())
     {
       NS_LOG_LOGIC ("Queue empty");
@@ -284,6 +403,15 @@ RemQueueDisc::DoDequeue (void)
             }
         }
 
+      if (m_pathPrice)
+        {
+          // Prices add up along the path: start from the tag set upstream, if any
+          RemPriceTag tag;
+          item->GetPacket ()->PeekPacketTag (tag);
+          tag.AddLinkPrice (m_linkPrice);
+          item->GetPacket ()->ReplacePacketTag (tag);
+        }
+
       NS_LOG_LOGIC ("Popped " << item);
 
       NS_LOG_LOGIC ("Number packets " << GetInternalQueue (0)->GetNPackets ());
@@ -315,6 +443,7 @@ void
 RemQueueDisc::RunUpdateRule (void)
 {
   NS_LOG_FUNCTION (this);
+  uint64_t start = ProfileStart ();
   double lp, in, in_avg, nQueued, c, exp, prob;
 
   // lp is link price (congestion measure)
@@ -351,7 +480,14 @@ RemQueueDisc::RunUpdateRule (void)
       lp = 0.0;
     }
 
-  exp = pow (m_phi, -lp);
+  if (m_fastProbability)
+    {
+      exp = FastExp (-lp * m_logPhi);
+    }
+  else
+    {
+      exp = pow (m_phi, -lp);
+    }
   prob = 1.0 - exp;
 
   m_count = 0.0;
@@ -359,7 +495,95 @@ RemQueueDisc::RunUpdateRule (void)
   m_linkPrice = lp;
   m_dropProb = prob;
 
-  m_rtrsEvent = Simulator::Schedule (m_updateInterval, &RemQueueDisc::RunUpdateRule, this);
+  ProfileStop (PROFILE_UPDATE, start);
+
+  if (!m_lazyUpdate)
+    {
+      m_rtrsEvent = Simulator::Schedule (m_updateInterval, &RemQueueDisc::RunUpdateRule, this);
+    }
+}
+
+void
+RemQueueDisc::CatchUpUpdateRule (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time now = Simulator::Now ();
+
+  while (m_nextUpdate < now)
+    {
+      bool idle = (m_count == 0);
+      double lp = m_linkPrice;
+      double in_avg = m_avgInputRate;
+
+      RunUpdateRule ();
+      m_nextUpdate += m_updateInterval;
+
+      if (idle && m_linkPrice == lp && m_avgInputRate == in_avg)
+        {
+          // Nothing arrived and the state did not move: every remaining
+          // update until now would give the same result, so skip them
+          int64_t interval = m_updateInterval.GetTimeStep ();
+          if (m_nextUpdate < now)
+            {
+              int64_t elapsed = (now - m_nextUpdate).GetTimeStep ();
+              m_nextUpdate += TimeStep (interval * ((elapsed + interval - 1) / interval));
+            }
+        }
+    }
+}
+
+double
+RemQueueDisc::FastExp (double x)
+{
+  // exp (x) = 2^k * exp (f), with k = round (x / ln (2)) and |f| <= ln (2) / 2
+  // x is clamped so that 2^k is a normal double (x is positive when Phi < 1)
+  x = std::min (std::max (x, -708.0), 709.0);
+  double t = x * 1.4426950408889634;
+  double k = std::floor (t + 0.5);
+  double f = (t - k) * 0.6931471805599453;
+  double p = 1.0 + f * (1.0 + f * (1.0 / 2 + f * (1.0 / 6 + f * (1.0 / 24
+                    + f * (1.0 / 120 + f * (1.0 / 720 + f * (1.0 / 5040)))))));
+
+  // Build 2^k directly in the exponent field
+  uint64_t bits = static_cast<uint64_t> (static_cast<int64_t> (k) + 1023) << 52;
+  double scale;
+  std::memcpy (&scale, &bits, sizeof (scale));
+  return p * scale;
+}
+
+void
+RemQueueDisc::SeedFastUniform (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      // splitmix64 of a value drawn from the ns-3 stream, as recommended
+      // for initializing the xoshiro family
+      uint64_t z = (static_cast<uint64_t> (m_uv->GetInteger (0, 0xffffffff)) << 32)
+        | m_uv->GetInteger (0, 0xffffffff);
+      z += 0x9e3779b97f4a7c15ULL;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      m_fastRngState[i] = z ^ (z >> 31);
+    }
+}
+
+double
+RemQueueDisc::FastUniform (void)
+{
+  uint64_t *s = m_fastRngState;
+  uint64_t result = s[0] + s[3];
+  uint64_t t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = (s[3] << 45) | (s[3] >> 19);
+
+  // The upper 53 bits give a double in [0,1)
+  return (result >> 11) * (1.0 / 9007199254740992.0);
 }
 
 bool
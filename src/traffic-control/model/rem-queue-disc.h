@@ -112,6 +112,15 @@ public:
    */
   Stats GetStats ();
 
+  /**
+   * \brief Get the current link price
+   *
+   * In lazy update mode, the updates due by now are applied first.
+   *
+   * \returns The link price.
+   */
+  double GetLinkPrice (void);
+
   /**
    * Assign a fixed random variable stream number to the random variables
    * used by this model. Return the number of streams (possibly zero) that
@@ -131,9 +140,24 @@ protected:
 private:
   virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
   virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual uint32_t DoEnqueueBatch (const std::vector<Ptr<QueueDiscItem> > &items);
+  virtual uint32_t DoDequeueBatch (std::vector<Ptr<QueueDiscItem> > &items, uint32_t maxItems);
   virtual Ptr<const QueueDiscItem> DoPeek (void) const;
   virtual bool CheckConfig (void);
 
+  /**
+   * \brief Enqueue an item, once the pending updates (if any) have been applied
+   * \param item the item to enqueue
+   * \returns true if the item was enqueued
+   */
+  bool EnqueueItem (Ptr<QueueDiscItem> item);
+
+  /**
+   * \brief Dequeue an item, once the pending updates (if any) have been applied
+   * \returns the dequeued item, or 0 if the queue is empty
+   */
+  Ptr<QueueDiscItem> DequeueItem (void);
+
   /**
    * \brief Initialize the queue parameters.
    */
@@ -152,6 +176,45 @@ private:
    */
   void RunUpdateRule ();
 
+  /**
+   * \brief Apply the updates the periodic mode would have run by now
+   *
+   * Used when LazyUpdate is enabled. The queue length and the arrival count
+   * only change inside DoEnqueue and DoDequeue, so running the update rule
+   * once per elapsed interval before handling the next packet yields the same
+   * price and probability as the periodic event. An update falling at the
+   * very same time as a packet is applied after that packet.
+   */
+  void CatchUpUpdateRule (void);
+
+  /**
+   * \brief Compute exp (x) with a relative error below 1e-8
+   *
+   * Range reduction to 2^k * exp (f) with |f| <= ln (2) / 2, followed by a
+   * degree 7 polynomial. The code is branch free so that it vectorizes.
+   * Arguments are clamped to [-708, 709], so that the result is always a
+   * finite normal number: close to zero below -708 and close to the largest
+   * double above 709 (which happens with a Phi below 1).
+   *
+   * \param x the exponent
+   * \returns an approximation of exp (x)
+   */
+  static double FastExp (double x);
+
+  /**
+   * \brief Seed the inline generator used when FastProbability is enabled
+   *
+   * The state is drawn from m_uv, so the sequence depends on the global
+   * seed and run number and on the stream set by AssignStreams ().
+   */
+  void SeedFastUniform (void);
+
+  /**
+   * \brief Draw a value uniformly distributed in [0,1) with xoshiro256+
+   * \returns the drawn value
+   */
+  double FastUniform (void);
+
   Stats m_stats;                                //!< REM statistics
 
   // ** Variables supplied by user
@@ -167,6 +230,9 @@ private:
   double m_ptc;                                 //!< Bandwidth in packets per second
   DataRate m_linkBandwidth;                     //!< Link bandwidth
   bool m_useEcn;                                //!< True if ECN is used (packets are marked instead of being dropped)
+  bool m_lazyUpdate;                            //!< True if the update rule is run on packet arrival/departure instead of periodically
+  bool m_fastProbability;                       //!< True if the drop probability and the random draws use the fast path
+  bool m_pathPrice;                             //!< True if the link price is added to the RemPriceTag of dequeued packets
 
   // ** Variables maintained by REM
   double m_linkPrice;                           //!< Variable to compute the link price
@@ -175,6 +241,9 @@ private:
   double m_avgInputRate;                        //!< Variable to store the average input rate
   uint32_t m_count;                             //!< Number of bytes or packets arriving at the link during each update time interval
   uint32_t m_countInBytes;                      //!< Queue length in bytes
+  Time m_nextUpdate;                            //!< Time of the next update rule run (lazy update mode only)
+  double m_logPhi;                              //!< Cached natural logarithm of m_phi
+  uint64_t m_fastRngState[4];                   //!< State of the xoshiro256+ generator (fast probability only)
 
   EventId m_rtrsEvent;                          //!< Event used to decide the decision of interval of drop probability calculation
   Ptr<UniformRandomVariable> m_uv;              //!< Rng stream
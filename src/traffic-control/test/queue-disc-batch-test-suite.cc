@@ -0,0 +1,240 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/queue-disc.h"
+#include "ns3/object-factory.h"
+#include "ns3/uinteger.h"
+#include "ns3/socket.h"
+#include "ns3/simulator.h"
+#include "ns3/red-queue-disc.h"
+#include "ns3/pie-queue-disc.h"
+#include "ns3/rem-queue-disc.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue Disc Batch Test Item
+ */
+class QueueDiscBatchTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   * \param protocol the protocol
+   */
+  QueueDiscBatchTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol);
+  virtual ~QueueDiscBatchTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+
+private:
+  QueueDiscBatchTestItem ();
+  /// copy constructor
+  QueueDiscBatchTestItem (const QueueDiscBatchTestItem &);
+  /// assignment operator
+  QueueDiscBatchTestItem &operator = (const QueueDiscBatchTestItem &);
+};
+
+QueueDiscBatchTestItem::QueueDiscBatchTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol)
+  : QueueDiscItem (p, addr, protocol)
+{
+}
+
+QueueDiscBatchTestItem::~QueueDiscBatchTestItem ()
+{
+}
+
+void
+QueueDiscBatchTestItem::AddHeader (void)
+{
+}
+
+bool
+QueueDiscBatchTestItem::Mark (void)
+{
+  return false;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue Disc Batch Test Case
+ *
+ * Enqueue and dequeue the same bursts of packets into two identical queue
+ * discs, one packet at a time in the first one and with EnqueueBatch and
+ * DequeueBatch in the second one, and check that the queue discs behave the
+ * same.
+ */
+class QueueDiscBatchTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param type the type of the queue disc
+   * \param limitAttribute the name of the attribute setting the queue disc limit
+   */
+  QueueDiscBatchTestCase (std::string type, std::string limitAttribute);
+  virtual void DoRun (void);
+private:
+  /**
+   * Create a queue disc of the type under test
+   * \return the queue disc
+   */
+  Ptr<QueueDisc> CreateQueueDisc (void);
+  /**
+   * Create a burst of packets, with sizes identifying them
+   * \param first the index of the first packet
+   * \param nPkt the number of packets
+   * \return the items
+   */
+  std::vector<Ptr<QueueDiscItem> > CreateBurst (uint32_t first, uint32_t nPkt);
+
+  std::string m_type;           //!< Type of the queue disc
+  std::string m_limitAttribute; //!< Name of the attribute setting the limit
+};
+
+QueueDiscBatchTestCase::QueueDiscBatchTestCase (std::string type, std::string limitAttribute)
+  : TestCase ("Check that batch operations match single packet operations for " + type),
+    m_type (type),
+    m_limitAttribute (limitAttribute)
+{
+}
+
+Ptr<QueueDisc>
+QueueDiscBatchTestCase::CreateQueueDisc (void)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (m_type);
+  factory.Set (m_limitAttribute, UintegerValue (30));
+  Ptr<QueueDisc> queue = factory.Create<QueueDisc> ();
+
+  if (DynamicCast<RedQueueDisc> (queue))
+    {
+      DynamicCast<RedQueueDisc> (queue)->AssignStreams (3);
+    }
+  else if (DynamicCast<PieQueueDisc> (queue))
+    {
+      DynamicCast<PieQueueDisc> (queue)->AssignStreams (3);
+    }
+  else if (DynamicCast<RemQueueDisc> (queue))
+    {
+      DynamicCast<RemQueueDisc> (queue)->AssignStreams (3);
+    }
+  queue->Initialize ();
+  return queue;
+}
+
+std::vector<Ptr<QueueDiscItem> >
+QueueDiscBatchTestCase::CreateBurst (uint32_t first, uint32_t nPkt)
+{
+  Address dest;
+  std::vector<Ptr<QueueDiscItem> > items;
+  for (uint32_t i = first; i < first + nPkt; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (100 + i);
+      SocketPriorityTag priorityTag;
+      priorityTag.SetPriority ((i * 7) % 16);
+      p->AddPacketTag (priorityTag);
+      items.push_back (Create<QueueDiscBatchTestItem> (p, dest, 0));
+    }
+  return items;
+}
+
+void
+QueueDiscBatchTestCase::DoRun (void)
+{
+  Ptr<QueueDisc> single = CreateQueueDisc ();
+  Ptr<QueueDisc> batch = CreateQueueDisc ();
+
+  uint32_t next = 0;
+  uint32_t burstSizes[] = { 20, 20, 5, 13, 40 };
+  uint32_t dequeueSizes[] = { 7, 0, 12, 50, 9 };
+
+  for (uint32_t round = 0; round < 5; round++)
+    {
+      std::vector<Ptr<QueueDiscItem> > singleItems = CreateBurst (next, burstSizes[round]);
+      std::vector<Ptr<QueueDiscItem> > batchItems = CreateBurst (next, burstSizes[round]);
+      next += burstSizes[round];
+
+      uint32_t nSingle = 0;
+      for (uint32_t i = 0; i < singleItems.size (); i++)
+        {
+          nSingle += single->Enqueue (singleItems[i]) ? 1 : 0;
+        }
+      uint32_t nBatch = batch->EnqueueBatch (batchItems);
+
+      NS_TEST_EXPECT_MSG_EQ (nBatch, nSingle, "The same number of packets should be enqueued");
+      NS_TEST_EXPECT_MSG_EQ (batch->GetNPackets (), single->GetNPackets (), "The queue discs should hold the same packets");
+      NS_TEST_EXPECT_MSG_EQ (batch->GetNBytes (), single->GetNBytes (), "The queue discs should hold the same bytes");
+      NS_TEST_EXPECT_MSG_EQ (batch->GetTotalReceivedPackets (), single->GetTotalReceivedPackets (),
+                             "The queue discs should have received the same packets");
+      NS_TEST_EXPECT_MSG_EQ (batch->GetTotalDroppedPackets (), single->GetTotalDroppedPackets (),
+                             "The queue discs should have dropped the same packets");
+
+      std::vector<Ptr<QueueDiscItem> > singleOut;
+      Ptr<QueueDiscItem> item;
+      while (singleOut.size () < dequeueSizes[round] && (item = single->Dequeue ()) != 0)
+        {
+          singleOut.push_back (item);
+        }
+      std::vector<Ptr<QueueDiscItem> > batchOut;
+      batch->DequeueBatch (batchOut, dequeueSizes[round]);
+
+      NS_TEST_EXPECT_MSG_EQ (batchOut.size (), singleOut.size (), "The same number of packets should be dequeued");
+      for (uint32_t i = 0; i < batchOut.size () && i < singleOut.size (); i++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (batchOut[i]->GetPacketSize (), singleOut[i]->GetPacketSize (),
+                                 "The packets should be dequeued in the same order");
+        }
+      NS_TEST_EXPECT_MSG_EQ (batch->GetNPackets (), single->GetNPackets (), "The queue discs should hold the same packets");
+      NS_TEST_EXPECT_MSG_EQ (batch->GetNBytes (), single->GetNBytes (), "The queue discs should hold the same bytes");
+    }
+
+  single->Dispose ();
+  batch->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue Disc Batch Test Suite
+ */
+static class QueueDiscBatchTestSuite : public TestSuite
+{
+public:
+  QueueDiscBatchTestSuite ()
+    : TestSuite ("queue-disc-batch", UNIT)
+  {
+    AddTestCase (new QueueDiscBatchTestCase ("ns3::PfifoFastQueueDisc", "Limit"), TestCase::QUICK);
+    AddTestCase (new QueueDiscBatchTestCase ("ns3::RedQueueDisc", "QueueLimit"), TestCase::QUICK);
+    AddTestCase (new QueueDiscBatchTestCase ("ns3::PieQueueDisc", "QueueLimit"), TestCase::QUICK);
+    AddTestCase (new QueueDiscBatchTestCase ("ns3::RemQueueDisc", "QueueLimit"), TestCase::QUICK);
+    AddTestCase (new QueueDiscBatchTestCase ("ns3::CoDelQueueDisc", "MaxPackets"), TestCase::QUICK);
+  }
+} g_queueDiscBatchTestSuite; ///< the test suite
@@ -0,0 +1,232 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/queue-disc.h"
+#include "ns3/queue-disc-item-pool.h"
+#include <new>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue Disc Item Pool Test Item
+ */
+class QueueDiscItemPoolTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   * \param protocol the protocol
+   */
+  QueueDiscItemPoolTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol);
+  virtual ~QueueDiscItemPoolTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+
+  /**
+   * Allocate an item from the pool
+   * \param size the size of the item
+   * \return the allocated memory
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Return an item to the pool
+   * \param p the memory of the item
+   * \param size the size of the item
+   */
+  static void operator delete (void *p, std::size_t size);
+  /**
+   * Get the pool of test items
+   * \return the pool
+   */
+  static QueueDiscItemPool & GetPool (void);
+
+private:
+  QueueDiscItemPoolTestItem ();
+  /// copy constructor
+  QueueDiscItemPoolTestItem (const QueueDiscItemPoolTestItem &);
+  /// assignment operator
+  QueueDiscItemPoolTestItem &operator = (const QueueDiscItemPoolTestItem &);
+};
+
+QueueDiscItemPoolTestItem::QueueDiscItemPoolTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol)
+  : QueueDiscItem (p, addr, protocol)
+{
+}
+
+QueueDiscItemPoolTestItem::~QueueDiscItemPoolTestItem ()
+{
+}
+
+void
+QueueDiscItemPoolTestItem::AddHeader (void)
+{
+}
+
+bool
+QueueDiscItemPoolTestItem::Mark (void)
+{
+  return false;
+}
+
+void *
+QueueDiscItemPoolTestItem::operator new (std::size_t size)
+{
+  return GetPool ().Allocate (size);
+}
+
+void
+QueueDiscItemPoolTestItem::operator delete (void *p, std::size_t size)
+{
+  GetPool ().Deallocate (p, size);
+}
+
+QueueDiscItemPool &
+QueueDiscItemPoolTestItem::GetPool (void)
+{
+  static QueueDiscItemPool pool (sizeof (QueueDiscItemPoolTestItem), 4);
+  return pool;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Larger subclass of the test item, which does not declare its own operators
+ */
+class QueueDiscItemPoolLargeTestItem : public QueueDiscItemPoolTestItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   */
+  QueueDiscItemPoolLargeTestItem (Ptr<Packet> p);
+
+private:
+  uint64_t m_padding[8]; //!< Padding making the item larger
+};
+
+QueueDiscItemPoolLargeTestItem::QueueDiscItemPoolLargeTestItem (Ptr<Packet> p)
+  : QueueDiscItemPoolTestItem (p, Address (), 0)
+{
+  m_padding[0] = 0;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue Disc Item Pool Test Case
+ */
+class QueueDiscItemPoolTestCase : public TestCase
+{
+public:
+  QueueDiscItemPoolTestCase ();
+  virtual void DoRun (void);
+};
+
+QueueDiscItemPoolTestCase::QueueDiscItemPoolTestCase ()
+  : TestCase ("Sanity check on the queue disc item pool")
+{
+}
+
+void
+QueueDiscItemPoolTestCase::DoRun (void)
+{
+  QueueDiscItemPool &pool = QueueDiscItemPoolTestItem::GetPool ();
+  pool.ResetStats ();
+  NS_TEST_EXPECT_MSG_EQ (pool.GetNFree (), 0, "The pool should initially be empty");
+
+  // Allocate six items while the pool is empty
+  std::vector<Ptr<QueueDiscItem> > items;
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      items.push_back (Create<QueueDiscItemPoolTestItem> (Create<Packet> (100), Address (), 0));
+    }
+  NS_TEST_EXPECT_MSG_EQ (pool.GetHits (), 0, "There should be no hits");
+  NS_TEST_EXPECT_MSG_EQ (pool.GetMisses (), 6, "There should be six misses");
+
+  // Releasing the last reference returns the item to the pool, up to MaxFree items
+  QueueDiscItem *last = PeekPointer (items[3]);
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      items[i] = 0;
+    }
+  NS_TEST_EXPECT_MSG_EQ (pool.GetNFree (), 4, "The pool should keep at most four free items");
+
+  // The next allocation reuses the last freed item
+  Ptr<QueueDiscItem> item = Create<QueueDiscItemPoolTestItem> (Create<Packet> (200), Address (), 0);
+  NS_TEST_EXPECT_MSG_EQ (PeekPointer (item), last, "The last freed item should be reused");
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacketSize (), 200, "The reused item should be constructed anew");
+  NS_TEST_EXPECT_MSG_EQ (pool.GetHits (), 1, "There should be one hit");
+  NS_TEST_EXPECT_MSG_EQ (pool.GetNFree (), 3, "The pool should have three free items");
+
+  // Items of a larger subclass bypass the pool
+  Ptr<QueueDiscItem> large = Create<QueueDiscItemPoolLargeTestItem> (Create<Packet> (300));
+  NS_TEST_EXPECT_MSG_EQ (pool.GetHits (), 1, "The larger item should not be taken from the pool");
+  NS_TEST_EXPECT_MSG_EQ (pool.GetMisses (), 7, "The larger item should count as a miss");
+  large = 0;
+  NS_TEST_EXPECT_MSG_EQ (pool.GetNFree (), 3, "The larger item should not be returned to the pool");
+
+  // Disabling the pool releases the free items
+  pool.SetMaxFree (0);
+  NS_TEST_EXPECT_MSG_EQ (pool.GetNFree (), 0, "The pool should be empty");
+  item = 0;
+  NS_TEST_EXPECT_MSG_EQ (pool.GetNFree (), 0, "The disabled pool should not keep free items");
+  item = Create<QueueDiscItemPoolTestItem> (Create<Packet> (100), Address (), 0);
+  NS_TEST_EXPECT_MSG_EQ (pool.GetMisses (), 8, "Allocations from the disabled pool should be misses");
+  item = 0;
+  pool.SetMaxFree (4);
+
+  // A destroyed pool forwards the blocks to the global operators, as happens
+  // to the items released during the destruction of the static objects
+  alignas (QueueDiscItemPool) unsigned char storage[sizeof (QueueDiscItemPool)];
+  QueueDiscItemPool *destroyed = new (storage) QueueDiscItemPool (64);
+  void *block = destroyed->Allocate (64);
+  destroyed->~QueueDiscItemPool ();
+  destroyed->Deallocate (block, 64);
+  NS_TEST_EXPECT_MSG_EQ (destroyed->GetNFree (), 0, "A destroyed pool should not keep free blocks");
+  block = destroyed->Allocate (64);
+  NS_TEST_EXPECT_MSG_EQ (destroyed->GetHits (), 0, "A destroyed pool should not serve allocations");
+  destroyed->Deallocate (block, 64);
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue Disc Item Pool Test Suite
+ */
+static class QueueDiscItemPoolTestSuite : public TestSuite
+{
+public:
+  QueueDiscItemPoolTestSuite ()
+    : TestSuite ("queue-disc-item-pool", UNIT)
+  {
+    AddTestCase (new QueueDiscItemPoolTestCase (), TestCase::QUICK);
+  }
+} g_queueDiscItemPoolTestSuite; ///< the test suite
@@ -0,0 +1,196 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/queue-disc.h"
+#include "ns3/object-factory.h"
+#include "ns3/boolean.h"
+#include "ns3/config.h"
+#include "ns3/simulator.h"
+#include "ns3/pie-queue-disc.h"
+#include "ns3/rem-queue-disc.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue Disc Profiling Test Item
+ */
+class QueueDiscProfilingTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param addr the address
+   * \param protocol the protocol
+   */
+  QueueDiscProfilingTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol);
+  virtual ~QueueDiscProfilingTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+
+private:
+  QueueDiscProfilingTestItem ();
+  /// copy constructor
+  QueueDiscProfilingTestItem (const QueueDiscProfilingTestItem &);
+  /// assignment operator
+  QueueDiscProfilingTestItem &operator = (const QueueDiscProfilingTestItem &);
+};
+
+QueueDiscProfilingTestItem::QueueDiscProfilingTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol)
+  : QueueDiscItem (p, addr, protocol)
+{
+}
+
+QueueDiscProfilingTestItem::~QueueDiscProfilingTestItem ()
+{
+}
+
+void
+QueueDiscProfilingTestItem::AddHeader (void)
+{
+}
+
+bool
+QueueDiscProfilingTestItem::Mark (void)
+{
+  return false;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue Disc Profiling Test Case
+ *
+ * Enqueue and dequeue packets while the periodic update routine of the
+ * queue disc runs, and check that the calls are counted only when the
+ * QueueDiscProfiling global value is true.
+ */
+class QueueDiscProfilingTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param type the type of the queue disc
+   * \param profiling whether profiling is enabled
+   */
+  QueueDiscProfilingTestCase (std::string type, bool profiling);
+  virtual void DoRun (void);
+private:
+  virtual void DoTeardown (void);
+  /**
+   * Enqueue a packet and dequeue one packet every other call
+   * \param queue the queue disc
+   * \param i the index of the packet
+   */
+  void EnqueueDequeue (Ptr<QueueDisc> queue, uint32_t i);
+
+  std::string m_type;   //!< Type of the queue disc
+  bool m_profiling;     //!< Whether profiling is enabled
+};
+
+QueueDiscProfilingTestCase::QueueDiscProfilingTestCase (std::string type, bool profiling)
+  : TestCase ("Check the profiling of " + type + (profiling ? " (enabled)" : " (disabled)")),
+    m_type (type),
+    m_profiling (profiling)
+{
+}
+
+void
+QueueDiscProfilingTestCase::EnqueueDequeue (Ptr<QueueDisc> queue, uint32_t i)
+{
+  Address dest;
+  queue->Enqueue (Create<QueueDiscProfilingTestItem> (Create<Packet> (500), dest, 0));
+  if (i % 2)
+    {
+      queue->Dequeue ();
+    }
+}
+
+void
+QueueDiscProfilingTestCase::DoRun (void)
+{
+  Config::SetGlobal ("QueueDiscProfiling", BooleanValue (m_profiling));
+
+  ObjectFactory factory;
+  factory.SetTypeId (m_type);
+  Ptr<QueueDisc> queue = factory.Create<QueueDisc> ();
+  queue->Initialize ();
+
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Simulator::Schedule (MilliSeconds (10 * i), &QueueDiscProfilingTestCase::EnqueueDequeue,
+                           this, queue, i);
+    }
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+
+  QueueDisc::ProfileStats enqueue = queue->GetProfileStats (QueueDisc::PROFILE_ENQUEUE);
+  QueueDisc::ProfileStats dequeue = queue->GetProfileStats (QueueDisc::PROFILE_DEQUEUE);
+  QueueDisc::ProfileStats update = queue->GetProfileStats (QueueDisc::PROFILE_UPDATE);
+  if (m_profiling)
+    {
+      NS_TEST_EXPECT_MSG_EQ (enqueue.count, 100, "Every enqueue should be counted");
+      NS_TEST_EXPECT_MSG_EQ (dequeue.count, 50, "Every dequeue should be counted");
+      NS_TEST_EXPECT_MSG_GT (update.count, 0, "The updates should be counted");
+      NS_TEST_EXPECT_MSG_GT (enqueue.totalNs, 0, "The time spent enqueuing should be measured");
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (enqueue.maxNs, enqueue.totalNs, "The longest call cannot exceed the total");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (enqueue.count, 0, "No enqueue should be counted");
+      NS_TEST_EXPECT_MSG_EQ (dequeue.count, 0, "No dequeue should be counted");
+      NS_TEST_EXPECT_MSG_EQ (update.count, 0, "No update should be counted");
+    }
+
+  Simulator::Destroy ();
+  // The counters of the queue disc are folded into the summary at Destroy
+  NS_TEST_EXPECT_MSG_EQ (queue->GetProfileStats (QueueDisc::PROFILE_ENQUEUE).count, enqueue.count,
+                         "The counters of the queue disc should be kept");
+  queue->Dispose ();
+}
+
+void
+QueueDiscProfilingTestCase::DoTeardown (void)
+{
+  Config::SetGlobal ("QueueDiscProfiling", BooleanValue (false));
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Queue Disc Profiling Test Suite
+ */
+static class QueueDiscProfilingTestSuite : public TestSuite
+{
+public:
+  QueueDiscProfilingTestSuite ()
+    : TestSuite ("queue-disc-profiling", UNIT)
+  {
+    AddTestCase (new QueueDiscProfilingTestCase ("ns3::RemQueueDisc", true), TestCase::QUICK);
+    AddTestCase (new QueueDiscProfilingTestCase ("ns3::PieQueueDisc", true), TestCase::QUICK);
+    AddTestCase (new QueueDiscProfilingTestCase ("ns3::RemQueueDisc", false), TestCase::QUICK);
+  }
+} g_queueDiscProfilingTestSuite; ///< the test suite
@@ -23,9 +23,11 @@
 
 #include "ns3/test.h"
 #include "ns3/rem-queue-disc.h"
+#include "ns3/rem-price-tag.h"
 #include "ns3/uinteger.h"
 #include "ns3/string.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 
@@ -371,6 +373,324 @@ RemQueueDiscTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Rem Queue Disc Lazy Update Test Case
+ *
+ * Check that running the update rule lazily, on packet arrival and departure,
+ * gives the same drops and marks as running it periodically.
+ */
+class RemQueueDiscLazyUpdateTestCase : public TestCase
+{
+public:
+  RemQueueDiscLazyUpdateTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Run a scenario with bursts separated by idle periods
+   * \param mode the queue disc mode
+   * \param lazy whether the lazy update mode is enabled
+   * \param useEcn whether the queue disc marks instead of dropping
+   * \return the queue disc statistics at the end of the run
+   */
+  RemQueueDisc::Stats RunScenario (StringValue mode, bool lazy, bool useEcn);
+  /**
+   * Enqueue a burst of packets
+   * \param queue the queue disc
+   * \param size the packet size
+   * \param nPkt the number of packets
+   * \param ecnCapable whether the packets are ECN capable
+   */
+  void Enqueue (Ptr<RemQueueDisc> queue, uint32_t size, uint32_t nPkt, bool ecnCapable);
+  /**
+   * Dequeue packets
+   * \param queue the queue disc
+   * \param nPkt the number of packets
+   */
+  void Dequeue (Ptr<RemQueueDisc> queue, uint32_t nPkt);
+};
+
+RemQueueDiscLazyUpdateTestCase::RemQueueDiscLazyUpdateTestCase ()
+  : TestCase ("Check that the lazy update mode of the rem queue disc matches the periodic mode")
+{
+}
+
+RemQueueDisc::Stats
+RemQueueDiscLazyUpdateTestCase::RunScenario (StringValue mode, bool lazy, bool useEcn)
+{
+  uint32_t pktSize = 1000;
+  uint32_t qSize = 300;
+  Ptr<RemQueueDisc> queue = CreateObject<RemQueueDisc> ();
+  queue->SetAttribute ("Mode", mode);
+  if (queue->GetMode () == Queue::QUEUE_MODE_BYTES)
+    {
+      qSize = qSize * pktSize;
+    }
+  queue->SetAttribute ("QueueLimit", UintegerValue (qSize));
+  queue->SetAttribute ("Gamma", DoubleValue (0.1));
+  queue->SetAttribute ("InputWeight", DoubleValue (0.5));
+  queue->SetAttribute ("Target", UintegerValue (50));
+  queue->SetAttribute ("UseEcn", BooleanValue (useEcn));
+  queue->SetAttribute ("LazyUpdate", BooleanValue (lazy));
+  queue->AssignStreams (1);
+  queue->Initialize ();
+
+  // Bursts arrive faster than they are served, with idle gaps in between
+  // long enough for the price to fall back to zero
+  for (uint32_t burst = 0; burst < 4; burst++)
+    {
+      Time burstStart = Seconds (1.0 * burst) + MicroSeconds (137 * burst);
+      for (uint32_t i = 0; i < 150; i++)
+        {
+          Simulator::Schedule (burstStart + MicroSeconds (1300 * i),
+                               &RemQueueDiscLazyUpdateTestCase::Enqueue, this, queue, pktSize, 2, useEcn);
+          Simulator::Schedule (burstStart + MicroSeconds (1300 * i + 650),
+                               &RemQueueDiscLazyUpdateTestCase::Dequeue, this, queue, 1);
+        }
+      for (uint32_t i = 0; i < 300; i++)
+        {
+          Simulator::Schedule (burstStart + MilliSeconds (200) + MicroSeconds (500 * i),
+                               &RemQueueDiscLazyUpdateTestCase::Dequeue, this, queue, 1);
+        }
+    }
+
+  Simulator::Stop (Seconds (5.0));
+  Simulator::Run ();
+  RemQueueDisc::Stats st = queue->GetStats ();
+  queue->Dispose ();
+  return st;
+}
+
+void
+RemQueueDiscLazyUpdateTestCase::Enqueue (Ptr<RemQueueDisc> queue, uint32_t size, uint32_t nPkt, bool ecnCapable)
+{
+  Address dest;
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Enqueue (Create<RemQueueDiscTestItem> (Create<Packet> (size), dest, 0, ecnCapable));
+    }
+}
+
+void
+RemQueueDiscLazyUpdateTestCase::Dequeue (Ptr<RemQueueDisc> queue, uint32_t nPkt)
+{
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      Ptr<QueueDiscItem> item = queue->Dequeue ();
+    }
+}
+
+void
+RemQueueDiscLazyUpdateTestCase::DoRun (void)
+{
+  const char *modes[] = { "QUEUE_MODE_PACKETS", "QUEUE_MODE_BYTES" };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      for (uint32_t ecn = 0; ecn < 2; ecn++)
+        {
+          RemQueueDisc::Stats periodic = RunScenario (StringValue (modes[i]), false, ecn);
+          RemQueueDisc::Stats lazy = RunScenario (StringValue (modes[i]), true, ecn);
+
+          NS_TEST_EXPECT_MSG_NE (periodic.unforcedDrop + periodic.unforcedMark, 0,
+                                 "The scenario should trigger early drops or marks");
+          NS_TEST_EXPECT_MSG_EQ (lazy.unforcedDrop, periodic.unforcedDrop,
+                                 "Lazy and periodic updates should give the same unforced drops");
+          NS_TEST_EXPECT_MSG_EQ (lazy.unforcedMark, periodic.unforcedMark,
+                                 "Lazy and periodic updates should give the same unforced marks");
+          NS_TEST_EXPECT_MSG_EQ (lazy.qLimDrop, periodic.qLimDrop,
+                                 "Lazy and periodic updates should give the same forced drops");
+        }
+    }
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Rem Queue Disc Fast Probability Test Case
+ *
+ * Check that the fast probability path is seeded by AssignStreams and that
+ * it drops about as many packets as the exact computation.
+ */
+class RemQueueDiscFastProbabilityTestCase : public TestCase
+{
+public:
+  RemQueueDiscFastProbabilityTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Run a longer version of test 2 of RemQueueDiscTestCase
+   * \param fast whether the fast probability path is enabled
+   * \param stream the stream assigned to the queue disc
+   * \return the queue disc statistics at the end of the run
+   */
+  RemQueueDisc::Stats RunScenario (bool fast, int64_t stream);
+  /**
+   * Enqueue a packet
+   * \param queue the queue disc
+   */
+  void Enqueue (Ptr<RemQueueDisc> queue);
+  /**
+   * Dequeue a packet
+   * \param queue the queue disc
+   */
+  void Dequeue (Ptr<RemQueueDisc> queue);
+};
+
+RemQueueDiscFastProbabilityTestCase::RemQueueDiscFastProbabilityTestCase ()
+  : TestCase ("Check the fast probability path of the rem queue disc")
+{
+}
+
+RemQueueDisc::Stats
+RemQueueDiscFastProbabilityTestCase::RunScenario (bool fast, int64_t stream)
+{
+  Ptr<RemQueueDisc> queue = CreateObject<RemQueueDisc> ();
+  queue->SetAttribute ("QueueLimit", UintegerValue (300));
+  queue->SetAttribute ("Gamma", DoubleValue (0.1));
+  queue->SetAttribute ("Target", UintegerValue (50));
+  queue->SetAttribute ("FastProbability", BooleanValue (fast));
+  queue->AssignStreams (stream);
+  queue->Initialize ();
+
+  for (uint32_t i = 0; i < 5000; i++)
+    {
+      Simulator::Schedule (Seconds ((i + 1) * 0.01), &RemQueueDiscFastProbabilityTestCase::Enqueue, this, queue);
+      Simulator::Schedule (Seconds ((i + 1) * 0.012), &RemQueueDiscFastProbabilityTestCase::Dequeue, this, queue);
+    }
+
+  Simulator::Stop (Seconds (61.0));
+  Simulator::Run ();
+  RemQueueDisc::Stats st = queue->GetStats ();
+  queue->Dispose ();
+  return st;
+}
+
+void
+RemQueueDiscFastProbabilityTestCase::Enqueue (Ptr<RemQueueDisc> queue)
+{
+  Address dest;
+  queue->Enqueue (Create<RemQueueDiscTestItem> (Create<Packet> (1000), dest, 0, false));
+}
+
+void
+RemQueueDiscFastProbabilityTestCase::Dequeue (Ptr<RemQueueDisc> queue)
+{
+  Ptr<QueueDiscItem> item = queue->Dequeue ();
+}
+
+void
+RemQueueDiscFastProbabilityTestCase::DoRun (void)
+{
+  RemQueueDisc::Stats exact = RunScenario (false, 5);
+  RemQueueDisc::Stats fast1 = RunScenario (true, 5);
+  RemQueueDisc::Stats fast2 = RunScenario (true, 5);
+  RemQueueDisc::Stats fast3 = RunScenario (true, 6);
+
+  NS_TEST_EXPECT_MSG_NE (fast1.unforcedDrop, 0, "There should be unforced drops");
+  NS_TEST_EXPECT_MSG_EQ (fast1.qLimDrop, 0, "There should be no forced drops");
+  NS_TEST_EXPECT_MSG_EQ (fast1.unforcedDrop, fast2.unforcedDrop, "The same stream should give the same drops");
+  NS_TEST_EXPECT_MSG_EQ_TOL (fast1.unforcedDrop, exact.unforcedDrop, exact.unforcedDrop / 5,
+                             "The fast path should drop about as many packets as the exact computation");
+  NS_TEST_EXPECT_MSG_EQ_TOL (fast3.unforcedDrop, exact.unforcedDrop, exact.unforcedDrop / 5,
+                             "The fast path should drop about as many packets as the exact computation");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Rem Queue Disc Path Price Test Case
+ *
+ * Check that link prices add up in the RemPriceTag of packets crossing
+ * several REM queue discs.
+ */
+class RemQueueDiscPathPriceTestCase : public TestCase
+{
+public:
+  RemQueueDiscPathPriceTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Create a queue disc and fill it with packets
+   * \param pathPrice the value of the PathPrice attribute
+   * \param nPkt the number of packets to enqueue
+   * \return the queue disc
+   */
+  Ptr<RemQueueDisc> CreateQueue (bool pathPrice, uint32_t nPkt);
+};
+
+RemQueueDiscPathPriceTestCase::RemQueueDiscPathPriceTestCase ()
+  : TestCase ("Check that the rem queue disc adds its price to the path price tag")
+{
+}
+
+Ptr<RemQueueDisc>
+RemQueueDiscPathPriceTestCase::CreateQueue (bool pathPrice, uint32_t nPkt)
+{
+  Address dest;
+  Ptr<RemQueueDisc> queue = CreateObject<RemQueueDisc> ();
+  queue->SetAttribute ("Gamma", DoubleValue (0.1));
+  queue->SetAttribute ("Target", UintegerValue (5));
+  queue->SetAttribute ("PathPrice", BooleanValue (pathPrice));
+  queue->Initialize ();
+  for (uint32_t i = 0; i < nPkt; i++)
+    {
+      queue->Enqueue (Create<RemQueueDiscTestItem> (Create<Packet> (1000), dest, 0, false));
+    }
+  return queue;
+}
+
+void
+RemQueueDiscPathPriceTestCase::DoRun (void)
+{
+  Address dest;
+  Ptr<RemQueueDisc> first = CreateQueue (true, 20);
+  Ptr<RemQueueDisc> second = CreateQueue (true, 10);
+  Ptr<RemQueueDisc> noPrice = CreateQueue (false, 10);
+
+  // Let the queues build up a price
+  Simulator::Stop (MilliSeconds (10));
+  Simulator::Run ();
+
+  double firstPrice = first->GetLinkPrice ();
+  double secondPrice = second->GetLinkPrice ();
+  NS_TEST_EXPECT_MSG_GT (firstPrice, 0.0, "The first queue should have a positive price");
+  NS_TEST_EXPECT_MSG_GT (secondPrice, 0.0, "The second queue should have a positive price");
+
+  RemPriceTag tag;
+  Ptr<QueueDiscItem> item = first->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->PeekPacketTag (tag), true, "The packet should carry a price tag");
+  NS_TEST_EXPECT_MSG_EQ (tag.GetPathPrice (), firstPrice, "The path price should be the price of the first link");
+  NS_TEST_EXPECT_MSG_EQ ((uint16_t) tag.GetNLinks (), 1, "The packet should have crossed one REM link");
+
+  // Forward the packet to the second queue, behind the packets already there
+  Ptr<Packet> p = item->GetPacket ();
+  second->Enqueue (Create<RemQueueDiscTestItem> (p, dest, 0, false));
+  do
+    {
+      item = second->Dequeue ();
+    }
+  while (item->GetPacket ()->GetUid () != p->GetUid ());
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->PeekPacketTag (tag), true, "The packet should carry a price tag");
+  NS_TEST_EXPECT_MSG_EQ_TOL (tag.GetPathPrice (), firstPrice + secondPrice, 1e-12,
+                             "The path price should be the sum of the link prices");
+  NS_TEST_EXPECT_MSG_EQ ((uint16_t) tag.GetNLinks (), 2, "The packet should have crossed two REM links");
+
+  item = noPrice->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->PeekPacketTag (tag), false,
+                         "No price tag should be added if PathPrice is not set");
+
+  first->Dispose ();
+  second->Dispose ();
+  noPrice->Dispose ();
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup traffic-control-test
  * \ingroup tests
@@ -384,5 +704,8 @@ public:
     : TestSuite ("rem-queue-disc", UNIT)
   {
     AddTestCase (new RemQueueDiscTestCase (), TestCase::QUICK);
+    AddTestCase (new RemQueueDiscLazyUpdateTestCase (), TestCase::QUICK);
+    AddTestCase (new RemQueueDiscFastProbabilityTestCase (), TestCase::QUICK);
+    AddTestCase (new RemQueueDiscPathPriceTestCase (), TestCase::QUICK);
   }
 } g_remQueueTestSuite; ///< the test suite
@@ -119,6 +119,13 @@ InterferenceHelper::NiChange::operator < (const InterferenceHelper::NiChange& o)
 }
 
 
+InterferenceHelper::PowerChange::PowerChange (double delta, Ptr<InterferenceHelper::Event> event)
+  : m_delta (delta),
+    m_event (event)
+{
+}
+
+
 /****************************************************************
  *       The actual InterferenceHelper
  ****************************************************************/
@@ -193,10 +200,10 @@ InterferenceHelper::GetEnergyDuration (double energyW)
   double noiseInterferenceW = 0.0;
   Time end = now;
   noiseInterferenceW = m_firstPower;
-  for (NiChanges::const_iterator i = m_niChanges.begin (); i != m_niChanges.end (); i++)
+  for (PowerChanges::const_iterator i = m_powerChanges.begin (); i != m_powerChanges.end (); i++)
     {
-      noiseInterferenceW += i->GetDelta ();
-      end = i->GetTime ();
+      noiseInterferenceW += i->second.m_delta;
+      end = i->first;
       if (end < now)
         {
           continue;
@@ -212,26 +219,31 @@ InterferenceHelper::GetEnergyDuration (double energyW)
 void
 InterferenceHelper::AppendEvent (Ptr<InterferenceHelper::Event> event)
 {
-  Time now = Simulator::Now ();
   if (!m_rxing)
     {
-      NiChanges::iterator nowIterator = GetPosition (now);
-      for (NiChanges::iterator i = m_niChanges.begin (); i != nowIterator; i++)
-        {
-          m_firstPower += i->GetDelta ();
-        }
-      m_niChanges.erase (m_niChanges.begin (), nowIterator);
-      m_niChanges.insert (m_niChanges.begin (), NiChange (event->GetStartTime (), event->GetRxPowerW ()));
+      //nobody will ask for the interference seen in the past anymore
+      EraseChanges (m_powerChanges.upper_bound (Simulator::Now ()));
     }
-  else
+  //std::multimap inserts after the elements with an equivalent key
+  m_powerChanges.insert (std::make_pair (event->GetStartTime (), PowerChange (event->GetRxPowerW (), event)));
+  m_powerChanges.insert (std::make_pair (event->GetEndTime (), PowerChange (-event->GetRxPowerW (), event)));
+}
+
+void
+InterferenceHelper::EraseChanges (PowerChanges::iterator end)
+{
+  for (PowerChanges::const_iterator i = m_powerChanges.begin (); i != end; i++)
     {
-      AddNiChangeEvent (NiChange (event->GetStartTime (), event->GetRxPowerW ()));
+      m_firstPower += i->second.m_delta;
+    }
+  m_powerChanges.erase (m_powerChanges.begin (), end);
+  if (m_powerChanges.empty ())
+    {
+      //every signal has ended: drop the rounding errors accumulated so far
+      m_firstPower = 0.0;
     }
-  AddNiChangeEvent (NiChange (event->GetEndTime (), -event->GetRxPowerW ()));
-
 }
 
-
 double
 InterferenceHelper::CalculateSnr (double signal, double noiseInterference, uint8_t channelWidth) const
 {
@@ -252,15 +264,19 @@ InterferenceHelper::CalculateNoiseInterferenceW (Ptr<InterferenceHelper::Event>
 {
   double noiseInterference = m_firstPower;
   NS_ASSERT (m_rxing);
-  for (NiChanges::const_iterator i = m_niChanges.begin () + 1; i != m_niChanges.end (); i++)
+  PowerChanges::const_iterator i = m_powerChanges.begin ();
+  //the changes preceding the start of the event add up to the initial interference
+  while (i != m_powerChanges.end () && i->second.m_event != event)
     {
-      if ((event->GetEndTime () == i->GetTime ()) && event->GetRxPowerW () == -i->GetDelta ())
-        {
-          break;
-        }
-      ni->push_back (*i);
+      noiseInterference += i->second.m_delta;
+      i++;
+    }
+  NS_ASSERT (i != m_powerChanges.end ());
+  ni->push_back (NiChange (event->GetStartTime (), noiseInterference));
+  for (i++; i != m_powerChanges.end () && i->second.m_event != event; i++)
+    {
+      ni->push_back (NiChange (i->first, i->second.m_delta));
     }
-  ni->insert (ni->begin (), NiChange (event->GetStartTime (), noiseInterference));
   ni->push_back (NiChange (event->GetEndTime (), 0));
   return noiseInterference;
 }
@@ -838,23 +854,11 @@ InterferenceHelper::CalculatePlcpHeaderSnrPer (Ptr<InterferenceHelper::Event> ev
 void
 InterferenceHelper::EraseEvents (void)
 {
-  m_niChanges.clear ();
+  m_powerChanges.clear ();
   m_rxing = false;
   m_firstPower = 0.0;
 }
 
-InterferenceHelper::NiChanges::iterator
-InterferenceHelper::GetPosition (Time moment)
-{
-  return std::upper_bound (m_niChanges.begin (), m_niChanges.end (), NiChange (moment, 0));
-}
-
-void
-InterferenceHelper::AddNiChangeEvent (NiChange change)
-{
-  m_niChanges.insert (GetPosition (change.GetTime ()), change);
-}
-
 void
 InterferenceHelper::NotifyRxStart ()
 {
@@ -867,6 +871,8 @@ InterferenceHelper::NotifyRxEnd ()
 {
   NS_LOG_FUNCTION (this);
   m_rxing = false;
+  //release the signals which ended during the reception
+  EraseChanges (m_powerChanges.lower_bound (Simulator::Now ()));
 }
 
 } //namespace ns3
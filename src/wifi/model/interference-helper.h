@@ -24,6 +24,8 @@
 #include "ns3/nstime.h"
 #include "wifi-tx-vector.h"
 #include "error-rate-model.h"
+#include <map>
+#include <vector>
 
 namespace ns3 {
 
@@ -251,10 +253,26 @@ private:
    * typedef for a vector of NiChanges
    */
   typedef std::vector <NiChange> NiChanges;
+
+  /**
+   * A change of the received power caused by the start or the end
+   * of the given event.
+   */
+  struct PowerChange
+  {
+    /**
+     * \param delta the change of power (W)
+     * \param event the event which starts or ends
+     */
+    PowerChange (double delta, Ptr<Event> event);
+    double m_delta; ///< change of power (W)
+    Ptr<Event> m_event; ///< event which starts or ends
+  };
   /**
-   * typedef for a list of Events
+   * typedef for the power changes ordered by the time at which they
+   * happen; changes happening at the same time are kept in insertion order.
    */
-  typedef std::list<Ptr<Event> > Events;
+  typedef std::multimap<Time, PowerChange> PowerChanges;
 
   /**
    * Append the given Event.
@@ -319,17 +337,16 @@ private:
   Ptr<ErrorRateModel> m_errorRateModel; ///< error rate model
   uint8_t m_numRxAntennas; /**< the number of RX antennas in the corresponding receiver */
   /// Experimental: needed for energy duration calculation
-  NiChanges m_niChanges;
-  double m_firstPower; ///< first power
+  PowerChanges m_powerChanges;
+  double m_firstPower; ///< power (W) of the changes already folded out of m_powerChanges
   bool m_rxing; ///< flag whether it is in receiving state
-  /// Returns an iterator to the first nichange, which is later than moment
-  NiChanges::iterator GetPosition (Time moment);
   /**
-   * Add NiChange to the list at the appropriate position.
+   * Fold the power changes preceding the given position into
+   * m_firstPower and release them.
    *
-   * \param change
+   * \param end the first power change to keep
    */
-  void AddNiChangeEvent (NiChange change);
+  void EraseChanges (PowerChanges::iterator end);
 };
 
 } //namespace ns3
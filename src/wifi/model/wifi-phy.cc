@@ -1209,7 +1209,7 @@ WifiPhy::SetFrequency (uint16_t frequency)
       DoFrequencySwitch (0);
       NS_LOG_DEBUG ("Setting frequency and channel number to zero");
       m_channelCenterFrequency = 0;
-      m_channelNumber = 0;
+      UpdateChannelNumber (0);
       return;
     }
   // If the user has configured both Frequency and ChannelNumber, Frequency
@@ -1223,7 +1223,7 @@ WifiPhy::SetFrequency (uint16_t frequency)
         {
           NS_LOG_DEBUG ("Channel frequency switched to " << frequency << "; channel number to " << (uint16_t)nch);
           m_channelCenterFrequency = frequency;
-          m_channelNumber = nch;
+          UpdateChannelNumber (nch);
         }
       else
         {
@@ -1237,7 +1237,7 @@ WifiPhy::SetFrequency (uint16_t frequency)
         {
           NS_LOG_DEBUG ("Channel frequency switched to " << frequency << "; channel number to " << 0);
           m_channelCenterFrequency = frequency;
-          m_channelNumber = 0;
+          UpdateChannelNumber (0);
         }
       else
         {
@@ -1440,7 +1440,7 @@ WifiPhy::SetChannelNumber (uint8_t nch)
       // DoChannelSwitch () because DoFrequencySwitch () should have been
       // called by the client
       NS_LOG_DEBUG ("Setting channel number to zero");
-      m_channelNumber = 0;
+      UpdateChannelNumber (0);
       return;
     }
 
@@ -1458,7 +1458,7 @@ WifiPhy::SetChannelNumber (uint8_t nch)
           NS_LOG_DEBUG ("Setting frequency to " << f.first << "; width to " << (uint16_t)f.second);
           m_channelCenterFrequency = f.first;
           SetChannelWidth (f.second);
-          m_channelNumber = nch;
+          UpdateChannelNumber (nch);
         }
       else
         {
@@ -1478,6 +1478,22 @@ WifiPhy::GetChannelNumber (void) const
   return m_channelNumber;
 }
 
+void
+WifiPhy::UpdateChannelNumber (uint8_t nch)
+{
+  uint8_t previous = m_channelNumber;
+  m_channelNumber = nch;
+  if (previous != nch)
+    {
+      DoChannelNumberChanged (previous);
+    }
+}
+
+void
+WifiPhy::DoChannelNumberChanged (uint8_t previous)
+{
+}
+
 bool
 WifiPhy::DoChannelSwitch (uint8_t nch)
 {
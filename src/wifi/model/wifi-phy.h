@@ -1655,6 +1655,14 @@ protected:
    * \see SetFrequency
    */
   bool DoFrequencySwitch (uint16_t frequency);
+  /**
+   * The default implementation does nothing.  This method is called
+   * internally whenever the channel number has been changed.
+   *
+   * \brief Perform any actions necessary after the channel number changed
+   * \param previous the previous channel number
+   */
+  virtual void DoChannelNumberChanged (uint8_t previous);
 
   /**
    * Check if Phy state should move to CCA busy state based on current
@@ -1689,6 +1697,13 @@ private:
    * DoInitialize () is called.
    */
   void InitializeFrequencyChannelNumber (void);
+  /**
+   * Set the channel number and call DoChannelNumberChanged if it
+   * differs from the current one.
+   *
+   * \param nch the new channel number
+   */
+  void UpdateChannelNumber (uint8_t nch);
   /**
    * Configure WifiPhy with appropriate channel frequency and
    * supported rates for 802.11a standard.
@@ -30,6 +30,7 @@
 #include "ht-capabilities.h"
 #include "vht-capabilities.h"
 #include "he-capabilities.h"
+#include <unordered_map>
 
 namespace ns3 {
 
@@ -1455,6 +1456,24 @@ private:
    * A vector of WifiRemoteStationStates
    */
   typedef std::vector <WifiRemoteStationState *> StationStates;
+  /**
+   * An index of the WifiRemoteStations, by address and TID
+   */
+  typedef std::unordered_map <uint64_t, WifiRemoteStation *> StationIndex;
+  /**
+   * An index of the WifiRemoteStationStates, by address
+   */
+  typedef std::unordered_map <uint64_t, WifiRemoteStationState *> StationStateIndex;
+
+  /**
+   * Return the key under which a station is indexed.
+   *
+   * \param address the address of the station
+   * \param tid the TID of the station, or 0 for the key of its state
+   *
+   * \return the address and the TID, packed in an integer
+   */
+  static uint64_t GetStationKey (Mac48Address address, uint8_t tid);
 
   /**
    * This is a pointer to the WifiPhy associated with this
@@ -1487,6 +1506,8 @@ private:
 
   StationStates m_states;  //!< States of known stations
   Stations m_stations;     //!< Information for each known stations
+  StationStateIndex m_stateIndex; //!< States of known stations, by address
+  StationIndex m_stationIndex;    //!< Known stations, by address and TID
 
   WifiMode m_defaultTxMode; //!< The default transmission mode
   WifiMode m_defaultTxMcs;   //!< The default transmission modulation-coding scheme (MCS)
@@ -21,10 +21,14 @@
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
+#include "ns3/double.h"
 #include "yans-wifi-channel.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/propagation-delay-model.h"
 #include "wifi-utils.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace ns3 {
 
@@ -47,10 +51,27 @@ YansWifiChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&YansWifiChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("RxPowerFloor",
+                   "The rx power (dBm), before the rx gain of the receiver, below "
+                   "which transmissions are not passed to the receiving phy. "
+                   "If the propagation loss model can bound its loss, the "
+                   "receivers beyond the corresponding range are skipped without "
+                   "computing their rx power.  The default value corresponds to "
+                   "passing all transmissions.  Make sure that this value is "
+                   "below the energy detection and CCA thresholds of the phys, "
+                   "minus their rx gain.",
+                   DoubleValue (-1000.0),
+                   MakeDoubleAccessor (&YansWifiChannel::m_rxPowerFloorDbm),
+                   MakeDoubleChecker<double> ())
   ;
   return tid;
 }
 
+YansWifiChannel::ChannelPhys::ChannelPhys ()
+  : indexed (false)
+{
+}
+
 YansWifiChannel::YansWifiChannel ()
 {
   NS_LOG_FUNCTION (this);
@@ -59,6 +80,7 @@ YansWifiChannel::YansWifiChannel ()
 YansWifiChannel::~YansWifiChannel ()
 {
   NS_LOG_FUNCTION (this);
+  m_channelPhys.clear ();
   m_phyList.clear ();
 }
 
@@ -80,23 +102,49 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
   NS_LOG_FUNCTION (this << sender << packet << txPowerDbm << duration.GetSeconds ());
   Ptr<MobilityModel> senderMobility = sender->GetMobility ();
   NS_ASSERT (senderMobility != 0);
-  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+  //For now don't account for inter channel interference nor channel bonding
+  ChannelPhysMap::iterator channelPhys = m_channelPhys.find (sender->GetChannelNumber ());
+  if (channelPhys == m_channelPhys.end ())
     {
-      if (sender != (*i))
+      return;
+    }
+  ChannelPhys &channel = channelPhys->second;
+  const std::vector<uint32_t> *receivers = &channel.phys;
+  std::vector<uint32_t> receiversInRange;
+  double maxRange = GetMaxRange (txPowerDbm);
+  if (!std::isinf (maxRange))
+    {
+      if (!channel.indexed)
         {
-          //For now don't account for inter channel interference nor channel bonding
-          if ((*i)->GetChannelNumber () != sender->GetChannelNumber ())
+          channel.index.SetCellSize (std::max (maxRange, 1.0));
+          for (std::vector<uint32_t>::const_iterator i = channel.phys.begin (); i != channel.phys.end (); i++)
             {
-              continue;
+              NS_ASSERT_MSG (m_phyList[*i]->GetMobility () != 0, "YansWifiPhy without mobility model");
+              channel.index.Add (*i, m_phyList[*i]->GetMobility ());
             }
-
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
+          channel.indexed = true;
+        }
+      channel.index.Find (senderMobility->GetPosition (), maxRange, receiversInRange);
+      NS_LOG_LOGIC ("phys within " << maxRange << "m: " << receiversInRange.size () << "/" << channel.phys.size ());
+      receivers = &receiversInRange;
+    }
+  for (std::vector<uint32_t>::const_iterator i = receivers->begin (); i != receivers->end (); i++)
+    {
+      Ptr<YansWifiPhy> receiver = m_phyList[*i];
+      if (sender != receiver)
+        {
+          Ptr<MobilityModel> receiverMobility = receiver->GetMobility ()->GetObject<MobilityModel> ();
           Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
           double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
+          if (rxPowerDbm < m_rxPowerFloorDbm)
+            {
+              NS_LOG_DEBUG ("propagation: rxPower=" << rxPowerDbm << "dbm below the floor");
+              continue;
+            }
           NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
                         "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
           Ptr<Packet> copy = packet->Copy ();
-          Ptr<NetDevice> dstNetDevice = (*i)->GetDevice ();
+          Ptr<NetDevice> dstNetDevice = receiver->GetDevice ();
           uint32_t dstNode;
           if (dstNetDevice == 0)
             {
@@ -109,7 +157,72 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
 
           Simulator::ScheduleWithContext (dstNode,
                                           delay, &YansWifiChannel::Receive, this,
-                                          (*i), copy, rxPowerDbm, duration);
+                                          receiver, copy, rxPowerDbm, duration);
+        }
+    }
+}
+
+double
+YansWifiChannel::GetMaxRange (double txPowerDbm) const
+{
+  if (m_loss == 0)
+    {
+      return std::numeric_limits<double>::infinity ();
+    }
+  if (m_rangeLoss != m_loss)
+    {
+      m_ranges.clear ();
+      m_rangeLoss = m_loss;
+    }
+  double maxLossDb = txPowerDbm - m_rxPowerFloorDbm;
+  std::map<double, double>::const_iterator it = m_ranges.find (maxLossDb);
+  if (it != m_ranges.end ())
+    {
+      return it->second;
+    }
+  double maxRange = m_loss->GetMaxRange (maxLossDb);
+  NS_LOG_DEBUG ("maximum range " << maxRange << "m for txPower=" << txPowerDbm << "dbm");
+  m_ranges[maxLossDb] = maxRange;
+  return maxRange;
+}
+
+void
+YansWifiChannel::AddToChannelPhys (uint32_t i, uint8_t channelNumber)
+{
+  ChannelPhys &channel = m_channelPhys[channelNumber];
+  channel.phys.insert (std::lower_bound (channel.phys.begin (), channel.phys.end (), i), i);
+  if (channel.indexed)
+    {
+      NS_ASSERT_MSG (m_phyList[i]->GetMobility () != 0, "YansWifiPhy without mobility model");
+      channel.index.Add (i, m_phyList[i]->GetMobility ());
+    }
+}
+
+void
+YansWifiChannel::RemoveFromChannelPhys (uint32_t i, uint8_t channelNumber)
+{
+  ChannelPhysMap::iterator channelPhys = m_channelPhys.find (channelNumber);
+  NS_ASSERT (channelPhys != m_channelPhys.end ());
+  ChannelPhys &channel = channelPhys->second;
+  std::vector<uint32_t>::iterator it = std::lower_bound (channel.phys.begin (), channel.phys.end (), i);
+  NS_ASSERT (it != channel.phys.end () && *it == i);
+  channel.phys.erase (it);
+  if (channel.indexed)
+    {
+      channel.index.Remove (i);
+    }
+}
+
+void
+YansWifiChannel::NotifyChannelNumberChanged (Ptr<YansWifiPhy> phy, uint8_t previous)
+{
+  NS_LOG_FUNCTION (this << phy << (uint16_t)previous);
+  for (uint32_t i = 0; i < m_phyList.size (); i++)
+    {
+      if (m_phyList[i] == phy)
+        {
+          RemoveFromChannelPhys (i, previous);
+          AddToChannelPhys (i, phy->GetChannelNumber ());
         }
     }
 }
@@ -137,6 +250,7 @@ void
 YansWifiChannel::Add (Ptr<YansWifiPhy> phy)
 {
   m_phyList.push_back (phy);
+  AddToChannelPhys (m_phyList.size () - 1, phy->GetChannelNumber ());
 }
 
 int64_t
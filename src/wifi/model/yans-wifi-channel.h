@@ -22,7 +22,9 @@
 #define YANS_WIFI_CHANNEL_H
 
 #include "ns3/channel.h"
+#include "ns3/mobility-grid-index.h"
 #include "yans-wifi-phy.h"
+#include <map>
 
 namespace ns3 {
 
@@ -38,6 +40,15 @@ class PropagationDelayModel;
  * class and supports an ns3::PropagationLossModel and an 
  * ns3::PropagationDelayModel.  By default, no propagation models are set; 
  * it is the caller's responsibility to set them before using the channel.
+ *
+ * The phys are grouped by channel number, so that a transmission only
+ * visits the phys tuned to the channel of the sender.  If the
+ * RxPowerFloor attribute is set and the propagation loss model can
+ * bound its loss (see PropagationLossModel::GetMinLossDb), the phys that
+ * cannot receive more than RxPowerFloor are not visited either: their
+ * positions are kept in a MobilityGridIndex.  The moving phys are indexed
+ * as well, so that a transmission visits about the phys within range
+ * even when every node moves (e.g., in a vehicular network).
  */
 class YansWifiChannel : public Channel
 {
@@ -84,6 +95,16 @@ public:
    */
   void Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double txPowerDbm, Time duration) const;
 
+  /**
+   * \param phy the YansWifiPhy whose channel number changed
+   * \param previous the channel number the phy was using
+   *
+   * This method should not be invoked by normal users. It is
+   * currently invoked only from YansWifiPhy, to move the phy to the
+   * group of phys using its new channel number.
+   */
+  void NotifyChannelNumberChanged (Ptr<YansWifiPhy> phy, uint8_t previous);
+
   /**
    * Assign a fixed random variable stream number to the random variables
    * used by this model.  Return the number of streams (possibly zero) that
@@ -102,6 +123,23 @@ private:
    */
   typedef std::vector<Ptr<YansWifiPhy> > PhyList;
 
+  /**
+   * The phys using a given channel number.
+   */
+  struct ChannelPhys
+  {
+    ChannelPhys ();
+
+    std::vector<uint32_t> phys;        //!< Indexes of the phys in m_phyList, in increasing order
+    MobilityGridIndex<uint32_t> index; //!< Positions of the phys, once a transmission culled receivers
+    bool indexed;                      //!< Whether the phys were added to the index
+  };
+
+  /**
+   * Container: channel number, ChannelPhys
+   */
+  typedef std::map<uint8_t, ChannelPhys> ChannelPhysMap;
+
   /**
    * This method is scheduled by Send for each associated YansWifiPhy.
    * The method then calls the corresponding YansWifiPhy that the first
@@ -114,9 +152,36 @@ private:
    */
   void Receive (Ptr<YansWifiPhy> receiver, Ptr<Packet> packet, double txPowerDbm, Time duration) const;
 
+  /**
+   * Add a phy to the group of phys using a channel number.
+   *
+   * \param i the index of the phy in m_phyList
+   * \param channelNumber the channel number
+   */
+  void AddToChannelPhys (uint32_t i, uint8_t channelNumber);
+  /**
+   * Remove a phy from the group of phys using a channel number.
+   *
+   * \param i the index of the phy in m_phyList
+   * \param channelNumber the channel number
+   */
+  void RemoveFromChannelPhys (uint32_t i, uint8_t channelNumber);
+
+  /**
+   * \param txPowerDbm the tx power
+   * \return the distance beyond which the rx power is lower than
+   * m_rxPowerFloorDbm, or infinity if it cannot be bounded
+   */
+  double GetMaxRange (double txPowerDbm) const;
+
   PhyList m_phyList;                   //!< List of YansWifiPhys connected to this YansWifiChannel
   Ptr<PropagationLossModel> m_loss;    //!< Propagation loss model
   Ptr<PropagationDelayModel> m_delay;  //!< Propagation delay model
+  double m_rxPowerFloorDbm;            //!< Rx power below which receivers are skipped
+
+  mutable ChannelPhysMap m_channelPhys;          //!< Phys grouped by channel number
+  mutable Ptr<PropagationLossModel> m_rangeLoss; //!< Loss model for which m_ranges are computed
+  mutable std::map<double, double> m_ranges;     //!< Maximum range for each maximum loss
 };
 
 } //namespace ns3
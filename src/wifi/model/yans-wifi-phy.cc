@@ -59,6 +59,16 @@ YansWifiPhy::DoDispose (void)
   m_channel = 0;
 }
 
+void
+YansWifiPhy::DoChannelNumberChanged (uint8_t previous)
+{
+  NS_LOG_FUNCTION (this << (uint16_t)previous);
+  if (m_channel != 0)
+    {
+      m_channel->NotifyChannelNumberChanged (this, previous);
+    }
+}
+
 Ptr<Channel>
 YansWifiPhy::GetChannel (void) const
 {
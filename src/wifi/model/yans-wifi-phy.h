@@ -78,6 +78,7 @@ public:
 protected:
   // Inherited
   virtual void DoDispose (void);
+  virtual void DoChannelNumberChanged (uint8_t previous);
 
 
 private:
@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/interference-helper.h"
+#include "ns3/nist-error-rate-model.h"
+#include "ns3/wifi-phy.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Check the energy durations and the SNIR computed by the
+ * InterferenceHelper while signals come and go.
+ */
+class InterferenceHelperTest : public TestCase
+{
+public:
+  InterferenceHelperTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Add a non-Wi-Fi signal.
+   * \param duration the duration of the signal
+   * \param powerW the power of the signal (W)
+   */
+  void AddSignal (Time duration, double powerW);
+  /**
+   * Check the time during which the energy stays above a threshold.
+   * \param energyW the threshold (W)
+   * \param expected the expected duration
+   */
+  void CheckEnergyDuration (double energyW, Time expected);
+  /**
+   * Start receiving a frame.
+   * \param duration the duration of the frame
+   * \param powerW the power of the frame (W)
+   */
+  void StartRx (Time duration, double powerW);
+  /**
+   * Finish receiving the current frame and check its SNR.
+   * \param interferenceW the expected interference at the start of the frame (W)
+   */
+  void EndRx (double interferenceW);
+
+  InterferenceHelper m_interference; ///< the interference helper under test
+  WifiTxVector m_txVector; ///< TXVECTOR of the received frames
+  Ptr<InterferenceHelper::Event> m_event; ///< frame being received
+  std::vector<double> m_pers; ///< PER of the received frames
+};
+
+InterferenceHelperTest::InterferenceHelperTest ()
+  : TestCase ("Check the InterferenceHelper bookkeeping of overlapping signals")
+{
+}
+
+void
+InterferenceHelperTest::AddSignal (Time duration, double powerW)
+{
+  m_interference.AddForeignSignal (duration, powerW);
+}
+
+void
+InterferenceHelperTest::CheckEnergyDuration (double energyW, Time expected)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_interference.GetEnergyDuration (energyW), expected,
+                         "Unexpected energy duration at " << Simulator::Now ());
+}
+
+void
+InterferenceHelperTest::StartRx (Time duration, double powerW)
+{
+  m_event = m_interference.Add (1000, m_txVector, duration, powerW);
+  m_interference.NotifyRxStart ();
+}
+
+void
+InterferenceHelperTest::EndRx (double interferenceW)
+{
+  InterferenceHelper::SnrPer snrPer = m_interference.CalculatePlcpPayloadSnrPer (m_event);
+  m_interference.NotifyRxEnd ();
+  //thermal noise at 290K over 20 MHz, with a noise figure of 1
+  double noiseW = 1.3803e-23 * 290.0 * 20e6;
+  double expected = m_event->GetRxPowerW () / (noiseW + interferenceW);
+  NS_TEST_EXPECT_MSG_EQ_TOL (snrPer.snr, expected, expected * 1e-9,
+                             "Unexpected SNR at " << Simulator::Now ());
+  m_pers.push_back (snrPer.per);
+  m_event = 0;
+}
+
+void
+InterferenceHelperTest::DoRun (void)
+{
+  m_interference.SetNoiseFigure (1.0);
+  m_interference.SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+  m_txVector.SetMode (WifiPhy::GetOfdmRate6Mbps ());
+  m_txVector.SetPreambleType (WIFI_PREAMBLE_LONG);
+
+  //two overlapping signals: 1 pW over [0, 100us] and 1 pW over [10us, 30us]
+  Simulator::Schedule (MicroSeconds (0), &InterferenceHelperTest::AddSignal, this, MicroSeconds (100), 1e-12);
+  Simulator::Schedule (MicroSeconds (0), &InterferenceHelperTest::CheckEnergyDuration, this, 0.5e-12, MicroSeconds (100));
+  Simulator::Schedule (MicroSeconds (0), &InterferenceHelperTest::CheckEnergyDuration, this, 2e-12, MicroSeconds (0));
+  Simulator::Schedule (MicroSeconds (10), &InterferenceHelperTest::AddSignal, this, MicroSeconds (20), 1e-12);
+  Simulator::Schedule (MicroSeconds (10), &InterferenceHelperTest::CheckEnergyDuration, this, 1.5e-12, MicroSeconds (20));
+  Simulator::Schedule (MicroSeconds (10), &InterferenceHelperTest::CheckEnergyDuration, this, 0.5e-12, MicroSeconds (90));
+
+  //a frame received over the first signal, hit by a third one
+  Simulator::Schedule (MicroSeconds (50), &InterferenceHelperTest::StartRx, this, MicroSeconds (1000), 1e-11);
+  Simulator::Schedule (MicroSeconds (500), &InterferenceHelperTest::AddSignal, this, MicroSeconds (10), 3e-12);
+  Simulator::Schedule (MicroSeconds (1050), &InterferenceHelperTest::EndRx, this, 1e-12);
+
+  //once every signal is over, many frames are received with no interference
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      Time start = MilliSeconds (2) + MicroSeconds (1200 * i);
+      Simulator::Schedule (start, &InterferenceHelperTest::AddSignal, this, MicroSeconds (100), 1e-12);
+      Simulator::Schedule (start + MicroSeconds (100), &InterferenceHelperTest::StartRx, this, MicroSeconds (1000), 1e-11);
+      Simulator::Schedule (start + MicroSeconds (1100), &InterferenceHelperTest::EndRx, this, 0);
+      Simulator::Schedule (start + MicroSeconds (1100), &InterferenceHelperTest::CheckEnergyDuration, this, 0.1e-12, MicroSeconds (0));
+    }
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_pers.size (), 1001, "Every frame should have been received");
+  NS_TEST_ASSERT_MSG_GT (m_pers.front (), m_pers.back (), "Interference should increase the PER");
+}
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief InterferenceHelper Test Suite
+ */
+class InterferenceHelperTestSuite : public TestSuite
+{
+public:
+  InterferenceHelperTestSuite ();
+};
+
+InterferenceHelperTestSuite::InterferenceHelperTestSuite ()
+  : TestSuite ("wifi-interference-helper", UNIT)
+{
+  AddTestCase (new InterferenceHelperTest, TestCase::QUICK);
+}
+
+static InterferenceHelperTestSuite g_interferenceHelperTestSuite; ///< the test suite
@@ -0,0 +1,349 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/wifi-remote-station-manager.h"
+#include "ns3/wifi-mac-header.h"
+#include "ns3/yans-wifi-phy.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief A WifiRemoteStationManager recording the stations it is given
+ */
+class RecordingWifiManager : public WifiRemoteStationManager
+{
+public:
+  RecordingWifiManager ();
+
+  uint32_t m_nCreated;               //!< Number of stations created
+  WifiRemoteStation *m_lastStation;  //!< Last station reported
+
+private:
+  // inherited from WifiRemoteStationManager
+  virtual bool IsLowLatency (void) const;
+  virtual WifiRemoteStation* DoCreateStation (void) const;
+  virtual WifiTxVector DoGetDataTxVector (WifiRemoteStation *station);
+  virtual WifiTxVector DoGetRtsTxVector (WifiRemoteStation *station);
+  virtual void DoReportRxOk (WifiRemoteStation *station, double rxSnr, WifiMode txMode);
+  virtual void DoReportRtsFailed (WifiRemoteStation *station);
+  virtual void DoReportDataFailed (WifiRemoteStation *station);
+  virtual void DoReportRtsOk (WifiRemoteStation *station, double ctsSnr, WifiMode ctsMode, double rtsSnr);
+  virtual void DoReportDataOk (WifiRemoteStation *station, double ackSnr, WifiMode ackMode, double dataSnr);
+  virtual void DoReportFinalRtsFailed (WifiRemoteStation *station);
+  virtual void DoReportFinalDataFailed (WifiRemoteStation *station);
+};
+
+RecordingWifiManager::RecordingWifiManager ()
+  : m_nCreated (0),
+    m_lastStation (0)
+{
+}
+
+bool
+RecordingWifiManager::IsLowLatency (void) const
+{
+  return true;
+}
+
+WifiRemoteStation *
+RecordingWifiManager::DoCreateStation (void) const
+{
+  const_cast<RecordingWifiManager *> (this)->m_nCreated++;
+  return new WifiRemoteStation ();
+}
+
+WifiTxVector
+RecordingWifiManager::DoGetDataTxVector (WifiRemoteStation *station)
+{
+  return WifiTxVector ();
+}
+
+WifiTxVector
+RecordingWifiManager::DoGetRtsTxVector (WifiRemoteStation *station)
+{
+  return WifiTxVector ();
+}
+
+void
+RecordingWifiManager::DoReportRxOk (WifiRemoteStation *station, double rxSnr, WifiMode txMode)
+{
+}
+
+void
+RecordingWifiManager::DoReportRtsFailed (WifiRemoteStation *station)
+{
+}
+
+void
+RecordingWifiManager::DoReportDataFailed (WifiRemoteStation *station)
+{
+  m_lastStation = station;
+}
+
+void
+RecordingWifiManager::DoReportRtsOk (WifiRemoteStation *station, double ctsSnr, WifiMode ctsMode, double rtsSnr)
+{
+}
+
+void
+RecordingWifiManager::DoReportDataOk (WifiRemoteStation *station, double ackSnr, WifiMode ackMode, double dataSnr)
+{
+}
+
+void
+RecordingWifiManager::DoReportFinalRtsFailed (WifiRemoteStation *station)
+{
+}
+
+void
+RecordingWifiManager::DoReportFinalDataFailed (WifiRemoteStation *station)
+{
+}
+
+/**
+ * \param manager the station manager
+ * \returns a phy set up for 802.11a, given to the manager
+ */
+static Ptr<YansWifiPhy>
+SetupManagerPhy (Ptr<WifiRemoteStationManager> manager)
+{
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  manager->SetupPhy (phy);
+  return phy;
+}
+
+/**
+ * \param i the index of the station
+ * \returns the address of the station
+ */
+static Mac48Address
+GetStationAddress (uint32_t i)
+{
+  uint8_t buffer[6] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+  buffer[3] = (i >> 16) & 0xff;
+  buffer[4] = (i >> 8) & 0xff;
+  buffer[5] = i & 0xff;
+  Mac48Address address;
+  address.CopyFrom (buffer);
+  return address;
+}
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Check that the station manager finds the station of each
+ * address and TID, and keeps the state shared by the TIDs of an address.
+ */
+class WifiRemoteStationLookupTest : public TestCase
+{
+public:
+  WifiRemoteStationLookupTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+WifiRemoteStationLookupTest::WifiRemoteStationLookupTest ()
+  : TestCase ("Check the lookup of remote stations by address and TID")
+{
+}
+
+void
+WifiRemoteStationLookupTest::DoRun (void)
+{
+  Ptr<RecordingWifiManager> manager = CreateObject<RecordingWifiManager> ();
+  Ptr<YansWifiPhy> phy = SetupManagerPhy (manager);
+
+  WifiMacHeader header;
+  header.SetType (WIFI_MAC_QOSDATA);
+  std::vector<WifiRemoteStation *> stations;
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      for (uint8_t tid = 0; tid < 4; tid++)
+        {
+          header.SetQosTid (tid);
+          manager->ReportDataFailed (GetStationAddress (i), &header);
+          NS_TEST_ASSERT_MSG_EQ (manager->m_lastStation->m_state->m_address, GetStationAddress (i), "Wrong station address");
+          NS_TEST_ASSERT_MSG_EQ ((uint16_t) manager->m_lastStation->m_tid, (uint16_t) tid, "Wrong station TID");
+          NS_TEST_ASSERT_MSG_EQ (manager->m_lastStation->m_slrc, 1, "New station should have failed once");
+          if (tid > 0)
+            {
+              NS_TEST_ASSERT_MSG_EQ (manager->m_lastStation->m_state, stations.back ()->m_state,
+                                     "The TIDs of an address should share its state");
+            }
+          stations.push_back (manager->m_lastStation);
+        }
+      manager->RecordGotAssocTxOk (GetStationAddress (i));
+    }
+  NS_TEST_ASSERT_MSG_EQ (manager->m_nCreated, 1200, "Wrong number of stations created");
+
+  // existing stations are found again, in any order
+  for (uint32_t i = 300; i-- > 0; )
+    {
+      for (uint8_t tid = 0; tid < 4; tid++)
+        {
+          header.SetQosTid (tid);
+          manager->ReportDataFailed (GetStationAddress (i), &header);
+          NS_TEST_ASSERT_MSG_EQ (manager->m_lastStation, stations[i * 4 + tid], "Wrong station found");
+          NS_TEST_ASSERT_MSG_EQ (manager->m_lastStation->m_slrc, 2, "Station should have failed twice");
+        }
+      NS_TEST_ASSERT_MSG_EQ (manager->IsAssociated (GetStationAddress (i)), true, "Station should be associated");
+    }
+  NS_TEST_ASSERT_MSG_EQ (manager->m_nCreated, 1200, "No station should be created again");
+  NS_TEST_ASSERT_MSG_EQ (manager->IsAssociated (GetStationAddress (300)), false, "Unknown station should not be associated");
+
+  // after a reset, the stations are created again, with the same states
+  manager->Reset ();
+  header.SetQosTid (0);
+  manager->ReportDataFailed (GetStationAddress (7), &header);
+  NS_TEST_ASSERT_MSG_EQ (manager->m_nCreated, 1201, "Station should be created again after a reset");
+  NS_TEST_ASSERT_MSG_EQ (manager->m_lastStation->m_slrc, 1, "New station should have failed once");
+  NS_TEST_ASSERT_MSG_EQ (manager->IsAssociated (GetStationAddress (7)), true, "Station state should be kept after a reset");
+
+  manager->Dispose ();
+  phy->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Wifi remote station manager Test Suite
+ */
+class WifiRemoteStationManagerTestSuite : public TestSuite
+{
+public:
+  WifiRemoteStationManagerTestSuite ();
+};
+
+WifiRemoteStationManagerTestSuite::WifiRemoteStationManagerTestSuite ()
+  : TestSuite ("wifi-remote-station-manager", UNIT)
+{
+  AddTestCase (new WifiRemoteStationLookupTest, TestCase::QUICK);
+}
+
+static WifiRemoteStationManagerTestSuite g_wifiRemoteStationManagerTestSuite; ///< the test suite
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Check that the cost of looking up a station does not grow with
+ * the number of associated stations.
+ */
+class WifiRemoteStationLookupCostTest : public TestCase
+{
+public:
+  WifiRemoteStationLookupCostTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Time the lookups of the stations of a station manager.
+   * \param nStations the number of associated stations
+   * \returns the time taken by a lookup, in seconds
+   */
+  double TimeLookups (uint32_t nStations);
+};
+
+WifiRemoteStationLookupCostTest::WifiRemoteStationLookupCostTest ()
+  : TestCase ("Check that the cost of a station lookup does not grow with the number of stations")
+{
+}
+
+double
+WifiRemoteStationLookupCostTest::TimeLookups (uint32_t nStations)
+{
+  typedef std::chrono::steady_clock Clock;
+  const uint32_t lookups = 200000;
+
+  Ptr<RecordingWifiManager> manager = CreateObject<RecordingWifiManager> ();
+  Ptr<YansWifiPhy> phy = SetupManagerPhy (manager);
+  WifiMacHeader header;
+  header.SetType (WIFI_MAC_QOSDATA);
+  header.SetQosTid (0);
+  std::vector<Mac48Address> addresses;
+  for (uint32_t i = 0; i < nStations; i++)
+    {
+      addresses.push_back (GetStationAddress (i));
+      manager->RecordGotAssocTxOk (addresses.back ());
+      manager->ReportDataFailed (addresses.back (), &header);
+    }
+
+  // the best of a few runs, to filter out the noise
+  double best = 0;
+  for (uint32_t run = 0; run < 3; run++)
+    {
+      Clock::time_point start = Clock::now ();
+      for (uint32_t i = 0; i < lookups; i++)
+        {
+          manager->ReportDataFailed (addresses[(i * 7919) % nStations], &header);
+        }
+      double seconds = std::chrono::duration<double> (Clock::now () - start).count () / lookups;
+      best = (run == 0 || seconds < best) ? seconds : best;
+    }
+  std::cout << "wifi-remote-station-manager-perf: " << nStations << " stations: "
+            << 1e9 * best << " ns/lookup" << std::endl;
+
+  manager->Dispose ();
+  phy->Dispose ();
+  return best;
+}
+
+void
+WifiRemoteStationLookupCostTest::DoRun (void)
+{
+  double few = TimeLookups (8);
+  TimeLookups (64);
+  double many = TimeLookups (1024);
+  // a linear scan of the stations makes the lookups among 1024 stations
+  // more than ten times slower
+  NS_TEST_EXPECT_MSG_LT (many, 3 * few, "Station lookup cost grows with the number of stations");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Wifi remote station manager performance Test Suite
+ */
+class WifiRemoteStationManagerPerformanceSuite : public TestSuite
+{
+public:
+  WifiRemoteStationManagerPerformanceSuite ();
+};
+
+WifiRemoteStationManagerPerformanceSuite::WifiRemoteStationManagerPerformanceSuite ()
+  : TestSuite ("wifi-remote-station-manager-perf", PERFORMANCE)
+{
+  AddTestCase (new WifiRemoteStationLookupCostTest, TestCase::QUICK);
+}
+
+static WifiRemoteStationManagerPerformanceSuite g_wifiRemoteStationManagerPerformanceSuite; ///< the test suite
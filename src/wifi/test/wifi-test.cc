@@ -29,6 +29,8 @@
 #include "ns3/propagation-loss-model.h"
 #include "ns3/yans-error-rate-model.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/double.h"
 #include "ns3/test.h"
 #include "ns3/pointer.h"
 #include "ns3/rng-seed-manager.h"
@@ -1154,6 +1156,176 @@ Bug2222TestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_countInternalCollisions, 1, "unexpected number of internal collisions!");
 }
 
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Make sure that YansWifiChannel only passes the transmissions to
+ * the phys tuned to the channel of the sender and not below the
+ * RxPowerFloor, while phys move and switch channels.
+ *
+ * The receivers are put in sleep mode, so that each transmission passed
+ * to them is dropped exactly once.
+ */
+class YansWifiChannelCullingTest : public TestCase
+{
+public:
+  YansWifiChannelCullingTest ();
+
+  virtual void DoRun (void);
+
+
+private:
+  /**
+   * Create a phy
+   * \param channelNumber the channel number of the phy
+   * \returns the phy
+   */
+  Ptr<YansWifiPhy> CreatePhy (uint8_t channelNumber);
+  /**
+   * Send a packet from a phy, and compute the phys expected to get it
+   * \param sender the index of the sending phy
+   */
+  void Send (uint32_t sender);
+  /**
+   * Switch the channel of a sleeping phy
+   * \param i the index of the phy
+   * \param channelNumber the new channel number
+   */
+  void SwitchChannel (uint32_t i, uint8_t channelNumber);
+  /**
+   * Count the transmissions dropped by a receiver
+   * \param i the index of the phy
+   * \param p the packet
+   */
+  void RxDrop (uint32_t i, Ptr<const Packet> p);
+
+  Ptr<YansWifiChannel> m_channel;       ///< the channel
+  Ptr<PropagationLossModel> m_loss;     ///< the propagation loss model
+  std::vector<Ptr<YansWifiPhy> > m_phys; ///< the phys
+  std::vector<uint32_t> m_expected;     ///< expected number of drops of each receiver
+  std::vector<uint32_t> m_drops;        ///< number of drops of each receiver
+  uint32_t m_nSenders;                  ///< number of senders, the first phys
+  double m_rxPowerFloor;                ///< the rx power floor
+};
+
+YansWifiChannelCullingTest::YansWifiChannelCullingTest ()
+  : TestCase ("Test case for YansWifiChannel receiver culling"),
+    m_nSenders (5),
+    m_rxPowerFloor (-80)
+{
+}
+
+Ptr<YansWifiPhy>
+YansWifiChannelCullingTest::CreatePhy (uint8_t channelNumber)
+{
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->SetErrorRateModel (CreateObject<YansErrorRateModel> ());
+  phy->SetChannel (m_channel);
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  phy->SetChannelNumber (channelNumber);
+  return phy;
+}
+
+void
+YansWifiChannelCullingTest::Send (uint32_t sender)
+{
+  Ptr<YansWifiPhy> phy = m_phys[sender];
+  double txPowerDbm = phy->GetTxPowerStart () + phy->GetTxGain ();
+  for (uint32_t i = m_nSenders; i < m_phys.size (); i++)
+    {
+      if (m_phys[i]->GetChannelNumber () == phy->GetChannelNumber ()
+          && m_loss->CalcRxPower (txPowerDbm, phy->GetMobility (), m_phys[i]->GetMobility ()) >= m_rxPowerFloor)
+        {
+          m_expected[i]++;
+        }
+    }
+  WifiTxVector txVector = WifiTxVector (WifiPhy::GetOfdmRate6Mbps (), 0, 0, WIFI_PREAMBLE_LONG, false, 1, 1, 0, 20, false, false);
+  Ptr<Packet> packet = Create<Packet> (100);
+  phy->SendPacket (packet, txVector);
+}
+
+void
+YansWifiChannelCullingTest::SwitchChannel (uint32_t i, uint8_t channelNumber)
+{
+  m_phys[i]->ResumeFromSleep ();
+  m_phys[i]->SetChannelNumber (channelNumber);
+  m_phys[i]->SetSleepMode ();
+}
+
+void
+YansWifiChannelCullingTest::RxDrop (uint32_t i, Ptr<const Packet> p)
+{
+  m_drops[i]++;
+}
+
+void
+YansWifiChannelCullingTest::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+
+  m_loss = CreateObject<LogDistancePropagationLossModel> ();
+  m_channel = CreateObject<YansWifiChannel> ();
+  m_channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  m_channel->SetPropagationLossModel (m_loss);
+  m_channel->SetAttribute ("RxPowerFloor", DoubleValue (m_rxPowerFloor));
+
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      Ptr<YansWifiPhy> phy = CreatePhy (i < m_nSenders || i % 2 ? 36 : 40);
+      Vector position (random->GetValue (0, 300), random->GetValue (0, 300), 0);
+      if (i % 3 == 0)
+        {
+          Ptr<ConstantVelocityMobilityModel> mobility = CreateObject<ConstantVelocityMobilityModel> ();
+          mobility->SetPosition (position);
+          mobility->SetVelocity (Vector (random->GetValue (-10, 10), random->GetValue (-10, 10), 0));
+          phy->SetMobility (mobility);
+        }
+      else
+        {
+          Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+          mobility->SetPosition (position);
+          phy->SetMobility (mobility);
+        }
+      if (i >= m_nSenders)
+        {
+          phy->SetSleepMode ();
+          phy->TraceConnectWithoutContext ("PhyRxDrop", MakeCallback (&YansWifiChannelCullingTest::RxDrop, this).Bind (i));
+        }
+      m_phys.push_back (phy);
+    }
+  m_expected.resize (m_phys.size (), 0);
+  m_drops.resize (m_phys.size (), 0);
+
+  for (uint32_t i = 0; i < 40; i++)
+    {
+      Simulator::Schedule (Seconds (i), &YansWifiChannelCullingTest::Send, this, i % m_nSenders);
+    }
+  for (uint32_t i = m_nSenders; i < m_phys.size (); i += 7)
+    {
+      Simulator::Schedule (Seconds (20.5), &YansWifiChannelCullingTest::SwitchChannel, this, i,
+                           m_phys[i]->GetChannelNumber () == 36 ? 40 : 36);
+    }
+  Simulator::Run ();
+
+  uint32_t drops = 0;
+  for (uint32_t i = m_nSenders; i < m_phys.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_drops[i], m_expected[i], "unexpected number of transmissions received by phy " << i);
+      drops += m_drops[i];
+    }
+  NS_TEST_EXPECT_MSG_GT (drops, 0, "some transmissions should be received");
+
+  for (uint32_t i = 0; i < m_phys.size (); i++)
+    {
+      m_phys[i]->Dispose ();
+    }
+  m_phys.clear ();
+  m_channel = 0;
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup wifi-test
  * \ingroup tests
@@ -1176,6 +1348,7 @@ WifiTestSuite::WifiTestSuite ()
   AddTestCase (new Bug730TestCase, TestCase::QUICK); //Bug 730
   AddTestCase (new SetChannelFrequencyTest, TestCase::QUICK);
   AddTestCase (new Bug2222TestCase, TestCase::QUICK); //Bug 2222
+  AddTestCase (new YansWifiChannelCullingTest, TestCase::QUICK);
 }
 
 static WifiTestSuite g_wifiTestSuite; ///< the test suite
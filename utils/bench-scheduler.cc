@@ -0,0 +1,341 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 NITK Surathkal
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <stdlib.h>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+std::string g_me;
+#define LOG(x)   std::cout << x << std::endl
+#define LOGME(x) LOG (g_me << x)
+
+// Output field width
+int g_fwidth = 14;
+
+/**
+ * Extract the delay of an event from a line of the log of
+ * DefaultSimulatorImpl, obtained with
+ * NS_LOG="DefaultSimulatorImpl=level_function".
+ *
+ * \param [in] line The log line.
+ * \param [out] delay The delay of the event, in time steps.
+ * \returns \c true if the line logs the scheduling of an event.
+ */
+bool
+ParseLogLine (const std::string &line, int64_t &delay)
+{
+  std::string::size_type pos;
+  uint32_t field;
+  if ((pos = line.find ("DefaultSimulatorImpl:ScheduleWithContext(")) != std::string::npos)
+    {
+      // (this, context, delay, event)
+      field = 2;
+    }
+  else if ((pos = line.find ("DefaultSimulatorImpl:Schedule(")) != std::string::npos)
+    {
+      // (this, delay, event)
+      field = 1;
+    }
+  else if (line.find ("DefaultSimulatorImpl:ScheduleNow(") != std::string::npos)
+    {
+      delay = 0;
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+  pos = line.find ('(', pos);
+  for (uint32_t i = 0; i < field && pos != std::string::npos; i++)
+    {
+      pos = line.find (',', pos + 1);
+    }
+  if (pos == std::string::npos)
+    {
+      return false;
+    }
+  delay = strtoll (line.c_str () + pos + 1, 0, 10);
+  return true;
+}
+
+/**
+ * Read a recorded distribution of event delays.
+ *
+ * The input is either the log of DefaultSimulatorImpl of a simulation
+ * (see ParseLogLine), or an ascii list of delays, in time steps.
+ *
+ * \param [in] filename The input file name, or "-" for standard input.
+ * \returns The delays, in the order they were recorded.
+ */
+std::vector<uint64_t>
+ReadDelays (std::string filename)
+{
+  std::istream *input;
+  std::ifstream file;
+  if (filename == "-")
+    {
+      LOGME ("using event distribution from stdin");
+      input = &std::cin;
+    }
+  else
+    {
+      LOGME ("using event distribution from " << filename);
+      file.open (filename.c_str ());
+      if (!file.is_open ())
+        {
+          NS_FATAL_ERROR ("Could not open " << filename);
+        }
+      input = &file;
+    }
+
+  std::vector<uint64_t> delays;
+  std::string line;
+  while (std::getline (*input, line))
+    {
+      int64_t delay;
+      if (ParseLogLine (line, delay))
+        {
+          delays.push_back (delay);
+          continue;
+        }
+      std::istringstream iss (line);
+      while (iss >> delay)
+        {
+          delays.push_back (delay);
+        }
+    }
+  LOGME ("found " << delays.size () << " entries");
+  return delays;
+}
+
+/**
+ * Generate delays from an exponential distribution.
+ *
+ * \param [in] n The number of delays.
+ * \returns The delays.
+ */
+std::vector<uint64_t>
+ExponentialDelays (uint32_t n)
+{
+  LOGME ("using default exponential distribution");
+  Ptr<ExponentialRandomVariable> erv = CreateObject<ExponentialRandomVariable> ();
+  erv->SetAttribute ("Mean", DoubleValue (100));
+  std::vector<uint64_t> delays;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      delays.push_back (static_cast<uint64_t> (erv->GetValue ()));
+    }
+  return delays;
+}
+
+/**
+ * Replay a distribution of delays on a scheduler according to the
+ * classical hold model: a population of events is inserted, then each
+ * event removed from the scheduler is replaced by a new event, whose
+ * delay is the next delay of the distribution. In a percentage of the
+ * hold operations, a timer event is also restarted, i.e., cancelled if
+ * it is still pending and scheduled again.
+ *
+ * \param [in] type The scheduler type.
+ * \param [in] delays The delays, which are replayed cyclically.
+ * \param [in] pop The population of events.
+ * \param [in] total The number of hold operations.
+ * \param [in] cancel The percentage of hold operations restarting the timer.
+ */
+void
+RunBench (std::string type, const std::vector<uint64_t> &delays,
+          uint32_t pop, uint32_t total, uint32_t cancel)
+{
+  ObjectFactory factory (type);
+  Ptr<Scheduler> scheduler = factory.Create<Scheduler> ();
+  SystemWallClockMs time;
+  uint32_t next = 0;
+  uint32_t uid = 0;
+  uint64_t now = 0;
+
+  Scheduler::Event ev;
+  ev.impl = 0;
+  ev.key.m_context = 0;
+  Scheduler::Event timer = ev;
+  bool timerPending = false;
+
+  time.Start ();
+  for (uint32_t i = 0; i < pop; i++)
+    {
+      ev.key.m_ts = now + delays[next];
+      ev.key.m_uid = uid++;
+      next = (next + 1) % delays.size ();
+      scheduler->Insert (ev);
+    }
+  double init = time.End () / 1000.0;
+
+  time.Start ();
+  for (uint32_t i = 0; i < total && !scheduler->IsEmpty (); i++)
+    {
+      Scheduler::Event removed = scheduler->RemoveNext ();
+      now = removed.key.m_ts;
+      if (timerPending && removed.key.m_uid == timer.key.m_uid)
+        {
+          timerPending = false;
+        }
+      ev.key.m_ts = now + delays[next];
+      ev.key.m_uid = uid++;
+      next = (next + 1) % delays.size ();
+      scheduler->Insert (ev);
+      if (i % 100 < cancel)
+        {
+          // restart the timer
+          if (timerPending)
+            {
+              scheduler->Remove (timer);
+            }
+          timer.key.m_ts = now + delays[next];
+          timer.key.m_uid = uid++;
+          next = (next + 1) % delays.size ();
+          scheduler->Insert (timer);
+          timerPending = true;
+        }
+    }
+  double simu = time.End () / 1000.0;
+
+  LOG (std::left << std::setw (2 * g_fwidth) << type <<
+       std::right << std::setw (g_fwidth) << init <<
+       std::setw (g_fwidth) << (init * 1e9 / pop) <<
+       std::setw (g_fwidth) << simu <<
+       std::setw (g_fwidth) << (simu * 1e9 / total));
+}
+
+
+int main (int argc, char *argv[])
+{
+  bool schedCal    = false;
+  bool schedHeap   = false;
+  bool schedLadder = false;
+  bool schedList   = false;
+  bool schedMap    = false;
+
+  uint32_t pop    =  100000;
+  uint32_t total  = 1000000;
+  uint32_t runs   =       1;
+  uint32_t cancel =       0;
+  std::string filename = "";
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the event schedulers, without the simulator.\n"
+             "\n"
+             "Event delays are taken from one of:\n"
+             "  an exponential distribution, with mean 100 ns,\n"
+             "  a file, given by the --file=\"<filename>\" argument,\n"
+             "  or standard input, by the argument --file=\"-\"\n"
+             "In the case of either --file form, the input is either an\n"
+             "ascii list of delays, in time steps, or the log of the\n"
+             "DefaultSimulatorImpl of a real simulation, which can be\n"
+             "recorded with, e.g.:\n"
+             "  NS_LOG=\"DefaultSimulatorImpl=level_function\" \\\n"
+             "  ./waf --run rem-example 2> rem-example.log\n"
+             "All the schedulers but ListScheduler are compared, unless\n"
+             "some are selected.");
+  cmd.AddValue ("cal",    "use CalendarSheduler",          schedCal);
+  cmd.AddValue ("heap",   "use HeapScheduler",             schedHeap);
+  cmd.AddValue ("ladder", "use LadderScheduler",           schedLadder);
+  cmd.AddValue ("list",   "use ListSheduler",              schedList);
+  cmd.AddValue ("map",    "use MapScheduler",              schedMap);
+  cmd.AddValue ("pop",    "event population size (default 1E5)",         pop);
+  cmd.AddValue ("total",  "total number of events to run (default 1E6)", total);
+  cmd.AddValue ("runs",   "number of runs (default 1)",    runs);
+  cmd.AddValue ("cancel", "percentage of events restarting a timer (default 0)",  cancel);
+  cmd.AddValue ("file",   "file of relative event times",  filename);
+  cmd.Parse (argc, argv);
+  g_me = cmd.GetName () + ": ";
+
+  std::vector<std::string> types;
+  if (schedMap)
+    {
+      types.push_back ("ns3::MapScheduler");
+    }
+  if (schedHeap)
+    {
+      types.push_back ("ns3::HeapScheduler");
+    }
+  if (schedCal)
+    {
+      types.push_back ("ns3::CalendarScheduler");
+    }
+  if (schedLadder)
+    {
+      types.push_back ("ns3::LadderScheduler");
+    }
+  if (schedList)
+    {
+      types.push_back ("ns3::ListScheduler");
+    }
+  if (types.empty ())
+    {
+      types.push_back ("ns3::MapScheduler");
+      types.push_back ("ns3::HeapScheduler");
+      types.push_back ("ns3::CalendarScheduler");
+      types.push_back ("ns3::LadderScheduler");
+    }
+
+  std::vector<uint64_t> delays;
+  if (filename == "")
+    {
+      delays = ExponentialDelays (pop + total);
+    }
+  else
+    {
+      delays = ReadDelays (filename);
+    }
+  if (delays.empty ())
+    {
+      NS_FATAL_ERROR ("No event delays");
+    }
+
+  LOGME ("population: " << pop);
+  LOGME ("total events: " << total);
+  LOGME ("timer restarts: " << cancel << "%");
+  LOGME ("runs: " << runs);
+
+  // table header
+  LOG ("");
+  LOG (std::left << std::setw (2 * g_fwidth) << "Scheduler" <<
+       std::right << std::setw (2 * g_fwidth) << "Initialization:" <<
+       std::setw (2 * g_fwidth) << "Hold:");
+  LOG (std::left << std::setw (2 * g_fwidth) << "" <<
+       std::right << std::setw (g_fwidth) << "Time (s)" <<
+       std::setw (g_fwidth) << "Per (ns/ev)" <<
+       std::setw (g_fwidth) << "Time (s)" <<
+       std::setw (g_fwidth) << "Per (ns/ev)");
+  LOG (std::setfill ('-') << std::setw (6 * g_fwidth) << "" << std::setfill (' '));
+
+  for (uint32_t i = 0; i < runs; i++)
+    {
+      for (std::vector<std::string>::const_iterator t = types.begin (); t != types.end (); ++t)
+        {
+          RunBench (*t, delays, pop, total, cancel);
+        }
+    }
+  return 0;
+}
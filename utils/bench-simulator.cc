@@ -205,6 +205,7 @@ int main (int argc, char *argv[])
 
   bool schedCal  = false;
   bool schedHeap = false;
+  bool schedLadder = false;
   bool schedList = false;
   bool schedMap  = true;
 
@@ -224,6 +225,7 @@ int main (int argc, char *argv[])
              "to be ascii, giving the relative event times in ns.");
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
+  cmd.AddValue ("ladder", "use LadderScheduler",          schedLadder);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
@@ -245,6 +247,10 @@ int main (int argc, char *argv[])
     {
       factory.SetTypeId ("ns3::HeapScheduler");
     }
+  if (schedLadder)
+    {
+      factory.SetTypeId ("ns3::LadderScheduler");
+    }
   if (schedList)
     {
       factory.SetTypeId ("ns3::ListScheduler");
@@ -300,6 +306,19 @@ int main (int argc, char *argv[])
     }
 
   LOG ("");
+  double seconds = Simulator::Now ().GetSeconds ();
+  if (seconds > 0)
+    {
+      LOGME ("events allocated: " << EventImpl::GetNAllocations () <<
+             ", recycled: " << EventImpl::GetNRecycled () <<
+             " (" << EventImpl::GetNRecycled () / seconds <<
+             " allocations avoided per simulated second)");
+    }
+  else
+    {
+      LOGME ("events allocated: " << EventImpl::GetNAllocations () <<
+             ", recycled: " << EventImpl::GetNRecycled ());
+    }
   Simulator::Destroy ();
   delete bench;
   return 0;